@@ -0,0 +1,51 @@
+# - Try to find LZ4
+# Once done this will define
+#
+#  LZ4_FOUND - system has LZ4
+#  LZ4_INCLUDE_DIRS - the LZ4 include directory
+#  LZ4_LIBRARIES - Link these to use LZ4
+#
+
+if (LZ4_LIBRARIES AND LZ4_INCLUDE_DIRS)
+  # in cache already
+  set(LZ4_FOUND TRUE)
+else (LZ4_LIBRARIES AND LZ4_INCLUDE_DIRS)
+
+  find_path(LZ4_INCLUDE_DIR
+    NAMES
+      lz4.h
+    PATHS
+      /usr/include
+      /usr/local/include
+      /opt/local/include
+      /sw/include
+  )
+
+  find_library(LZ4_LIBRARY
+    NAMES
+      lz4
+    PATHS
+      /usr/lib
+      /usr/local/lib
+      /opt/local/lib
+      /sw/lib
+  )
+
+  set(LZ4_INCLUDE_DIRS
+    ${LZ4_INCLUDE_DIR}
+  )
+
+  if (LZ4_LIBRARY)
+    set(LZ4_LIBRARIES
+        ${LZ4_LIBRARIES}
+        ${LZ4_LIBRARY}
+    )
+  endif (LZ4_LIBRARY)
+
+  include(FindPackageHandleStandardArgs)
+  find_package_handle_standard_args(LZ4 DEFAULT_MSG LZ4_LIBRARIES LZ4_INCLUDE_DIRS)
+
+  # show the LZ4_INCLUDE_DIRS and LZ4_LIBRARIES variables only in the advanced view
+  mark_as_advanced(LZ4_INCLUDE_DIRS LZ4_LIBRARIES)
+
+endif (LZ4_LIBRARIES AND LZ4_INCLUDE_DIRS)
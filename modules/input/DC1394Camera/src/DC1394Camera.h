@@ -21,19 +21,67 @@
 #define MODULES_INPUT_DC1394CAMERA_H
 
 #include <nuclear>
+#include <atomic>
+#include <map>
+#include <mutex>
 
 #include <dc1394/dc1394.h>
 
+#include "FrameRing.h"
+#include "RingCapture.h"
+
 namespace modules {
 namespace input {
 
+    /**
+     * @brief Captures from cameras on the 1394 bus.
+     *
+     * @details
+     *  An event driven camera is read by a service task that blocks until its DMA ring has a frame, so frames are
+     *  emitted as soon as they arrive. Its images borrow the DMA buffers rather than copying them while the ring has
+     *  buffers to spare. Other cameras are read, with a copy, on a timer.
+     */
     class DC1394Camera : public NUClear::Reactor {
+    private:
+        struct Camera {
+            uint cameraID;
+            uint buffers;
+            bool eventDriven;
+            std::shared_ptr<FrameRing> ring;
+            std::unique_ptr<RingCapture> capture;
+        };
+
+        /// @brief Emits a frame as an image from camera camID
+        template <int camID>
+        void emitImage(RingCapture::Capture&& capture);
+
+        /// @brief Emits a frame as an image from the right camera
+        void emitImage(uint cameraID, RingCapture::Capture&& capture);
+
+        /// @brief Waits for the event driven cameras' frames and emits them until we are killed
+        void run();
+
+        /// @brief Stops the capture thread
+        void kill();
+
     public:
-        std::unique_ptr<dc1394_t, std::function<void (dc1394_t*)>> context;
-        std::map<uint64_t, std::unique_ptr<dc1394camera_t, std::function<void (dc1394camera_t*)>>> cameras;
+        std::shared_ptr<dc1394_t> context;
+        std::map<uint64_t, Camera> cameras;
+
+        /// @brief Held while the cameras are changed or read
+        std::mutex camerasMutex;
+
+        /// @brief Whether our capture thread should keep running
+        std::atomic<bool> running;
 
         static constexpr const char* CONFIGURATION_PATH = "Cameras";
 
+        /// @brief How many copy buffers each camera keeps for reuse
+        static constexpr size_t POOL_SIZE = 4;
+
+        /// @brief How long the capture thread waits for a frame before checking whether it should stop
+        static constexpr int POLL_TIMEOUT_MS = 100;
+
         /// @brief Called by the powerplant to build and setup the DC1394Camera reactor.
         explicit DC1394Camera(std::unique_ptr<NUClear::Environment> environment);
     };
@@ -42,4 +90,4 @@ namespace input {
 }
 
 
-#endif
\ No newline at end of file
+#endif
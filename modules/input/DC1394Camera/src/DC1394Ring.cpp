@@ -0,0 +1,160 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "DC1394Ring.h"
+
+#include <algorithm>
+#include <map>
+#include <system_error>
+
+#include "utility/error/dc1394_error_category.h"
+
+namespace modules {
+namespace input {
+
+    namespace {
+        void check(dc1394error_t err) {
+            if(err != DC1394_SUCCESS) throw std::system_error(err, utility::error::dc1394_error_category());
+        }
+
+        /*
+         * The ring that is driving each camera (by guid). A ring replaced by a new one on the same camera lives on
+         * while images hold its buffers, and must not stop the camera out from under the new ring when it goes.
+         */
+        std::mutex ownersMutex;
+        std::map<uint64_t, const DC1394Ring*> owners;
+    }
+
+    DC1394Ring::DC1394Ring(std::shared_ptr<dc1394_t> context, uint64_t guid, uint buffers)
+        : context(context)
+        , camera(dc1394_camera_new(context.get(), guid), dc1394_camera_free)
+        , guid(guid)
+        , buffers(buffers)
+        , period()
+        , mutex()
+        , frames(buffers, nullptr) {
+
+        if(!camera) {
+            throw std::system_error(DC1394_NOT_A_CAMERA, utility::error::dc1394_error_category(), "Failed to find camera " + std::to_string(guid));
+        }
+
+        // Set some important bus options
+        // Apparently ISO speed is transmission speed in MB/s and must be set
+        check(dc1394_video_set_operation_mode(camera.get(), DC1394_OPERATION_MODE_LEGACY));
+        check(dc1394_video_set_iso_speed(camera.get(), DC1394_ISO_SPEED_400));
+        check(dc1394_video_set_mode(camera.get(), DC1394_VIDEO_MODE_1280x960_RGB8));
+        check(dc1394_video_set_framerate(camera.get(), DC1394_FRAMERATE_3_75));
+
+        float framerate;
+        check(dc1394_framerate_as_float(DC1394_FRAMERATE_3_75, &framerate));
+        period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / framerate));
+
+        // Setup our capture
+        check(dc1394_capture_setup(camera.get(), buffers, DC1394_CAPTURE_FLAGS_DEFAULT));
+
+        // Start the camera
+        check(dc1394_video_set_transmission(camera.get(), DC1394_ON));
+
+        // Reset to factory default settings
+        dc1394_memory_load(camera.get(), 0);
+
+        // We drive the camera now, any ring that was before us must leave it alone
+        std::lock_guard<std::mutex> lock(ownersMutex);
+        owners[guid] = this;
+    }
+
+    DC1394Ring::~DC1394Ring() {
+
+        bool owner = false;
+        {
+            std::lock_guard<std::mutex> lock(ownersMutex);
+            auto it = owners.find(guid);
+            if(it != owners.end() && it->second == this) {
+                owners.erase(it);
+                owner = true;
+            }
+        }
+
+        // Only the newest ring on a camera stops it, an older one would stop the newer one's stream (our handle is
+        // still freed either way)
+        if(owner) {
+            dc1394_video_set_transmission(camera.get(), DC1394_OFF);
+            dc1394_capture_stop(camera.get());
+        }
+    }
+
+    bool DC1394Ring::dequeue(Frame& frame) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        dc1394video_frame_t* filled = nullptr;
+        if(dc1394_capture_dequeue(camera.get(), DC1394_CAPTURE_POLICY_POLL, &filled) != DC1394_SUCCESS || !filled) {
+            return false;
+        }
+
+        frames[filled->id] = filled;
+
+        // libdc1394 timestamps frames (in microseconds) by the wall clock when they arrive
+        auto arrived = std::chrono::system_clock::time_point(std::chrono::microseconds(filled->timestamp));
+        auto age = std::max(std::chrono::system_clock::now() - arrived, std::chrono::system_clock::duration::zero());
+
+        frame.index = filled->id;
+        frame.data = filled->image;
+        frame.bytes = filled->image_bytes;
+        frame.width = filled->size[0];
+        frame.height = filled->size[1];
+        frame.timestamp = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+        frame.behind = filled->frames_behind;
+
+        return true;
+    }
+
+    void DC1394Ring::enqueue(uint index) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(frames[index]) {
+            dc1394_capture_enqueue(camera.get(), frames[index]);
+            frames[index] = nullptr;
+        }
+    }
+
+    int DC1394Ring::getFileDescriptor() const {
+        return dc1394_capture_get_fileno(camera.get());
+    }
+
+    uint DC1394Ring::getBufferCount() const {
+        return buffers;
+    }
+
+    uint DC1394Ring::getBytesPerPixel() const {
+        // We always capture in RGB8
+        return 3;
+    }
+
+    std::chrono::steady_clock::duration DC1394Ring::getPeriod() const {
+        return period;
+    }
+
+    std::string DC1394Ring::getName() const {
+        return std::to_string(guid);
+    }
+
+}
+}
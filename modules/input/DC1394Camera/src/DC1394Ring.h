@@ -0,0 +1,79 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_DC1394RING_H
+#define MODULES_INPUT_DC1394RING_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <dc1394/dc1394.h>
+
+#include "FrameRing.h"
+
+namespace modules {
+namespace input {
+
+    /**
+     * @brief The DMA ring of a camera on the 1394 bus, which is capturing from when it is made until it is destroyed.
+     *
+     * @details
+     *  Images can hold on to the ring's buffers after the camera has been reconfigured or the module has shut down,
+     *  so whoever lends out a buffer should keep the ring alive until it is given back. A camera can be reopened
+     *  while the old ring is still alive, the newest ring owns the camera and only the owner stops it.
+     */
+    class DC1394Ring : public FrameRing {
+    public:
+        /**
+         * @brief Connects to the camera and starts it transmitting
+         *
+         * @param context the dc1394 library context, kept alive for as long as the ring
+         * @param guid    the camera's id on the bus
+         * @param buffers how many buffers the ring should have
+         */
+        DC1394Ring(std::shared_ptr<dc1394_t> context, uint64_t guid, uint buffers);
+        ~DC1394Ring();
+
+        bool dequeue(Frame& frame) override;
+        void enqueue(uint index) override;
+        int getFileDescriptor() const override;
+        uint getBufferCount() const override;
+        uint getBytesPerPixel() const override;
+        std::chrono::steady_clock::duration getPeriod() const override;
+        std::string getName() const override;
+
+    private:
+        std::shared_ptr<dc1394_t> context;
+        std::unique_ptr<dc1394camera_t, std::function<void (dc1394camera_t*)>> camera;
+        uint64_t guid;
+        uint buffers;
+        std::chrono::steady_clock::duration period;
+
+        /// @brief Held while dequeuing or enqueuing, which can happen on different threads
+        std::mutex mutex;
+        /// @brief The frame libdc1394 gave us for each buffer we have dequeued, which it wants back to enqueue it
+        std::vector<dc1394video_frame_t*> frames;
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FRAMERING_H
+#define MODULES_INPUT_FRAMERING_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace modules {
+namespace input {
+
+    /**
+     * @brief The ring of DMA buffers a camera captures into.
+     *
+     * @details
+     *  The camera fills the buffers in turn. A filled buffer is ours from dequeue until we enqueue it again, and
+     *  while we have it the camera can't capture into it. If the camera has no empty buffer when a frame arrives the
+     *  frame is dropped. Buffers may be enqueued from any thread.
+     */
+    class FrameRing {
+    public:
+        struct Frame {
+            /// @brief which buffer of the ring this is, to hand back to enqueue
+            uint index;
+            const uint8_t* data;
+            size_t bytes;
+            uint width;
+            uint height;
+            /// @brief when the camera captured the frame
+            std::chrono::steady_clock::time_point timestamp;
+            /// @brief how many more filled buffers are waiting after this one
+            uint behind;
+        };
+
+        virtual ~FrameRing() = default;
+
+        /**
+         * @brief Takes the next filled buffer if there is one, without waiting
+         */
+        virtual bool dequeue(Frame& frame) = 0;
+
+        /**
+         * @brief Gives a buffer back to the camera to capture into
+         */
+        virtual void enqueue(uint index) = 0;
+
+        /// @brief A file descriptor that polls readable when a buffer is filled, or -1 if there isn't one
+        virtual int getFileDescriptor() const = 0;
+
+        /// @brief How many buffers are in the ring
+        virtual uint getBufferCount() const = 0;
+
+        /// @brief How many bytes each pixel of a whole frame takes, so short frames can be told apart
+        virtual uint getBytesPerPixel() const = 0;
+
+        /// @brief How long the camera takes between frames
+        virtual std::chrono::steady_clock::duration getPeriod() const = 0;
+
+        virtual std::string getName() const = 0;
+    };
+
+}
+}
+
+#endif
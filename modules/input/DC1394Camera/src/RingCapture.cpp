@@ -0,0 +1,158 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "RingCapture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace modules {
+namespace input {
+
+    using messages::input::CaptureStatistics;
+
+    constexpr uint RingCapture::RESERVED;
+
+    RingCapture::RingCapture(size_t poolSize)
+        : pool(poolSize)
+        , lent(std::make_shared<std::atomic<uint>>(0))
+        , haveTimestamp(false)
+        , lastTimestamp()
+        , statisticsMutex()
+        , frames(0)
+        , dropped(0)
+        , corrupt(0)
+        , allocations(0)
+        , copied(0)
+        , maxQueued(0)
+        , maxLent(0)
+        , totalLatency(0)
+        , maxLatency(0) {
+    }
+
+    bool RingCapture::capture(const std::shared_ptr<FrameRing>& ring, bool lend, Capture& capture) {
+
+        FrameRing::Frame frame;
+        if(!ring->dequeue(frame)) {
+            return false;
+        }
+
+        // The ring has no frame counter so we find dropped frames by gaps between the timestamps
+        uint64_t skipped = 0;
+        if(haveTimestamp) {
+            double periods = std::chrono::duration<double>(frame.timestamp - lastTimestamp).count()
+                           / std::chrono::duration<double>(ring->getPeriod()).count();
+            skipped = uint64_t(std::max(std::lround(periods) - 1, 0l));
+        }
+        haveTimestamp = true;
+        lastTimestamp = frame.timestamp;
+
+        bool complete = frame.bytes >= size_t(frame.width) * frame.height * ring->getBytesPerPixel();
+
+        // Lend the buffer if the camera would still have enough left to capture into
+        uint held = *lent;
+        bool lending = lend && complete && held + 1 + RESERVED <= ring->getBufferCount();
+        bool reused = true;
+
+        if(lending) {
+            ++*lent;
+            held += 1;
+
+            std::shared_ptr<FrameRing> owner = ring;
+            std::shared_ptr<std::atomic<uint>> count = lent;
+            uint index = frame.index;
+
+            capture.borrowed = std::shared_ptr<const uint8_t>(frame.data, [owner, count, index] (const uint8_t*) {
+                owner->enqueue(index);
+                --*count;
+            });
+        }
+        else {
+            if(complete) {
+                capture.data = pool.acquire(frame.bytes, reused);
+                capture.recycle = pool.recycler();
+                std::memcpy(capture.data.data(), frame.data, frame.bytes);
+            }
+            ring->enqueue(frame.index);
+        }
+
+        // Put the capture time on the same clock as the rest of the system
+        auto age = std::chrono::steady_clock::now() - frame.timestamp;
+        capture.timestamp = NUClear::clock::now() - std::chrono::duration_cast<NUClear::clock::duration>(age);
+        capture.width = frame.width;
+        capture.height = frame.height;
+        capture.bytes = frame.bytes;
+        double latency = std::chrono::duration<double>(age).count();
+
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        dropped += skipped;
+        allocations += reused ? 0 : 1;
+        maxQueued = std::max(maxQueued, frame.behind + 1);
+        maxLent = std::max(maxLent, held);
+
+        if(complete) {
+            ++frames;
+            copied += lending ? 0 : 1;
+            totalLatency += latency;
+            maxLatency = std::max(maxLatency, latency);
+        }
+        else {
+            ++corrupt;
+        }
+
+        return complete;
+    }
+
+    std::unique_ptr<CaptureStatistics> RingCapture::takeStatistics(const FrameRing& ring) {
+
+        auto statistics = std::make_unique<CaptureStatistics>();
+        statistics->device = ring.getName();
+        statistics->buffers = ring.getBufferCount();
+
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        statistics->frames = frames;
+        statistics->dropped = dropped;
+        statistics->corrupt = corrupt;
+        statistics->allocations = allocations;
+        statistics->copied = copied;
+        statistics->maxQueued = maxQueued;
+        statistics->maxLent = maxLent;
+        statistics->meanLatency = frames > 0 ? totalLatency / frames : 0;
+        statistics->maxLatency = maxLatency;
+
+        frames = 0;
+        dropped = 0;
+        corrupt = 0;
+        allocations = 0;
+        copied = 0;
+        maxQueued = 0;
+        maxLent = 0;
+        totalLatency = 0;
+        maxLatency = 0;
+
+        return statistics;
+    }
+
+    uint RingCapture::getLent() const {
+        return *lent;
+    }
+
+}
+}
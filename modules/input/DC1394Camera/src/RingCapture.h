@@ -0,0 +1,113 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_RINGCAPTURE_H
+#define MODULES_INPUT_RINGCAPTURE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <nuclear>
+
+#include "messages/input/CaptureStatistics.h"
+#include "utility/image/FramePool.h"
+#include "FrameRing.h"
+
+namespace modules {
+namespace input {
+
+    /**
+     * @brief Takes frames out of a camera's DMA ring, lending them to images where it can and copying them where not.
+     *
+     * @details
+     *  A lent frame stays in its DMA buffer and the buffer goes back to the camera when the last image using it is
+     *  destroyed, so emitting it costs no copy. Every buffer we lend is one the camera can't capture into though, so
+     *  once lending another would leave the camera fewer than RESERVED buffers the frame is copied into a pooled
+     *  buffer instead and the DMA buffer goes straight back.
+     */
+    class RingCapture {
+    public:
+        /// @brief A frame taken out of the ring, either lent or copied
+        struct Capture {
+            NUClear::clock::time_point timestamp;
+            uint width;
+            uint height;
+
+            /// @brief the DMA buffer if the frame was lent, which goes back to the ring when the last copy is released
+            std::shared_ptr<const uint8_t> borrowed;
+            size_t bytes;
+
+            /// @brief otherwise a copy of the frame and where to put it once it is finished with
+            std::vector<uint8_t> data;
+            std::function<void (std::vector<uint8_t>&&)> recycle;
+        };
+
+        /// @brief How many buffers we always leave the camera to capture into
+        static constexpr uint RESERVED = 2;
+
+        /**
+         * @param poolSize how many copy buffers to keep for reuse
+         */
+        explicit RingCapture(size_t poolSize);
+
+        /**
+         * @brief Takes the next filled buffer out of the ring, if there is one
+         *
+         * @param ring  the ring, which is kept alive until everything lent from it is given back
+         * @param lend  whether the frame may be lent, if false it is always copied
+         *
+         * @return true if capture was filled in
+         */
+        bool capture(const std::shared_ptr<FrameRing>& ring, bool lend, Capture& capture);
+
+        /**
+         * @brief Gets the statistics gathered since the last call and starts gathering afresh
+         */
+        std::unique_ptr<messages::input::CaptureStatistics> takeStatistics(const FrameRing& ring);
+
+        /// @brief How many of the ring's buffers are lent out right now
+        uint getLent() const;
+
+    private:
+        utility::image::FramePool pool;
+
+        /// @brief Shared with the lent buffers, which can be given back after we are gone
+        std::shared_ptr<std::atomic<uint>> lent;
+
+        bool haveTimestamp;
+        std::chrono::steady_clock::time_point lastTimestamp;
+
+        std::mutex statisticsMutex;
+        uint64_t frames;
+        uint64_t dropped;
+        uint64_t corrupt;
+        uint64_t allocations;
+        uint64_t copied;
+        uint maxQueued;
+        uint maxLent;
+        double totalLatency;
+        double maxLatency;
+    };
+
+}
+}
+
+#endif
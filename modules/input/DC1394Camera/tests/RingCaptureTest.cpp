@@ -0,0 +1,279 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <deque>
+
+#include "messages/input/Image.h"
+#include "FrameRing.h"
+#include "RingCapture.h"
+
+using messages::input::Image;
+using modules::input::FrameRing;
+using modules::input::RingCapture;
+
+namespace {
+
+    /*
+     * A ring the test fills by hand, which drops frames when it has no free buffer like a camera would
+     */
+    class FakeRing : public FrameRing {
+    public:
+        FakeRing(uint buffers, uint width, uint height, uint bytesPerPixel = 1)
+            : buffers(buffers, std::vector<uint8_t>(width * height * bytesPerPixel))
+            , free(buffers, true)
+            , width(width)
+            , height(height)
+            , bytesPerPixel(bytesPerPixel)
+            , dropped(0) {
+        }
+
+        // A frame arriving from the camera, every byte of which is value
+        void fill(uint8_t value, const std::chrono::steady_clock::time_point& timestamp) {
+            for(uint i = 0; i < buffers.size(); ++i) {
+                if(free[i]) {
+                    free[i] = false;
+                    std::fill(buffers[i].begin(), buffers[i].end(), value);
+                    filled.push_back(std::make_pair(i, timestamp));
+                    return;
+                }
+            }
+            ++dropped;
+        }
+
+        uint freeBuffers() const {
+            return uint(std::count(free.begin(), free.end(), true));
+        }
+
+        bool dequeue(Frame& frame) override {
+            if(filled.empty()) {
+                return false;
+            }
+
+            frame.index = filled.front().first;
+            frame.data = buffers[frame.index].data();
+            frame.bytes = buffers[frame.index].size();
+            frame.width = width;
+            frame.height = height;
+            frame.timestamp = filled.front().second;
+            filled.pop_front();
+            frame.behind = uint(filled.size());
+            return true;
+        }
+
+        void enqueue(uint index) override {
+            REQUIRE_FALSE(free[index]);
+            free[index] = true;
+        }
+
+        int getFileDescriptor() const override {
+            return -1;
+        }
+
+        uint getBufferCount() const override {
+            return uint(buffers.size());
+        }
+
+        uint getBytesPerPixel() const override {
+            return bytesPerPixel;
+        }
+
+        std::chrono::steady_clock::duration getPeriod() const override {
+            return std::chrono::milliseconds(10);
+        }
+
+        std::string getName() const override {
+            return "fake";
+        }
+
+        std::vector<std::vector<uint8_t>> buffers;
+        std::vector<bool> free;
+        std::deque<std::pair<uint, std::chrono::steady_clock::time_point>> filled;
+        uint width;
+        uint height;
+        uint bytesPerPixel;
+        uint dropped;
+    };
+
+    std::unique_ptr<Image<0>> toImage(RingCapture::Capture&& capture) {
+        auto image = std::make_unique<Image<0>>();
+        image->dimensions = { capture.width, capture.height };
+        image->source = std::move(capture.data);
+        image->recycle = std::move(capture.recycle);
+        image->borrowed = std::move(capture.borrowed);
+        image->borrowedBytes = capture.bytes;
+        return image;
+    }
+}
+
+TEST_CASE("Frames are lent until the camera would run short of buffers", "[camera][dc1394]") {
+
+    auto ring = std::make_shared<FakeRing>(5, 8, 4);
+    RingCapture capture(4);
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<Image<0>>> images;
+    for(uint i = 0; i < 4; ++i) {
+        ring->fill(uint8_t(i + 1), now + i * ring->getPeriod());
+
+        RingCapture::Capture frame;
+        REQUIRE(capture.capture(ring, true, frame));
+        images.push_back(toImage(std::move(frame)));
+    }
+
+    // The first frames stay in the ring's buffers, the rest are copies once only RESERVED would be left
+    uint lendable = ring->getBufferCount() - RingCapture::RESERVED;
+    REQUIRE(capture.getLent() == lendable);
+    REQUIRE(ring->freeBuffers() == RingCapture::RESERVED);
+    for(uint i = 0; i < images.size(); ++i) {
+        bool lent = i < lendable;
+        REQUIRE(bool(images[i]->borrowed) == lent);
+        REQUIRE(images[i]->source.empty() == lent);
+        REQUIRE(images[i]->bytes() == 8 * 4);
+        REQUIRE(images[i]->data()[0] == i + 1);
+        REQUIRE(images[i]->get(7, 3) == i + 1);
+        if(lent) {
+            REQUIRE(images[i]->data() == ring->buffers[i].data());
+        }
+    }
+
+    // Letting go of a lent image gives its buffer back to the camera
+    images[0].reset();
+    REQUIRE(capture.getLent() == lendable - 1);
+    REQUIRE(ring->freeBuffers() == RingCapture::RESERVED + 1);
+
+    // Which means the next frame can be lent again
+    ring->fill(9, now + 4 * ring->getPeriod());
+    RingCapture::Capture frame;
+    REQUIRE(capture.capture(ring, true, frame));
+    REQUIRE(frame.borrowed);
+
+    auto statistics = capture.takeStatistics(*ring);
+    REQUIRE(statistics->frames == 5);
+    REQUIRE(statistics->copied == 4 - lendable);
+    REQUIRE(statistics->maxLent == lendable);
+    REQUIRE(statistics->dropped == 0);
+}
+
+TEST_CASE("Lent buffers keep their ring alive", "[camera][dc1394]") {
+
+    std::weak_ptr<FakeRing> weak;
+    std::unique_ptr<Image<0>> image;
+    {
+        auto ring = std::make_shared<FakeRing>(4, 8, 4);
+        weak = ring;
+
+        RingCapture capture(4);
+        ring->fill(7, std::chrono::steady_clock::now());
+
+        RingCapture::Capture frame;
+        REQUIRE(capture.capture(ring, true, frame));
+        image = toImage(std::move(frame));
+    }
+
+    // The capture and everyone else's reference to the ring are gone but the image can still be read
+    REQUIRE_FALSE(weak.expired());
+    REQUIRE(image->data()[5] == 7);
+
+    image.reset();
+    REQUIRE(weak.expired());
+}
+
+TEST_CASE("Frames are copied when lending is off", "[camera][dc1394]") {
+
+    auto ring = std::make_shared<FakeRing>(4, 8, 4);
+    RingCapture capture(4);
+    auto now = std::chrono::steady_clock::now();
+
+    for(uint i = 0; i < 10; ++i) {
+        ring->fill(uint8_t(i), now + i * ring->getPeriod());
+
+        RingCapture::Capture frame;
+        REQUIRE(capture.capture(ring, false, frame));
+        REQUIRE_FALSE(frame.borrowed);
+        REQUIRE(frame.data[0] == i);
+        REQUIRE(ring->freeBuffers() == 4);
+        frame.recycle(std::move(frame.data));
+    }
+
+    auto statistics = capture.takeStatistics(*ring);
+    REQUIRE(statistics->copied == 10);
+    REQUIRE(statistics->maxLent == 0);
+
+    // Only the first buffer needed allocating, the rest were reused
+    REQUIRE(statistics->allocations == 1);
+}
+
+TEST_CASE("Dropped frames and queued buffers are counted", "[camera][dc1394]") {
+
+    auto ring = std::make_shared<FakeRing>(4, 8, 4);
+    RingCapture capture(4);
+    auto now = std::chrono::steady_clock::now();
+
+    RingCapture::Capture frame;
+    ring->fill(0, now);
+    REQUIRE(capture.capture(ring, false, frame));
+
+    // Three frames are waiting when we get to them, after the camera dropped two (that never got timestamps)
+    ring->fill(1, now + 3 * ring->getPeriod());
+    ring->fill(2, now + 4 * ring->getPeriod());
+    ring->fill(3, now + 5 * ring->getPeriod());
+
+    std::vector<RingCapture::Capture> frames(3);
+    for(auto& f : frames) {
+        REQUIRE(capture.capture(ring, false, f));
+    }
+    REQUIRE_FALSE(capture.capture(ring, false, frame));
+
+    auto statistics = capture.takeStatistics(*ring);
+    REQUIRE(statistics->device == "fake");
+    REQUIRE(statistics->buffers == 4);
+    REQUIRE(statistics->frames == 4);
+    REQUIRE(statistics->dropped == 2);
+    REQUIRE(statistics->maxQueued == 3);
+
+    // Statistics start afresh
+    statistics = capture.takeStatistics(*ring);
+    REQUIRE(statistics->frames == 0);
+    REQUIRE(statistics->dropped == 0);
+}
+
+TEST_CASE("Frames shorter than a whole frame of pixels are corrupt", "[camera][dc1394]") {
+
+    // An RGB ring whose frames arrive with only one byte for each pixel
+    auto ring = std::make_shared<FakeRing>(4, 8, 4, 3);
+    for(auto& buffer : ring->buffers) {
+        buffer.resize(8 * 4);
+    }
+    RingCapture capture(4);
+
+    ring->fill(1, std::chrono::steady_clock::now());
+
+    RingCapture::Capture frame;
+    REQUIRE_FALSE(capture.capture(ring, true, frame));
+    REQUIRE_FALSE(frame.borrowed);
+    REQUIRE(frame.data.empty());
+    REQUIRE(ring->freeBuffers() == 4);
+
+    auto statistics = capture.takeStatistics(*ring);
+    REQUIRE(statistics->frames == 0);
+    REQUIRE(statistics->corrupt == 1);
+    REQUIRE(statistics->copied == 0);
+}
@@ -0,0 +1,311 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "CaptureScheduler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace modules {
+    namespace input {
+
+        using messages::input::CameraFrameSet;
+        using messages::input::CaptureStatistics;
+
+        constexpr std::chrono::milliseconds CaptureScheduler::RETRIEVE_TIMEOUT;
+
+        CaptureScheduler::CaptureScheduler(size_t poolSize
+            , std::function<void (Capture&&)> onFrame
+            , std::function<void (std::unique_ptr<CameraFrameSet>&&)> onFrameSet)
+            : onFrame(onFrame)
+            , onFrameSet(onFrameSet)
+            , pool(poolSize)
+            , camerasMutex()
+            , cameras()
+            , synchronisation({ FlycapDevice::Trigger::FREE_RUNNING, 0, 0, std::chrono::milliseconds(5) })
+            , triggerMutex()
+            , triggerWait()
+            , triggerThread()
+            , triggering(false)
+            , matcherMutex()
+            , matcher() {
+        }
+
+        CaptureScheduler::~CaptureScheduler() {
+            stop();
+        }
+
+        void CaptureScheduler::synchronise(const Synchronisation& synchronisation) {
+
+            // The trigger thread needs camerasMutex so it has to be stopped first
+            stopTriggers();
+
+            {
+                std::lock_guard<std::mutex> lock(camerasMutex);
+                this->synchronisation = synchronisation;
+
+                for (auto& camera : cameras) {
+                    stopCamera(*camera.second);
+                    camera.second->device->setTrigger(synchronisation.trigger, synchronisation.source);
+                    startCamera(*camera.second);
+                }
+
+                resetMatcher();
+            }
+
+            if (synchronisation.trigger == FlycapDevice::Trigger::SOFTWARE) {
+                startTriggers();
+            }
+        }
+
+        void CaptureScheduler::addCamera(uint cameraID, std::shared_ptr<FlycapDevice> device) {
+
+            removeCamera(cameraID);
+
+            std::lock_guard<std::mutex> lock(camerasMutex);
+
+            auto camera = std::make_unique<Camera>();
+            camera->cameraID = cameraID;
+            camera->device = device;
+            camera->running = false;
+
+            device->setTrigger(synchronisation.trigger, synchronisation.source);
+            startCamera(*camera);
+
+            cameras[cameraID] = std::move(camera);
+            resetMatcher();
+        }
+
+        std::shared_ptr<FlycapDevice> CaptureScheduler::removeCamera(uint cameraID) {
+
+            std::lock_guard<std::mutex> lock(camerasMutex);
+
+            auto camera = cameras.find(cameraID);
+            if (camera == cameras.end()) {
+                return nullptr;
+            }
+
+            stopCamera(*camera->second);
+            auto device = camera->second->device;
+
+            cameras.erase(camera);
+            resetMatcher();
+
+            return device;
+        }
+
+        void CaptureScheduler::stop() {
+
+            stopTriggers();
+
+            std::lock_guard<std::mutex> lock(camerasMutex);
+            for (auto& camera : cameras) {
+                stopCamera(*camera.second);
+                camera.second->device->close();
+            }
+            cameras.clear();
+        }
+
+        std::vector<std::unique_ptr<CaptureStatistics>> CaptureScheduler::takeStatistics() {
+
+            std::vector<std::unique_ptr<CaptureStatistics>> statistics;
+
+            std::lock_guard<std::mutex> lock(camerasMutex);
+            for (auto& entry : cameras) {
+                auto& camera = *entry.second;
+
+                auto s = std::make_unique<CaptureStatistics>();
+                s->device = std::to_string(camera.device->getSerial());
+                s->buffers = camera.device->getSettings().buffers;
+
+                std::lock_guard<std::mutex> statisticsLock(camera.statisticsMutex);
+                s->frames = camera.frames;
+                s->dropped = camera.dropped;
+                s->corrupt = camera.corrupt;
+                s->allocations = camera.allocations;
+                s->copied = camera.frames;
+                s->maxQueued = 0;
+                s->maxLent = 0;
+                s->meanLatency = camera.frames > 0 ? camera.totalLatency / camera.frames : 0;
+                s->maxLatency = camera.maxLatency;
+
+                camera.frames = 0;
+                camera.dropped = 0;
+                camera.corrupt = 0;
+                camera.allocations = 0;
+                camera.totalLatency = 0;
+                camera.maxLatency = 0;
+
+                statistics.push_back(std::move(s));
+            }
+
+            return statistics;
+        }
+
+        uint64_t CaptureScheduler::getUnmatched() {
+            std::lock_guard<std::mutex> lock(matcherMutex);
+            return matcher.getUnmatched();
+        }
+
+        void CaptureScheduler::startCamera(Camera& camera) {
+            camera.haveSequence = false;
+            camera.frames = 0;
+            camera.dropped = 0;
+            camera.corrupt = 0;
+            camera.allocations = 0;
+            camera.totalLatency = 0;
+            camera.maxLatency = 0;
+
+            camera.device->startCapture();
+            camera.running = true;
+            camera.thread = std::thread(&CaptureScheduler::capture, this, std::ref(camera));
+        }
+
+        void CaptureScheduler::stopCamera(Camera& camera) {
+            camera.running = false;
+            if (camera.thread.joinable()) {
+                camera.thread.join();
+            }
+            camera.device->stopCapture();
+        }
+
+        void CaptureScheduler::resetMatcher() {
+
+            std::vector<uint> ids;
+            for (auto& camera : cameras) {
+                ids.push_back(camera.first);
+            }
+
+            std::lock_guard<std::mutex> lock(matcherMutex);
+            matcher.reset(ids, synchronisation.tolerance);
+        }
+
+        void CaptureScheduler::capture(Camera& camera) {
+
+            while (camera.running) {
+
+                FlycapDevice::Frame frame;
+                if (!camera.device->retrieve(frame, RETRIEVE_TIMEOUT)) {
+                    continue;
+                }
+
+                // Copy the frame out so the camera can have its buffer back
+                bool reused;
+                Capture capture;
+                capture.cameraID = camera.cameraID;
+                capture.width = frame.width;
+                capture.height = frame.height;
+                capture.sequence = frame.sequence;
+                capture.data = pool.acquire(frame.bytes, reused);
+                capture.recycle = pool.recycler();
+                std::memcpy(capture.data.data(), frame.data, frame.bytes);
+
+                // Put the capture time on the same clock as the rest of the system
+                auto age = std::chrono::steady_clock::now() - frame.timestamp;
+                capture.timestamp = NUClear::clock::now() - std::chrono::duration_cast<NUClear::clock::duration>(age);
+                double latency = std::chrono::duration<double>(age).count();
+
+                // Any gap in the frame counter is frames the camera had nowhere to put (a counter that went
+                // backwards was reset or wrapped, which we can't count across)
+                uint32_t skipped = 0;
+                if (frame.hasSequence) {
+                    if (camera.haveSequence && frame.sequence > camera.lastSequence) {
+                        skipped = frame.sequence - camera.lastSequence - 1;
+                    }
+                    camera.haveSequence = true;
+                    camera.lastSequence = frame.sequence;
+                }
+
+                bool complete = frame.bytes >= size_t(frame.width) * frame.height;
+                {
+                    std::lock_guard<std::mutex> lock(camera.statisticsMutex);
+                    camera.dropped += skipped;
+                    camera.allocations += reused ? 0 : 1;
+                    if (complete) {
+                        ++camera.frames;
+                        camera.totalLatency += latency;
+                        camera.maxLatency = std::max(camera.maxLatency, latency);
+                    }
+                    else {
+                        ++camera.corrupt;
+                    }
+                }
+
+                if (!complete) {
+                    capture.recycle(std::move(capture.data));
+                    continue;
+                }
+
+                uint32_t sequence = capture.sequence;
+                NUClear::clock::time_point timestamp = capture.timestamp;
+                onFrame(std::move(capture));
+
+                std::unique_ptr<CameraFrameSet> set;
+                {
+                    std::lock_guard<std::mutex> lock(matcherMutex);
+                    set = matcher.add(camera.cameraID, sequence, timestamp);
+                }
+
+                if (set) {
+                    onFrameSet(std::move(set));
+                }
+            }
+        }
+
+        void CaptureScheduler::startTriggers() {
+            std::lock_guard<std::mutex> lock(triggerMutex);
+            triggering = true;
+            triggerThread = std::thread(&CaptureScheduler::fireTriggers, this);
+        }
+
+        void CaptureScheduler::stopTriggers() {
+            {
+                std::lock_guard<std::mutex> lock(triggerMutex);
+                triggering = false;
+                triggerWait.notify_all();
+            }
+            if (triggerThread.joinable()) {
+                triggerThread.join();
+            }
+        }
+
+        void CaptureScheduler::fireTriggers() {
+
+            const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / synchronisation.framerate));
+            auto next = std::chrono::steady_clock::now();
+
+            std::unique_lock<std::mutex> lock(triggerMutex);
+            while (triggering) {
+
+                // Fire every camera as close together as we can
+                {
+                    std::lock_guard<std::mutex> camerasLock(camerasMutex);
+                    for (auto& camera : cameras) {
+                        camera.second->device->fireSoftwareTrigger();
+                    }
+                }
+
+                // Keep to the schedule, but don't try to catch up on triggers we were too late for
+                next = std::max(next + period, std::chrono::steady_clock::now());
+                triggerWait.wait_until(lock, next, [this] { return !triggering; });
+            }
+        }
+
+    }  // input
+}  // modules
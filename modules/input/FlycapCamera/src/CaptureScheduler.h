@@ -0,0 +1,175 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_CAPTURESCHEDULER_H
+#define MODULES_INPUT_CAPTURESCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <nuclear>
+
+#include "messages/input/CameraFrameSet.h"
+#include "messages/input/CaptureStatistics.h"
+#include "utility/image/FramePool.h"
+#include "FlycapDevice.h"
+#include "FrameSetMatcher.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief Captures from a group of cameras, each on its own thread, and keeps them in step.
+         *
+         * @details
+         *  Every camera has a thread that blocks until the camera delivers a frame. The thread copies the frame into a
+         *  pooled buffer and hands it to onFrame straight away. So a camera is never held up waiting for a timer or
+         *  for the other cameras.
+         *
+         *  The cameras are either free running, software triggered (by our own thread, at the synchronised
+         *  framerate), or hardware triggered by a shared signal. The frames are also matched up by timestamp into
+         *  sets, which go to onFrameSet after the last of their frames has gone to onFrame.
+         */
+        class CaptureScheduler {
+        public:
+            /// @brief A frame copied out of the camera, with the function that gives its buffer back to the pool
+            struct Capture {
+                uint cameraID;
+                uint width;
+                uint height;
+                uint32_t sequence;
+                NUClear::clock::time_point timestamp;
+                std::vector<uint8_t> data;
+                std::function<void (std::vector<uint8_t>&&)> recycle;
+            };
+
+            /// @brief How the cameras are kept in step
+            struct Synchronisation {
+                FlycapDevice::Trigger trigger;
+                /// @brief how often to fire software triggers
+                double framerate;
+                /// @brief the GPIO pin hardware triggers come in on
+                uint source;
+                /// @brief how far apart frames can be captured and still be in the same set
+                NUClear::clock::duration tolerance;
+            };
+
+            /// @brief How long a capture thread waits for a frame before checking whether it should stop
+            static constexpr std::chrono::milliseconds RETRIEVE_TIMEOUT = std::chrono::milliseconds(100);
+
+            /**
+             * @param poolSize   how many frame buffers to keep for reuse
+             * @param onFrame    called on the camera's thread with each frame
+             * @param onFrameSet called on the thread of the camera that completed the set
+             */
+            CaptureScheduler(size_t poolSize
+                , std::function<void (Capture&&)> onFrame
+                , std::function<void (std::unique_ptr<messages::input::CameraFrameSet>&&)> onFrameSet);
+
+            ~CaptureScheduler();
+
+            /**
+             * @brief Changes how the cameras are triggered and matched, pausing them while they are changed over
+             */
+            void synchronise(const Synchronisation& synchronisation);
+
+            /**
+             * @brief Starts capturing from an open device, replacing any camera that already had this id
+             */
+            void addCamera(uint cameraID, std::shared_ptr<FlycapDevice> device);
+
+            /**
+             * @brief Stops capturing from a camera and gives back its device (still open)
+             */
+            std::shared_ptr<FlycapDevice> removeCamera(uint cameraID);
+
+            /**
+             * @brief Stops capturing from every camera and closes them
+             */
+            void stop();
+
+            /**
+             * @brief Gets each camera's statistics since the last call and starts gathering afresh
+             */
+            std::vector<std::unique_ptr<messages::input::CaptureStatistics>> takeStatistics();
+
+            /// @brief How many frames could not be matched into a set
+            uint64_t getUnmatched();
+
+        private:
+            struct Camera {
+                uint cameraID;
+                std::shared_ptr<FlycapDevice> device;
+                std::thread thread;
+                std::atomic<bool> running;
+
+                bool haveSequence;
+                uint32_t lastSequence;
+
+                std::mutex statisticsMutex;
+                uint64_t frames;
+                uint64_t dropped;
+                uint64_t corrupt;
+                uint64_t allocations;
+                double totalLatency;
+                double maxLatency;
+            };
+
+            /// @brief The body of each camera's thread
+            void capture(Camera& camera);
+
+            /// @brief The body of the software trigger thread
+            void fireTriggers();
+
+            void startCamera(Camera& camera);
+            void stopCamera(Camera& camera);
+            void startTriggers();
+            void stopTriggers();
+
+            /// @brief Starts matching sets for the current cameras (with camerasMutex held)
+            void resetMatcher();
+
+            std::function<void (Capture&&)> onFrame;
+            std::function<void (std::unique_ptr<messages::input::CameraFrameSet>&&)> onFrameSet;
+
+            utility::image::FramePool pool;
+
+            /// @brief Held while the cameras are added, removed or triggered
+            std::mutex camerasMutex;
+            std::map<uint, std::unique_ptr<Camera>> cameras;
+            Synchronisation synchronisation;
+
+            std::mutex triggerMutex;
+            std::condition_variable triggerWait;
+            std::thread triggerThread;
+            bool triggering;
+
+            std::mutex matcherMutex;
+            FrameSetMatcher matcher;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_CAPTURESCHEDULER_H
@@ -0,0 +1,246 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "FlyCapture2Device.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+namespace modules {
+    namespace input {
+
+        namespace {
+
+            // The camera's software trigger register, the top bit is set until it is ready for another trigger
+            constexpr unsigned int SOFTWARE_TRIGGER = 0x62C;
+
+            void check(const FlyCapture2::Error& error, const std::string& what) {
+                if (error != FlyCapture2::PGRERROR_OK) {
+                    throw std::runtime_error(what + ": " + error.GetDescription());
+                }
+            }
+
+            // Rounds value down to a multiple of step (which the SDK reports as 0 when anything goes)
+            unsigned int align(unsigned int value, unsigned int step) {
+                return step == 0 ? value : value / step * step;
+            }
+
+            const std::map<std::string, FlyCapture2::PropertyType> PROPERTIES = {
+                { "brightness",    FlyCapture2::BRIGHTNESS    },
+                { "auto_exposure", FlyCapture2::AUTO_EXPOSURE },
+                { "white_balance", FlyCapture2::WHITE_BALANCE },
+                { "gamma",         FlyCapture2::GAMMA         },
+                { "pan",           FlyCapture2::PAN           },
+                { "tilt",          FlyCapture2::TILT          },
+                { "shutter",       FlyCapture2::SHUTTER       },
+                { "gain",          FlyCapture2::GAIN          },
+                { "temperature",   FlyCapture2::TEMPERATURE   }
+            };
+        }
+
+        FlyCapture2Device::FlyCapture2Device()
+            : camera()
+            , image()
+            , serial(0)
+            , settings()
+            , capturing(false)
+            , softwareTriggered(false)
+            , frameCounter(false)
+            , grabTimeout(0) {
+        }
+
+        void FlyCapture2Device::open(uint serial, const Settings& settings) {
+
+            // Find the physical camera to connect to
+            FlyCapture2::PGRGuid id;
+            check(FlyCapture2::BusManager().GetCameraFromSerialNumber(serial, &id), "Failed to find camera " + std::to_string(serial));
+            check(camera.Connect(&id), "Failed to connect to camera, did you run as sudo?");
+
+            this->serial = serial;
+            this->settings = settings;
+
+            // Capture raw bayer in the middle of the sensor
+            FlyCapture2::Format7Info info;
+            bool supported = false;
+            info.mode = FlyCapture2::MODE_0;
+            check(camera.GetFormat7Info(&info, &supported), "Failed to get the format7 modes");
+            if (!supported || settings.width > info.maxWidth || settings.height > info.maxHeight) {
+                throw std::runtime_error("The camera can not capture " + std::to_string(settings.width) + "x" + std::to_string(settings.height));
+            }
+
+            FlyCapture2::Format7ImageSettings format;
+            format.mode = FlyCapture2::MODE_0;
+            format.width = align(settings.width, info.imageHStepSize);
+            format.height = align(settings.height, info.imageVStepSize);
+            format.offsetX = align((info.maxWidth - format.width) / 2, info.offsetHStepSize);
+            format.offsetY = align((info.maxHeight - format.height) / 2, info.offsetVStepSize);
+            format.pixelFormat = FlyCapture2::PIXEL_FORMAT_RAW8;
+
+            bool valid = false;
+            FlyCapture2::Format7PacketInfo packet;
+            check(camera.ValidateFormat7Settings(&format, &valid, &packet), "Failed to validate the format");
+            if (!valid) {
+                throw std::runtime_error("The camera rejected the format");
+            }
+            check(camera.SetFormat7Configuration(&format, packet.recommendedBytesPerPacket), "Failed to set the format");
+
+            this->settings.width = format.width;
+            this->settings.height = format.height;
+
+            // Run at an absolute frame rate rather than the fixed ones
+            FlyCapture2::Property rate;
+            rate.type = FlyCapture2::FRAME_RATE;
+            camera.GetProperty(&rate);
+            rate.onOff = true;
+            rate.autoManualMode = false;
+            rate.absControl = true;
+            rate.absValue = float(settings.framerate);
+            check(camera.SetProperty(&rate), "Failed to set the framerate");
+
+            // Put the camera's frame counter in the first pixels of each frame
+            FlyCapture2::EmbeddedImageInfo embedded;
+            camera.GetEmbeddedImageInfo(&embedded);
+            embedded.frameCounter.onOff = embedded.frameCounter.available;
+            embedded.timestamp.onOff = embedded.timestamp.available;
+            camera.SetEmbeddedImageInfo(&embedded);
+            frameCounter = embedded.frameCounter.available;
+
+            FlyCapture2::FC2Config config;
+            camera.GetConfiguration(&config);
+            config.numBuffers = settings.buffers;
+            config.grabMode = FlyCapture2::DROP_FRAMES;
+            config.highPerformanceRetrieveBuffer = true;
+            config.grabTimeout = 100;
+            check(camera.SetConfiguration(&config), "Failed to set the buffers");
+            grabTimeout = std::chrono::milliseconds(config.grabTimeout);
+        }
+
+        void FlyCapture2Device::setTrigger(Trigger trigger, uint source) {
+
+            FlyCapture2::TriggerMode mode;
+            camera.GetTriggerMode(&mode);
+            mode.onOff = trigger != Trigger::FREE_RUNNING;
+            mode.mode = 0;
+            mode.parameter = 0;
+            // Source 7 is the software trigger
+            mode.source = trigger == Trigger::SOFTWARE ? 7 : source;
+            check(camera.SetTriggerMode(&mode), "Failed to set the trigger mode");
+
+            softwareTriggered = trigger == Trigger::SOFTWARE;
+        }
+
+        bool FlyCapture2Device::setProperty(const std::string& name, const Property& property) {
+
+            auto type = PROPERTIES.find(name);
+            if (type == PROPERTIES.end()) {
+                return false;
+            }
+
+            FlyCapture2::Property p;
+            p.type = type->second;
+            camera.GetProperty(&p);
+            p.onOff = property.onOff;
+            p.autoManualMode = property.autoManualMode;
+            p.absControl = property.absControl;
+            p.valueA = property.valueA;
+            p.valueB = property.valueB;
+            p.absValue = property.absValue;
+
+            return camera.SetProperty(&p) == FlyCapture2::PGRERROR_OK;
+        }
+
+        void FlyCapture2Device::startCapture() {
+            check(camera.StartCapture(), "Failed to start capturing");
+            capturing = true;
+        }
+
+        void FlyCapture2Device::stopCapture() {
+            if (capturing) {
+                camera.StopCapture();
+                capturing = false;
+            }
+        }
+
+        bool FlyCapture2Device::retrieve(Frame& frame, const std::chrono::milliseconds& timeout) {
+
+            if (timeout != grabTimeout) {
+                FlyCapture2::FC2Config config;
+                camera.GetConfiguration(&config);
+                config.grabTimeout = int(timeout.count());
+                camera.SetConfiguration(&config);
+                grabTimeout = timeout;
+            }
+
+            // This blocks until the camera has a frame for us
+            FlyCapture2::Error error = camera.RetrieveBuffer(&image);
+            if (error != FlyCapture2::PGRERROR_OK) {
+                return false;
+            }
+
+            // FlyCapture stamps the frame with the system clock when it arrived, move that onto the steady clock
+            FlyCapture2::TimeStamp stamp = image.GetTimeStamp();
+            auto arrived = std::chrono::system_clock::time_point(std::chrono::seconds(stamp.seconds) + std::chrono::microseconds(stamp.microSeconds));
+            auto age = std::max(std::chrono::system_clock::now() - arrived, std::chrono::system_clock::duration::zero());
+
+            frame.data = image.GetData();
+            frame.bytes = image.GetDataSize();
+            frame.width = image.GetCols();
+            frame.height = image.GetRows();
+            frame.sequence = image.GetMetadata().embeddedFrameCounter;
+            frame.hasSequence = frameCounter;
+            frame.timestamp = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+
+            return true;
+        }
+
+        void FlyCapture2Device::fireSoftwareTrigger() {
+
+            if (!softwareTriggered) {
+                return;
+            }
+
+            // Wait (briefly) for the camera to finish the last frame, otherwise it ignores the trigger
+            auto giveUp = std::chrono::steady_clock::now() + grabTimeout;
+            unsigned int value = 0;
+            do {
+                if (camera.ReadRegister(SOFTWARE_TRIGGER, &value) != FlyCapture2::PGRERROR_OK) {
+                    return;
+                }
+            } while ((value >> 31) != 0 && std::chrono::steady_clock::now() < giveUp);
+
+            camera.FireSoftwareTrigger();
+        }
+
+        void FlyCapture2Device::close() {
+            stopCapture();
+            camera.Disconnect();
+        }
+
+        uint FlyCapture2Device::getSerial() const {
+            return serial;
+        }
+
+        const FlycapDevice::Settings& FlyCapture2Device::getSettings() const {
+            return settings;
+        }
+
+    }  // input
+}  // modules
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FLYCAPTURE2DEVICE_H
+#define MODULES_INPUT_FLYCAPTURE2DEVICE_H
+
+#include <flycapture/FlyCapture2.h>
+
+#include "FlycapDevice.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief A Point Grey camera driven through the FlyCapture2 SDK.
+         *
+         * @details
+         *  The camera captures raw bayer frames through Format7 mode 0 at the requested resolution. The image is
+         *  centred on the sensor and it uses an absolute frame rate. The camera's embedded frame counter is
+         *  turned on so we can tell when frames are dropped.
+         */
+        class FlyCapture2Device : public FlycapDevice {
+        public:
+            FlyCapture2Device();
+
+            void open(uint serial, const Settings& settings) override;
+            void setTrigger(Trigger trigger, uint source) override;
+            bool setProperty(const std::string& name, const Property& property) override;
+            void startCapture() override;
+            void stopCapture() override;
+            bool retrieve(Frame& frame, const std::chrono::milliseconds& timeout) override;
+            void fireSoftwareTrigger() override;
+            void close() override;
+
+            uint getSerial() const override;
+            const Settings& getSettings() const override;
+
+        private:
+            FlyCapture2::Camera camera;
+            /// @brief the last frame we retrieved, FlyCapture keeps its data until the next retrieve
+            FlyCapture2::Image image;
+
+            uint serial;
+            Settings settings;
+            bool capturing;
+            bool softwareTriggered;
+            /// @brief if the camera is embedding its frame counter in each frame
+            bool frameCounter;
+            std::chrono::milliseconds grabTimeout;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FLYCAPTURE2DEVICE_H
@@ -19,145 +19,175 @@
 
 #include "FlycapCamera.h"
 
-#include "utility/image/ColorModelConversions.h"
-#include "messages/support/Configuration.h"
-#include "CamCallbacks.h"
+#include "messages/input/CameraFrameSet.h"
+#include "messages/input/CaptureStatistics.h"
+#include "FlyCapture2Device.h"
 
 namespace modules
 {
 namespace input
 {
 
+using messages::input::Image;
+using messages::input::CameraFrameSet;
 using messages::support::Configuration;
 
-FlycapCamera::FlycapCamera(std::unique_ptr<NUClear::Environment> environment) : Reactor(std::move(environment))
+FlycapCamera::FlycapCamera(std::unique_ptr<NUClear::Environment> environment)
+    : Reactor(std::move(environment))
+    , cameras()
+    , camerasMutex()
+    , lenses()
+    , lensMutex()
+    , triggerLine()
+    , triggerRate(30)
+    , scheduler(POOL_SIZE
+        , [this](CaptureScheduler::Capture&& capture)
+        {
+            // Based on what camera this is, emit it as that camera's image
+            switch(capture.cameraID) {
+                case 0:
+                    emitImage<0>(std::move(capture));
+                    break;
+                case 1:
+                    emitImage<1>(std::move(capture));
+                    break;
+                case 2:
+                    emitImage<2>(std::move(capture));
+                    break;
+                case 3:
+                    emitImage<3>(std::move(capture));
+                    break;
+                default:
+                    capture.recycle(std::move(capture.data));
+                    break;
+            }
+        }
+        , [this](std::unique_ptr<CameraFrameSet>&& set)
+        {
+            emit(std::move(set));
+        })
 {
 
-    // When we shutdown, we must tell our camera class to close (stop streaming)
+    // When we shutdown, we must tell our cameras to stop streaming and close
     on<Trigger<Shutdown>>([this](const Shutdown &)
     {
-
-        // Stop streaming somehow
-        // for (auto& camera: cameras) {
-        //     camera.closeCamera();
-        // }
+        std::lock_guard<std::mutex> lock(camerasMutex);
+        scheduler.stop();
+        cameras.clear();
     });
 
-    on<Trigger<Configuration<FlycapCamera>>>([this](const Configuration<FlycapCamera> &config)
+    on<Trigger<Configuration<FlycapSynchronisation>>>([this](const Configuration<FlycapSynchronisation> &config)
     {
-        try
-        {
-            // Try to find our camera
-            uint deviceId = config["device_id"].as<int>();
-            auto camera = cameras.find(deviceId);
+        CaptureScheduler::Synchronisation synchronisation;
 
-            // If we don't have a camera then make a new one
-            if (camera == cameras.end()) {
+        std::string trigger = config["trigger"].as<std::string>();
+        if (trigger == "SOFTWARE") {
+            synchronisation.trigger = FlycapDevice::Trigger::SOFTWARE;
+        }
+        else if (trigger == "HARDWARE") {
+            synchronisation.trigger = FlycapDevice::Trigger::HARDWARE;
+        }
+        else if (trigger == "FREE_RUNNING") {
+            synchronisation.trigger = FlycapDevice::Trigger::FREE_RUNNING;
+        }
+        else {
+            throw std::runtime_error("Unknown camera trigger " + trigger);
+        }
 
-                // Stop all the cameras streaming
-                for (auto &cam : cameras) {
-                    cam.second.second->StopCapture();
-                }
+        synchronisation.framerate = config["framerate"].as<double>();
+        synchronisation.source = config["hardware_trigger_source"].as<uint>();
+        synchronisation.tolerance = std::chrono::duration_cast<NUClear::clock::duration>(
+            std::chrono::duration<double, std::milli>(config["tolerance"].as<double>()));
 
-                // Make a new camera
-                auto newCam = std::make_unique<FlyCapture2::Camera>();
+        // The mock cameras' trigger wire pulses at the rate the real one would
+        {
+            std::lock_guard<std::mutex> lock(camerasMutex);
+            triggerRate = synchronisation.framerate;
+            if (triggerLine) {
+                triggerLine->setRate(triggerRate);
+            }
+        }
 
-                // Find the physical camera to connect to
-                FlyCapture2::PGRGuid id;
-                FlyCapture2::BusManager().GetCameraFromSerialNumber(deviceId, &id);
-                FlyCapture2::Error error = newCam->Connect(&id);
+        scheduler.synchronise(synchronisation);
+    });
 
-                if (error != FlyCapture2::PGRERROR_OK) {
-                    throw std::system_error(errno, std::system_category(), "Failed to connect to camera, did you run as sudo?");
+    on<Trigger<Configuration<FlycapCamera>>>([this](const Configuration<FlycapCamera> &config)
+    {
+        try
+        {
+            uint serial = config["device_id"].as<uint>();
+            uint cameraID = config["camera_id"].as<uint>();
+            std::string backend = config["backend"].as<std::string>();
+
+            FlycapDevice::Settings settings;
+            settings.width = config["image_width"].as<uint>();
+            settings.height = config["image_height"].as<uint>();
+            settings.framerate = config["framerate"].as<double>();
+            settings.buffers = config["buffers"].as<uint>();
+
+            std::lock_guard<std::mutex> lock(camerasMutex);
+
+            auto& camera = cameras[serial];
+            bool opened = false;
+
+            // Reopen the camera if anything that is fixed while it is open has changed
+            if (!camera.device
+                || camera.cameraID != cameraID
+                || camera.backend != backend
+                || camera.device->getSettings().width != settings.width
+                || camera.device->getSettings().height != settings.height
+                || camera.device->getSettings().framerate != settings.framerate
+                || camera.device->getSettings().buffers != settings.buffers) {
+
+                if (camera.device) {
+                    scheduler.removeCamera(camera.cameraID);
+                    camera.device->close();
+                    camera.device.reset();
                 }
 
-                // Set our camera settings
-                error = newCam->SetVideoModeAndFrameRate(FlyCapture2::VIDEOMODE_1280x960Y8, FlyCapture2::FRAMERATE_3_75);
-                if (error != FlyCapture2::PGRERROR_OK) {
-                    throw std::system_error(errno, std::system_category(), "Failed to set the format or framerate");
+                std::shared_ptr<FlycapDevice> device;
+                if (backend == "flycapture") {
+                    device = std::make_shared<FlyCapture2Device>();
+                }
+                else if (backend == "mock") {
+                    // Only mock cameras need a pretend trigger wire, so it is made for the first one
+                    if (!triggerLine) {
+                        triggerLine = std::make_shared<MockTriggerLine>(triggerRate);
+                    }
+                    device = std::make_shared<MockFlycapDevice>(triggerLine, std::chrono::microseconds(config["mock_jitter"].as<uint>()));
+                }
+                else {
+                    throw std::runtime_error("Unknown camera backend " + backend);
                 }
 
-                // Insert our new camera
-                camera = cameras.insert(std::make_pair(deviceId, std::make_pair(Image<0>::Lens(), std::move(newCam)))).first;
+                device->open(serial, settings);
 
-                // Stop all the cameras streaming
-                for (auto &cam : cameras) {
-                    cam.second.second->StartCapture();
-                }
+                camera.cameraID = cameraID;
+                camera.backend = backend;
+                camera.device = device;
+                opened = true;
             }
 
-            auto& cam = *camera->second.second;
-            auto& lens = camera->second.first;
+            {
+                std::lock_guard<std::mutex> lensLock(lensMutex);
+                auto& lens = lenses[cameraID];
 
-            if(config["lens"]["type"].as<std::string>() == "RADIAL") {
-                lens.type = Image<0>::Lens::Type::RADIAL;
-                lens.parameters.radial.fov = config["lens"]["fov"].as<double>();
-                lens.parameters.radial.pitch = config["lens"]["pixel_pitch"].as<double>();
-                lens.parameters.radial.centre[0] = config["lens"]["image_centre"][0].as<double>();
-                lens.parameters.radial.centre[1] = config["lens"]["image_centre"][1].as<double>();
-                lens.cameraID = config["camera_id"].as<uint>();
+                if(config["lens"]["type"].as<std::string>() == "RADIAL") {
+                    lens.type = Image<0>::Lens::Type::RADIAL;
+                    lens.parameters.radial.fov = config["lens"]["fov"].as<double>();
+                    lens.parameters.radial.pitch = config["lens"]["pixel_pitch"].as<double>();
+                    lens.parameters.radial.centre[0] = config["lens"]["image_centre"][0].as<double>();
+                    lens.parameters.radial.centre[1] = config["lens"]["image_centre"][1].as<double>();
+                }
+                lens.cameraID = cameraID;
             }
 
-            FlyCapture2::Property p;
-            p.type = FlyCapture2::BRIGHTNESS;
-            cam.GetProperty(&p);
-            p.onOff = true;
-            p.valueA = config["brightness"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::AUTO_EXPOSURE;
-            cam.GetProperty(&p);
-            p.onOff = config["auto_exposure"].as<bool>();
-            p.absValue = config["auto_exposure_val"].as<float>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::WHITE_BALANCE;
-            cam.GetProperty(&p);
-            p.valueA = config["white_balance_temperature_red"].as<unsigned int>();
-            p.valueB = config["white_balance_temperature_blue"].as<unsigned int>();
-            p.onOff = config["auto_white_balance"].as<bool>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::GAMMA;
-            cam.GetProperty(&p);
-            p.onOff = true;
-            p.valueA = config["gamma"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::PAN;
-            cam.GetProperty(&p);
-            p.valueA = config["absolute_pan"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::TILT;
-            cam.GetProperty(&p);
-            p.valueA = config["absolute_tilt"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::SHUTTER;
-            cam.GetProperty(&p);
-            p.valueA = config["absolute_exposure"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::GAIN;
-            cam.GetProperty(&p);
-            p.autoManualMode = config["gain_auto"].as<bool>();
-            p.valueA = config["gain"].as<unsigned int>();
-            cam.SetProperty(&p);
-
-            p.type = FlyCapture2::TEMPERATURE;
-            cam.GetProperty(&p);
-            p.valueA = config["white_balance_temperature_red"].as<unsigned int>();
-            p.valueB = config["white_balance_temperature_blue"].as<unsigned int>();
-            p.onOff = config["auto_white_balance"].as<bool>();
-            cam.SetProperty(&p);
-
-            FlyCapture2::FC2Config camConf;
-            cam.GetConfiguration(&camConf);
-            camConf.numBuffers = 3;
-            camConf.highPerformanceRetrieveBuffer = true;
-            camConf.grabTimeout = 500;
-            cam.SetConfiguration(&camConf);
+            applyProperties(*camera.device, config);
+
+            // Start capturing once it is set up
+            if (opened) {
+                scheduler.addCamera(cameraID, camera.device);
+            }
         }
         catch (const std::exception &e) {
             NUClear::log<NUClear::DEBUG>(std::string("Exception while starting camera streaming: ") + e.what());
@@ -165,40 +195,89 @@ FlycapCamera::FlycapCamera(std::unique_ptr<NUClear::Environment> environment) :
         }
     });
 
-    on<Trigger<Every<225, Per<std::chrono::minutes>>>, Options<Single>>([this](const time_t&) {
-
-        FlyCapture2::Image image;
-
-        for(const auto& camera : cameras) {
-            auto& cam = *camera.second.second;
-            auto& lens = camera.second.first;
-
-            cam.RetrieveBuffer(&image);
-
-            auto img = std::make_unique<Image<0>>(captureBayer(image));
-            img->lens = lens;
-
-            // Based on what camera this is, cast Image to another type and emit (WOW! MUCH BAD! VERY HACK!)
-
-            switch(lens.cameraID) {
-                case 0:
-                    emit(std::unique_ptr<Image<0>>(reinterpret_cast<Image<0>*>(img.release())));
-                    break;
-                case 1:
-                    emit(std::unique_ptr<Image<1>>(reinterpret_cast<Image<1>*>(img.release())));
-                    break;
-                case 2:
-                    emit(std::unique_ptr<Image<2>>(reinterpret_cast<Image<2>*>(img.release())));
-                    break;
-                case 3:
-                    emit(std::unique_ptr<Image<3>>(reinterpret_cast<Image<3>*>(img.release())));
-                    break;
-            }
-
-            emit(std::move(img));
+    // Report how well each camera is keeping up
+    on<Trigger<Every<1, std::chrono::seconds>>>("Camera Statistics", [this] (const time_t&)
+    {
+        for (auto& statistics : scheduler.takeStatistics()) {
+            emit(std::move(statistics));
         }
     });
 }
 
+template <int camID>
+void FlycapCamera::emitImage(CaptureScheduler::Capture&& capture)
+{
+    auto image = std::make_unique<Image<camID>>();
+    image->timestamp = capture.timestamp;
+    image->format = Image<camID>::SourceFormat::BGGR;
+    image->dimensions = { capture.width, capture.height };
+    image->source = std::move(capture.data);
+    image->recycle = std::move(capture.recycle);
+
+    // Each camera's image has its own Lens type, so copy ours across a field at a time
+    // (radial is the largest member of the parameters so copying it copies an equirectangular lens too)
+    {
+        std::lock_guard<std::mutex> lock(lensMutex);
+        const auto& lens = lenses[camID];
+
+        image->lens.type = static_cast<typename Image<camID>::Lens::Type>(lens.type);
+        image->lens.parameters.radial.fov = lens.parameters.radial.fov;
+        image->lens.parameters.radial.pitch = lens.parameters.radial.pitch;
+        image->lens.parameters.radial.centre[0] = lens.parameters.radial.centre[0];
+        image->lens.parameters.radial.centre[1] = lens.parameters.radial.centre[1];
+        image->lens.cameraID = lens.cameraID;
+    }
+
+    emit(std::move(image));
+}
+
+void FlycapCamera::applyProperties(FlycapDevice& device, const Configuration<FlycapCamera>& config)
+{
+    FlycapDevice::Property p = { false, false, false, 0, 0, 0 };
+
+    p.onOff = true;
+    p.valueA = config["brightness"].as<unsigned int>();
+    device.setProperty("brightness", p);
+
+    p = { false, false, true, 0, 0, 0 };
+    p.onOff = config["auto_exposure"].as<bool>();
+    p.absValue = config["auto_exposure_val"].as<float>();
+    device.setProperty("auto_exposure", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.valueA = config["white_balance_temperature_red"].as<unsigned int>();
+    p.valueB = config["white_balance_temperature_blue"].as<unsigned int>();
+    p.onOff = config["auto_white_balance"].as<bool>();
+    device.setProperty("white_balance", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.onOff = true;
+    p.valueA = config["gamma"].as<unsigned int>();
+    device.setProperty("gamma", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.valueA = config["absolute_pan"].as<unsigned int>();
+    device.setProperty("pan", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.valueA = config["absolute_tilt"].as<unsigned int>();
+    device.setProperty("tilt", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.valueA = config["absolute_exposure"].as<unsigned int>();
+    device.setProperty("shutter", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.autoManualMode = config["gain_auto"].as<bool>();
+    p.valueA = config["gain"].as<unsigned int>();
+    device.setProperty("gain", p);
+
+    p = { false, false, false, 0, 0, 0 };
+    p.valueA = config["white_balance_temperature_red"].as<unsigned int>();
+    p.valueB = config["white_balance_temperature_blue"].as<unsigned int>();
+    p.onOff = config["auto_white_balance"].as<bool>();
+    device.setProperty("temperature", p);
+}
+
 }  // input
 }  // modules
@@ -21,19 +21,33 @@
 #define MODULES_INPUT_FLYCAPCAMERA_H
 
 #include <nuclear>
-#include <flycapture/FlyCapture2.h>
+#include <map>
+#include <mutex>
+#include <string>
+
 #include "messages/input/Image.h"
+#include "messages/support/Configuration.h"
+#include "CaptureScheduler.h"
+#include "MockFlycapDevice.h"
 
 namespace modules {
     namespace input {
-        using messages::input::Image;
+
         /**
-         * @breif This module is responsible for reading data from the Darwin's Camera and emitting the resulting images.
+         * @brief How the Flycap cameras are triggered and matched into sets
+         */
+        struct FlycapSynchronisation {
+            static constexpr const char* CONFIGURATION_PATH = "FlycapSynchronisation.yaml";
+        };
+
+        /**
+         * @breif This module is responsible for reading data from the Point Grey cameras and emitting the resulting images.
          *
          * @details
-         *    This Reactor uses it's DarwinCamera class in order to read a stream of images from the Darwin's camera and
-         *    emit them out to the rest of the system. It does this using the Video4Linux2 drivers that are built into
-         *    the kernel.
+         *    Each camera is read on its own thread by a CaptureScheduler, so the images are emitted as soon as each
+         *    camera has them. Each camera's images are emitted as Image<camera_id>. The cameras can be triggered
+         *    together by software or hardware, and once an image from every camera has been emitted for the same
+         *    instant a CameraFrameSet is emitted to tie them together.
          *
          * @author Josiah Walker
          * @author Trent Houliston
@@ -41,13 +55,45 @@ namespace modules {
         class FlycapCamera : public NUClear::Reactor {
 
         private:
-            /// @brief Our internal camera class that interacts with the physical device
-            std::map<uint, std::pair<messages::input::Image<0>::Lens, std::unique_ptr<FlyCapture2::Camera>>> cameras;
+            /// @brief A camera we have opened, along with how we opened it
+            struct Camera {
+                uint cameraID;
+                std::string backend;
+                std::shared_ptr<FlycapDevice> device;
+            };
+
+            /// @brief Our cameras by serial number
+            std::map<uint, Camera> cameras;
+
+            /// @brief Held while cameras are opened, closed or configured
+            std::mutex camerasMutex;
+
+            /// @brief The lens of each camera by camera id, read by the capture threads
+            std::map<uint, messages::input::Image<0>::Lens> lenses;
+            std::mutex lensMutex;
+
+            /// @brief The trigger wire shared by mock cameras when they are hardware triggered, null until one is opened
+            std::shared_ptr<MockTriggerLine> triggerLine;
+            /// @brief How fast the trigger wire pulses, from the synchronisation config
+            double triggerRate;
+
+            /// @brief Reads every camera on its own thread and matches their frames into sets
+            CaptureScheduler scheduler;
+
+            /// @brief Emits a captured frame as an image from camera camID
+            template <int camID>
+            void emitImage(CaptureScheduler::Capture&& capture);
+
+            /// @brief Sets the camera's properties from its configuration
+            void applyProperties(FlycapDevice& device, const messages::support::Configuration<FlycapCamera>& config);
 
         public:
             /// @brief Our configuration file for this class
             static constexpr const char* CONFIGURATION_PATH = "FlycapCameras";
 
+            /// @brief How many frame buffers we keep around for reuse between all the cameras
+            static constexpr size_t POOL_SIZE = 16;
+
             /// @brief Called by the PowerPlant to build and setup our Reactor
             FlycapCamera(std::unique_ptr<NUClear::Environment> environment);
         };
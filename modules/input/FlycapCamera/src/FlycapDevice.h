@@ -0,0 +1,131 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FLYCAPDEVICE_H
+#define MODULES_INPUT_FLYCAPDEVICE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief A FlyCapture camera, or something that behaves like one.
+         *
+         * @details
+         *  Each device is read by one capture thread which blocks in retrieve until the camera's next frame arrives.
+         *  Frames arrive when the camera is ready if it is free running, when fireSoftwareTrigger is called if it is
+         *  software triggered, or when a pulse arrives on its trigger input if it is hardware triggered. Properties
+         *  and triggers may be set from other threads while the capture thread is waiting.
+         */
+        class FlycapDevice {
+        public:
+            enum class Trigger {
+                FREE_RUNNING,
+                SOFTWARE,
+                HARDWARE
+            };
+
+            /// @brief What to capture, fixed for as long as the device is open
+            struct Settings {
+                uint width;
+                uint height;
+                /// @brief frames per second when free running
+                double framerate;
+                /// @brief how many frames the driver can hold for us before it has to drop one
+                uint buffers;
+            };
+
+            /// @brief A frame as the camera gave it to us
+            struct Frame {
+                /// @brief the raw bayer data (only valid until the next retrieve)
+                const uint8_t* data;
+                size_t bytes;
+                uint width;
+                uint height;
+                /// @brief the camera's frame counter, gaps mean frames were dropped
+                uint32_t sequence;
+                /// @brief false if the camera has no frame counter, so sequence means nothing
+                bool hasSequence;
+                /// @brief when the camera captured the frame
+                std::chrono::steady_clock::time_point timestamp;
+            };
+
+            /// @brief A camera property (brightness, gain, ...) the way FlyCapture describes them
+            struct Property {
+                bool onOff;
+                bool autoManualMode;
+                bool absControl;
+                uint valueA;
+                uint valueB;
+                float absValue;
+            };
+
+            virtual ~FlycapDevice() = default;
+
+            /**
+             * @brief Connects to the camera and sets it up to capture
+             *
+             * @param serial the camera's serial number
+             * @param settings the resolution, frame rate and buffering to capture with
+             */
+            virtual void open(uint serial, const Settings& settings) = 0;
+
+            /**
+             * @brief Sets what makes the camera take a frame
+             *
+             * @param trigger the kind of trigger
+             * @param source the GPIO pin a hardware trigger comes in on
+             */
+            virtual void setTrigger(Trigger trigger, uint source) = 0;
+
+            /**
+             * @brief Sets one of the camera's properties
+             *
+             * @return false if the camera does not have the property or would not take the value
+             */
+            virtual bool setProperty(const std::string& name, const Property& property) = 0;
+
+            virtual void startCapture() = 0;
+            virtual void stopCapture() = 0;
+
+            /**
+             * @brief Waits up to timeout for the camera's next frame
+             *
+             * @return true if frame was filled in, false if no frame arrived in time
+             */
+            virtual bool retrieve(Frame& frame, const std::chrono::milliseconds& timeout) = 0;
+
+            /**
+             * @brief Makes a software triggered camera take a frame
+             */
+            virtual void fireSoftwareTrigger() = 0;
+
+            virtual void close() = 0;
+
+            virtual uint getSerial() const = 0;
+            virtual const Settings& getSettings() const = 0;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FLYCAPDEVICE_H
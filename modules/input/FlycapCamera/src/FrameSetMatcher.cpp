@@ -0,0 +1,103 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "FrameSetMatcher.h"
+
+namespace modules {
+    namespace input {
+
+        using messages::input::CameraFrameSet;
+
+        constexpr size_t FrameSetMatcher::MAXIMUM_WAITING;
+
+        FrameSetMatcher::FrameSetMatcher()
+            : waiting()
+            , tolerance(NUClear::clock::duration::zero())
+            , sequence(0)
+            , unmatched(0) {
+        }
+
+        void FrameSetMatcher::reset(const std::vector<uint>& cameras, const NUClear::clock::duration& tolerance) {
+            waiting.clear();
+            for (auto& camera : cameras) {
+                waiting[camera];
+            }
+            this->tolerance = tolerance;
+        }
+
+        std::unique_ptr<CameraFrameSet> FrameSetMatcher::add(uint cameraID, uint32_t sequence, const NUClear::clock::time_point& timestamp) {
+
+            auto camera = waiting.find(cameraID);
+
+            // Frames from cameras that aren't in a set (or on their own) don't make sets
+            if (camera == waiting.end() || waiting.size() < 2) {
+                return nullptr;
+            }
+
+            camera->second.push_back({ cameraID, sequence, timestamp });
+            if (camera->second.size() > MAXIMUM_WAITING) {
+                camera->second.pop_front();
+                ++unmatched;
+            }
+
+            while (true) {
+                auto earliest = waiting.begin();
+                auto latest = waiting.begin();
+
+                for (auto it = waiting.begin(); it != waiting.end(); ++it) {
+                    if (it->second.empty()) {
+                        return nullptr;
+                    }
+                    if (it->second.front().timestamp < earliest->second.front().timestamp) {
+                        earliest = it;
+                    }
+                    if (it->second.front().timestamp > latest->second.front().timestamp) {
+                        latest = it;
+                    }
+                }
+
+                const auto spread = latest->second.front().timestamp - earliest->second.front().timestamp;
+
+                if (spread <= tolerance) {
+                    auto set = std::make_unique<CameraFrameSet>();
+                    set->sequence = this->sequence++;
+                    set->timestamp = earliest->second.front().timestamp;
+                    set->spread = spread;
+                    set->frames.reserve(waiting.size());
+
+                    for (auto& frames : waiting) {
+                        set->frames.push_back(frames.second.front());
+                        frames.second.pop_front();
+                    }
+
+                    return set;
+                }
+
+                // Everyone else is past this frame so nothing can match it
+                earliest->second.pop_front();
+                ++unmatched;
+            }
+        }
+
+        uint64_t FrameSetMatcher::getUnmatched() const {
+            return unmatched;
+        }
+
+    }  // input
+}  // modules
@@ -0,0 +1,77 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FRAMESETMATCHER_H
+#define MODULES_INPUT_FRAMESETMATCHER_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+#include <nuclear>
+
+#include "messages/input/CameraFrameSet.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief Groups frames from several cameras into sets that were captured at the same time.
+         *
+         * @details
+         *  Frames wait in a queue per camera. Whenever every camera has a frame waiting, the oldest frame of each
+         *  camera is checked. If they are all within the tolerance of each other they become a set. Otherwise the
+         *  earliest of them can never be in a set (every other camera has moved past it) so it is discarded. A camera
+         *  that stops sending frames only holds up the others for MAXIMUM_WAITING frames.
+         *
+         *  This is not thread safe, callers adding frames from several threads must lock around it.
+         */
+        class FrameSetMatcher {
+        public:
+            /// @brief How many frames a camera can have waiting before its oldest is discarded
+            static constexpr size_t MAXIMUM_WAITING = 8;
+
+            FrameSetMatcher();
+
+            /**
+             * @brief Sets which cameras make up a set and how far apart their frames can be, and forgets waiting frames
+             */
+            void reset(const std::vector<uint>& cameras, const NUClear::clock::duration& tolerance);
+
+            /**
+             * @brief Adds a frame from a camera
+             *
+             * @return the set this frame completed, or nullptr if it didn't complete one
+             */
+            std::unique_ptr<messages::input::CameraFrameSet> add(uint cameraID, uint32_t sequence, const NUClear::clock::time_point& timestamp);
+
+            /// @brief How many frames have been discarded because they didn't match any others
+            uint64_t getUnmatched() const;
+
+        private:
+            std::map<uint, std::deque<messages::input::CameraFrameSet::Frame>> waiting;
+            NUClear::clock::duration tolerance;
+            uint64_t sequence;
+            uint64_t unmatched;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FRAMESETMATCHER_H
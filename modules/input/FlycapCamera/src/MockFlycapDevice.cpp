@@ -0,0 +1,212 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "MockFlycapDevice.h"
+
+#include <thread>
+
+namespace modules {
+    namespace input {
+
+        using std::chrono::steady_clock;
+
+        constexpr std::chrono::microseconds MockFlycapDevice::EXPOSURE;
+
+        MockTriggerLine::MockTriggerLine(double rate)
+            : mutex()
+            , epoch(steady_clock::now())
+            , period(std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(1.0 / rate))) {
+        }
+
+        void MockTriggerLine::setRate(double rate) {
+            std::lock_guard<std::mutex> lock(mutex);
+            period = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+        }
+
+        steady_clock::time_point MockTriggerLine::next(const steady_clock::time_point& time) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return epoch + ((time - epoch) / period + 1) * period;
+        }
+
+        steady_clock::time_point MockTriggerLine::previous(const steady_clock::time_point& time) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return epoch + ((time - epoch) / period) * period;
+        }
+
+        steady_clock::duration MockTriggerLine::getPeriod() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return period;
+        }
+
+        MockFlycapDevice::MockFlycapDevice(std::shared_ptr<const MockTriggerLine> line, const std::chrono::microseconds& jitter)
+            : mutex()
+            , triggered()
+            , line(line)
+            , jitter(jitter)
+            , random(std::random_device()())
+            , serial(0)
+            , settings()
+            , trigger(Trigger::FREE_RUNNING)
+            , capturing(false)
+            , buffer()
+            , sequence(0)
+            , lastFrame()
+            , triggers()
+            , properties() {
+        }
+
+        void MockFlycapDevice::open(uint serial, const Settings& settings) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            this->serial = serial;
+            this->settings = settings;
+
+            buffer.resize(settings.width * settings.height);
+            for (size_t i = 0; i < buffer.size(); ++i) {
+                buffer[i] = uint8_t(i % settings.width + i / settings.width);
+            }
+
+            // Free running cameras don't start in step with each other
+            std::uniform_real_distribution<double> phase(0, 1.0 / settings.framerate);
+            lastFrame = steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(phase(random)));
+        }
+
+        void MockFlycapDevice::setTrigger(Trigger trigger, uint) {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->trigger = trigger;
+            triggers.clear();
+        }
+
+        bool MockFlycapDevice::setProperty(const std::string& name, const Property& property) {
+            std::lock_guard<std::mutex> lock(mutex);
+            properties[name] = property;
+            return true;
+        }
+
+        void MockFlycapDevice::startCapture() {
+            std::lock_guard<std::mutex> lock(mutex);
+            capturing = true;
+        }
+
+        void MockFlycapDevice::stopCapture() {
+            std::lock_guard<std::mutex> lock(mutex);
+            capturing = false;
+            triggers.clear();
+        }
+
+        bool MockFlycapDevice::retrieve(Frame& frame, const std::chrono::milliseconds& timeout) {
+
+            const auto deadline = steady_clock::now() + timeout;
+            steady_clock::time_point due;
+            uint32_t skipped = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (!capturing) {
+                    lock.unlock();
+                    std::this_thread::sleep_until(deadline);
+                    return false;
+                }
+
+                if (trigger == Trigger::SOFTWARE) {
+                    if (!triggered.wait_until(lock, deadline, [this] { return !triggers.empty(); })) {
+                        return false;
+                    }
+                    due = triggers.front() + EXPOSURE;
+                    triggers.pop_front();
+                }
+                else {
+                    const auto period = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(1.0 / settings.framerate));
+                    const auto now = steady_clock::now();
+
+                    if (trigger == Trigger::HARDWARE && line) {
+                        // If we missed pulses the camera captured them and overwrote them, so skip to the latest
+                        due = line->next(lastFrame);
+                        auto latest = line->previous(now);
+                        if (latest > due) {
+                            skipped = uint32_t((latest - due) / line->getPeriod());
+                            due = latest;
+                        }
+                    }
+                    else {
+                        due = lastFrame + period;
+                        if (now - due > period) {
+                            skipped = uint32_t((now - due) / period);
+                            due += skipped * period;
+                        }
+                    }
+                }
+
+                if (due > deadline) {
+                    lock.unlock();
+                    std::this_thread::sleep_until(deadline);
+                    return false;
+                }
+
+                lastFrame = due;
+                sequence += skipped + 1;
+            }
+
+            std::uniform_int_distribution<int64_t> delay(0, jitter.count());
+            auto delivered = due + std::chrono::microseconds(delay(random));
+            std::this_thread::sleep_until(delivered);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < 4 && i < buffer.size(); ++i) {
+                buffer[i] = uint8_t(sequence >> (i * 8));
+            }
+
+            frame.data = buffer.data();
+            frame.bytes = buffer.size();
+            frame.width = settings.width;
+            frame.height = settings.height;
+            frame.sequence = sequence;
+            frame.hasSequence = true;
+            frame.timestamp = due;
+
+            return true;
+        }
+
+        void MockFlycapDevice::fireSoftwareTrigger() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (capturing && trigger == Trigger::SOFTWARE) {
+                triggers.push_back(steady_clock::now());
+                triggered.notify_one();
+            }
+        }
+
+        void MockFlycapDevice::close() {
+            stopCapture();
+        }
+
+        uint MockFlycapDevice::getSerial() const {
+            return serial;
+        }
+
+        const FlycapDevice::Settings& MockFlycapDevice::getSettings() const {
+            return settings;
+        }
+
+        std::map<std::string, FlycapDevice::Property> MockFlycapDevice::getProperties() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return properties;
+        }
+
+    }  // input
+}  // modules
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_MOCKFLYCAPDEVICE_H
+#define MODULES_INPUT_MOCKFLYCAPDEVICE_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "FlycapDevice.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief A square wave that hardware triggered mock cameras share, like the strobe wire between real ones
+         */
+        class MockTriggerLine {
+        public:
+            explicit MockTriggerLine(double rate);
+
+            void setRate(double rate);
+
+            /// @brief The first pulse after time
+            std::chrono::steady_clock::time_point next(const std::chrono::steady_clock::time_point& time) const;
+
+            /// @brief The last pulse at or before time
+            std::chrono::steady_clock::time_point previous(const std::chrono::steady_clock::time_point& time) const;
+
+            std::chrono::steady_clock::duration getPeriod() const;
+
+        private:
+            mutable std::mutex mutex;
+            std::chrono::steady_clock::time_point epoch;
+            std::chrono::steady_clock::duration period;
+        };
+
+        /**
+         * @brief Generates frames the way a FlyCapture camera would, without one.
+         *
+         * @details
+         *  Free running it makes frames at the framerate it was opened with, starting at a random phase. Hardware
+         *  triggered it makes a frame on every pulse of its trigger line. Software triggered it makes one a short
+         *  exposure after each trigger. Like a real camera it skips frames nobody retrieved in time, which shows
+         *  up as gaps in the frame counter. Each frame is a gradient with the frame counter in its first four bytes.
+         */
+        class MockFlycapDevice : public FlycapDevice {
+        public:
+            /**
+             * @param line   the trigger line to follow when hardware triggered
+             * @param jitter how much later than the trigger each frame can be delivered
+             */
+            MockFlycapDevice(std::shared_ptr<const MockTriggerLine> line, const std::chrono::microseconds& jitter);
+
+            void open(uint serial, const Settings& settings) override;
+            void setTrigger(Trigger trigger, uint source) override;
+            bool setProperty(const std::string& name, const Property& property) override;
+            void startCapture() override;
+            void stopCapture() override;
+            bool retrieve(Frame& frame, const std::chrono::milliseconds& timeout) override;
+            void fireSoftwareTrigger() override;
+            void close() override;
+
+            uint getSerial() const override;
+            const Settings& getSettings() const override;
+
+            /// @brief The last value each property was set to
+            std::map<std::string, Property> getProperties() const;
+
+            /// @brief How long after a software trigger the frame is ready
+            static constexpr std::chrono::microseconds EXPOSURE = std::chrono::microseconds(1000);
+
+        private:
+            mutable std::mutex mutex;
+            std::condition_variable triggered;
+
+            std::shared_ptr<const MockTriggerLine> line;
+            std::chrono::microseconds jitter;
+            std::mt19937 random;
+
+            uint serial;
+            Settings settings;
+            Trigger trigger;
+            bool capturing;
+
+            std::vector<uint8_t> buffer;
+            uint32_t sequence;
+            std::chrono::steady_clock::time_point lastFrame;
+            std::deque<std::chrono::steady_clock::time_point> triggers;
+            std::map<std::string, Property> properties;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_MOCKFLYCAPDEVICE_H
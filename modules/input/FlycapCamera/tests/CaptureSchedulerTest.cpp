@@ -0,0 +1,305 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "CaptureScheduler.h"
+#include "FrameSetMatcher.h"
+#include "MockFlycapDevice.h"
+
+using messages::input::CameraFrameSet;
+using modules::input::CaptureScheduler;
+using modules::input::FlycapDevice;
+using modules::input::FrameSetMatcher;
+using modules::input::MockFlycapDevice;
+using modules::input::MockTriggerLine;
+
+namespace {
+
+    /*
+     * Runs a scheduler over some mock cameras and keeps everything it gives us
+     */
+    struct Recorder {
+        Recorder()
+            : scheduler(16
+                , [this] (CaptureScheduler::Capture&& capture) {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    uint32_t sequence;
+                    std::memcpy(&sequence, capture.data.data(), sizeof(sequence));
+                    if (sequence != capture.sequence) {
+                        ++mismatched;
+                    }
+
+                    frames.push_back(std::make_pair(capture.cameraID, capture.sequence));
+                    capture.recycle(std::move(capture.data));
+                }
+                , [this] (std::unique_ptr<CameraFrameSet>&& set) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    sets.push_back(*set);
+                }) {
+        }
+
+        std::shared_ptr<MockFlycapDevice> addCamera(uint cameraID, double framerate, std::shared_ptr<const MockTriggerLine> line = nullptr) {
+            auto device = std::make_shared<MockFlycapDevice>(line, std::chrono::microseconds(200));
+            device->open(1000 + cameraID, { 64, 48, framerate, 4 });
+            scheduler.addCamera(cameraID, device);
+            return device;
+        }
+
+        size_t framesFrom(uint cameraID) {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t count = 0;
+            for (auto& frame : frames) {
+                count += frame.first == cameraID ? 1 : 0;
+            }
+            return count;
+        }
+
+        std::vector<CameraFrameSet> takeSets() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sets;
+        }
+
+        std::mutex mutex;
+        std::vector<std::pair<uint, uint32_t>> frames;
+        std::vector<CameraFrameSet> sets;
+        uint mismatched = 0;
+
+        CaptureScheduler scheduler;
+    };
+
+    /*
+     * A camera that gives a fixed list of frame counters, then nothing
+     */
+    class ScriptedDevice : public FlycapDevice {
+    public:
+        ScriptedDevice(std::vector<uint32_t> sequences, bool hasSequence)
+            : sequences(sequences), hasSequence(hasSequence), buffer(64 * 48), next(0), settings({ 64, 48, 100, 4 }) {
+        }
+
+        void open(uint, const Settings&) override {}
+        void setTrigger(Trigger, uint) override {}
+        bool setProperty(const std::string&, const Property&) override { return true; }
+        void startCapture() override {}
+        void stopCapture() override {}
+        void fireSoftwareTrigger() override {}
+        void close() override {}
+        uint getSerial() const override { return 2000; }
+        const Settings& getSettings() const override { return settings; }
+
+        bool retrieve(Frame& frame, const std::chrono::milliseconds& timeout) override {
+            if (next == sequences.size()) {
+                std::this_thread::sleep_for(timeout);
+                return false;
+            }
+
+            frame.data = buffer.data();
+            frame.bytes = buffer.size();
+            frame.width = 64;
+            frame.height = 48;
+            frame.sequence = sequences[next++];
+            frame.hasSequence = hasSequence;
+            frame.timestamp = std::chrono::steady_clock::now();
+            return true;
+        }
+
+    private:
+        std::vector<uint32_t> sequences;
+        bool hasSequence;
+        std::vector<uint8_t> buffer;
+        std::atomic<size_t> next;
+        Settings settings;
+    };
+
+    NUClear::clock::time_point at(int milliseconds) {
+        return NUClear::clock::time_point(std::chrono::milliseconds(milliseconds));
+    }
+}
+
+TEST_CASE("Frames are matched into sets by timestamp", "[camera][flycap]") {
+
+    FrameSetMatcher matcher;
+    matcher.reset({ 0, 1, 2 }, std::chrono::milliseconds(5));
+
+    // A set only comes once every camera has a frame
+    REQUIRE_FALSE(matcher.add(0, 10, at(1000)));
+    REQUIRE_FALSE(matcher.add(1, 20, at(1002)));
+    auto set = matcher.add(2, 30, at(999));
+    REQUIRE(set);
+    REQUIRE(set->sequence == 0);
+    REQUIRE(set->frames.size() == 3);
+    REQUIRE(set->frames[0].cameraID == 0);
+    REQUIRE(set->frames[1].sequence == 20);
+    REQUIRE(set->timestamp == at(999));
+    REQUIRE(set->spread == std::chrono::milliseconds(3));
+
+    // A frame that is too far from the others is discarded and the rest wait for a better match
+    REQUIRE_FALSE(matcher.add(0, 11, at(1100)));
+    REQUIRE_FALSE(matcher.add(1, 21, at(1100)));
+    REQUIRE_FALSE(matcher.add(2, 31, at(1050)));
+    REQUIRE(matcher.getUnmatched() == 1);
+    set = matcher.add(2, 32, at(1101));
+    REQUIRE(set);
+    REQUIRE(set->sequence == 1);
+    REQUIRE(set->frames[2].sequence == 32);
+
+    // Frames from cameras that aren't in the set are ignored
+    REQUIRE_FALSE(matcher.add(7, 1, at(1200)));
+
+    // A camera that stops can't hold up the others' frames forever
+    for (uint i = 0; i < 2 * FrameSetMatcher::MAXIMUM_WAITING; ++i) {
+        REQUIRE_FALSE(matcher.add(0, 12 + i, at(1300 + i * 100)));
+        REQUIRE_FALSE(matcher.add(1, 22 + i, at(1300 + i * 100)));
+    }
+    REQUIRE(matcher.getUnmatched() == 1 + 2 * FrameSetMatcher::MAXIMUM_WAITING);
+
+    // A single camera never makes sets
+    matcher.reset({ 0 }, std::chrono::milliseconds(5));
+    REQUIRE_FALSE(matcher.add(0, 1, at(2000)));
+}
+
+TEST_CASE("Free running cameras capture at their own rates", "[camera][flycap]") {
+
+    Recorder recorder;
+    recorder.addCamera(0, 100);
+    recorder.addCamera(1, 40);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    recorder.scheduler.stop();
+
+    // Loose bounds, the machine running the test may be busy
+    REQUIRE(recorder.framesFrom(0) > 25);
+    REQUIRE(recorder.framesFrom(0) <= 55);
+    REQUIRE(recorder.framesFrom(1) > 10);
+    REQUIRE(recorder.framesFrom(1) <= 24);
+    REQUIRE(recorder.mismatched == 0);
+}
+
+TEST_CASE("Software triggered cameras capture together", "[camera][flycap]") {
+
+    Recorder recorder;
+    recorder.addCamera(0, 15);
+    recorder.addCamera(1, 15);
+    recorder.addCamera(2, 15);
+
+    recorder.scheduler.synchronise({ FlycapDevice::Trigger::SOFTWARE, 50, 0, std::chrono::milliseconds(10) });
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    recorder.scheduler.stop();
+
+    auto sets = recorder.takeSets();
+
+    // Triggered faster than they would free run
+    REQUIRE(sets.size() > 12);
+    REQUIRE(sets.size() <= 30);
+
+    for (size_t i = 0; i < sets.size(); ++i) {
+        REQUIRE(sets[i].frames.size() == 3);
+        REQUIRE(sets[i].spread < std::chrono::milliseconds(10));
+        if (i > 0) {
+            REQUIRE(sets[i].sequence == sets[i - 1].sequence + 1);
+            REQUIRE(sets[i].timestamp > sets[i - 1].timestamp);
+        }
+    }
+    REQUIRE(recorder.mismatched == 0);
+}
+
+TEST_CASE("Hardware triggered cameras capture on the trigger line", "[camera][flycap]") {
+
+    auto line = std::make_shared<MockTriggerLine>(40);
+
+    Recorder recorder;
+    recorder.scheduler.synchronise({ FlycapDevice::Trigger::HARDWARE, 40, 0, std::chrono::milliseconds(5) });
+    recorder.addCamera(0, 15, line);
+    recorder.addCamera(1, 15, line);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    recorder.scheduler.stop();
+
+    auto sets = recorder.takeSets();
+    REQUIRE(sets.size() > 10);
+    REQUIRE(sets.size() <= 24);
+
+    for (auto& set : sets) {
+        REQUIRE(set.frames.size() == 2);
+        REQUIRE(set.spread < std::chrono::milliseconds(5));
+    }
+}
+
+TEST_CASE("Frames nobody retrieved show up as dropped", "[camera][flycap]") {
+
+    std::mutex block;
+    std::unique_lock<std::mutex> blocked(block);
+
+    uint frames = 0;
+    CaptureScheduler scheduler(4
+        , [&] (CaptureScheduler::Capture&& capture) {
+            // Hold up the first frame so the camera has to skip the ones after it
+            if (frames++ == 0) {
+                std::lock_guard<std::mutex> lock(block);
+            }
+            capture.recycle(std::move(capture.data));
+        }
+        , [] (std::unique_ptr<CameraFrameSet>&&) {});
+
+    auto device = std::make_shared<MockFlycapDevice>(nullptr, std::chrono::microseconds(0));
+    device->open(1000, { 64, 48, 100, 4 });
+    scheduler.addCamera(0, device);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    blocked.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto statistics = scheduler.takeStatistics();
+    scheduler.stop();
+
+    REQUIRE(statistics.size() == 1);
+    REQUIRE(statistics[0]->device == "1000");
+    REQUIRE(statistics[0]->dropped > 10);
+    REQUIRE(statistics[0]->frames > 1);
+    REQUIRE(statistics[0]->corrupt == 0);
+}
+
+TEST_CASE("Only forward gaps in the frame counter count as dropped", "[camera][flycap]") {
+
+    // A camera whose counter resets part way, and one with no counter at all
+    for (bool hasSequence : { true, false }) {
+
+        CaptureScheduler scheduler(4
+            , [] (CaptureScheduler::Capture&& capture) {
+                capture.recycle(std::move(capture.data));
+            }
+            , [] (std::unique_ptr<CameraFrameSet>&&) {});
+
+        scheduler.addCamera(0, std::make_shared<ScriptedDevice>(std::vector<uint32_t>({ 5, 6, 9, 2, 3, 0, 0 }), hasSequence));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        auto statistics = scheduler.takeStatistics();
+        scheduler.stop();
+
+        REQUIRE(statistics.size() == 1);
+        REQUIRE(statistics[0]->frames == 7);
+        REQUIRE(statistics[0]->dropped == (hasSequence ? 2 : 0));
+    }
+}
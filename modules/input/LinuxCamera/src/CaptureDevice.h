@@ -0,0 +1,102 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_CAPTUREDEVICE_H
+#define MODULES_INPUT_CAPTUREDEVICE_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "V4L2CameraSetting.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief A source of frames that are captured into a ring of buffers owned by the device.
+         *
+         * @details
+         *  A frame is dequeued, read in place, and then enqueued again so the device can fill that buffer with a later
+         *  frame. While a frame is dequeued the device has one less buffer to capture into, so it should be handed
+         *  back as soon as its data has been read.
+         */
+        class CaptureDevice {
+        public:
+            /// @brief One filled buffer from the ring
+            struct Frame {
+                /// @brief which buffer in the ring this is
+                uint index;
+                /// @brief the frame data (only valid until the frame is enqueued again)
+                const uint8_t* data;
+                /// @brief how many bytes of the buffer the frame uses
+                size_t bytesUsed;
+                /// @brief the frame number the device gave this frame, gaps mean frames were dropped
+                uint32_t sequence;
+                /// @brief when the device captured the frame
+                std::chrono::steady_clock::time_point timestamp;
+            };
+
+            virtual ~CaptureDevice() = default;
+
+            /**
+             * @brief Opens the device and maps a ring of buffers for it to capture into
+             *
+             * @param device the path to the device
+             * @param format the pixel format to capture (YUYV or MJPG)
+             * @param width the width of the image
+             * @param height the height of the image
+             * @param buffers how many buffers to put in the ring
+             */
+            virtual void open(const std::string& device, const std::string& format, size_t width, size_t height, uint buffers) = 0;
+
+            /**
+             * @brief Waits up to timeout for a filled buffer
+             *
+             * @return true if frame was filled in, false if no frame arrived in time
+             */
+            virtual bool dequeue(Frame& frame, const std::chrono::milliseconds& timeout) = 0;
+
+            /**
+             * @brief Gives a buffer back to the device to capture into
+             */
+            virtual void enqueue(const Frame& frame) = 0;
+
+            virtual void startStreaming() = 0;
+            virtual void stopStreaming() = 0;
+            virtual bool isStreaming() const = 0;
+            virtual void closeCamera() = 0;
+
+            /// @brief Returns a map of all configurable settings
+            virtual std::map<std::string, V4L2CameraSetting>& getSettings() = 0;
+
+            /// @brief Returns the number of buffers in the ring
+            virtual uint getBufferCount() const = 0;
+
+            virtual size_t getWidth() const = 0;
+            virtual size_t getHeight() const = 0;
+            virtual const std::string& getDevicePath() const = 0;
+            virtual const std::string& getFormat() const = 0;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_CAPTUREDEVICE_H
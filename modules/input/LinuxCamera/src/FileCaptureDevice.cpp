@@ -0,0 +1,231 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "FileCaptureDevice.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace modules {
+    namespace input {
+
+        FileCaptureDevice::FileCaptureDevice(uint framerate)
+            : period(framerate > 0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / framerate
+                                   : std::chrono::steady_clock::duration::zero())
+            , file()
+            , buffers()
+            , queued()
+            , filled()
+            , nextDue()
+            , sequence(0)
+            , settings()
+            , width(0)
+            , height(0)
+            , devicePath("")
+            , format("")
+            , streaming(false) {
+        }
+
+        void FileCaptureDevice::open(const std::string& device, const std::string& fmt, size_t w, size_t h, uint n) {
+            closeCamera();
+
+            if (fmt != "YUYV" && fmt != "MJPG") {
+                throw std::runtime_error("The format must be either YUYV or MJPG");
+            }
+
+            devicePath = device;
+            format = fmt;
+            width = w;
+            height = h;
+
+            file.open(devicePath, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error(std::string("We were unable to open the replay file ") + devicePath);
+            }
+
+            // Every buffer can hold a whole YUYV frame, which is bigger than any JPEG of the same image should be
+            buffers.resize(std::max(n, 2u));
+            for (uint i = 0; i < buffers.size(); ++i) {
+                buffers[i].data.reserve(width * height * 2);
+                queued.push_back(i);
+            }
+        }
+
+        size_t FileCaptureDevice::readFrame(std::vector<uint8_t>* data) {
+
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                size_t size = width * height * 2;
+
+                if (format == "MJPG") {
+                    uint8_t header[4];
+                    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+                        // Go back to the start of the file and try again
+                        file.clear();
+                        file.seekg(0);
+                        continue;
+                    }
+                    size = header[0] | (header[1] << 8) | (header[2] << 16) | (uint32_t(header[3]) << 24);
+                }
+
+                if (data) {
+                    data->resize(size);
+                    file.read(reinterpret_cast<char*>(data->data()), size);
+                }
+                else {
+                    file.seekg(size, std::ios::cur);
+                }
+
+                if (file) {
+                    return size;
+                }
+
+                // We ran off the end part way through a frame, go back to the start
+                file.clear();
+                file.seekg(0);
+            }
+
+            throw std::runtime_error(std::string("The replay file does not contain a whole frame ") + devicePath);
+        }
+
+        void FileCaptureDevice::fill(const std::chrono::steady_clock::time_point& now) {
+
+            // As fast as possible means a frame is due whenever there is a buffer for it
+            if (period == std::chrono::steady_clock::duration::zero()) {
+                if (!queued.empty()) {
+                    uint index = queued.front();
+                    queued.pop_front();
+
+                    buffers[index].bytesUsed = readFrame(&buffers[index].data);
+                    buffers[index].sequence = sequence++;
+                    buffers[index].timestamp = now;
+                    filled.push_back(index);
+                }
+                return;
+            }
+
+            while (nextDue <= now) {
+                if (queued.empty()) {
+                    // No buffer to capture into so this frame is lost
+                    readFrame(nullptr);
+                }
+                else {
+                    uint index = queued.front();
+                    queued.pop_front();
+
+                    buffers[index].bytesUsed = readFrame(&buffers[index].data);
+                    buffers[index].sequence = sequence;
+                    buffers[index].timestamp = nextDue;
+                    filled.push_back(index);
+                }
+
+                ++sequence;
+                nextDue += period;
+            }
+        }
+
+        bool FileCaptureDevice::dequeue(Frame& frame, const std::chrono::milliseconds& timeout) {
+            if (!streaming) {
+                return false;
+            }
+
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            fill(std::chrono::steady_clock::now());
+
+            // Wait for a frame to come due if we don't have one yet
+            while (filled.empty()) {
+                auto wake = std::min(deadline, period == std::chrono::steady_clock::duration::zero() ? deadline : nextDue);
+                std::this_thread::sleep_until(wake);
+
+                auto now = std::chrono::steady_clock::now();
+                fill(now);
+
+                if (filled.empty() && now >= deadline) {
+                    return false;
+                }
+            }
+
+            uint index = filled.front();
+            filled.pop_front();
+
+            frame.index = index;
+            frame.data = buffers[index].data.data();
+            frame.bytesUsed = buffers[index].bytesUsed;
+            frame.sequence = buffers[index].sequence;
+            frame.timestamp = buffers[index].timestamp;
+
+            return true;
+        }
+
+        void FileCaptureDevice::enqueue(const Frame& frame) {
+            queued.push_back(frame.index);
+        }
+
+        void FileCaptureDevice::startStreaming() {
+            if (!streaming) {
+                nextDue = std::chrono::steady_clock::now();
+                streaming = true;
+            }
+        }
+
+        void FileCaptureDevice::stopStreaming() {
+            streaming = false;
+        }
+
+        bool FileCaptureDevice::isStreaming() const {
+            return streaming;
+        }
+
+        void FileCaptureDevice::closeCamera() {
+            stopStreaming();
+            file.close();
+            file.clear();
+            buffers.clear();
+            queued.clear();
+            filled.clear();
+            sequence = 0;
+        }
+
+        std::map<std::string, V4L2CameraSetting>& FileCaptureDevice::getSettings() {
+            // A file has no settings to change
+            return settings;
+        }
+
+        uint FileCaptureDevice::getBufferCount() const {
+            return buffers.size();
+        }
+
+        size_t FileCaptureDevice::getWidth() const {
+            return width;
+        }
+
+        size_t FileCaptureDevice::getHeight() const {
+            return height;
+        }
+
+        const std::string& FileCaptureDevice::getDevicePath() const {
+            return devicePath;
+        }
+
+        const std::string& FileCaptureDevice::getFormat() const {
+            return format;
+        }
+
+    }  // input
+}  // modules
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FILECAPTUREDEVICE_H
+#define MODULES_INPUT_FILECAPTUREDEVICE_H
+
+#include <deque>
+#include <fstream>
+#include <vector>
+
+#include "CaptureDevice.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief A capture device that replays raw frames from a file, used to run and test the capture pipeline
+         *    without a camera.
+         *
+         * @details
+         *  YUYV files are frames of width * height * 2 bytes back to back. MJPG files are JPEG images each preceded by
+         *  their length as a 32 bit little endian integer. When the end of the file is reached it starts again.
+         *
+         *  Frames come due at the framerate as they would from a camera. When a frame comes due and every buffer is
+         *  either filled or held by the reader that frame is dropped and its sequence number is skipped, the same as
+         *  the kernel does when its ring is full.
+         */
+        class FileCaptureDevice : public CaptureDevice {
+        public:
+            /**
+             * @param framerate how many frames per second to replay, 0 replays them as fast as they are read
+             */
+            explicit FileCaptureDevice(uint framerate);
+
+            void open(const std::string& device, const std::string& fmt, size_t w, size_t h, uint n) override;
+            bool dequeue(Frame& frame, const std::chrono::milliseconds& timeout) override;
+            void enqueue(const Frame& frame) override;
+
+            void startStreaming() override;
+            void stopStreaming() override;
+            bool isStreaming() const override;
+            void closeCamera() override;
+
+            std::map<std::string, V4L2CameraSetting>& getSettings() override;
+            uint getBufferCount() const override;
+            size_t getWidth() const override;
+            size_t getHeight() const override;
+            const std::string& getDevicePath() const override;
+            const std::string& getFormat() const override;
+
+        private:
+            /// @brief Captures every frame that has come due into a free buffer, or drops it if there is none
+            void fill(const std::chrono::steady_clock::time_point& now);
+
+            /// @brief Reads the next frame from the file into data (or skips it if data is null), returning its size
+            size_t readFrame(std::vector<uint8_t>* data);
+
+            struct Buffer {
+                std::vector<uint8_t> data;
+                size_t bytesUsed;
+                uint32_t sequence;
+                std::chrono::steady_clock::time_point timestamp;
+            };
+
+            std::chrono::steady_clock::duration period;
+
+            std::ifstream file;
+            std::vector<Buffer> buffers;
+            std::deque<uint> queued;
+            std::deque<uint> filled;
+
+            std::chrono::steady_clock::time_point nextDue;
+            uint32_t sequence;
+
+            std::map<std::string, V4L2CameraSetting> settings;
+            size_t width;
+            size_t height;
+            std::string devicePath;
+            std::string format;
+            bool streaming;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FILECAPTUREDEVICE_H
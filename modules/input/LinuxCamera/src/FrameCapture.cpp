@@ -0,0 +1,143 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "FrameCapture.h"
+
+#include <algorithm>
+
+namespace modules {
+    namespace input {
+
+        using messages::input::Image;
+        using messages::input::CaptureStatistics;
+
+        FrameCapture::FrameCapture(size_t poolSize)
+            : decoder()
+            , pool(poolSize)
+            , haveSequence(false)
+            , lastSequence(0)
+            , statisticsMutex()
+            , frames(0)
+            , dropped(0)
+            , corrupt(0)
+            , allocations(0)
+            , totalLatency(0)
+            , maxLatency(0) {
+        }
+
+        std::unique_ptr<Image<0>> FrameCapture::capture(CaptureDevice& device, const std::chrono::milliseconds& timeout) {
+
+            CaptureDevice::Frame frame;
+            if (!device.dequeue(frame, timeout)) {
+                return nullptr;
+            }
+
+            const size_t width = device.getWidth();
+            const size_t height = device.getHeight();
+
+            bool reused;
+            std::vector<uint8_t> data = pool.acquire(width * height * 3, reused);
+
+            bool decoded = true;
+            if (device.getFormat() == "MJPG") {
+                decoded = decoder.decodeMJPG(frame.data, frame.bytesUsed, width, height, data.data());
+            }
+            else if (frame.bytesUsed >= width * height * 2) {
+                decoder.decodeYUYV(frame.data, width, height, data.data());
+            }
+            else {
+                decoded = false;
+            }
+
+            // We are done with the device's buffer so let it capture into it again
+            device.enqueue(frame);
+
+            // Any gap in the sequence numbers is frames the device had nowhere to put
+            uint32_t skipped = haveSequence ? frame.sequence - lastSequence - 1 : 0;
+            haveSequence = true;
+            lastSequence = frame.sequence;
+
+            std::unique_ptr<Image<0>> image;
+            double latency = 0;
+
+            if (decoded) {
+                image = std::make_unique<Image<0>>();
+                image->format = Image<0>::SourceFormat::YCbCr444;
+                image->dimensions = { uint(width), uint(height) };
+                image->source = std::move(data);
+                image->recycle = pool.recycler();
+
+                // Put the capture time on the same clock as the rest of the system
+                auto age = std::chrono::steady_clock::now() - frame.timestamp;
+                image->timestamp = NUClear::clock::now() - std::chrono::duration_cast<NUClear::clock::duration>(age);
+                latency = std::chrono::duration<double>(age).count();
+            }
+            else {
+                pool.recycler()(std::move(data));
+            }
+
+            std::lock_guard<std::mutex> lock(statisticsMutex);
+            dropped += skipped;
+            allocations += reused ? 0 : 1;
+
+            if (decoded) {
+                ++frames;
+                totalLatency += latency;
+                maxLatency = std::max(maxLatency, latency);
+            }
+            else {
+                ++corrupt;
+            }
+
+            return image;
+        }
+
+        std::unique_ptr<CaptureStatistics> FrameCapture::takeStatistics(const CaptureDevice& device) {
+
+            auto statistics = std::make_unique<CaptureStatistics>();
+            statistics->device = device.getDevicePath();
+            statistics->buffers = device.getBufferCount();
+
+            std::lock_guard<std::mutex> lock(statisticsMutex);
+            statistics->frames = frames;
+            statistics->dropped = dropped;
+            statistics->corrupt = corrupt;
+            statistics->allocations = allocations;
+            statistics->copied = frames;
+            statistics->maxQueued = 0;
+            statistics->maxLent = 0;
+            statistics->meanLatency = frames > 0 ? totalLatency / frames : 0;
+            statistics->maxLatency = maxLatency;
+
+            frames = 0;
+            dropped = 0;
+            corrupt = 0;
+            allocations = 0;
+            totalLatency = 0;
+            maxLatency = 0;
+
+            return statistics;
+        }
+
+        void FrameCapture::reset() {
+            haveSequence = false;
+        }
+
+    }  // input
+}  // modules
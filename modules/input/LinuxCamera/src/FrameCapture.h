@@ -0,0 +1,87 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FRAMECAPTURE_H
+#define MODULES_INPUT_FRAMECAPTURE_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "messages/input/Image.h"
+#include "messages/input/CaptureStatistics.h"
+#include "utility/image/FramePool.h"
+#include "CaptureDevice.h"
+#include "FrameDecoder.h"
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief Takes frames from a capture device and turns them into images, keeping track of how it is keeping up.
+         *
+         * @details
+         *  Each frame is decoded directly out of the device's buffer into a pooled output buffer, and the device's
+         *  buffer is handed back as soon as that is done. The output buffer returns to the pool when the last copy of
+         *  the image is released.
+         */
+        class FrameCapture {
+        public:
+            /**
+             * @param poolSize how many output buffers to keep for reuse
+             */
+            explicit FrameCapture(size_t poolSize);
+
+            /**
+             * @brief Waits up to timeout for a frame and decodes it
+             *
+             * @return the image, or nullptr if no frame arrived in time or it could not be decoded
+             */
+            std::unique_ptr<messages::input::Image<0>> capture(CaptureDevice& device, const std::chrono::milliseconds& timeout);
+
+            /**
+             * @brief Gets the statistics gathered since the last call and starts gathering afresh
+             */
+            std::unique_ptr<messages::input::CaptureStatistics> takeStatistics(const CaptureDevice& device);
+
+            /**
+             * @brief Forgets the last sequence number, for when the device is reopened and starts counting again
+             */
+            void reset();
+
+        private:
+            FrameDecoder decoder;
+            utility::image::FramePool pool;
+
+            bool haveSequence;
+            uint32_t lastSequence;
+
+            std::mutex statisticsMutex;
+            uint64_t frames;
+            uint64_t dropped;
+            uint64_t corrupt;
+            uint64_t allocations;
+            double totalLatency;
+            double maxLatency;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FRAMECAPTURE_H
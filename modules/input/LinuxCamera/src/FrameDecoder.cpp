@@ -0,0 +1,102 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "FrameDecoder.h"
+
+#include <cstring>
+
+namespace modules {
+    namespace input {
+
+        FrameDecoder::FrameDecoder() {
+            std::memset(&cinfo, 0, sizeof(cinfo));
+            cinfo.err = jpeg_std_error(&error.manager);
+            error.manager.error_exit = &FrameDecoder::errorExit;
+
+            // Corrupt frames are counted rather than printed
+            error.manager.output_message = [] (j_common_ptr) {};
+            jpeg_create_decompress(&cinfo);
+        }
+
+        FrameDecoder::~FrameDecoder() {
+            jpeg_destroy_decompress(&cinfo);
+        }
+
+        void FrameDecoder::errorExit(j_common_ptr cinfo) {
+            // The error manager is the first member so we can get back to our jump buffer
+            ErrorManager* error = reinterpret_cast<ErrorManager*>(cinfo->err);
+            std::longjmp(error->jump, 1);
+        }
+
+        void FrameDecoder::decodeYUYV(const uint8_t* input, size_t width, size_t height, uint8_t* output) {
+
+            const size_t pairs = width * height / 2;
+
+            // Each Y0 Cb Y1 Cr group becomes two pixels that share the chroma
+            for (size_t i = 0; i < pairs; ++i, input += 4, output += 6) {
+                output[0] = input[0];
+                output[1] = input[1];
+                output[2] = input[3];
+                output[3] = input[2];
+                output[4] = input[1];
+                output[5] = input[3];
+            }
+        }
+
+        bool FrameDecoder::decodeMJPG(const uint8_t* input, size_t bytes, size_t width, size_t height, uint8_t* output) {
+
+            if (setjmp(error.jump)) {
+                // libjpeg hit an error part way through, throw this frame away and get ready for the next
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+
+            // Read straight out of the capture buffer
+            jpeg_mem_src(&cinfo, const_cast<uint8_t*>(input), bytes);
+
+            // Read our header
+            jpeg_read_header(&cinfo, true);
+
+            if (cinfo.image_width != width || cinfo.image_height != height) {
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+
+            // Set our options
+            cinfo.do_fancy_upsampling = false;
+            cinfo.out_color_space = JCS_YCbCr;
+            cinfo.dct_method = JDCT_IFAST;
+
+            // Start decompression
+            jpeg_start_decompress(&cinfo);
+
+            // Decompress the JPEG a scanline at a time into place
+            const size_t stride = width * cinfo.output_components;
+            while (cinfo.output_scanline < cinfo.output_height) {
+                JSAMPROW row = output + cinfo.output_scanline * stride;
+                jpeg_read_scanlines(&cinfo, &row, 1);
+            }
+
+            jpeg_finish_decompress(&cinfo);
+
+            return true;
+        }
+
+    }  // input
+}  // modules
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_INPUT_FRAMEDECODER_H
+#define MODULES_INPUT_FRAMEDECODER_H
+
+#include <csetjmp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+extern "C" {
+    #include <jpeglib.h>
+}
+
+namespace modules {
+    namespace input {
+
+        /**
+         * @brief Turns the raw frames a camera gives us into YCbCr444 images, writing them into memory we already own.
+         *
+         * @details
+         *  The JPEG decompressor is made once and reused for every frame. It reads straight out of the capture buffer
+         *  and writes each scanline straight into the output, so decoding a frame does not allocate or copy.
+         */
+        class FrameDecoder {
+        public:
+            FrameDecoder();
+            ~FrameDecoder();
+
+            FrameDecoder(const FrameDecoder&) = delete;
+            FrameDecoder& operator=(const FrameDecoder&) = delete;
+
+            /**
+             * @brief Expands a YUYV (YCbCr422) frame so every pixel has its own chroma
+             *
+             * @param input the frame, width * height * 2 bytes
+             * @param output where to write the image, width * height * 3 bytes
+             */
+            void decodeYUYV(const uint8_t* input, size_t width, size_t height, uint8_t* output);
+
+            /**
+             * @brief Decompresses a JPEG frame into YCbCr444
+             *
+             * @param input the compressed frame
+             * @param bytes the size of the compressed frame
+             * @param output where to write the image, width * height * 3 bytes
+             *
+             * @return false if the frame was corrupt or not the size we expected
+             */
+            bool decodeMJPG(const uint8_t* input, size_t bytes, size_t width, size_t height, uint8_t* output);
+
+        private:
+            /// @brief libjpeg's error manager with somewhere to jump back to instead of exiting
+            struct ErrorManager {
+                jpeg_error_mgr manager;
+                std::jmp_buf jump;
+            };
+
+            static void errorExit(j_common_ptr cinfo);
+
+            jpeg_decompress_struct cinfo;
+            ErrorManager error;
+        };
+
+    }  // input
+}  // modules
+
+#endif  // MODULES_INPUT_FRAMEDECODER_H
@@ -19,12 +19,13 @@
 
 #include "LinuxCamera.h"
 
-extern "C" {
-    #include <jpeglib.h>
-}
+#include <sys/stat.h>
+#include <thread>
 
 #include "V4L2Camera.h"
+#include "FileCaptureDevice.h"
 #include "messages/input/Image.h"
+#include "messages/input/CaptureStatistics.h"
 #include "messages/support/Configuration.h"
 
 namespace modules {
@@ -32,63 +33,63 @@ namespace modules {
 
         using messages::support::Configuration;
 
-        // We assume that the device will always be video0, if not then change this
-        LinuxCamera::LinuxCamera(std::unique_ptr<NUClear::Environment> environment) : Reactor(std::move(environment)) {
+        LinuxCamera::LinuxCamera(std::unique_ptr<NUClear::Environment> environment)
+            : Reactor(std::move(environment))
+            , camera()
+            , cameraMutex()
+            , capture(OUTPUT_POOL_SIZE)
+            , requestedBuffers(0)
+            , running(true) {
 
-            // This trigger gets us as close as we can to the frame rate as possible (as high resolution as we can)
-            on<Trigger<Every<V4L2Camera::FRAMERATE, Per<std::chrono::seconds>>>, Options<Single>>("Read Camera", [this](const time_t&) {
-
-                // If the camera is ready, get an image and emit it
-                if (camera.isStreaming()) {
-                    auto image = camera.getImage();
-
-                    // TODO apply the lens
-
-                    emit(camera.getImage());
-                }
-            });
+            powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask(std::bind(std::mem_fn(&LinuxCamera::run), this), std::bind(std::mem_fn(&LinuxCamera::kill), this)));
 
             // When we shutdown, we must tell our camera class to close (stop streaming)
             on<Trigger<Shutdown>>([this](const Shutdown&) {
-                camera.closeCamera();
+                std::lock_guard<std::mutex> lock(cameraMutex);
+                if (camera) {
+                    camera->closeCamera();
+                }
             });
 
             on<Trigger<Configuration<LinuxCamera>>>([this](const Configuration<LinuxCamera>& config) {
 
-                double fovX = config["fov"][0].as<double>();
-                double fovY = config["fov"][1].as<double>();
-
-//                auto cameraParameters = std::make_unique<CameraParameters>();
-//
-//                cameraParameters->imageSizePixels << config["imageWidth"].as<uint>() << config["imageHeight"].as<uint>();
-//                cameraParameters->FOV << config["FOV_X"].as<double>() << config["FOV_Y"].as<double>();
-//                cameraParameters->distortionFactor = config["DISTORTION_FACTOR"].as<double>();
-//                arma::vec2 tanHalfFOV;
-//                tanHalfFOV << std::tan(cameraParameters->FOV[0] * 0.5) << std::tan(cameraParameters->FOV[1] * 0.5);
-//                arma::vec2 imageCentre;
-//                imageCentre << cameraParameters->imageSizePixels[0] * 0.5 << cameraParameters->imageSizePixels[1] * 0.5;
-//                cameraParameters->pixelsToTanThetaFactor << (tanHalfFOV[0] / imageCentre[0]) << (tanHalfFOV[1] / imageCentre[1]);
-//                cameraParameters->focalLengthPixels = imageCentre[0] / tanHalfFOV[0];
-//
-//
-//                emit<Scope::DIRECT>(std::move(cameraParameters));
-
                 try {
                     // Recreate the camera device at the required resolution
                     int width = config["image_width"].as<uint>();
                     int height = config["image_height"].as<uint>();
+                    uint buffers = config["buffers"].as<uint>();
                     std::string devicePath = config["device_path"].as<std::string>();
-                    std::string format = config["imageFormat"].as<std::string>();
+                    std::string format = config["image_format"].as<std::string>();
+
+                    std::lock_guard<std::mutex> lock(cameraMutex);
+
+                    if (!camera
+                        || camera->getWidth() != static_cast<size_t>(width)
+                        || camera->getHeight() != static_cast<size_t>(height)
+                        || camera->getFormat() != format
+                        || camera->getDevicePath() != devicePath
+                        || buffers != requestedBuffers) {
+
+                        if (camera) {
+                            camera->closeCamera();
+                        }
+
+                        // A regular file is a recording of raw frames to replay, anything else is a camera
+                        struct stat info;
+                        if (stat(devicePath.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                            camera = std::make_unique<FileCaptureDevice>(config["replay_framerate"].as<uint>());
+                        }
+                        else {
+                            camera = std::make_unique<V4L2Camera>();
+                        }
 
-                    if (camera.getWidth() != static_cast<size_t>(width)
-                        || camera.getHeight() != static_cast<size_t>(height)
-                        || camera.getFormat() != format
-                        || camera.getDevicePath() != devicePath) {
-                        camera.resetCamera(devicePath, format, width, height);
+                        camera->open(devicePath, format, width, height, buffers);
+                        requestedBuffers = buffers;
+                        capture.reset();
                     }
 
                     // Set all other camera settings
-                    for(auto& setting : camera.getSettings()) {
+                    for(auto& setting : camera->getSettings()) {
                         int value = config[setting.first].as<int>();
                         if(setting.second.set(value) == false) {
                             NUClear::log<NUClear::DEBUG>("Failed to set " + setting.first + " on camera");
@@ -96,7 +97,7 @@ namespace modules {
                     }
 
                     // Start the camera streaming video
-                    camera.startStreaming();
+                    camera->startStreaming();
                 } catch(const std::exception& e) {
                     NUClear::log<NUClear::DEBUG>(std::string("Exception while setting camera configuration: ") + e.what());
                     throw e;
@@ -105,9 +106,10 @@ namespace modules {
 
             // Try to reapply the camera settings every 1 second because sometimes they don't all apply properly
             on<Trigger<Every<1, std::chrono::seconds>>, With<Configuration<LinuxCamera>>>("Camera Setting Applicator", [this] (const time_t&, const Configuration<LinuxCamera>& config) {
-                if(camera.isStreaming()) {
+                std::lock_guard<std::mutex> lock(cameraMutex);
+                if(camera && camera->isStreaming()) {
                     // Set all other camera settings
-                    for(auto& setting : camera.getSettings()) {
+                    for(auto& setting : camera->getSettings()) {
                         int value = config[setting.first].as<int>();
                         if(setting.second.set(value) == false) {
                             NUClear::log<NUClear::DEBUG>("Failed to set " + setting.first + " on camera");
@@ -115,6 +117,42 @@ namespace modules {
                     }
                 }
             });
+
+            // Report how well we are keeping up
+            on<Trigger<Every<1, std::chrono::seconds>>>("Camera Statistics", [this] (const time_t&) {
+                std::lock_guard<std::mutex> lock(cameraMutex);
+                if(camera && camera->isStreaming()) {
+                    emit(capture.takeStatistics(*camera));
+                }
+            });
+        }
+
+        void LinuxCamera::run() {
+
+            while (running) {
+                std::unique_ptr<messages::input::Image<0>> image;
+                bool streaming;
+                {
+                    std::lock_guard<std::mutex> lock(cameraMutex);
+                    streaming = camera && camera->isStreaming();
+
+                    // Wait a short while for each frame so we notice being reconfigured or killed
+                    if (streaming) {
+                        image = capture.capture(*camera, std::chrono::milliseconds(100));
+                    }
+                }
+
+                if (image) {
+                    emit(std::move(image));
+                }
+                else if (!streaming) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+        }
+
+        void LinuxCamera::kill() {
+            running = false;
         }
 
     }  // input
@@ -21,7 +21,11 @@
 #define MODULES_INPUT_LINUXCAMERA_H
 
 #include <nuclear>
-#include "V4L2Camera.h"
+#include <atomic>
+#include <mutex>
+
+#include "CaptureDevice.h"
+#include "FrameCapture.h"
 
 namespace modules {
     namespace input {
@@ -30,9 +34,10 @@ namespace modules {
          * @breif This module is responsible for reading data from the Darwin's Camera and emitting the resulting images.
          *
          * @details
-         *    This Reactor uses it's DarwinCamera class in order to read a stream of images from the Darwin's camera and
-         *    emit them out to the rest of the system. It does this using the Video4Linux2 drivers that are built into
-         *    the kernel.
+         *    This Reactor uses a V4L2Camera in order to read a stream of images from the Darwin's camera and emit them
+         *    out to the rest of the system. It does this using the Video4Linux2 drivers that are built into the kernel.
+         *    Frames are read on their own service thread as soon as the kernel has them, so capture is never held up
+         *    by the thread pool. If the device path is a regular file its frames are replayed instead.
          *
          * @author Michael Burton
          * @author Jake Woods
@@ -41,13 +46,34 @@ namespace modules {
         class LinuxCamera : public NUClear::Reactor {
 
         private:
-            /// @brief Our internal camera class that interacts with the physical device
-            V4L2Camera camera;
+            /// @brief Our internal camera class that interacts with the physical device (or a file standing in for it)
+            std::unique_ptr<CaptureDevice> camera;
+
+            /// @brief Held while using the camera so it is not reconfigured out from under the capture thread
+            std::mutex cameraMutex;
+
+            /// @brief Turns the camera's frames into images
+            FrameCapture capture;
+
+            /// @brief How many buffers we last asked the camera for
+            uint requestedBuffers;
+
+            /// @brief Whether our capture thread should keep running
+            std::atomic<bool> running;
+
+            /// @brief Reads frames from the camera and emits them until we are killed
+            void run();
+
+            /// @brief Stops the capture thread
+            void kill();
 
         public:
             /// @brief Our configuration file for this class
             static constexpr const char* CONFIGURATION_PATH = "LinuxCamera.yaml";
 
+            /// @brief How many output images we keep around for reuse
+            static constexpr size_t OUTPUT_POOL_SIZE = 8;
+
             /// @brief Called by the PowerPlant to build and setup our Reactor
             LinuxCamera(std::unique_ptr<NUClear::Environment> environment);
         };
@@ -19,8 +19,10 @@
 
 #include "V4L2Camera.h"
 
+#include <algorithm>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -29,19 +31,31 @@
 #include <string>
 #include <sstream>
 #include <linux/videodev2.h>
-#include <jpeglib.h>
 
 namespace modules {
     namespace input {
 
-        using messages::input::Image;
+        V4L2Camera::V4L2Camera() : buffers(), fd(-1), width(0), height(0), settings(), devicePath(""), format(""), streaming(false) {
+        }
 
-        V4L2Camera::V4L2Camera() : fd(-1), width(0), height(0), devicePath(""), streaming(false) {
+        V4L2Camera::~V4L2Camera() {
+            closeCamera();
         }
 
-        std::unique_ptr<Image> V4L2Camera::getImage() {
+        bool V4L2Camera::dequeue(Frame& frame, const std::chrono::milliseconds& timeout) {
             if (!streaming) {
-                return nullptr;
+                return false;
+            }
+
+            // Wait for the kernel to fill a buffer
+            pollfd event { fd, POLLIN, 0 };
+            int ready = poll(&event, 1, timeout.count());
+
+            if (ready == -1 && errno != EINTR) {
+                throw std::system_error(errno, std::system_category(), "There was an error while waiting for a frame");
+            }
+            else if (ready <= 0) {
+                return false;
             }
 
             v4l2_buffer current;
@@ -51,98 +65,44 @@ namespace modules {
 
             // Get our frame buffer with data in it
             if (ioctl(fd, VIDIOC_DQBUF, &current) == -1) {
+                if (errno == EAGAIN) {
+                    return false;
+                }
                 throw std::system_error(errno, std::system_category(), "There was an error while de-queuing a buffer");
             }
 
-            const uint NUM_CHANNELS = 3;
-
-            std::vector<uint8_t> data(width * height * NUM_CHANNELS);
-            auto image = std::make_unique<Image>();
-
-            // If it is a MJPG
-            if(format == "MJPG") {
-                struct jpeg_error_mgr err;
-                struct jpeg_decompress_struct cinfo;
-                std::memset(&cinfo, 0, sizeof(jpeg_decompress_struct));
-
-                uint8_t* payload = static_cast<uint8_t*>(buff[current.index].payload);
-
-                // Create a decompressor
-                jpeg_create_decompress(&cinfo);
-                cinfo.err = jpeg_std_error(&err);
-
-                std::vector<uint8_t> jpegData(current.bytesused);
-
-                // Copy our header (the first 195 bytes)
-                std::copy(payload, payload + current.bytesused, std::begin(jpegData));
-
-                // Set our source buffer
-                jpeg_mem_src(&cinfo, jpegData.data(), current.bytesused);
-
-                // Read our header
-                jpeg_read_header(&cinfo, true);
-
-                // Set our options
-                cinfo.do_fancy_upsampling = false;
-                cinfo.out_color_components = NUM_CHANNELS;
-                cinfo.out_color_space = JCS_YCbCr;
-
-                // Start decompression
-                jpeg_start_decompress(&cinfo);
-
-                // Decompress the JPEG
-                for (uint8_t* row = data.data();
-                        cinfo.output_scanline < cinfo.output_height;
-                        row += width * cinfo.out_color_components) {
-
-                    // Read the scanline into place
-                    jpeg_read_scanlines(&cinfo, &row, 1);
-                }
-
-                // Clean up
-                jpeg_finish_decompress(&cinfo);
-                jpeg_destroy_decompress(&cinfo);
+            frame.index = current.index;
+            frame.data = static_cast<const uint8_t*>(buffers[current.index].payload);
+            frame.bytesUsed = current.bytesused;
+            frame.sequence = current.sequence;
 
-                // Move this data into the image along with the jpeg source
-                image->dimensions = { width, height };
-                image->source = std::move(data);
+            // Monotonic kernel timestamps are on the same clock as steady_clock, otherwise the best we have is now
+            if ((current.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+                frame.timestamp = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::seconds(current.timestamp.tv_sec) + std::chrono::microseconds(current.timestamp.tv_usec)));
             }
-
             else {
+                frame.timestamp = std::chrono::steady_clock::now();
+            }
 
-                // TODO this is totally broken now
-
-                uint8_t* input = static_cast<uint8_t*>(buff[current.index].payload);
-
-                const size_t total = width * height;
-
-                // Fix the colour information to be YUV444 rather then YUV422
-                for(size_t i = 0; i < total; ++++i) {
-
-                    // data[i].y  = input[i * 2];
-                    // data[i].cb = input[i * 2 + 1];
-                    // data[i].cr = input[i * 2 + 3];
+            return true;
+        }
 
-                    // data[i + 1].y  = input[i * 2 + 2];
-                    // data[i + 1].cb = input[i * 2 + 1];
-                    // data[i + 1].cr = input[i * 2 + 3];
-                }
+        void V4L2Camera::enqueue(const Frame& frame) {
 
-                // Move this data into the image
-                image->dimensions = { width, height };
-                image->source = std::move(data);
-            }
+            v4l2_buffer current;
+            memset(&current, 0, sizeof(current));
+            current.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            current.memory = V4L2_MEMORY_MMAP;
+            current.index = frame.index;
 
-            // Enqueue our next buffer so it can be written to
+            // Enqueue our buffer so it can be written to
             if (ioctl(fd, VIDIOC_QBUF, &current) == -1) {
                 throw std::system_error(errno, std::system_category(), "There was an error while re-queuing a buffer");
             }
-
-            // Return our image
-            return image;
         }
 
-        void V4L2Camera::resetCamera(const std::string& device, const std::string& fmt, size_t w, size_t h) {
+        void V4L2Camera::open(const std::string& device, const std::string& fmt, size_t w, size_t h, uint n) {
             // if the camera device is already open, close it
             closeCamera();
 
@@ -153,7 +113,7 @@ namespace modules {
             height = h;
 
             // Open the camera device
-            fd = open(devicePath.c_str(), O_RDWR);
+            fd = ::open(devicePath.c_str(), O_RDWR | O_NONBLOCK);
             // Check if we managed to open our file descriptor
             if (fd < 0) {
                 throw std::runtime_error(std::string("We were unable to access the camera device on ") + devicePath);
@@ -196,19 +156,25 @@ namespace modules {
                 throw std::system_error(errno, std::system_category(), "We were unable to get the current camera FPS parameters");
             }
 
-            // Request 2 kernel space buffers to read the data from the camera into
+            // Request a ring of kernel space buffers to read the data from the camera into
             v4l2_requestbuffers rb;
             memset(&rb, 0, sizeof(rb));
-            rb.count = 2; // 2 buffers, one to queue one to read
+            rb.count = std::max(n, uint(MINIMUM_BUFFERS));
             rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
             rb.memory = V4L2_MEMORY_MMAP;
             if (ioctl(fd, VIDIOC_REQBUFS, &rb) == -1) {
                 throw std::system_error(errno, std::system_category(), "There was an error requesting the buffer");
             }
 
-            // Map those two buffers into our user space so we can access them
-            for (int i = 0; i < 2; ++i) {
+            // The driver may have given us a different number of buffers than we asked for
+            if (rb.count < MINIMUM_BUFFERS) {
+                throw std::runtime_error("The camera did not give us enough buffers to stream with");
+            }
+
+            // Map those buffers into our user space so we can access them
+            for (uint i = 0; i < rb.count; ++i) {
                 v4l2_buffer buffer;
+                memset(&buffer, 0, sizeof(buffer));
                 buffer.index = i;
                 buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                 buffer.memory = V4L2_MEMORY_MMAP;
@@ -216,13 +182,16 @@ namespace modules {
                     throw std::system_error(errno, std::system_category(), "There was an error mapping the video buffer into user space");
                 }
 
-                buff[i].length = buffer.length;
-                buff[i].payload = mmap(0, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset);
+                KernelBuffer mapped;
+                mapped.length = buffer.length;
+                mapped.payload = mmap(0, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset);
 
-                if (buff[i].payload == MAP_FAILED) {
+                if (mapped.payload == MAP_FAILED) {
                     throw std::runtime_error("There was an error mapping the video buffer into user space");
                 }
 
+                buffers.push_back(mapped);
+
                 // Enqueue our buffer so that the kernel can write data to it
                 if (ioctl(fd, VIDIOC_QBUF, &buffer) == -1) {
                     throw std::system_error(errno, std::system_category(), "There was an error queuing buffers for the kernel to write to");
@@ -280,6 +249,10 @@ namespace modules {
             return settings;
         }
 
+        uint V4L2Camera::getBufferCount() const {
+            return buffers.size();
+        }
+
         size_t V4L2Camera::getWidth() const {
             return width;
         }
@@ -301,9 +274,13 @@ namespace modules {
                 stopStreaming();
 
                 // unmap buffers
-                for (int i = 0; i < 2; ++i) {
-                    munmap(buff[i].payload, buff[i].length);
+                for (auto& buffer : buffers) {
+                    munmap(buffer.payload, buffer.length);
                 }
+                buffers.clear();
+
+                // The settings hold our file descriptor so they go with it
+                settings.clear();
 
                 close(fd);
                 fd = -1;
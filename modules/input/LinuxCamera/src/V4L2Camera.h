@@ -23,8 +23,9 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
-#include "messages/input/Image.h"
+#include "CaptureDevice.h"
 #include "V4L2CameraSetting.h"
 
 namespace modules {
@@ -36,8 +37,8 @@ namespace modules {
          *
          * @details
          *    This class uses the Video4Linux2 kernel drivers in order to connect to and get data from the darwins built in
-         *    webcam. It allocates 2 kernel mode buffers which are mapped into user space. These buffers are alternated and
-         *  the data from the most recently filled one is used to construct an image object. This class also provides easy
+         *    webcam. It allocates a ring of kernel mode buffers which are mapped into user space. The kernel fills them
+         *  in turn and each filled buffer is read in place before it is handed back. This class also provides easy
          *  access to all the settings that are available on the camera. It is provided as a map in order to make accessing
          *  the paramters by name (from a config file) easier
          *
@@ -45,7 +46,7 @@ namespace modules {
          * @author Jake Woods
          * @author Trent Houliston
          */
-        class V4L2Camera {
+        class V4L2Camera : public CaptureDevice {
         private:
             /// @brief This struct holds all of the variables we need for interaction with the kernel space buffers
             struct KernelBuffer {
@@ -53,7 +54,10 @@ namespace modules {
                 size_t length;
                 /// @brief a pointer to the first address of the virtual mapped kernel space
                 void* payload;
-            } buff[2];
+            };
+
+            /// @brief the ring of buffers the kernel captures into
+            std::vector<KernelBuffer> buffers;
 
             /// @brief this file descriptor points to the camera object
             int fd;
@@ -80,83 +84,83 @@ namespace modules {
             /// @brief the framerate we are requesting
             static constexpr uint FRAMERATE = 30;
 
-            /**
-             * @brief Constructs a new DarwinCamera class using the passed string as the device
-             *
-             * @param device the path to the video device to use (e.g. /dev/video0)
-             */
+            /// @brief the fewest buffers we will run with, one being filled and one being read
+            static constexpr uint MINIMUM_BUFFERS = 2;
+
             V4L2Camera();
+            ~V4L2Camera();
 
             /**
-             * @brief Gets a pointer to the latest image from the camera so that it can be sent out to the rest of the system
-             *
-             * @details
-             *   This function blocks until the camera device provides a new frame of video
-             *   data, at which point it copies the frame into a new Image and returns. The
-             *   camera device must already be set up (using resetCamera) and
+             * @brief Sets up the camera at a given resolution
              *
-             * @return a pointer to the latest image from the camera
+             * @param device the path to the camera device
+             * @param fmt the format to capture in (YUYV or MJPG)
+             * @param w the image's width
+             * @param h the image's height
+             * @param n how many buffers to ask the kernel for (it may give us a different number)
              */
-            std::unique_ptr<messages::input::Image> getImage();
+            void open(const std::string& device, const std::string& fmt, size_t w, size_t h, uint n) override;
 
             /**
-             * @brief Sets up the camera at a given resolution
+             * @brief Waits for the kernel to fill a buffer
              *
-             * @param name the name of the camera device
-             * @param w the image's width
-             * @param h the image's height
-             * @param f whether the camera is mounted upside down
+             * @details
+             *   The frame points straight into the kernel buffer, no data is copied. The buffer must be handed back
+             *   with enqueue once it has been read.
              */
-            void resetCamera(const std::string& device, const std::string& fmt, size_t w, size_t h);
+            bool dequeue(Frame& frame, const std::chrono::milliseconds& timeout) override;
+
+            void enqueue(const Frame& frame) override;
 
             /**
              * @brief Returns a map of all configurable settings
              */
-            std::map<std::string, V4L2CameraSetting>& getSettings();
+            std::map<std::string, V4L2CameraSetting>& getSettings() override;
+
+            uint getBufferCount() const override;
 
             /**
              * @brief Returns the horizontal resolution the camera is currently set to
              */
-            size_t getWidth() const;
+            size_t getWidth() const override;
 
             /**
              * @brief Returns the vertical resolution the camera is currently set to
              */
-            size_t getHeight() const;
+            size_t getHeight() const override;
 
             /**
              * @brief Returns the device path that is currently used as the camera
              */
-            const std::string& getDevicePath() const;
+            const std::string& getDevicePath() const override;
 
             /**
              * @brief returns the format that the camera is currently reading (YUYV or MJPG)
              */
-            const std::string& getFormat() const;
+            const std::string& getFormat() const override;
 
             /**
              * @brief This method is to be called when shutting down the system. It does cleanup on the cameras resources
              */
-            void closeCamera();
+            void closeCamera() override;
 
             /**
              * @brief Starts the camera streaming video
              */
-            void startStreaming();
+            void startStreaming() override;
 
             /**
              * @brief Check whether the camera is actively streaming video
              */
-            bool isStreaming() const;
+            bool isStreaming() const override;
 
             /**
              * @brief Stops the camera streaming video
              */
-            void stopStreaming();
+            void stopStreaming() override;
         };
 
     }  // input
 }  // modules
 
 #endif  // MODULES_INPUT_V4L2CAMERA_H
-
@@ -0,0 +1,236 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+extern "C" {
+    #include <jpeglib.h>
+}
+
+#include "FileCaptureDevice.h"
+#include "FrameCapture.h"
+
+using modules::input::FileCaptureDevice;
+using modules::input::FrameCapture;
+
+namespace {
+
+    /*
+     * A temporary file holding the given bytes, removed when it goes out of scope
+     */
+    struct TemporaryFile {
+        explicit TemporaryFile(const std::vector<uint8_t>& data) {
+            char name[] = "/tmp/capturetestXXXXXX";
+            int fd = mkstemp(name);
+            close(fd);
+            path = name;
+
+            std::ofstream out(path, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        }
+
+        ~TemporaryFile() {
+            std::remove(path.c_str());
+        }
+
+        std::string path;
+    };
+
+    // A width x height YUYV frame where every byte is its own index plus the frame number
+    std::vector<uint8_t> yuyvFrames(size_t width, size_t height, uint frames) {
+        std::vector<uint8_t> data;
+        for(uint f = 0; f < frames; ++f) {
+            for(size_t i = 0; i < width * height * 2; ++i) {
+                data.push_back(uint8_t(i + f));
+            }
+        }
+        return data;
+    }
+
+    // A flat colour YCbCr JPEG preceded by its length, the way MJPG replay files are laid out
+    std::vector<uint8_t> mjpgFrame(size_t width, size_t height, uint8_t y, uint8_t cb, uint8_t cr) {
+
+        jpeg_compress_struct cinfo;
+        jpeg_error_mgr err;
+        cinfo.err = jpeg_std_error(&err);
+        jpeg_create_compress(&cinfo);
+
+        unsigned char* buffer = nullptr;
+        unsigned long size = 0;
+        jpeg_mem_dest(&cinfo, &buffer, &size);
+
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_YCbCr;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, 100, true);
+        jpeg_start_compress(&cinfo, true);
+
+        std::vector<uint8_t> row(width * 3);
+        for(size_t x = 0; x < width; ++x) {
+            row[x * 3 + 0] = y;
+            row[x * 3 + 1] = cb;
+            row[x * 3 + 2] = cr;
+        }
+        while(cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW r = row.data();
+            jpeg_write_scanlines(&cinfo, &r, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+
+        std::vector<uint8_t> data = { uint8_t(size), uint8_t(size >> 8), uint8_t(size >> 16), uint8_t(size >> 24) };
+        data.insert(data.end(), buffer, buffer + size);
+        free(buffer);
+
+        return data;
+    }
+}
+
+TEST_CASE("YUYV frames are replayed and expanded to YCbCr444", "[input][camera]") {
+
+    TemporaryFile file(yuyvFrames(4, 2, 3));
+
+    FileCaptureDevice device(0);
+    device.open(file.path, "YUYV", 4, 2, 4);
+    device.startStreaming();
+
+    FrameCapture capture(4);
+
+    // Go round the file more than once
+    for(uint f = 0; f < 5; ++f) {
+        auto image = capture.capture(device, std::chrono::milliseconds(100));
+        REQUIRE(image);
+        REQUIRE(image->source.size() == 4 * 2 * 3);
+
+        uint8_t base = f % 3;
+        for(size_t p = 0; p < 8; p += 2) {
+            const uint8_t* in = &image->source[p * 3];
+            uint8_t y0 = base + p * 2;
+
+            // Both pixels of a pair share the chroma
+            REQUIRE(in[0] == y0);
+            REQUIRE(in[1] == uint8_t(y0 + 1));
+            REQUIRE(in[2] == uint8_t(y0 + 3));
+            REQUIRE(in[3] == uint8_t(y0 + 2));
+            REQUIRE(in[4] == uint8_t(y0 + 1));
+            REQUIRE(in[5] == uint8_t(y0 + 3));
+        }
+    }
+
+    auto statistics = capture.takeStatistics(device);
+    REQUIRE(statistics->frames == 5);
+    REQUIRE(statistics->dropped == 0);
+    REQUIRE(statistics->corrupt == 0);
+    REQUIRE(statistics->buffers == 4);
+}
+
+TEST_CASE("Output buffers are reused once their image is released", "[input][camera]") {
+
+    TemporaryFile file(yuyvFrames(16, 16, 1));
+
+    FileCaptureDevice device(0);
+    device.open(file.path, "YUYV", 16, 16, 2);
+    device.startStreaming();
+
+    FrameCapture capture(2);
+
+    const uint8_t* first;
+    {
+        auto image = capture.capture(device, std::chrono::milliseconds(100));
+        first = image->source.data();
+    }
+
+    // The last image was released so this one should get its buffer
+    auto image = capture.capture(device, std::chrono::milliseconds(100));
+    REQUIRE(image->source.data() == first);
+
+    // While we hold an image the next one needs a buffer of its own
+    auto held = capture.capture(device, std::chrono::milliseconds(100));
+    REQUIRE(held->source.data() != first);
+
+    auto statistics = capture.takeStatistics(device);
+    REQUIRE(statistics->frames == 3);
+    REQUIRE(statistics->allocations == 2);
+}
+
+TEST_CASE("Frames that come due while every buffer is full are counted as dropped", "[input][camera]") {
+
+    TemporaryFile file(yuyvFrames(8, 8, 2));
+
+    // A frame every millisecond into a ring of two
+    FileCaptureDevice device(1000);
+    device.open(file.path, "YUYV", 8, 8, 2);
+    device.startStreaming();
+
+    FrameCapture capture(4);
+    REQUIRE(capture.capture(device, std::chrono::milliseconds(100)));
+
+    // Fall well behind, only the two buffers worth of frames can be kept
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    REQUIRE(capture.capture(device, std::chrono::milliseconds(100)));
+    REQUIRE(capture.capture(device, std::chrono::milliseconds(100)));
+    REQUIRE(capture.capture(device, std::chrono::milliseconds(100)));
+
+    auto statistics = capture.takeStatistics(device);
+    REQUIRE(statistics->frames == 4);
+    REQUIRE(statistics->dropped >= 40);
+    REQUIRE(statistics->maxLatency > 0.04);
+}
+
+TEST_CASE("MJPG frames are decompressed into YCbCr444 and corrupt ones are counted", "[input][camera]") {
+
+    auto data = mjpgFrame(16, 16, 100, 60, 200);
+
+    // A second frame that is cut short
+    auto broken = mjpgFrame(16, 16, 0, 0, 0);
+    broken.resize(40);
+    broken[0] = 36;
+    broken[1] = broken[2] = broken[3] = 0;
+    data.insert(data.end(), broken.begin(), broken.end());
+
+    TemporaryFile file(data);
+
+    FileCaptureDevice device(0);
+    device.open(file.path, "MJPG", 16, 16, 2);
+    device.startStreaming();
+
+    FrameCapture capture(2);
+
+    auto image = capture.capture(device, std::chrono::milliseconds(100));
+    REQUIRE(image);
+    for(size_t i = 0; i < image->source.size(); i += 3) {
+        REQUIRE(std::abs(int(image->source[i + 0]) - 100) <= 2);
+        REQUIRE(std::abs(int(image->source[i + 1]) - 60) <= 2);
+        REQUIRE(std::abs(int(image->source[i + 2]) - 200) <= 2);
+    }
+
+    REQUIRE_FALSE(capture.capture(device, std::chrono::milliseconds(100)));
+
+    auto statistics = capture.takeStatistics(device);
+    REQUIRE(statistics->frames == 1);
+    REQUIRE(statistics->corrupt == 1);
+}
@@ -24,7 +24,7 @@
 #include <armadillo>
 #include <chrono>
 
-#include "utility/math/kalman/UKF.h"
+#include "utility/math/kalman/FixedUKF.h"
 #include "messages/support/Configuration.h"
 #include "messages/vision/VisionObjects.h"
 #include "messages/localisation/FieldObject.h"
@@ -61,7 +61,7 @@ namespace localisation {
 
         bool CanEmitFieldObjects();
 
-        utility::math::kalman::UKF<ball::BallModel> ball_filter_;
+        utility::math::kalman::FixedUKF<ball::BallModel> ball_filter_;
 
     private:
         struct {
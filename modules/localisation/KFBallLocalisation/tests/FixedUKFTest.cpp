@@ -0,0 +1,294 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "utility/math/kalman/UKF.h"
+#include "utility/math/kalman/FixedUKF.h"
+#include "utility/math/kalman/IMUModel.h"
+#include "utility/math/kalman/AdaptiveIMUModel.h"
+#include "utility/math/kalman/InverseDepthPointModel.h"
+#include "utility/math/kalman/LinearVec3Model.h"
+#include "BallModel.h"
+
+using utility::math::kalman::UKF;
+using utility::math::kalman::FixedUKF;
+using utility::math::kalman::IMUModel;
+using utility::math::kalman::AdaptiveIMUModel;
+using utility::math::kalman::InverseDepthPointModel;
+using utility::math::kalman::LinearVec3Model;
+using modules::localisation::ball::BallModel;
+
+namespace {
+
+    // How far apart two matrices are relative to the size of the first
+    double relativeError(const arma::mat& a, const arma::mat& b) {
+        return arma::abs(a - b).max() / (1.0 + arma::abs(a).max());
+    }
+
+    template <typename Model>
+    void requireAgreement(const UKF<Model>& reference, const FixedUKF<Model>& fixed, double referenceQuality, double fixedQuality) {
+        REQUIRE(relativeError(reference.get(), fixed.get()) < 1e-8);
+        REQUIRE(relativeError(reference.getCovariance(), fixed.getCovariance()) < 1e-8);
+        REQUIRE(std::abs(referenceQuality - fixedQuality) <= 1e-8 * std::abs(referenceQuality));
+    }
+
+    arma::vec3 angularVelocity() {
+        return arma::vec3({ 0.1, -0.2, 0.05 });
+    }
+
+    // Runs an update cycle repeatedly and reports how many it managed per second
+    template <typename TUpdate>
+    double updatesPerSecond(TUpdate update) {
+        constexpr int CYCLES = 20000;
+
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < CYCLES; ++i) {
+            update(i);
+        }
+        return CYCLES / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const std::string& name, double reference, double fixed) {
+        std::cout << name << ": UKF " << reference << " updates/s, FixedUKF " << fixed << " updates/s ("
+                  << fixed / reference << "x)" << std::endl;
+    }
+}
+
+TEST_CASE("FixedUKF agrees with UKF for the IMU model", "[kalman][ukf]") {
+
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 0.3);
+
+    arma::vec::fixed<IMUModel::size> mean = { 0.1, -0.2, 0.05, 1, 0, 0, 0 };
+    UKF<IMUModel> reference(mean);
+    FixedUKF<IMUModel> fixed(mean);
+    reference.model.processNoiseDiagonal = arma::ones(IMUModel::size) * 1e-4;
+    fixed.model.processNoiseDiagonal = arma::ones(IMUModel::size) * 1e-4;
+
+    arma::mat33 accelerometerNoise = arma::eye(3, 3) * 0.5;
+    arma::mat33 gyroscopeNoise = arma::eye(3, 3) * 0.1;
+
+    for(int i = 0; i < 500; ++i) {
+        reference.timeUpdate(0.01);
+        fixed.timeUpdate(0.01);
+
+        arma::vec3 accelerometer = { noise(rng), noise(rng), -9.8 + noise(rng) };
+        double a = reference.measurementUpdate(accelerometer, accelerometerNoise, IMUModel::MeasurementType::ACCELEROMETER());
+        double b = fixed.measurementUpdate(accelerometer, accelerometerNoise, IMUModel::MeasurementType::ACCELEROMETER());
+        requireAgreement(reference, fixed, a, b);
+
+        arma::vec3 gyroscope = angularVelocity() + arma::vec3({ noise(rng), noise(rng), noise(rng) }) * 0.1;
+        a = reference.measurementUpdate(gyroscope, gyroscopeNoise, IMUModel::MeasurementType::GYROSCOPE());
+        b = fixed.measurementUpdate(gyroscope, gyroscopeNoise, IMUModel::MeasurementType::GYROSCOPE());
+        requireAgreement(reference, fixed, a, b);
+    }
+}
+
+TEST_CASE("FixedUKF agrees with UKF for the adaptive IMU model", "[kalman][ukf]") {
+
+    std::mt19937 rng(2);
+    std::normal_distribution<double> noise(0, 0.3);
+
+    arma::vec::fixed<AdaptiveIMUModel::size> mean = { 0, 0, 1, 1, 0, 0 };
+    UKF<AdaptiveIMUModel> reference(mean);
+    FixedUKF<AdaptiveIMUModel> fixed(mean);
+
+    arma::mat33 accelerometerNoise = arma::eye(3, 3) * 0.5;
+
+    for(int i = 0; i < 500; ++i) {
+        arma::vec3 gyroscope = angularVelocity() + arma::vec3({ noise(rng), noise(rng), noise(rng) }) * 0.1;
+        reference.timeUpdate(0.01, gyroscope);
+        fixed.timeUpdate(0.01, gyroscope);
+
+        arma::vec3 accelerometer = { noise(rng), noise(rng), 9.8 + noise(rng) };
+        double a = reference.measurementUpdate(accelerometer, accelerometerNoise);
+        double b = fixed.measurementUpdate(accelerometer, accelerometerNoise);
+        requireAgreement(reference, fixed, a, b);
+    }
+}
+
+TEST_CASE("FixedUKF agrees with UKF for the inverse depth point model", "[kalman][ukf]") {
+
+    std::mt19937 rng(3);
+    std::normal_distribution<double> noise(0, 0.01);
+
+    arma::vec::fixed<InverseDepthPointModel::size> mean = { 0, 0, 0.5, 0.2, 0.1, 0.05 };
+    arma::mat::fixed<InverseDepthPointModel::size, InverseDepthPointModel::size> covariance = arma::eye(6, 6) * 0.001;
+    UKF<InverseDepthPointModel> reference(mean, covariance);
+    FixedUKF<InverseDepthPointModel> fixed(mean, covariance);
+
+    // SLAME passes its measurements with runtime sizes, so this goes through the dispatching overload
+    arma::mat worldToCamera = arma::eye(4, 4);
+    arma::mat measurementNoise = arma::eye(2, 2) * 1e-3;
+
+    for(int i = 0; i < 200; ++i) {
+        worldToCamera(0, 3) = -0.001 * i;
+
+        reference.timeUpdate(0.03);
+        fixed.timeUpdate(0.03);
+
+        arma::vec screenAngular = { 0.1 + noise(rng), 0.05 + noise(rng) };
+        double a = reference.measurementUpdate(screenAngular, measurementNoise, worldToCamera);
+        double b = fixed.measurementUpdate(screenAngular, measurementNoise, worldToCamera);
+        requireAgreement(reference, fixed, a, b);
+    }
+}
+
+TEST_CASE("FixedUKF agrees with UKF for the linear vec3 model", "[kalman][ukf]") {
+
+    std::mt19937 rng(4);
+    std::normal_distribution<double> noise(0, 1);
+
+    UKF<LinearVec3Model> reference;
+    FixedUKF<LinearVec3Model> fixed;
+
+    arma::mat33 measurementNoise = arma::eye(3, 3) * 0.2;
+
+    for(int i = 0; i < 500; ++i) {
+        arma::vec3 acceleration = { noise(rng), noise(rng), noise(rng) };
+        reference.timeUpdate(0.01, acceleration);
+        fixed.timeUpdate(0.01, acceleration);
+
+        arma::vec3 velocity = { noise(rng), noise(rng), noise(rng) };
+        double a = reference.measurementUpdate(velocity, measurementNoise, nullptr);
+        double b = fixed.measurementUpdate(velocity, measurementNoise, nullptr);
+        requireAgreement(reference, fixed, a, b);
+    }
+}
+
+TEST_CASE("FixedUKF agrees with UKF for the ball model", "[kalman][ukf]") {
+
+    std::mt19937 rng(5);
+    std::normal_distribution<double> noise(0, 0.05);
+
+    arma::vec::fixed<BallModel::size> mean = { 1, 0.5, 0.2, -0.1 };
+    UKF<BallModel> reference(mean);
+    FixedUKF<BallModel> fixed(mean);
+
+    arma::mat33 measurementNoise = arma::eye(3, 3) * 0.01;
+
+    for(int i = 0; i < 500; ++i) {
+        reference.timeUpdate(0.03);
+        fixed.timeUpdate(0.03);
+
+        double ballAngle = 0.1;
+        arma::vec3 observation = { 1.1 + noise(rng), 0.4 + noise(rng), 0.04 + noise(rng) * 0.1 };
+        double a = reference.measurementUpdate(observation, measurementNoise, ballAngle);
+        double b = fixed.measurementUpdate(observation, measurementNoise, ballAngle);
+        requireAgreement(reference, fixed, a, b);
+    }
+}
+
+TEST_CASE("Benchmark UKF against FixedUKF", "[kalman][ukf][benchmark][.]") {
+
+    {
+        arma::vec::fixed<IMUModel::size> mean = { 0.1, -0.2, 0.05, 1, 0, 0, 0 };
+        UKF<IMUModel> reference(mean);
+        FixedUKF<IMUModel> fixed(mean);
+        reference.model.processNoiseDiagonal = arma::ones(IMUModel::size) * 1e-4;
+        fixed.model.processNoiseDiagonal = arma::ones(IMUModel::size) * 1e-4;
+
+        arma::vec3 accelerometer = { 0.1, 0.2, -9.8 };
+        arma::mat33 noise = arma::eye(3, 3) * 0.5;
+
+        report("IMUModel", updatesPerSecond([&] (int) {
+            reference.timeUpdate(0.01);
+            reference.measurementUpdate(accelerometer, noise, IMUModel::MeasurementType::ACCELEROMETER());
+        }), updatesPerSecond([&] (int) {
+            fixed.timeUpdate(0.01);
+            fixed.measurementUpdate(accelerometer, noise, IMUModel::MeasurementType::ACCELEROMETER());
+        }));
+    }
+
+    {
+        arma::vec::fixed<AdaptiveIMUModel::size> mean = { 0, 0, 1, 1, 0, 0 };
+        UKF<AdaptiveIMUModel> reference(mean);
+        FixedUKF<AdaptiveIMUModel> fixed(mean);
+
+        arma::vec3 gyroscope = angularVelocity();
+        arma::vec3 accelerometer = { 0.1, 0.2, 9.8 };
+        arma::mat33 noise = arma::eye(3, 3) * 0.5;
+
+        report("AdaptiveIMUModel", updatesPerSecond([&] (int) {
+            reference.timeUpdate(0.01, gyroscope);
+            reference.measurementUpdate(accelerometer, noise);
+        }), updatesPerSecond([&] (int) {
+            fixed.timeUpdate(0.01, gyroscope);
+            fixed.measurementUpdate(accelerometer, noise);
+        }));
+    }
+
+    {
+        arma::vec::fixed<InverseDepthPointModel::size> mean = { 0, 0, 0.5, 0.2, 0.1, 0.05 };
+        arma::mat::fixed<InverseDepthPointModel::size, InverseDepthPointModel::size> covariance = arma::eye(6, 6) * 0.001;
+        UKF<InverseDepthPointModel> reference(mean, covariance);
+        FixedUKF<InverseDepthPointModel> fixed(mean, covariance);
+
+        arma::mat worldToCamera = arma::eye(4, 4);
+        arma::vec2 screenAngular = { 0.1, 0.05 };
+        arma::mat22 noise = arma::eye(2, 2) * 1e-3;
+
+        report("InverseDepthPointModel", updatesPerSecond([&] (int) {
+            reference.timeUpdate(0.03);
+            reference.measurementUpdate(screenAngular, noise, worldToCamera);
+        }), updatesPerSecond([&] (int) {
+            fixed.timeUpdate(0.03);
+            fixed.measurementUpdate(screenAngular, noise, worldToCamera);
+        }));
+    }
+
+    {
+        UKF<LinearVec3Model> reference;
+        FixedUKF<LinearVec3Model> fixed;
+
+        arma::vec3 acceleration = { 0.1, 0.2, 0.3 };
+        arma::vec3 velocity = { 1, 2, 3 };
+        arma::mat33 noise = arma::eye(3, 3) * 0.2;
+
+        report("LinearVec3Model", updatesPerSecond([&] (int) {
+            reference.timeUpdate(0.01, acceleration);
+            reference.measurementUpdate(velocity, noise, nullptr);
+        }), updatesPerSecond([&] (int) {
+            fixed.timeUpdate(0.01, acceleration);
+            fixed.measurementUpdate(velocity, noise, nullptr);
+        }));
+    }
+
+    {
+        arma::vec::fixed<BallModel::size> mean = { 1, 0.5, 0.2, -0.1 };
+        UKF<BallModel> reference(mean);
+        FixedUKF<BallModel> fixed(mean);
+
+        arma::vec3 observation = { 1.1, 0.4, 0.04 };
+        arma::mat33 noise = arma::eye(3, 3) * 0.01;
+
+        report("BallModel", updatesPerSecond([&] (int) {
+            reference.timeUpdate(0.03);
+            reference.measurementUpdate(observation, noise, 0.1);
+        }), updatesPerSecond([&] (int) {
+            fixed.timeUpdate(0.03);
+            fixed.measurementUpdate(observation, noise, 0.1);
+        }));
+    }
+}
@@ -192,11 +192,11 @@ namespace localisation {
     }
 
     void MMKFRobotLocalisationEngine::Reset(const ResetRobotHypotheses& reset, const Sensors& sensors) {
-        robot_models_.robot_models_ = std::vector<std::unique_ptr<RobotHypothesis>>();
+        robot_models_.ClearModels();
         for (const auto& reset_hyp : reset.hypotheses) {
-            auto hyp = std::make_unique<RobotHypothesis>(reset_hyp, sensors);
-            hyp->weight_ = 1 / double(reset.hypotheses.size());
-            robot_models_.robot_models_.push_back(std::move(hyp));
+            RobotHypothesis hyp(reset_hyp, sensors);
+            hyp.weight_ = 1 / double(reset.hypotheses.size());
+            robot_models_.AddModel(hyp);
         }
     }
 
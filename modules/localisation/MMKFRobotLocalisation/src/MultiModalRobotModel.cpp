@@ -17,6 +17,8 @@
  * Copyright 2013 NUBots <nubots@nubots.net>
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 
 #include "MultiModalRobotModel.h"
@@ -55,8 +57,9 @@ std::ostream & operator<<(std::ostream &os, const RobotHypothesis& h) {
 }
 
 void MultiModalRobotModel::TimeUpdate(double seconds, const Sensors& sensors) {
-    for (auto& model : robot_models_)
-        model->TimeUpdate(seconds, sensors);
+    ForEachModel([&](RobotHypothesis& model, size_t) {
+        model.TimeUpdate(seconds, sensors);
+    });
 }
 void RobotHypothesis::TimeUpdate(double seconds, const Sensors& sensors) {
     filter_.timeUpdate(seconds, sensors);
@@ -66,8 +69,9 @@ void MultiModalRobotModel::MeasurementUpdate(
     const messages::vision::VisionObject& observed_object,
     const LocalisationFieldObject& actual_object) {
 
-    for (auto& model : robot_models_)
-        model->MeasurementUpdate(observed_object, actual_object);
+    ForEachModel([&](RobotHypothesis& model, size_t) {
+        model.MeasurementUpdate(observed_object, actual_object);
+    });
 }
 
 
@@ -75,8 +79,9 @@ void MultiModalRobotModel::MeasurementUpdate(
     const std::vector<messages::vision::VisionObject>& observed_objects,
     const std::vector<LocalisationFieldObject>& actual_objects) {
 
-    for (auto& model : robot_models_)
-        model->MeasurementUpdate(observed_objects, actual_objects);
+    ForEachModel([&](RobotHypothesis& model, size_t) {
+        model.MeasurementUpdate(observed_objects, actual_objects);
+    });
 }
 
 double RobotHypothesis::MeasurementUpdate(
@@ -101,8 +106,9 @@ double RobotHypothesis::MeasurementUpdate(
 
 //Odometry
 void MultiModalRobotModel::MeasurementUpdate(const Sensors& sensors){
-    for (auto& model : robot_models_)
-        model->MeasurementUpdate(sensors);
+    ForEachModel([&](RobotHypothesis& model, size_t) {
+        model.MeasurementUpdate(sensors);
+    });
 }
 
 double RobotHypothesis::MeasurementUpdate(const Sensors& sensors){
@@ -142,6 +148,30 @@ double RobotHypothesis::MeasurementUpdate(
 //         model->SetSensorsData(sensors);
 // }
 
+void MultiModalRobotModel::SplitModels(size_t splits) {
+    split_models_.clear();
+
+    if (splits == 0) {
+        pool_.Release(robot_models_.begin(), robot_models_.end());
+        robot_models_.clear();
+        return;
+    }
+
+    split_models_.reserve(robot_models_.size() * splits);
+
+    for (auto& model : robot_models_) {
+        for (size_t i = 1; i < splits; ++i) {
+            split_models_.push_back(pool_.Copy(*model));
+        }
+
+        // The original becomes the last split
+        split_models_.push_back(std::move(model));
+    }
+
+    std::swap(robot_models_, split_models_);
+    split_models_.clear();
+}
+
 /*! @brief Performs an ambiguous measurement update using the exhaustive
  *  process.
  *  This creates a new model for each possible location for the measurement.
@@ -151,36 +181,22 @@ void MultiModalRobotModel::AmbiguousMeasurementUpdate(
     const messages::vision::VisionObject& ambiguous_object,
     const std::vector<LocalisationFieldObject>& possible_objects) {
 
-    std::vector<std::unique_ptr<RobotHypothesis>> new_models;
-    new_models.reserve(possible_objects.size() * robot_models_.size());
+    // Split the model for each possible object, and observe that object:
+    SplitModels(possible_objects.size());
 
-    // For each model:
-    while (!robot_models_.empty()) {
-        auto model = std::move(robot_models_.back());
-        robot_models_.pop_back();
+    ForEachModel([&](RobotHypothesis& split_model, size_t i) {
+        auto& possible_object = possible_objects[i % possible_objects.size()];
 
-        // Split the model for each possible object, and observe that object:
-        // (TODO: Micro-optimisation: use model as the last split_model)
-        for (auto& possible_object : possible_objects) {
-            // std::cout << "possible_object: " << possible_object << std::endl;
+        split_model.obs_count_++;
 
-            auto split_model = std::make_unique<RobotHypothesis>(*model);
+        auto quality = split_model.MeasurementUpdate(ambiguous_object,
+                                                     possible_object);
 
-            split_model->obs_count_++;
-
-            auto quality = split_model->MeasurementUpdate(ambiguous_object,
-                                                          possible_object);
-
-            // Weight the new model based on the 'quality' of the observation
-            // just made.
-            auto weight = split_model->GetFilterWeight();
-            split_model->SetFilterWeight(weight * quality);
-
-            new_models.push_back(std::move(split_model));
-        }
-    }
-
-    robot_models_ = std::move(new_models);
+        // Weight the new model based on the 'quality' of the observation
+        // just made.
+        auto weight = split_model.GetFilterWeight();
+        split_model.SetFilterWeight(weight * quality);
+    });
 }
 
 
@@ -194,36 +210,23 @@ void MultiModalRobotModel::AmbiguousMeasurementUpdate(
     const std::vector<messages::vision::VisionObject>& ambiguous_objects,
     const std::vector<std::vector<LocalisationFieldObject>>& possible_object_sets) {
 
-    std::vector<std::unique_ptr<RobotHypothesis>> new_models;
-    new_models.reserve(possible_object_sets.size() * robot_models_.size());
+    // Split the model for each possible object set, and observe those objects:
+    SplitModels(possible_object_sets.size());
 
-    // For each model:
-    while (!robot_models_.empty()) {
-        auto model = std::move(robot_models_.back());
-        robot_models_.pop_back();
+    ForEachModel([&](RobotHypothesis& split_model, size_t i) {
+        auto& object_set = possible_object_sets[i % possible_object_sets.size()];
 
-        // Split the model for each possible object, and observe that object:
-        // (TODO: Micro-optimisation: use model as the last split_model)
-        for (auto& object_set : possible_object_sets) {
-            auto split_model = std::make_unique<RobotHypothesis>(*model);
+        for (int j = 0; j < int(object_set.size()); j++) {
+            split_model.obs_count_++;
 
-            for (int i = 0; i < int(object_set.size()); i++) {
-                split_model->obs_count_++;
+            auto quality = split_model.MeasurementUpdate(ambiguous_objects[j], object_set[j]);
 
-                auto quality = split_model->MeasurementUpdate(ambiguous_objects[i], object_set[i]);
-
-                // Weight the new model based on the 'quality' of the observation
-                // just made.
-                auto weight = split_model->GetFilterWeight();
-                split_model->SetFilterWeight(weight * quality);
-            }
-
-            new_models.push_back(std::move(split_model));
+            // Weight the new model based on the 'quality' of the observation
+            // just made.
+            auto weight = split_model.GetFilterWeight();
+            split_model.SetFilterWeight(weight * quality);
         }
-    }
-
-    robot_models_ = std::move(new_models);
-
+    });
 }
 
 // For an ordered list of observations which is known to be correspond one of
@@ -236,52 +239,41 @@ void MultiModalRobotModel::AmbiguousMultipleMeasurementUpdate(
     const std::vector<messages::vision::VisionObject>& ambiguous_objects,
     const std::vector<std::vector<LocalisationFieldObject>>& possible_object_sets) {
 
-    std::vector<std::unique_ptr<RobotHypothesis>> new_models;
-    new_models.reserve(possible_object_sets.size() * robot_models_.size());
-
-    // For each model:
-    while (!robot_models_.empty()) {
-        auto model = std::move(robot_models_.back());
-        robot_models_.pop_back();
-
-        // Split the model for each possible object, and observe that object:
-        // (TODO: Micro-optimisation: use model as the last split_model)
-        for (auto& object_set : possible_object_sets) {
-            auto split_model = std::make_unique<RobotHypothesis>(*model);
-
-            split_model->obs_count_++;
+    // Split the model for each possible object set, and observe those objects:
+    SplitModels(possible_object_sets.size());
 
-            auto quality = split_model->MeasurementUpdate(ambiguous_objects,
-                                                          object_set);
+    ForEachModel([&](RobotHypothesis& split_model, size_t i) {
+        auto& object_set = possible_object_sets[i % possible_object_sets.size()];
 
-            // Weight the new model based on the 'quality' of the observation
-            // just made.
-            auto weight = split_model->GetFilterWeight();
-            split_model->SetFilterWeight(weight * quality);
+        split_model.obs_count_++;
 
-            new_models.push_back(std::move(split_model));
-        }
-    }
+        auto quality = split_model.MeasurementUpdate(ambiguous_objects,
+                                                     object_set);
 
-    robot_models_ = std::move(new_models);
+        // Weight the new model based on the 'quality' of the observation
+        // just made.
+        auto weight = split_model.GetFilterWeight();
+        split_model.SetFilterWeight(weight * quality);
+    });
 }
 
 void MultiModalRobotModel::RemoveOldModels() {
-    std::vector<std::unique_ptr<RobotHypothesis>> new_models;
-    new_models.reserve(robot_models_.size());
-
-    // For each model:
-    while (!robot_models_.empty()) {
-        auto model = std::move(robot_models_.back());
+    auto old = std::stable_partition(robot_models_.begin(), robot_models_.end(),
+        [](const std::unique_ptr<RobotHypothesis>& model) {
+            return model->obs_count_ <= 4;
+        });
 
-        if (model->obs_count_ <= 4) {
-            new_models.push_back(std::move(model));
-        }
+    pool_.Release(old, robot_models_.end());
+    robot_models_.erase(old, robot_models_.end());
+}
 
-        robot_models_.pop_back();
-    }
+void MultiModalRobotModel::ClearModels() {
+    pool_.Release(robot_models_.begin(), robot_models_.end());
+    robot_models_.clear();
+}
 
-    robot_models_ = std::move(new_models);
+void MultiModalRobotModel::AddModel(const RobotHypothesis& hypothesis) {
+    robot_models_.push_back(pool_.Copy(hypothesis));
 }
 
 void MultiModalRobotModel::PruneModels() {
@@ -312,65 +304,84 @@ bool MultiModalRobotModel::ModelsAreSimilar(
 }
 
 /// Reduces the number of active models by merging similar models together
-// TODO: Find a neater, yet performant way of writing this method
+// Models are merged into the heaviest model they are similar to. As similar models are closer together than
+// merge_min_translation_dist, they are bucketed into a grid of that size and only neighbouring cells are compared.
 void MultiModalRobotModel::MergeSimilarModels() {
 
-    // Sort models by weight from smallest to largest.
+    // Sort models by weight from largest to smallest.
     std::sort(robot_models_.begin(), robot_models_.end(),
         [](const std::unique_ptr<RobotHypothesis> & a,
            const std::unique_ptr<RobotHypothesis> & b) {
-            return a->GetFilterWeight() < b->GetFilterWeight();
+            return a->GetFilterWeight() > b->GetFilterWeight();
         });
 
-    std::vector<std::unique_ptr<RobotHypothesis>> new_models;
-    new_models.reserve(robot_models_.size());
+    const double cell_size = cfg_.merge_min_translation_dist;
 
-    // Create a bool array to indicate which models have been merged
-    // into another model and should thus be ignored
-    std::vector<bool> merged;
-    merged.resize(robot_models_.size(), false);
+    // Nothing can be closer than a distance of zero
+    if (cell_size <= 0) {
+        return;
+    }
 
-    // Loop through each pair of merged models
-    for (int ma = robot_models_.size() - 1; ma >= 0; ma--) {
-        if (merged[ma])
+    auto cellOf = [&](size_t i) {
+        auto estimate = robot_models_[i]->GetEstimate();
+        return MergeCell {
+            int64_t(std::floor(estimate(robot::kX) / cell_size)),
+            int64_t(std::floor(estimate(robot::kY) / cell_size)),
+            i
+        };
+    };
+
+    // Find the cell each model is in and sort them so each cell is a contiguous run
+    merge_cells_.clear();
+    for (size_t i = 0; i < robot_models_.size(); ++i) {
+        merge_cells_.push_back(cellOf(i));
+    }
+    std::sort(merge_cells_.begin(), merge_cells_.end());
+
+    // Indicates which models have been merged into another model and should thus be ignored
+    merged_.assign(robot_models_.size(), false);
+
+    // Merge lighter models into each model that has not itself been merged, heaviest first
+    for (size_t ma = 0; ma < robot_models_.size(); ++ma) {
+        if (merged_[ma])
             continue;
 
-        // Compare the last model in the list to all the models before it
-        for (int mb = ma - 1; mb >= 0; mb--) {
-            if (merged[mb])
-                continue;
+        auto& model_a = robot_models_[ma];
+        auto cell = cellOf(ma);
 
-            auto& model_a = robot_models_[ma];
-            auto& model_b = robot_models_[mb];
+        for (int64_t dx = -1; dx <= 1; ++dx) {
+            for (int64_t dy = -1; dy <= 1; ++dy) {
 
-            if (!ModelsAreSimilar(model_a, model_b)) {
-                continue;
-            }
+                // Only models after ma are lighter
+                auto first = std::lower_bound(merge_cells_.begin(), merge_cells_.end(), MergeCell { cell.x + dx, cell.y + dy, ma + 1 });
+                auto last = std::lower_bound(first, merge_cells_.end(), MergeCell { cell.x + dx, cell.y + dy + 1, 0 });
 
-            float wa = model_a->GetFilterWeight();
-            float wb = model_b->GetFilterWeight();
+                for (auto it = first; it != last; ++it) {
+                    size_t mb = it->index;
+                    auto& model_b = robot_models_[mb];
 
-            if (wa < wb) {
-                merged[ma] = true;
-                model_b->SetFilterWeight(wa + wb);
-            } else {
-                model_a->SetFilterWeight(wa + wb);
-                merged[mb] = true;
+                    if (merged_[mb] || !ModelsAreSimilar(model_a, model_b)) {
+                        continue;
+                    }
+
+                    model_a->SetFilterWeight(model_a->GetFilterWeight() + model_b->GetFilterWeight());
+                    merged_[mb] = true;
+                }
             }
         }
+    }
 
-        // If the model remains unmerged, move it to the new list
-        if (!merged[ma]) {
-            new_models.push_back(std::move(robot_models_[ma]));
-
-            // Pop the now invalid last model from robot_models
-            // Note: not strictly necessary
-            robot_models_.pop_back();
+    // Keep the unmerged models (still heaviest first) and return the rest to the pool
+    size_t kept = 0;
+    for (size_t i = 0; i < robot_models_.size(); ++i) {
+        if (merged_[i]) {
+            pool_.Release(std::move(robot_models_[i]));
+        }
+        else {
+            robot_models_[kept++] = std::move(robot_models_[i]);
         }
     }
-
-    // Replace the old models with the new list of merged models
-    robot_models_ = std::move(new_models);
+    robot_models_.resize(kept);
 }
 
 /* @brief Prunes the models using the Viterbi method. This removes lower
@@ -382,14 +393,15 @@ void MultiModalRobotModel::PruneViterbi(unsigned int order) {
     if(robot_models_.size() <= order)
         return;
 
-    // Sort models by weight from largest to smallest.
-    std::sort(robot_models_.begin(), robot_models_.end(),
+    // Bring the most likely models to the front, largest to smallest.
+    std::partial_sort(robot_models_.begin(), robot_models_.begin() + order, robot_models_.end(),
         [](const std::unique_ptr<RobotHypothesis> & a,
            const std::unique_ptr<RobotHypothesis> & b) {
             return a->GetFilterWeight() > b->GetFilterWeight();
         });
 
     // Keep only the desired number of elements.
+    pool_.Release(robot_models_.begin() + order, robot_models_.end());
     robot_models_.resize(order);
 }
 
@@ -20,10 +20,16 @@
 #ifndef MODULES_MULTIMODALROBOTMODEL_H
 #define MODULES_MULTIMODALROBOTMODEL_H
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <tuple>
 #include <armadillo>
 #include <nuclear>
 #include "utility/localisation/LocalisationFieldObject.h"
-#include "utility/math/kalman/UKF.h"
+#include "utility/math/kalman/FixedUKF.h"
+#include "utility/parallel/WorkerPool.h"
 #include "messages/support/Configuration.h"
 #include "messages/vision/VisionObjects.h"
 #include "RobotModel.h"
@@ -39,7 +45,7 @@ namespace localisation {
     class RobotHypothesis {
     // private:
     public: // for unit testing.
-        utility::math::kalman::UKF<robot::RobotModel> filter_;
+        utility::math::kalman::FixedUKF<robot::RobotModel> filter_;
 
         double weight_;
 
@@ -105,6 +111,44 @@ namespace localisation {
         friend std::ostream& operator<<(std::ostream &os, const RobotHypothesis& h);
     };
 
+    /**
+     * Holds on to hypotheses that have been discarded so that splitting can copy into one of them rather than
+     * allocating a new one. A hypothesis is fixed size so the copy does not allocate either.
+     */
+    class RobotHypothesisPool {
+    public:
+        std::unique_ptr<RobotHypothesis> Copy(const RobotHypothesis& hypothesis) {
+            if (free_.empty()) {
+                return std::make_unique<RobotHypothesis>(hypothesis);
+            }
+
+            auto copy = std::move(free_.back());
+            free_.pop_back();
+            *copy = hypothesis;
+            return copy;
+        }
+
+        void Release(std::unique_ptr<RobotHypothesis> hypothesis) {
+            if (hypothesis) {
+                free_.push_back(std::move(hypothesis));
+            }
+        }
+
+        template <typename Iterator>
+        void Release(Iterator first, Iterator last) {
+            for (auto it = first; it != last; ++it) {
+                Release(std::move(*it));
+            }
+        }
+
+        size_t size() const {
+            return free_.size();
+        }
+
+    private:
+        std::vector<std::unique_ptr<RobotHypothesis>> free_;
+    };
+
     class MultiModalRobotModel {
     public:
         MultiModalRobotModel() {
@@ -117,6 +161,7 @@ namespace localisation {
             cfg_.max_models_after_merge = config["MaxModelsAfterMerge"].as<int>();
             cfg_.merge_min_translation_dist = config["MergeMinTranslationDist"].as<float>();
             cfg_.merge_min_heading_dist = config["MergeMinHeadingDist"].as<float>();
+            cfg_.worker_threads = config["WorkerThreads"].as<uint>();
 
             robot::RobotModel::Config rm_cfg;
             rm_cfg.processNoisePositionFactor = config["ProcessNoisePositionFactor"].as<double>();
@@ -180,20 +225,87 @@ namespace localisation {
             return robot_models_;
         }
 
+        /// Drops every hypothesis (keeping them in the pool for reuse)
+        void ClearModels();
+
+        /// Adds a copy of the given hypothesis
+        void AddModel(const RobotHypothesis& hypothesis);
+
+        /**
+         * Calls function(hypothesis, index) for every hypothesis, sharing them out between the worker pool.
+         * Each hypothesis is only touched by one thread, so the function must not touch the others.
+         */
+        template <typename TFunction>
+        void ForEachModel(TFunction&& function) {
+            const size_t count = robot_models_.size();
+
+            // A handful of hypotheses is not worth waking the workers for
+            auto& pool = utility::parallel::WorkerPool::instance();
+            size_t workers = cfg_.worker_threads == 0 ? pool.size() : cfg_.worker_threads;
+            workers = std::min(workers, (count + kMinModelsPerWorker - 1) / kMinModelsPerWorker);
+
+            std::atomic<size_t> next(0);
+            std::exception_ptr error;
+            std::mutex error_mutex;
+
+            pool.run(uint(workers), [&](uint) {
+                for (size_t i = next++; i < count; i = next++) {
+                    try {
+                        function(*robot_models_[i], i);
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            });
+
+            // Exceptions can't leave a worker thread so hand the first one back to the caller
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
     private:
+        static constexpr size_t kMinModelsPerWorker = 8;
+
         void PruneViterbi(unsigned int order);
+
+        // Replaces each hypothesis with the given number of copies of itself (the copies of a hypothesis are adjacent)
+        void SplitModels(size_t splits);
         // int AmbiguousLandmarkUpdateExhaustive(
         //     AmbiguousObject &ambiguous_object,
         //     const std::vector<StationaryObject*>& possible_objects);
 
+        // A hypothesis in the merge grid: the cell it is in and its rank by weight
+        struct MergeCell {
+            int64_t x;
+            int64_t y;
+            size_t index;
+
+            bool operator<(const MergeCell& other) const {
+                return std::tie(x, y, index) < std::tie(other.x, other.y, other.index);
+            }
+        };
+
+        // Working space kept between updates
+        std::vector<std::unique_ptr<RobotHypothesis>> split_models_;
+        std::vector<MergeCell> merge_cells_;
+        std::vector<bool> merged_;
+
     public: // For unit testing
         std::vector<std::unique_ptr<RobotHypothesis>> robot_models_;
 
+        RobotHypothesisPool pool_;
+
         struct {
             bool merging_enabled = true;
             int max_models_after_merge = 2;
             float merge_min_translation_dist = 0.05;
             float merge_min_heading_dist = 0.01;
+            uint worker_threads = 0;
         } cfg_;
     };
 }
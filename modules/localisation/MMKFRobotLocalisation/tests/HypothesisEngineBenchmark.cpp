@@ -0,0 +1,249 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "utility/localisation/mock.h"
+#include "utility/math/angle.h"
+#include "MultiModalRobotModel.h"
+
+using messages::input::Sensors;
+using messages::vision::Goal;
+using modules::localisation::MultiModalRobotModel;
+using modules::localisation::RobotHypothesis;
+using modules::localisation::robot::RobotModel;
+using utility::localisation::LFOId;
+using utility::localisation::LocalisationFieldObject;
+using utility::localisation::mock::goalObservation;
+using utility::localisation::mock::robotPath;
+using utility::localisation::mock::robotSensors;
+using utility::math::angle::vectorToBearing;
+
+namespace {
+
+    const LocalisationFieldObject goalpost_bl = { arma::vec2({ -4.5, -0.75 }), LFOId::kGoalBL, "goalpost_blue_left" };
+    const LocalisationFieldObject goalpost_br = { arma::vec2({ -4.5,  0.75 }), LFOId::kGoalBR, "goalpost_blue_right" };
+    const LocalisationFieldObject goalpost_yl = { arma::vec2({  4.5,  0.75 }), LFOId::kGoalYL, "goalpost_yellow_left" };
+    const LocalisationFieldObject goalpost_yr = { arma::vec2({  4.5, -0.75 }), LFOId::kGoalYR, "goalpost_yellow_right" };
+
+    constexpr double FRAME_RATE = 30;
+    constexpr double PATH_PERIOD = 100;
+
+    // What MockRobot would see at time t while walking its path
+    struct MockFrame {
+        std::shared_ptr<Sensors> sensors;
+        std::vector<Goal> goals;
+    };
+
+    MockFrame mockFrame(double t) {
+        arma::vec2 position = robotPath(t, PATH_PERIOD);
+        arma::vec2 diff = position - robotPath(t - 1 / FRAME_RATE, PATH_PERIOD);
+        double heading = vectorToBearing(diff);
+
+        arma::vec2 imu_direction = { std::cos(2 * M_PI * t / 300), std::sin(2 * M_PI * t / 300) };
+
+        MockFrame frame;
+        frame.sensors = robotSensors(heading, imu_direction, arma::vec2({ arma::norm(diff) * 100, 0 }));
+
+        // Look at the goal we are facing
+        bool facing_blue = heading < -M_PI * 0.5 || heading > M_PI * 0.5;
+        auto& left = facing_blue ? goalpost_bl : goalpost_yl;
+        auto& right = facing_blue ? goalpost_br : goalpost_yr;
+        frame.goals.push_back(goalObservation(position, heading, left.location(), Goal::Side::LEFT, frame.sensors));
+        frame.goals.push_back(goalObservation(position, heading, right.location(), Goal::Side::RIGHT, frame.sensors));
+
+        return frame;
+    }
+
+    // One camera frame of the engine: predict, odometry, split on each goal post, then merge and prune
+    void processFrame(MultiModalRobotModel& model, const MockFrame& frame) {
+        model.TimeUpdate(1 / FRAME_RATE, *frame.sensors);
+        model.MeasurementUpdate(*frame.sensors);
+
+        for (auto& goal : frame.goals) {
+            if (goal.side == Goal::Side::LEFT) {
+                model.AmbiguousMeasurementUpdate(goal, { goalpost_bl, goalpost_yl });
+            }
+            else {
+                model.AmbiguousMeasurementUpdate(goal, { goalpost_br, goalpost_yr });
+            }
+        }
+
+        model.PruneModels();
+    }
+
+    // Fills the model with hypotheses scattered over the field
+    void scatterHypotheses(MultiModalRobotModel& model, size_t count, uint seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> x(-4.5, 4.5);
+        std::uniform_real_distribution<double> y(-3, 3);
+        std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+
+        model.ClearModels();
+        for (size_t i = 0; i < count; ++i) {
+            RobotHypothesis hypothesis;
+            hypothesis.filter_.setState(arma::vec::fixed<RobotModel::size>({ x(rng), y(rng), heading(rng), 0, 0 }),
+                                        arma::eye(RobotModel::size, RobotModel::size) * 0.1);
+            hypothesis.SetFilterWeight(1.0 / count);
+            model.AddModel(hypothesis);
+        }
+
+        model.cfg_.max_models_after_merge = count;
+    }
+
+    // The all pairs merge that MergeSimilarModels replaced
+    std::vector<std::pair<float, arma::vec>> allPairsMerge(MultiModalRobotModel& model) {
+        auto& models = model.robot_models_;
+
+        std::sort(models.begin(), models.end(), [](const std::unique_ptr<RobotHypothesis>& a, const std::unique_ptr<RobotHypothesis>& b) {
+            return a->GetFilterWeight() > b->GetFilterWeight();
+        });
+
+        std::vector<bool> merged(models.size(), false);
+        std::vector<float> weights;
+        for (auto& m : models) {
+            weights.push_back(m->GetFilterWeight());
+        }
+
+        std::vector<std::pair<float, arma::vec>> result;
+        for (size_t a = 0; a < models.size(); ++a) {
+            if (merged[a]) {
+                continue;
+            }
+            for (size_t b = a + 1; b < models.size(); ++b) {
+                if (!merged[b] && model.ModelsAreSimilar(models[a], models[b])) {
+                    weights[a] += weights[b];
+                    merged[b] = true;
+                }
+            }
+            result.push_back(std::make_pair(weights[a], arma::vec(models[a]->GetEstimate())));
+        }
+
+        return result;
+    }
+}
+
+TEST_CASE("Bucketed merging merges the same hypotheses as comparing every pair", "[localisation][mmkf]") {
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> position(-0.5, 0.5);
+    std::uniform_real_distribution<double> heading(-0.02, 0.02);
+    std::uniform_real_distribution<double> weight(0.1, 1);
+
+    for (int trial = 0; trial < 20; ++trial) {
+        MultiModalRobotModel bucketed;
+        MultiModalRobotModel reference;
+        bucketed.ClearModels();
+        reference.ClearModels();
+
+        // Dense enough that plenty of hypotheses share or straddle cells
+        for (int i = 0; i < 300; ++i) {
+            RobotHypothesis hypothesis;
+            hypothesis.filter_.setState(arma::vec::fixed<RobotModel::size>({ position(rng), position(rng), heading(rng), 0, 0 }),
+                                        arma::eye(RobotModel::size, RobotModel::size) * 0.1);
+            hypothesis.SetFilterWeight(weight(rng));
+            bucketed.AddModel(hypothesis);
+            reference.AddModel(hypothesis);
+        }
+
+        auto expected = allPairsMerge(reference);
+        bucketed.MergeSimilarModels();
+
+        REQUIRE(bucketed.robot_models_.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(bucketed.robot_models_[i]->GetFilterWeight() == Approx(expected[i].first));
+            REQUIRE(arma::norm(arma::vec(bucketed.robot_models_[i]->GetEstimate()) - expected[i].second) == 0);
+        }
+    }
+}
+
+TEST_CASE("Updating hypotheses in parallel gives the same result as updating them serially", "[localisation][mmkf]") {
+
+    MultiModalRobotModel serial;
+    MultiModalRobotModel parallel;
+
+    scatterHypotheses(serial, 64, 3);
+    scatterHypotheses(parallel, 64, 3);
+    serial.cfg_.worker_threads = 1;
+
+    for (int i = 0; i < 30; ++i) {
+        auto frame = mockFrame(10 + i / FRAME_RATE);
+        processFrame(serial, frame);
+        processFrame(parallel, frame);
+
+        REQUIRE(serial.robot_models_.size() == parallel.robot_models_.size());
+        for (size_t j = 0; j < serial.robot_models_.size(); ++j) {
+            REQUIRE(serial.robot_models_[j]->GetFilterWeight() == parallel.robot_models_[j]->GetFilterWeight());
+            REQUIRE(arma::norm(arma::vec(serial.robot_models_[j]->GetEstimate() - parallel.robot_models_[j]->GetEstimate())) == 0);
+        }
+    }
+}
+
+TEST_CASE("Splitting reuses pooled hypotheses", "[localisation][mmkf]") {
+
+    MultiModalRobotModel model;
+    scatterHypotheses(model, 32, 5);
+
+    // The first frame has to allocate the splits, after that pruning returns them to the pool for the next frame
+    processFrame(model, mockFrame(20));
+    size_t allocated = model.robot_models_.size() + model.pool_.size();
+
+    for (int i = 1; i < 10; ++i) {
+        processFrame(model, mockFrame(20 + i / FRAME_RATE));
+
+        REQUIRE(model.robot_models_.size() + model.pool_.size() == allocated);
+    }
+}
+
+TEST_CASE("Benchmark the hypothesis engine against the number of hypotheses", "[localisation][mmkf][benchmark][.]") {
+
+    constexpr int FRAMES = 60;
+
+    for (size_t count : { 16, 64, 128, 256, 512 }) {
+        for (uint threads : { 1u, 0u }) {
+
+            MultiModalRobotModel model;
+            scatterHypotheses(model, count, 11);
+            model.cfg_.worker_threads = threads;
+
+            std::vector<MockFrame> frames;
+            for (int i = 0; i < FRAMES; ++i) {
+                frames.push_back(mockFrame(30 + i / FRAME_RATE));
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (auto& frame : frames) {
+                processFrame(model, frame);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Each frame does a time and odometry update on every hypothesis then two measurement updates on each of
+            // its four splits
+            double updates = double(FRAMES) * count * (2 + 2 * 2 + 4 * 2);
+
+            std::cout << count << " hypotheses, " << (threads == 0 ? "all" : std::to_string(threads)) << " thread(s): "
+                      << FRAMES / seconds << " frames/s, "
+                      << updates / seconds << " hypothesis updates/s" << std::endl;
+        }
+    }
+}
@@ -29,7 +29,7 @@ using utility::localisation::transform::RobotToWorldTransform;
 using utility::math::angle::normalizeAngle;
 using modules::localisation::MultiModalRobotModel;
 using modules::localisation::RobotHypothesis;
-using utility::math::kalman::UKF;
+using utility::math::kalman::FixedUKF;
 using modules::localisation::robot::RobotModel;
 
 TEST_CASE("Angle convinience functions should handle corner cases", "[math][angle]") {
@@ -106,7 +106,7 @@ TEST_CASE("MultiModalRobotModel::MergeSimilarModels tests") {
         INFO("Test merge with two identical and one different input models");
         MultiModalRobotModel mmrm;
         auto hyp = std::make_unique<RobotHypothesis>();
-        hyp->filter_ = UKF<RobotModel>(arma::vec({10, 20, 30}));
+        hyp->filter_ = FixedUKF<RobotModel>(arma::vec::fixed<RobotModel::size>({10, 20, 30}));
         mmrm.robot_models_.push_back(std::move(hyp));
         mmrm.robot_models_.push_back(std::make_unique<RobotHypothesis>());
         REQUIRE(mmrm.robot_models_.size() == 3);
@@ -24,6 +24,7 @@
 #include "utility/math/coordinates.h"
 #include "utility/nubugger/NUhelpers.h"
 #include "utility/localisation/transform.h"
+#include "utility/localisation/mock.h"
 #include "utility/motion/ForwardKinematics.h"
 #include "messages/vision/VisionObjects.h"
 #include "messages/support/Configuration.h"
@@ -42,6 +43,10 @@ using utility::motion::kinematics::calculateRobotToIMU;
 using utility::localisation::transform::SphericalRobotObservation;
 using utility::localisation::transform::WorldToRobotTransform;
 using utility::localisation::transform::RobotToWorldTransform;
+using utility::localisation::mock::triangleWave;
+using utility::localisation::mock::robotPath;
+using utility::localisation::mock::robotSensors;
+using utility::localisation::mock::goalObservation;
 using utility::nubugger::graph;
 using messages::support::Configuration;
 using messages::support::FieldDescription;
@@ -51,11 +56,6 @@ using messages::localisation::Mock;
 namespace modules {
 namespace localisation {
 
-    double triangle_wave(double t, double period) {
-        auto a = period; // / 2.0;
-        auto k = t / a;
-        return 2.0 * std::abs(2.0 * (k - std::floor(k + 0.5))) - 1.0;
-    }
     double sawtooth_wave(double t, double period) {
         return 2.0 * std::fmod(t / period, 1.0) - 1.0;
     }
@@ -112,16 +112,10 @@ namespace localisation {
 
             auto t = absolute_time();
             double period = cfg_.robot_movement_path_period;
-            double x_amp = 3;
-            double y_amp = 2;
 
             arma::vec2 old_pos = arma::vec2(robot_position_);
 
-            auto wave1 = triangle_wave(t, period);
-            auto wave2 = triangle_wave(t + (period / 4.0), period);
-            // auto wave1 = sine_wave(t, period);
-            // auto wave2 = sine_wave(t + (period / 4.0), period);
-            robot_position_ = arma::vec2({ wave1 * x_amp, wave2 * y_amp });
+            robot_position_ = robotPath(t, period);
 
             arma::vec2 diff = robot_position_ - old_pos;
 
@@ -145,8 +139,8 @@ namespace localisation {
             double x_amp = 3;
             double y_amp = 2;
 
-            auto triangle1 = triangle_wave(t, period);
-            auto triangle2 = triangle_wave(t + (period / 4.0), period);
+            auto triangle1 = triangleWave(t, period);
+            auto triangle2 = triangleWave(t + (period / 4.0), period);
             ball_position_ = { triangle1 * x_amp, triangle2 * y_amp };
 
             auto velocity_x = -square_wave(t, period) * ((x_amp * 4) / period);
@@ -165,31 +159,7 @@ namespace localisation {
                 return;
             }
 
-            auto sensors = std::make_shared<messages::input::Sensors>();
-
-
-            // Sensors:
-
-            // orientation
-            arma::vec2 robot_imu_dir_ = WorldToRobotTransform(arma::vec2({0, 0}), robot_heading_, world_imu_direction_);
-            arma::mat orientation = arma::eye(3, 3);
-
-                orientation.submat(0, 0, 1, 0) = robot_imu_dir_;
-                orientation.submat(0, 1, 1, 1) = arma::vec2({ -robot_imu_dir_(1), robot_imu_dir_(0) });
-
-            sensors->orientation = orientation;
-            sensors->robotToIMU = calculateRobotToIMU(sensors->orientation);
-
-            // orientationCamToGround
-            sensors->orientationCamToGround = arma::eye(4, 4);
-
-            // forwardKinematics
-            sensors->forwardKinematics[ServoID::HEAD_PITCH] = arma::eye(4, 4);
-
-            //Odometry simulation
-            sensors->odometry = robot_odometry_;
-            sensors->odometryCovariance = arma::eye(2,2) * 0.05;
-
+            auto sensors = robotSensors(robot_heading_, world_imu_direction_, robot_odometry_);
 
             // Goal observation
             if (cfg_.simulate_goal_observations) {
@@ -205,37 +175,19 @@ namespace localisation {
                     goal_r_pos.rows(0, 1) = field_description_->goalpost_br;
                 }
 
+                auto left_side = messages::vision::Goal::Side::UNKNOWN;
+                auto right_side = messages::vision::Goal::Side::UNKNOWN;
+                if (cfg_.distinguish_left_and_right_goals) {
+                    left_side = messages::vision::Goal::Side::LEFT;
+                    right_side = messages::vision::Goal::Side::RIGHT;
+                }
+
                 if (cfg_.observe_left_goal) {
-                    messages::vision::Goal goal1;
-                    messages::vision::VisionObject::Measurement g1_m;
-                    g1_m.position = SphericalRobotObservation(robot_position_, robot_heading_, goal_r_pos);
-                    g1_m.error = arma::eye(3, 3) * 0.1;
-                    goal1.measurements.push_back(g1_m);
-                    goal1.measurements.push_back(g1_m);
-                    goal1.side = messages::vision::Goal::Side::RIGHT;
-                    if (cfg_.distinguish_left_and_right_goals) {
-                        goal1.side = messages::vision::Goal::Side::RIGHT;
-                    } else {
-                        goal1.side = messages::vision::Goal::Side::UNKNOWN;
-                    }
-                    goal1.sensors = sensors;
-                    goals->push_back(goal1);
+                    goals->push_back(goalObservation(robot_position_, robot_heading_, goal_r_pos.rows(0, 1), right_side, sensors));
                 }
 
                 if (cfg_.observe_right_goal) {
-                    messages::vision::Goal goal2;
-                    messages::vision::VisionObject::Measurement g2_m;
-                    g2_m.position = SphericalRobotObservation(robot_position_, robot_heading_, goal_l_pos);
-                    g2_m.error = arma::eye(3, 3) * 0.1;
-                    goal2.measurements.push_back(g2_m);
-                    goal2.measurements.push_back(g2_m);
-                    if (cfg_.distinguish_left_and_right_goals) {
-                        goal2.side = messages::vision::Goal::Side::LEFT;
-                    } else {
-                        goal2.side = messages::vision::Goal::Side::UNKNOWN;
-                    }
-                    goal2.sensors = sensors;
-                    goals->push_back(goal2);
+                    goals->push_back(goalObservation(robot_position_, robot_heading_, goal_l_pos.rows(0, 1), left_side, sensors));
                 }
 
                 if (goals->size() > 0)
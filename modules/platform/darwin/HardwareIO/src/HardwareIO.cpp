@@ -148,10 +148,7 @@ namespace darwin {
         });
 
         // This trigger gets the sensor data from the CM730
-        on<Trigger<Every<60, Per<std::chrono::seconds>>>, Options<Single>>([this](const time_t&) {
-
-            // Our final sensor output
-            auto sensors = std::make_unique<DarwinSensors>();
+        on<Trigger<Every<100, Per<std::chrono::seconds>>>, Options<Single>>([this](const time_t&) {
 
             std::vector<uint8_t> command = {
                 0xFF,
@@ -204,18 +201,45 @@ namespace darwin {
                 // Do a checksum
                 command.push_back(0);
                 command.back() = Darwin::calculateChecksum(command.data());
+            }
+            else {
+                command.clear();
+            }
+
+            // Queue this cycle's write and read, they go out as soon as the last cycle's responses are in
+            auto nextRead = darwin.bulkReadAsync(command);
+
+            // While that is on the bus, parse the last cycle's data
+            if(pendingRead.valid()) {
+                Darwin::BulkResponse response = pendingRead.get();
 
-                darwin.sendRawCommand(command);
+                // Our final sensor output
+                auto sensors = std::make_unique<DarwinSensors>();
+                *sensors = parseSensors(darwin.bulkRead(response.results));
+
+                // Our data was taken when the responses arrived, not now
+                sensors->timestamp = response.timestamp;
+
+                // Send our nicely computed sensor data out to the world
+                emit(std::move(sensors));
             }
 
-            // Read our data
-            Darwin::BulkReadResults data = darwin.bulkRead();
+            pendingRead = std::move(nextRead);
+        });
 
-            // Parse our data
-            *sensors = parseSensors(data);
+        // Report how long our bulk reads are taking
+        on<Trigger<Every<10, std::chrono::seconds>>, Options<Single>>([this](const time_t&) {
 
-            // Send our nicely computed sensor data out to the world
-            emit(std::move(sensors));
+            Darwin::BulkLatency latency = darwin.bulkLatency(true);
+
+            if(latency.cycle.count() > 0) {
+                NUClear::log<NUClear::DEBUG>("CM730 bulk read latency over", latency.cycle.count(), "cycles:"
+                    , "cycle median", latency.cycle.percentile(0.5), "us"
+                    , "99%", latency.cycle.percentile(0.99), "us"
+                    , "max", latency.cycle.max(), "us"
+                    , "bus median", latency.bus.percentile(0.5), "us"
+                    , "99%", latency.bus.percentile(0.99), "us");
+            }
         });
 
         // This trigger writes the servo positions to the hardware
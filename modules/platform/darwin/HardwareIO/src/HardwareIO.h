@@ -41,6 +41,9 @@ namespace darwin {
         Darwin::Darwin darwin;
         messages::platform::darwin::DarwinSensors parseSensors(const Darwin::BulkReadResults& data);
 
+        /// @brief The bulk read from the last cycle, which is still on the bus while the next cycle is prepared
+        std::future<Darwin::BulkResponse> pendingRead;
+
         struct CM730State {
             messages::platform::darwin::DarwinSensors::LEDPanel ledPanel = { false, false, false };
             messages::platform::darwin::DarwinSensors::HeadLED headLED = { 0x00, 0xFF, 0x00 };
@@ -153,7 +153,15 @@ namespace Darwin {
     BulkReadResults Darwin::bulkRead() {
 
         // Execute the BulkRead command
-        std::vector<CommandResult> results = uart.executeBulk(bulkReadCommand);
+        return bulkRead(uart.executeBulk(bulkReadCommand));
+    }
+
+    std::future<BulkResponse> Darwin::bulkReadAsync(const std::vector<uint8_t>& writes) {
+
+        return uart.executeBulkAsync(writes, bulkReadCommand);
+    }
+
+    BulkReadResults Darwin::bulkRead(const std::vector<CommandResult>& results) {
 
         BulkReadResults data;
 
@@ -190,15 +198,24 @@ namespace Darwin {
                 // We only move the first error code to the end of the list
                 if (firstError && i != results.size() - 1) {
 
-                    uint8_t bytes[3];
-                    memcpy(bytes, &bulkReadCommand[Packet::PARAMETER + 1 + (i * 3)], 3);
+                    // Find it by ID, with pipelined reads the command may have been reordered since these results
+                    auto first = std::begin(bulkReadCommand) + Packet::PARAMETER + 1;
+                    auto last = std::end(bulkReadCommand) - 1;
+
+                    for (auto it = first; it != last; it += 3) {
+                        if (it[1] == r.header.id) {
+
+                            uint8_t bytes[3];
+                            std::copy(it, it + 3, bytes);
 
-                    // Erase our 3 bytes for this packet
-                    bulkReadCommand.erase(std::begin(bulkReadCommand) + Packet::PARAMETER + 1 + (i * 3),
-                                          std::begin(bulkReadCommand) + Packet::PARAMETER + 1 + (i * 3) + 3);
+                            // Erase our 3 bytes for this packet
+                            bulkReadCommand.erase(it, it + 3);
 
-                    // Insert our 3 bytes at the end
-                    bulkReadCommand.insert(std::end(bulkReadCommand) - 1, bytes, bytes + 3);
+                            // Insert our 3 bytes at the end
+                            bulkReadCommand.insert(std::end(bulkReadCommand) - 1, bytes, bytes + 3);
+                            break;
+                        }
+                    }
 
                     firstError = false;
                 }
@@ -21,6 +21,7 @@
 #define DARWIN_DARWIN_H
 
 #include <cstdint>
+#include <future>
 #include <utility>
 #include <vector>
 
@@ -168,6 +169,31 @@ namespace Darwin {
          */
         BulkReadResults bulkRead();
 
+        /**
+         * @brief Queues writes followed by the bulk read to run on the UART thread without waiting for them
+         *
+         * @param writes packets that expect no response (e.g. a SYNC_WRITE of the servo targets), can be empty
+         *
+         * @return the raw responses to pass to bulkRead once they arrive
+         */
+        std::future<BulkResponse> bulkReadAsync(const std::vector<uint8_t>& writes);
+
+        /**
+         * @brief Turns the responses to a bulk read into a BulkReadResults
+         *
+         * @details
+         *  Any device that failed to respond is moved to the end of the bulk read so it doesn't stop the devices after
+         *  it from being read next time.
+         */
+        BulkReadResults bulkRead(const std::vector<CommandResult>& results);
+
+        /**
+         * @brief The latency histograms for the asynchronous bulk reads
+         */
+        BulkLatency bulkLatency(bool reset = false) {
+            return uart.bulkLatency(reset);
+        }
+
         /**
          * @brief This sends a raw command to the UART that the dynamixels are on without expecting a response
          */
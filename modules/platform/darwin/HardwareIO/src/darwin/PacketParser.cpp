@@ -0,0 +1,153 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "PacketParser.h"
+
+#include <algorithm>
+
+namespace Darwin {
+    uint8_t calculateChecksum(void* command) {
+
+        uint8_t* data = static_cast<uint8_t*>(command);
+        uint8_t checksum = 0x00;
+        // Skip over the magic numbers and checksum the rest of the packet
+        for (int i = 2; i < data[Packet::LENGTH] + 3; ++i) {
+            checksum += data[i];
+        }
+        return (~checksum);
+    }
+
+    uint8_t calculateChecksum(const CommandResult& result) {
+
+        uint8_t checksum = 0x00;
+
+        checksum += result.header.id;
+        checksum += result.header.length;
+        checksum += result.header.errorcode;
+
+        for (size_t i = 0; i < result.data.size(); ++i) {
+            checksum += result.data[i];
+        }
+
+        return (~checksum);
+    }
+
+    PacketParser::PacketParser() {
+        reset();
+    }
+
+    void PacketParser::reset() {
+        current = State::SYNC_1;
+        packet = CommandResult();
+        packet.checksum = 0;
+        length = 0;
+    }
+
+    size_t PacketParser::remaining() const {
+        switch (current) {
+            case State::SYNC_1:   return 6;
+            case State::SYNC_2:   return 5;
+            case State::ID:       return 4;
+            case State::LENGTH:   return 3;
+            case State::ERRBIT:   return 2 + length;
+            case State::DATA:     return 1 + length - packet.data.size();
+            case State::CHECKSUM: return 1;
+            default:              return 0;
+        }
+    }
+
+    const uint8_t* PacketParser::parse(const uint8_t* first, const uint8_t* last) {
+
+        const uint8_t* it = first;
+
+        while (it != last && current != State::COMPLETE) {
+
+            switch (current) {
+                case State::SYNC_1:
+                    current = *it == 0xFF ? State::SYNC_2 : State::SYNC_1;
+                    ++it;
+                    break;
+
+                case State::SYNC_2:
+                    current = *it == 0xFF ? State::ID : State::SYNC_1;
+                    ++it;
+                    break;
+
+                case State::ID:
+                    // Extra sync bytes are not an ID
+                    if (*it != 0xFF) {
+                        packet.header.id = *it;
+                        current = State::LENGTH;
+                    }
+                    ++it;
+                    break;
+
+                case State::LENGTH:
+                    packet.header.length = *it;
+                    ++it;
+
+                    // The length counts the error byte and checksum, anything shorter is not a packet so look again
+                    if (packet.header.length < 2) {
+                        reset();
+                    }
+                    else {
+                        length = packet.header.length - 2;
+                        packet.data.reserve(length);
+                        current = State::ERRBIT;
+                    }
+                    break;
+
+                case State::ERRBIT:
+                    packet.header.errorcode = *it;
+                    ++it;
+                    current = length > 0 ? State::DATA : State::CHECKSUM;
+                    break;
+
+                case State::DATA: {
+                    // Take as much of the payload as we have in one go
+                    size_t take = std::min(size_t(last - it), length - packet.data.size());
+                    packet.data.insert(packet.data.end(), it, it + take);
+                    it += take;
+
+                    if (packet.data.size() == length) {
+                        current = State::CHECKSUM;
+                    }
+                } break;
+
+                case State::CHECKSUM:
+                    packet.checksum = *it;
+                    ++it;
+                    current = State::COMPLETE;
+
+                    // A bad checksum throws away the packet
+                    if (packet.checksum != calculateChecksum(packet)) {
+                        packet = CommandResult();
+                        packet.checksum = 0;
+                        packet.header.errorcode |= ErrorCode::CORRUPT_DATA;
+                    }
+                    break;
+
+                case State::COMPLETE:
+                    break;
+            }
+        }
+
+        return it;
+    }
+}  // namespace Darwin
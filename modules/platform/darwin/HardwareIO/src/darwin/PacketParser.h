@@ -0,0 +1,145 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef DARWIN_PACKETPARSER_H
+#define DARWIN_PACKETPARSER_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace Darwin {
+    namespace Packet {
+        enum {
+            MAGIC       = 0,
+            ID          = 2,
+            LENGTH      = 3,
+            INSTRUCTION = 4,
+            ERRBIT      = 4,
+            PARAMETER   = 5
+        };
+    }  // namespace Packet
+
+    namespace ErrorCode {
+        enum {
+            NO_RESPONSE     = 0x00FF,
+            NONE            = 0x0000,
+            INPUT_VOLTAGE   = 0x0001,
+            ANGLE_LIMIT     = 0x0002,
+            OVERHEATING     = 0x0004,
+            RANGE           = 0x0008,
+            CHECKSUM        = 0x0010,
+            OVERLOAD        = 0x0020,
+            INSTRUCTION     = 0x0040,
+            CORRUPT_DATA    = 0x0080
+        };
+    }  // namespace ErrorCode
+
+    // This is the header that is contained in the CommandResult
+    #pragma pack(push, 1)  // Make sure that this struct is not cache alligned
+    struct Header {
+        uint8_t id = -1;
+        uint8_t length = 0;
+        uint8_t errorcode = -1;
+    };
+    // Check that this struct is not cache alligned
+    static_assert(sizeof(Header) == 3, "The compiler is adding padding to this struct, Bad compiler!");
+    #pragma pack(pop)
+
+    // This is the object that is returned when a command is run
+    struct CommandResult {
+        Header header;
+        std::vector<uint8_t> data;
+        uint8_t checksum;
+    };
+
+    // This value calculates the checksum for a packet (the command argument is assumed to be in the CM730 format)
+    uint8_t calculateChecksum(void* command);
+    uint8_t calculateChecksum(const CommandResult& result);
+
+    /**
+     * @brief Assembles status packets from however many bytes happen to be available.
+     *
+     * @details
+     *  Bytes are fed in as they arrive, and the parser steps through the sync bytes, header, payload and checksum of a
+     *  packet, so a read can hand over a whole buffer at once rather than reading a byte at a time. Bytes before the
+     *  sync are skipped, as is any extra 0xFF between the sync and the ID (which is never a valid status ID).
+     */
+    class PacketParser {
+    public:
+        enum class State {
+            SYNC_1,
+            SYNC_2,
+            ID,
+            LENGTH,
+            ERRBIT,
+            DATA,
+            CHECKSUM,
+            COMPLETE
+        };
+
+        PacketParser();
+
+        /**
+         * @brief Starts looking for a new packet
+         */
+        void reset();
+
+        /**
+         * @brief Consumes bytes until a packet is complete or the bytes run out
+         *
+         * @return a pointer past the last byte consumed (bytes after a complete packet are left for the next one)
+         */
+        const uint8_t* parse(const uint8_t* first, const uint8_t* last);
+
+        State state() const {
+            return current;
+        }
+
+        /**
+         * @brief If the sync bytes have been seen, so we are part way through a packet
+         */
+        bool started() const {
+            return current != State::SYNC_1 && current != State::SYNC_2;
+        }
+
+        bool complete() const {
+            return current == State::COMPLETE;
+        }
+
+        /**
+         * @brief The number of bytes left in the packet, counting the payload as empty until the length is known
+         */
+        size_t remaining() const;
+
+        /**
+         * @brief The packet, once it is complete a bad checksum is reported as CORRUPT_DATA (as readPacket always has)
+         */
+        CommandResult& result() {
+            return packet;
+        }
+
+    private:
+        State current;
+        CommandResult packet;
+        size_t length;
+    };
+}  // namespace Darwin
+
+#endif
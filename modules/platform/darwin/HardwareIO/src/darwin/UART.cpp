@@ -19,45 +19,25 @@
 
 #include "UART.h"
 
+#include <cerrno>
 #include <thread>
 #include <sys/ioctl.h>
+#include <sys/select.h>
 #include <fcntl.h>
 #include <iostream>
 
 namespace Darwin {
-    uint8_t calculateChecksum(void* command) {
-
-        uint8_t* data = static_cast<uint8_t*>(command);
-        uint8_t checksum = 0x00;
-        // Skip over the magic numbers and checksum the rest of the packet
-        for (int i = 2; i < data[Packet::LENGTH] + 3; ++i) {
-            checksum += data[i];
-        }
-        return (~checksum);
-    }
-
-    uint8_t calculateChecksum(const CommandResult& result) {
-
-        uint8_t checksum = 0x00;
-
-        checksum += result.header.id;
-        checksum += result.header.length;
-        checksum += result.header.errorcode;
-
-        for (size_t i = 0; i < result.data.size(); ++i) {
-            checksum += result.data[i];
-        }
-
-        return (~checksum);
-    }
-
     void UART::setConfig(const messages::support::Configuration<UART>& config){
         PACKET_WAIT = config["PACKET_WAIT"].as<int>();
         BYTE_WAIT = config["BYTE_WAIT"].as<int>();
         BUS_RESET_WAIT_TIME_uS = config["BUS_RESET_WAIT_TIME_uS"].as<int>();
     }
 
-    UART::UART(const char* name) {
+    UART::UART(const char* name)
+    : buffer()
+    , bufferStart(buffer.data())
+    , bufferEnd(buffer.data())
+    , running(true) {
 
         double baud = 1000000;  // (1mb/s)
 
@@ -65,9 +45,26 @@ namespace Darwin {
 
         // If we have a valid file handle, and were able to configure it correctly (custom baud)
         if (fd < 0 || !configure(baud)) {
+            if (fd >= 0) {
+                close(fd);
+            }
             // There was an exception connecting
             throw std::runtime_error("There was an error setting up the serial connection to the CM730");
         }
+
+        ioThread = std::thread(&UART::runQueue, this);
+    }
+
+    UART::~UART() {
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            running = false;
+        }
+        queueCondition.notify_all();
+        ioThread.join();
+
+        close(fd);
     }
 
     bool UART::configure(double baud) {
@@ -94,7 +91,8 @@ namespace Darwin {
 
         // Get our serial_info from the system
         if (ioctl(fd, TIOCGSERIAL, &serinfo) < 0) {
-            return false;
+            // A pseudo terminal (like the servo simulator in the tests) has no baud rate to set
+            return errno == ENOTTY || errno == EINVAL;
         }
 
         // Set the speed flags to "Custom Speed" (clear the existing speed, and set the custom speed flags)
@@ -118,112 +116,108 @@ namespace Darwin {
         return true;
     }
 
-    CommandResult UART::readPacket() {
-
-        // Our result
-        CommandResult result;
-
-        // Clear our connection set and put in our serial device
-        fd_set connectionset;
-        timeval timeout;
-        timeout.tv_sec = 0;
-        FD_ZERO(&connectionset);
-        FD_SET(fd, &connectionset);
-
-        // First we find the packet magic number in order to sync with the channel
-        timeout.tv_usec = PACKET_WAIT;
-        for (int sync = 0; sync < 2;) {
-            if (select(fd + 1, &connectionset, nullptr, nullptr, &timeout) == 1) {
+    void UART::flushInput() {
+        tcflush(fd, TCIFLUSH);
+        bufferStart = buffer.data();
+        bufferEnd = buffer.data();
+    }
 
-                uint8_t byte;
-                int bytesRead = read(fd, &byte, 1);
+    void UART::writeAll(const uint8_t* data, size_t size) {
 
-                assert(bytesRead == 1);
-                (void) bytesRead; // Make the compiler happy when NDEBUG is set
+        for (size_t done = 0; done < size;) {
+            ssize_t written = write(fd, data + done, size - done);
 
-                sync = byte == 0xFF ? sync + 1 : 0;
+            if (written > 0) {
+                done += written;
+            }
+            // Our device is non blocking, so wait for it to drain if it is full
+            else if (written < 0 && (errno == EAGAIN || errno == EINTR)) {
+                fd_set connectionset;
+                FD_ZERO(&connectionset);
+                FD_SET(fd, &connectionset);
+                timeval timeout = { 0, PACKET_WAIT };
+                select(fd + 1, nullptr, &connectionset, nullptr, &timeout);
             }
             else {
-                // The result is pre initialized as a timeout
-                return result;
+                throw std::runtime_error("There was an error writing to the CM730");
             }
         }
+    }
 
-        // We now are now waiting for 4 bytes
-        timeout.tv_usec = BYTE_WAIT * sizeof(Header);
-        uint8_t* headerBytes = reinterpret_cast<uint8_t*>(&result.header);
-        for (size_t done = 0; done < sizeof(Header);) {
-            if (select(fd + 1, &connectionset, nullptr, nullptr, &timeout) == 1) {
+    CommandResult UART::readPacket() {
 
-                done += read(fd, &headerBytes[done], sizeof(Header) - done);
-            }
-            else {
-                // The result is pre initialized as a timeout
-                return result;
-            }
-        }
+        parser.reset();
 
-        // Here we adjust our "length" to mean the length of the payload rather then the length of bytes after the length
-        int length = result.header.length - 2;
+        // We wait PACKET_WAIT for the packet to start, and then BYTE_WAIT for each byte it has once it starts
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(PACKET_WAIT);
+        bool started = false;
 
-        // We now are now waiting for our data
-        timeout.tv_usec = BYTE_WAIT * length;
-        result.data.resize(length);
-        for (int done = 0; done < length;) {
-            if (select(fd + 1, &connectionset, nullptr, nullptr, &timeout) == 1) {
+        while (true) {
 
-                done += read(fd, &result.data[done], length - done);
+            // Parse what we already have
+            if (bufferStart != bufferEnd) {
+                bufferStart = parser.parse(bufferStart, bufferEnd);
+
+                if (parser.complete()) {
+                    return parser.result();
+                }
             }
-            else {
-                // Set our packet header to timeout and return it
-                result.header.errorcode = ErrorCode::NO_RESPONSE;
-                return result;
+
+            // Everything has been parsed so refill from the start of the buffer
+            bufferStart = buffer.data();
+            bufferEnd = buffer.data();
+
+            // The packet gets one deadline when it starts so a slow trickle of bytes can't hold us forever
+            auto now = std::chrono::steady_clock::now();
+            if (parser.started() && !started) {
+                started = true;
+                deadline = now + std::chrono::microseconds(BYTE_WAIT * parser.remaining());
             }
-        }
+            auto wait = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now);
 
-        // We just read the checksum now
-        timeout.tv_usec = 2000;
-        if (select(fd + 1, &connectionset, nullptr, nullptr, &timeout) == 1) {
+            fd_set connectionset;
+            FD_ZERO(&connectionset);
+            FD_SET(fd, &connectionset);
+            timeval timeout = { 0, std::max<long>(wait.count(), 0) };
 
-            size_t bytesRead = read(fd, &result.checksum, 1);
-            assert(bytesRead == 1);
-            (void)bytesRead; // Make the compiler happy when NDEBUG is set
-        }
-        else {
-            // If all we are missing is the checksum, just assume the data is corrupt
-            result.header.errorcode |= ErrorCode::CORRUPT_DATA;
-            return result;
-        }
+            ssize_t bytesRead = 0;
+            if (wait.count() > 0 && select(fd + 1, &connectionset, nullptr, nullptr, &timeout) == 1) {
+                // Read everything that is there
+                bytesRead = read(fd, buffer.data(), buffer.size());
+            }
 
-        // Validate our checksum
-        if (result.checksum != calculateChecksum(result)) {
-            CommandResult result;
-            result.checksum = 0; // GCC doesn't like that this isn't initalized
-            result.header.errorcode |= ErrorCode::CORRUPT_DATA;
-            return result;
+            if (bytesRead > 0) {
+                bufferEnd = buffer.data() + bytesRead;
+            }
+            // We timed out, or select said there was data but the read got none (an error or the device went away)
+            else {
+                CommandResult& result = parser.result();
+
+                switch (parser.state()) {
+                    // If all we are missing is the checksum, just assume the data is corrupt
+                    case PacketParser::State::CHECKSUM:
+                        result.header.errorcode |= ErrorCode::CORRUPT_DATA;
+                        return result;
+
+                    // We timed out part way through the packet
+                    case PacketParser::State::DATA:
+                        result.header.errorcode = ErrorCode::NO_RESPONSE;
+                        return result;
+
+                    // The result is pre initialized as a timeout
+                    default:
+                        return CommandResult();
+                }
+            }
         }
-
-        // Return the packet we recieved
-        return result;
     }
 
-    std::vector<CommandResult> UART::executeBulk(const std::vector<uint8_t>& command) {
+    std::vector<CommandResult> UART::readBulk(const std::vector<uint8_t>& command) {
 
         // We can work out how many responses to expect based on our packets length
         int responses = (command[Packet::LENGTH]-3) / 3;
         std::vector<CommandResult> results(responses);
 
-        // Lock our mutex
-        std::lock_guard<std::mutex> lock(mutex);
-
-        // We flush our buffer, just in case there was anything random in it
-        tcflush(fd, TCIFLUSH);
-
-        // Write the command as usual
-        size_t written = write(fd, command.data(), command.size());
-        assert(written == command.size());
-        (void)written; // Keep the compiler happy when NDEBUG is set
-
         // Read our responses for each of the packets
         for (int i = 0; i < responses; ++i) {
             results[i] = readPacket();
@@ -247,18 +241,112 @@ namespace Darwin {
         return results;
     }
 
+    std::vector<CommandResult> UART::executeBulk(const std::vector<uint8_t>& command) {
+
+        // Lock our mutex
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // We flush our buffer, just in case there was anything random in it
+        flushInput();
+
+        // Write the command as usual
+        writeAll(command.data(), command.size());
+
+        return readBulk(command);
+    }
+
+    std::future<BulkResponse> UART::executeBulkAsync(const std::vector<uint8_t>& writes, const std::vector<uint8_t>& command) {
+
+        BulkRequest request;
+
+        // Send everything in one write
+        request.packet.reserve(writes.size() + command.size());
+        request.packet.insert(request.packet.end(), writes.begin(), writes.end());
+        request.packet.insert(request.packet.end(), command.begin(), command.end());
+        request.command = command;
+        request.submitted = std::chrono::steady_clock::now();
+
+        std::future<BulkResponse> response = request.response.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(request));
+        }
+        queueCondition.notify_one();
+
+        return response;
+    }
+
+    BulkLatency UART::bulkLatency(bool reset) {
+
+        std::lock_guard<std::mutex> lock(latencyMutex);
+
+        BulkLatency result = latency;
+        if (reset) {
+            latency.cycle.clear();
+            latency.bus.clear();
+        }
+
+        return result;
+    }
+
+    void UART::runQueue() {
+
+        while (true) {
+
+            BulkRequest request;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this] { return !running || !queue.empty(); });
+
+                // Finish what was queued before stopping
+                if (queue.empty()) {
+                    return;
+                }
+
+                request = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            try {
+                BulkResponse response;
+                std::chrono::steady_clock::time_point written;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    flushInput();
+                    written = std::chrono::steady_clock::now();
+                    writeAll(request.packet.data(), request.packet.size());
+
+                    response.results = readBulk(request.command);
+                    response.timestamp = NUClear::clock::now();
+                }
+
+                auto done = std::chrono::steady_clock::now();
+                {
+                    std::lock_guard<std::mutex> lock(latencyMutex);
+                    latency.cycle.record(done - request.submitted);
+                    latency.bus.record(done - written);
+                }
+
+                request.response.set_value(std::move(response));
+            }
+            catch (...) {
+                request.response.set_exception(std::current_exception());
+            }
+        }
+    }
+
     void UART::executeBroadcast(const std::vector<uint8_t>& command) {
 
         // Lock our mutex
         std::lock_guard<std::mutex> lock(mutex);
 
         // We flush our buffer, just in case there was anything random in it
-        tcflush(fd,TCIFLUSH);
+        flushInput();
 
         // Write the command as usual
-        size_t written = write(fd, command.data(), command.size());
-        assert(written == command.size());
-        (void) written; // Make the compiler happy when NDEBUG is set
+        writeAll(command.data(), command.size());
 
         // There are no responses for broadcast commands
     }
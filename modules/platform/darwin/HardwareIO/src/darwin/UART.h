@@ -20,67 +20,41 @@
 #ifndef DARWIN_UART_H
 #define DARWIN_UART_H
 
-#include <cassert>
 #include <unistd.h>
 #include <termios.h>
 #include <stdint.h>
 #include <linux/serial.h>
 
 #include "messages/support/Configuration.h"
-
+#include "PacketParser.h"
+#include "utility/time/LatencyHistogram.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <mutex>
 #include <cstring>
+#include <thread>
 #include <vector>
 
 
 namespace Darwin {
-    namespace Packet {
-        enum {
-            MAGIC       = 0,
-            ID          = 2,
-            LENGTH      = 3,
-            INSTRUCTION = 4,
-            ERRBIT      = 4,
-            PARAMETER   = 5
-        };
-    }  // namespace Packet
-
-    namespace ErrorCode {
-        enum {
-            NO_RESPONSE     = 0x00FF,
-            NONE            = 0x0000,
-            INPUT_VOLTAGE   = 0x0001,
-            ANGLE_LIMIT     = 0x0002,
-            OVERHEATING     = 0x0004,
-            RANGE           = 0x0008,
-            CHECKSUM        = 0x0010,
-            OVERLOAD        = 0x0020,
-            INSTRUCTION     = 0x0040,
-            CORRUPT_DATA    = 0x0080
-        };
-    }  // namespace ErrorCode
-
-    // This is the header that is contained in the CommandResult
-    #pragma pack(push, 1)  // Make sure that this struct is not cache alligned
-    struct Header {
-        uint8_t id = -1;
-        uint8_t length = 0;
-        uint8_t errorcode = -1;
-    };
-    // Check that this struct is not cache alligned
-    static_assert(sizeof(Header) == 3, "The compiler is adding padding to this struct, Bad compiler!");
-    #pragma pack(pop)
-
-    // This is the object that is returned when a command is run
-    struct CommandResult {
-        Header header;
-        std::vector<uint8_t> data;
-        uint8_t checksum;
+
+    // The responses to a bulk read and when the last of them arrived
+    struct BulkResponse {
+        std::vector<CommandResult> results;
+        NUClear::clock::time_point timestamp;
     };
 
-    // This value calculates the checksum for a packet (the command argument is assumed to be in the CM730 format)
-    uint8_t calculateChecksum(void* command);
-    uint8_t calculateChecksum(const CommandResult& result);
+    // How long the asynchronous bulk reads are taking
+    struct BulkLatency {
+        /// From being submitted until the last response arrived
+        utility::time::LatencyHistogram cycle;
+        /// From being written to the bus until the last response arrived
+        utility::time::LatencyHistogram bus;
+    };
 
     /**
      * @brief Communicates with the components via the UART (through a USB TTY device)
@@ -105,6 +79,49 @@ namespace Darwin {
         /// @brief A mutex which is used for flow control on the USB TTY device
         std::mutex mutex;
 
+        /// @brief Bytes that have been read from the device but not parsed yet
+        std::array<uint8_t, 1024> buffer;
+        const uint8_t* bufferStart;
+        const uint8_t* bufferEnd;
+        PacketParser parser;
+
+        struct BulkRequest {
+            std::vector<uint8_t> packet;
+            std::vector<uint8_t> command;
+            std::promise<BulkResponse> response;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        /// @brief Runs the asynchronous bulk reads one after another
+        std::thread ioThread;
+        std::atomic<bool> running;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        std::deque<BulkRequest> queue;
+
+        std::mutex latencyMutex;
+        BulkLatency latency;
+
+        /**
+         * @brief Throws away anything waiting to be read, both in the device and our buffer
+         */
+        void flushInput();
+
+        /**
+         * @brief Writes all of the bytes, waiting for the device if it will not take them all at once
+         */
+        void writeAll(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Reads the responses to a bulk read command that has been written
+         */
+        std::vector<CommandResult> readBulk(const std::vector<uint8_t>& command);
+
+        /**
+         * @brief Executes the queued bulk reads until we are destroyed
+         */
+        void runQueue();
+
         /**
          * @brief Configures our serial port to use the passed Baud rate
          *
@@ -124,9 +141,15 @@ namespace Darwin {
          */
         explicit UART(const char* name);
 
+        ~UART();
+
         /**
          * @brief reads a single packet back from the uart, and returns error codes if they timeout
          *
+         * @details
+         *  Whatever bytes the device has are read in one go and fed to a PacketParser, so the sync bytes are not
+         *  read one select at a time. Bytes after the end of the packet are kept for the next one.
+         *
          * @return The command result, or a command result with an error flag if there was an error
          */
         CommandResult readPacket();
@@ -146,19 +169,16 @@ namespace Darwin {
             // Lock the mutex
             std::lock_guard<std::mutex> lock(mutex);
 
+            // We flush our buffer before writing, just in case there was anything random in it (flushing after the
+            // write could throw away a fast response)
+            flushInput();
+
             // Write our command to the UART
-            int written = write(fd, &command, sizeof(TPacket));
+            writeAll(reinterpret_cast<const uint8_t*>(&command), sizeof(TPacket));
 
             // Wait until we finish writing before continuing (no buffering)
             tcdrain(fd);
 
-            // We flush our buffer, just in case there was anything random in it
-            tcflush(fd, TCIFLUSH);
-
-            assert(written == sizeof(TPacket));
-            // If compiled with NDEBUG then technically written is unused, suppress that warning
-            (void) written;
-
             // Read the packet that we get in response
             return readPacket();
         }
@@ -177,14 +197,10 @@ namespace Darwin {
             std::lock_guard<std::mutex> lock(mutex);
 
             // Write our command to the UART
-            int written = write(fd, &command, sizeof(TPacket));
+            writeAll(reinterpret_cast<const uint8_t*>(&command), sizeof(TPacket));
 
             // Wait until we finish writing before continuing (no buffering)
             tcdrain(fd);
-
-            assert(written == sizeof(TPacket));
-            // If compiled with NDEBUG then technically written is unused, suppress that warning
-            (void) written;
         }
 
         /**
@@ -196,6 +212,29 @@ namespace Darwin {
          */
         std::vector<CommandResult> executeBulk(const std::vector<uint8_t>& command);
 
+        /**
+         * @brief Queues writes followed by a bulk read to run on the UART's own thread and returns straight away.
+         *
+         * @details
+         *  The writes and the bulk read go out in a single write, and the responses are parsed as they arrive. Bulk
+         *  reads run in the order they are queued, and the next one is written as soon as the last response to the
+         *  one before it has arrived, so a caller can queue cycle N + 1 and then work on the results of cycle N
+         *  while the bus is busy.
+         *
+         * @param writes  packets that expect no response (e.g. a SYNC_WRITE), can be empty
+         * @param command the bulk read packet
+         *
+         * @return the responses, one for each of the devices in the bulk read
+         */
+        std::future<BulkResponse> executeBulkAsync(const std::vector<uint8_t>& writes, const std::vector<uint8_t>& command);
+
+        /**
+         * @brief Gets the latency histograms of the asynchronous bulk reads so far
+         *
+         * @param reset clear the histograms after reading them
+         */
+        BulkLatency bulkLatency(bool reset = false);
+
         /**
          * @brief This is used to execute a broadcast command (to the broadcast address), these expect no response
          *
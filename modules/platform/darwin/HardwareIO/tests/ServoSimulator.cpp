@@ -0,0 +1,231 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "ServoSimulator.h"
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "darwin/Darwin.h"
+
+namespace simulator {
+
+    ServoSimulator::ServoSimulator(std::chrono::microseconds byteTime)
+        : byteTime(byteTime)
+        , running(true)
+        , bulkReadCount(0)
+        , syncWriteCount(0) {
+
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            throw std::runtime_error("Could not open a pseudo terminal for the servo simulator");
+        }
+        slavePath = ptsname(master);
+
+        // The CM730, the servos and the FSRs
+        std::array<uint8_t, 256> blank;
+        blank.fill(0);
+        devices[Darwin::ID::CM730] = blank;
+        for (uint8_t id = Darwin::ID::R_SHOULDER_PITCH; id <= Darwin::ID::HEAD_PITCH; ++id) {
+            devices[id] = blank;
+        }
+        devices[Darwin::ID::R_FSR] = blank;
+        devices[Darwin::ID::L_FSR] = blank;
+
+        thread = std::thread(&ServoSimulator::run, this);
+    }
+
+    ServoSimulator::~ServoSimulator() {
+        running = false;
+        thread.join();
+        close(master);
+    }
+
+    void ServoSimulator::set(uint8_t id, uint8_t address, const std::vector<uint8_t>& bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::copy(bytes.begin(), bytes.end(), devices.at(id).begin() + address);
+    }
+
+    std::vector<uint8_t> ServoSimulator::get(uint8_t id, uint8_t address, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& table = devices.at(id);
+        return std::vector<uint8_t>(table.begin() + address, table.begin() + address + length);
+    }
+
+    void ServoSimulator::disconnect(uint8_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        disconnected.insert(id);
+    }
+
+    void ServoSimulator::corruptNext(uint8_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        corrupt.insert(id);
+    }
+
+    void ServoSimulator::wait(size_t bytes) {
+        std::this_thread::sleep_for(byteTime * bytes);
+    }
+
+    void ServoSimulator::run() {
+
+        std::vector<uint8_t> input;
+
+        while (running) {
+
+            pollfd fds = { master, POLLIN, 0 };
+            if (poll(&fds, 1, 10) <= 0) {
+                continue;
+            }
+
+            uint8_t bytes[512];
+            ssize_t n = read(master, bytes, sizeof(bytes));
+
+            // Nobody has the other end open
+            if (n <= 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            input.insert(input.end(), bytes, bytes + n);
+
+            // Pull out every complete instruction packet
+            while (true) {
+                size_t start = 0;
+                while (start + 1 < input.size() && !(input[start] == 0xFF && input[start + 1] == 0xFF)) {
+                    ++start;
+                }
+                input.erase(input.begin(), input.begin() + start);
+
+                if (input.size() < 4 || input.size() < size_t(input[Darwin::Packet::LENGTH]) + 4) {
+                    break;
+                }
+
+                size_t size = input[Darwin::Packet::LENGTH] + 4;
+                std::vector<uint8_t> packet(input.begin(), input.begin() + size);
+                input.erase(input.begin(), input.begin() + size);
+
+                // The request has to cross the bus before anyone can answer it
+                wait(size);
+
+                if (Darwin::calculateChecksum(packet.data()) == packet.back()) {
+                    handle(packet);
+                }
+            }
+        }
+    }
+
+    void ServoSimulator::handle(const std::vector<uint8_t>& packet) {
+
+        using Darwin::DarwinDevice;
+
+        uint8_t id = packet[Darwin::Packet::ID];
+        const uint8_t* parameters = &packet[Darwin::Packet::PARAMETER];
+        size_t parameterCount = packet[Darwin::Packet::LENGTH] - 2;
+
+        switch (packet[Darwin::Packet::INSTRUCTION]) {
+
+            case DarwinDevice::Instruction::PING:
+                respond(id, nullptr, 0);
+                break;
+
+            case DarwinDevice::Instruction::READ: {
+                std::vector<uint8_t> data = devices.count(id) ? get(id, parameters[0], parameters[1]) : std::vector<uint8_t>();
+                respond(id, data.data(), parameters[1]);
+            } break;
+
+            case DarwinDevice::Instruction::WRITE: {
+                std::vector<uint8_t> data(parameters + 1, parameters + parameterCount);
+                if (id == Darwin::ID::BROADCAST) {
+                    for (auto& device : devices) {
+                        set(device.first, parameters[0], data);
+                    }
+                }
+                else if (devices.count(id)) {
+                    set(id, parameters[0], data);
+                }
+            } break;
+
+            case DarwinDevice::Instruction::SYNC_WRITE: {
+                ++syncWriteCount;
+
+                uint8_t address = parameters[0];
+                uint8_t length = parameters[1];
+
+                for (size_t i = 2; i + length < parameterCount; i += length + 1) {
+                    if (devices.count(parameters[i])) {
+                        set(parameters[i], address, std::vector<uint8_t>(parameters + i + 1, parameters + i + 1 + length));
+                    }
+                }
+            } break;
+
+            case DarwinDevice::Instruction::BULK_READ: {
+                ++bulkReadCount;
+
+                // Each device answers in turn (length, id, address) after the one before it
+                for (size_t i = 1; i + 2 < parameterCount; i += 3) {
+                    uint8_t length = parameters[i];
+                    uint8_t device = parameters[i + 1];
+                    uint8_t address = parameters[i + 2];
+
+                    bool missing;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        missing = !devices.count(device) || disconnected.count(device);
+                    }
+
+                    // Everyone after a missing device is left waiting for it
+                    if (missing) {
+                        break;
+                    }
+
+                    std::vector<uint8_t> data = get(device, address, length);
+                    respond(device, data.data(), data.size());
+                }
+            } break;
+        }
+    }
+
+    void ServoSimulator::respond(uint8_t id, const uint8_t* data, size_t length) {
+
+        bool bad;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!devices.count(id) || disconnected.count(id)) {
+                return;
+            }
+            bad = corrupt.erase(id) > 0;
+        }
+
+        std::vector<uint8_t> packet = { 0xFF, 0xFF, id, uint8_t(length + 2), 0 };
+        packet.insert(packet.end(), data, data + length);
+        packet.push_back(0);
+        packet.back() = Darwin::calculateChecksum(packet.data()) + (bad ? 1 : 0);
+
+        wait(packet.size());
+
+        for (size_t done = 0; done < packet.size();) {
+            ssize_t written = write(master, packet.data() + done, packet.size() - done);
+            if (written > 0) {
+                done += written;
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef DARWIN_TESTS_SERVOSIMULATOR_H
+#define DARWIN_TESTS_SERVOSIMULATOR_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace simulator {
+
+    /**
+     * @brief Pretends to be a CM730 with its MX28s and FSRs on the other end of a pseudo terminal.
+     *
+     * @details
+     *  Open path() with a Darwin::UART and the simulator answers PING, READ, WRITE, SYNC_WRITE and BULK_READ
+     *  instructions from each device's control table. Writes are never answered (as if RETURN_LEVEL were 1). Bytes
+     *  take byteTime each to cross the simulated bus, so requests and responses take about as long as they would at
+     *  1Mbps. A device that has been disconnected never answers, which in a bulk read stops the devices after it.
+     */
+    class ServoSimulator {
+    public:
+        explicit ServoSimulator(std::chrono::microseconds byteTime = std::chrono::microseconds(10));
+        ~ServoSimulator();
+
+        const std::string& path() const {
+            return slavePath;
+        }
+
+        void set(uint8_t id, uint8_t address, const std::vector<uint8_t>& bytes);
+
+        template <typename TType>
+        void set(uint8_t id, uint8_t address, const TType& value) {
+            std::vector<uint8_t> bytes(sizeof(TType));
+            memcpy(bytes.data(), &value, sizeof(TType));
+            set(id, address, bytes);
+        }
+
+        std::vector<uint8_t> get(uint8_t id, uint8_t address, size_t length);
+
+        void disconnect(uint8_t id);
+
+        /**
+         * @brief Gives the next response from this device a bad checksum
+         */
+        void corruptNext(uint8_t id);
+
+        size_t bulkReads() const {
+            return bulkReadCount;
+        }
+
+        size_t syncWrites() const {
+            return syncWriteCount;
+        }
+
+    private:
+        void run();
+        void handle(const std::vector<uint8_t>& packet);
+        void respond(uint8_t id, const uint8_t* data, size_t length);
+        void wait(size_t bytes);
+
+        std::chrono::microseconds byteTime;
+
+        int master;
+        std::string slavePath;
+
+        std::thread thread;
+        std::atomic<bool> running;
+
+        std::mutex mutex;
+        std::map<uint8_t, std::array<uint8_t, 256>> devices;
+        std::set<uint8_t> disconnected;
+        std::set<uint8_t> corrupt;
+
+        std::atomic<size_t> bulkReadCount;
+        std::atomic<size_t> syncWriteCount;
+    };
+}
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "darwin/Darwin.h"
+#include "darwin/PacketParser.h"
+#include "darwin/UART.h"
+#include "ServoSimulator.h"
+
+using Darwin::CommandResult;
+using Darwin::DarwinDevice;
+namespace ErrorCode = Darwin::ErrorCode;
+using Darwin::PacketParser;
+using simulator::ServoSimulator;
+
+namespace {
+
+    std::vector<uint8_t> statusPacket(uint8_t id, uint8_t error, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> packet = { 0xFF, 0xFF, id, uint8_t(data.size() + 2), error };
+        packet.insert(packet.end(), data.begin(), data.end());
+        packet.push_back(0);
+        packet.back() = Darwin::calculateChecksum(packet.data());
+        return packet;
+    }
+
+    // A bulk read of the present position block of the given servos
+    std::vector<uint8_t> bulkReadPacket(const std::vector<uint8_t>& ids) {
+        std::vector<uint8_t> packet = { 0xFF, 0xFF, Darwin::ID::BROADCAST, uint8_t(3 + ids.size() * 3), DarwinDevice::Instruction::BULK_READ, 0x00 };
+        for (auto& id : ids) {
+            packet.insert(packet.end(), { uint8_t(sizeof(Darwin::Types::MX28Data)), id, Darwin::MX28::Address::PRESENT_POSITION_L });
+        }
+        packet.push_back(0);
+        packet.back() = Darwin::calculateChecksum(packet.data());
+        return packet;
+    }
+
+    // A sync write of the goal position of the given servos
+    std::vector<uint8_t> syncWritePacket(const std::vector<uint8_t>& ids, uint16_t position) {
+        std::vector<uint8_t> packet = { 0xFF, 0xFF, Darwin::ID::BROADCAST, 0, DarwinDevice::Instruction::SYNC_WRITE, Darwin::MX28::Address::GOAL_POSITION_L, 2 };
+        for (auto& id : ids) {
+            packet.insert(packet.end(), { id, uint8_t(position & 0xFF), uint8_t(position >> 8) });
+        }
+        packet[Darwin::Packet::LENGTH] = packet.size() - 3;
+        packet.push_back(0);
+        packet.back() = Darwin::calculateChecksum(packet.data());
+        return packet;
+    }
+
+    std::vector<uint8_t> servoIds() {
+        std::vector<uint8_t> ids;
+        for (uint8_t id = Darwin::ID::R_SHOULDER_PITCH; id <= Darwin::ID::HEAD_PITCH; ++id) {
+            ids.push_back(id);
+        }
+        return ids;
+    }
+}
+
+TEST_CASE("The packet parser assembles packets however the bytes arrive", "[hardware][darwin][uart]") {
+
+    PacketParser parser;
+    auto packet = statusPacket(7, 0, { 1, 2, 3, 4 });
+
+    SECTION("All at once") {
+        REQUIRE(parser.parse(packet.data(), packet.data() + packet.size()) == packet.data() + packet.size());
+        REQUIRE(parser.complete());
+        REQUIRE(parser.result().header.id == 7);
+        REQUIRE(parser.result().header.errorcode == ErrorCode::NONE);
+        REQUIRE(parser.result().data == std::vector<uint8_t>({ 1, 2, 3, 4 }));
+    }
+
+    SECTION("A byte at a time") {
+        for (size_t i = 0; i < packet.size(); ++i) {
+            REQUIRE_FALSE(parser.complete());
+            parser.parse(&packet[i], &packet[i] + 1);
+        }
+        REQUIRE(parser.complete());
+        REQUIRE(parser.result().data == std::vector<uint8_t>({ 1, 2, 3, 4 }));
+    }
+
+    SECTION("After noise and extra sync bytes") {
+        std::vector<uint8_t> bytes = { 0x12, 0xFF, 0x34, 0xFF };
+        bytes.insert(bytes.end(), packet.begin(), packet.end());
+
+        parser.parse(bytes.data(), bytes.data() + bytes.size());
+        REQUIRE(parser.complete());
+        REQUIRE(parser.result().header.id == 7);
+        REQUIRE(parser.result().data.size() == 4);
+    }
+
+    SECTION("Leaving the next packet for later") {
+        auto next = statusPacket(8, 0, { 5 });
+        std::vector<uint8_t> bytes = packet;
+        bytes.insert(bytes.end(), next.begin(), next.end());
+
+        const uint8_t* rest = parser.parse(bytes.data(), bytes.data() + bytes.size());
+        REQUIRE(rest == bytes.data() + packet.size());
+        REQUIRE(parser.result().header.id == 7);
+
+        parser.reset();
+        parser.parse(rest, bytes.data() + bytes.size());
+        REQUIRE(parser.complete());
+        REQUIRE(parser.result().header.id == 8);
+        REQUIRE(parser.result().data == std::vector<uint8_t>({ 5 }));
+    }
+
+    SECTION("Reporting a bad checksum as corrupt") {
+        packet.back() += 1;
+        parser.parse(packet.data(), packet.data() + packet.size());
+        REQUIRE(parser.complete());
+        REQUIRE(parser.result().data.empty());
+        REQUIRE((parser.result().header.errorcode & ErrorCode::CORRUPT_DATA));
+    }
+
+    SECTION("Counting the bytes it still needs") {
+        REQUIRE(parser.remaining() == 6);
+        parser.parse(packet.data(), packet.data() + 4);
+        REQUIRE(parser.started());
+        REQUIRE(parser.remaining() == 6);
+        parser.parse(packet.data() + 4, packet.data() + 6);
+        REQUIRE(parser.remaining() == 4);
+    }
+}
+
+TEST_CASE("The UART talks to the servo simulator", "[hardware][darwin][uart]") {
+
+    ServoSimulator sim;
+    Darwin::UART uart(sim.path().c_str());
+
+    for (auto& id : servoIds()) {
+        sim.set(id, Darwin::MX28::Address::PRESENT_POSITION_L, uint16_t(100 + id));
+    }
+
+    SECTION("Single reads and writes") {
+        REQUIRE(uart.executeRead(DarwinDevice::PingCommand(Darwin::ID::CM730)).header.errorcode == ErrorCode::NONE);
+        REQUIRE(uart.executeRead(DarwinDevice::PingCommand(99)).header.errorcode == ErrorCode::NO_RESPONSE);
+
+        uart.executeWrite(DarwinDevice::WriteCommand<uint16_t>(5, Darwin::MX28::Address::GOAL_POSITION_L, 1234));
+        CommandResult result = uart.executeRead(DarwinDevice::ReadCommand<uint16_t>(5, Darwin::MX28::Address::GOAL_POSITION_L));
+        REQUIRE(result.data == std::vector<uint8_t>({ 1234 & 0xFF, 1234 >> 8 }));
+    }
+
+    SECTION("Bulk reads") {
+        auto results = uart.executeBulk(bulkReadPacket(servoIds()));
+
+        REQUIRE(results.size() == 20);
+        for (size_t i = 0; i < results.size(); ++i) {
+            REQUIRE(results[i].header.id == i + 1);
+            REQUIRE(results[i].header.errorcode == ErrorCode::NONE);
+            REQUIRE(results[i].data.size() == sizeof(Darwin::Types::MX28Data));
+            REQUIRE(size_t(results[i].data[0] | results[i].data[1] << 8) == 100 + i + 1);
+        }
+    }
+
+    SECTION("Bulk reads with a missing servo") {
+        sim.disconnect(4);
+        auto results = uart.executeBulk(bulkReadPacket(servoIds()));
+
+        REQUIRE(results.size() == 20);
+        REQUIRE(results[2].header.errorcode == ErrorCode::NONE);
+        REQUIRE(results[3].header.id == 4);
+        REQUIRE(results[3].header.errorcode == ErrorCode::NO_RESPONSE);
+        for (size_t i = 4; i < results.size(); ++i) {
+            REQUIRE(results[i].header.id == i + 1);
+            REQUIRE(results[i].header.errorcode == ErrorCode::CORRUPT_DATA);
+        }
+    }
+
+    SECTION("Pipelined bulk reads run in order and apply their writes first") {
+        auto ids = servoIds();
+
+        std::vector<std::future<Darwin::BulkResponse>> responses;
+        for (uint16_t cycle = 0; cycle < 5; ++cycle) {
+            responses.push_back(uart.executeBulkAsync(syncWritePacket(ids, 2000 + cycle), bulkReadPacket(ids)));
+        }
+
+        NUClear::clock::time_point last;
+        for (auto& response : responses) {
+            Darwin::BulkResponse r = response.get();
+            REQUIRE(r.results.size() == 20);
+            REQUIRE(r.results[19].header.errorcode == ErrorCode::NONE);
+            REQUIRE(r.timestamp >= last);
+            last = r.timestamp;
+        }
+
+        REQUIRE(sim.syncWrites() == 5);
+        REQUIRE(sim.bulkReads() == 5);
+        REQUIRE(sim.get(20, Darwin::MX28::Address::GOAL_POSITION_L, 2) == std::vector<uint8_t>({ 2004 & 0xFF, 2004 >> 8 }));
+
+        Darwin::BulkLatency latency = uart.bulkLatency(true);
+        REQUIRE(latency.cycle.count() == 5);
+        REQUIRE(latency.bus.count() == 5);
+        REQUIRE(latency.cycle.percentile(1.0) >= latency.bus.percentile(0.0));
+        REQUIRE(uart.bulkLatency().cycle.count() == 0);
+    }
+}
+
+TEST_CASE("The Darwin reads its sensors through the servo simulator", "[hardware][darwin][uart]") {
+
+    ServoSimulator sim;
+    sim.set(Darwin::ID::CM730, Darwin::CM730::Address::VOLTAGE, uint8_t(120));
+    for (auto& id : servoIds()) {
+        sim.set(id, Darwin::MX28::Address::PRESENT_POSITION_L, uint16_t(2048 + id));
+        sim.set(id, Darwin::MX28::Address::PRESENT_TEMPERATURE, uint8_t(40));
+    }
+
+    Darwin::Darwin darwin(sim.path().c_str());
+
+    Darwin::BulkReadResults sequential = darwin.bulkRead();
+    Darwin::BulkReadResults pipelined = darwin.bulkRead(darwin.bulkReadAsync({}).get().results);
+
+    for (auto* data : { &sequential, &pipelined }) {
+        REQUIRE(data->cm730.voltage == 120);
+        REQUIRE(data->cm730ErrorCode == ErrorCode::NONE);
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(int(data->servos[i].presentPosition) == 2048 + i + 1);
+            REQUIRE(data->servos[i].temperature == 40);
+            REQUIRE(data->servoErrorCodes[i] == ErrorCode::NONE);
+        }
+    }
+
+    // A servo that stops answering is moved to the back so the rest can still be read
+    sim.disconnect(Darwin::ID::R_KNEE);
+    darwin.bulkRead();
+    Darwin::BulkReadResults data = darwin.bulkRead();
+
+    REQUIRE(data.servoErrorCodes[Darwin::ID::R_KNEE - 1] == ErrorCode::NO_RESPONSE);
+    REQUIRE(int(data.servos[Darwin::ID::L_KNEE - 1].presentPosition) == 2048 + Darwin::ID::L_KNEE);
+    REQUIRE(data.servoErrorCodes[Darwin::ID::L_KNEE - 1] == ErrorCode::NONE);
+}
+
+TEST_CASE("Benchmark the sequential and pipelined control cycle", "[hardware][darwin][uart][benchmark][.]") {
+
+    constexpr int CYCLES = 300;
+
+    // Roughly what converting and emitting the sensors and building the next write costs
+    const auto work = std::chrono::microseconds(4000);
+
+    ServoSimulator sim;
+    Darwin::UART uart(sim.path().c_str());
+
+    auto ids = servoIds();
+    auto read = bulkReadPacket(ids);
+
+    // One cycle after another: write, read, then work
+    auto start = std::chrono::steady_clock::now();
+    utility::time::LatencyHistogram sequentialLatency;
+    for (int i = 0; i < CYCLES; ++i) {
+        auto cycleStart = std::chrono::steady_clock::now();
+        uart.executeBroadcast(syncWritePacket(ids, 2048 + i % 100));
+        auto results = uart.executeBulk(read);
+        sequentialLatency.record(std::chrono::steady_clock::now() - cycleStart);
+        std::this_thread::sleep_for(work);
+    }
+    double sequentialRate = CYCLES / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Queue the next cycle, then work on the last one while it is on the bus
+    start = std::chrono::steady_clock::now();
+    std::future<Darwin::BulkResponse> pending;
+    for (int i = 0; i < CYCLES; ++i) {
+        auto next = uart.executeBulkAsync(syncWritePacket(ids, 2048 + i % 100), read);
+        if (pending.valid()) {
+            auto results = pending.get();
+            std::this_thread::sleep_for(work);
+        }
+        pending = std::move(next);
+    }
+    pending.get();
+    double pipelinedRate = CYCLES / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto latency = uart.bulkLatency();
+
+    std::cout << "Sequential: " << sequentialRate << " Hz, transaction median "
+              << sequentialLatency.percentile(0.5) << "us, 99% " << sequentialLatency.percentile(0.99) << "us" << std::endl;
+    std::cout << "Pipelined: " << pipelinedRate << " Hz, bus median "
+              << latency.bus.percentile(0.5) << "us, 99% " << latency.bus.percentile(0.99) << "us, cycle median "
+              << latency.cycle.percentile(0.5) << "us, 99% " << latency.cycle.percentile(0.99) << "us" << std::endl;
+
+    REQUIRE(pipelinedRate > sequentialRate);
+}
@@ -22,7 +22,7 @@
 
 #include <nuclear>
 
-#include "utility/math/kalman/UKF.h"
+#include "utility/math/kalman/FixedUKF.h"
 #include "utility/math/kalman/IMUModel.h"
 #include "utility/math/kalman/LinearVec3Model.h"
 #include "utility/motion/RobotModels.h"
@@ -42,8 +42,8 @@ namespace modules {
             public:
                 explicit SensorFilter(std::unique_ptr<NUClear::Environment> environment);
 
-                utility::math::kalman::UKF<utility::math::kalman::IMUModel> orientationFilter;
-                utility::math::kalman::UKF<utility::math::kalman::LinearVec3Model> velocityFilter;
+                utility::math::kalman::FixedUKF<utility::math::kalman::IMUModel> orientationFilter;
+                utility::math::kalman::FixedUKF<utility::math::kalman::LinearVec3Model> velocityFilter;
 
                 double DEFAULT_NOISE_GAIN;
                 double HIGH_NOISE_THRESHOLD;
@@ -212,9 +212,9 @@ namespace research {
     }
 
     void AutoClassifier::cacheColours(const messages::vision::LookUpTable& lut) {
-        uint i = 0;
-        for (auto& colour : lut.getRawData()) {
-            switch (colour) {
+        const Colour* colours = lut.getRawData();
+        for (uint i = 0; i < lut.LUT_SIZE; i++) {
+            switch (colours[i]) {
                 case Colour::ORANGE: {
                     orangeData.pixels.push_back(lut.getPixelFromIndex(i));
                     break;
@@ -234,7 +234,6 @@ namespace research {
                 default:
                     break; // -Wswitch
             }
-            i++;
         }
     }
 
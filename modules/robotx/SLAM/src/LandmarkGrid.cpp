@@ -0,0 +1,71 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "LandmarkGrid.h"
+
+#include <algorithm>
+
+namespace modules {
+namespace robotx {
+
+    using messages::robotx::LandmarkMap;
+
+    LandmarkGrid::LandmarkGrid(double cellSize)
+        : cellSize(cellSize) {
+    }
+
+    void LandmarkGrid::clear(double size) {
+        cellSize = size;
+        landmarks.clear();
+        landmarkCells.clear();
+        cells.clear();
+    }
+
+    uint LandmarkGrid::add(const LandmarkMap::Type& type, const arma::vec2& position, const arma::mat22& covariance) {
+
+        uint id = landmarks.size();
+        landmarks.push_back(Landmark { id, type, position, covariance, 0, Landmark::NONE, 0 });
+
+        uint64_t k = key(cell(position[0]), cell(position[1]));
+        landmarkCells.push_back(k);
+        cells[k].push_back(id);
+
+        return id;
+    }
+
+    void LandmarkGrid::move(uint id, const arma::vec2& position) {
+
+        landmarks[id].position = position;
+
+        uint64_t k = key(cell(position[0]), cell(position[1]));
+
+        if(k != landmarkCells[id]) {
+            auto& old = cells[landmarkCells[id]];
+            old.erase(std::find(old.begin(), old.end(), id));
+            if(old.empty()) {
+                cells.erase(landmarkCells[id]);
+            }
+
+            landmarkCells[id] = k;
+            cells[k].push_back(id);
+        }
+    }
+
+}
+}
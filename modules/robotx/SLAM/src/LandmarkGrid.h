@@ -0,0 +1,137 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_ROBOTX_LANDMARKGRID_H
+#define MODULES_ROBOTX_LANDMARKGRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <armadillo>
+
+#include "messages/robotx/LandmarkMap.h"
+
+namespace modules {
+namespace robotx {
+
+    struct Landmark {
+        enum : uint {
+            NONE = uint(-1)
+        };
+
+        uint id;
+        messages::robotx::LandmarkMap::Type type;
+
+        // The marginal estimate, refreshed from the filter by SLAMEngine::landmarks while the landmark is active
+        arma::vec2 position;
+        arma::mat22 covariance;
+
+        uint observations;
+
+        // Where the landmark lives in the filter state, NONE once it has been marginalised
+        uint slot;
+
+        // The keyframe the landmark was last observed in
+        uint keyframe;
+    };
+
+    /**
+     * Holds every landmark that has been mapped and buckets them into square cells so the landmarks near a point
+     * can be found without looking at the whole map.
+     *
+     * Landmarks are never removed so a landmark's id is its index.
+     */
+    class LandmarkGrid {
+    public:
+        explicit LandmarkGrid(double cellSize = 5.0);
+
+        /**
+         * Empties the map. Lookups with forEachNear find everything within cellSize of the point.
+         */
+        void clear(double cellSize);
+
+        uint add(const messages::robotx::LandmarkMap::Type& type, const arma::vec2& position, const arma::mat22& covariance);
+
+        /**
+         * Moves a landmark to a new position, changing which cell it is bucketed into if it needs to
+         */
+        void move(uint id, const arma::vec2& position);
+
+        /**
+         * Calls f(id) for every landmark in the cell containing position and the eight cells around it, this
+         * includes every landmark within cellSize of the point (and some further away).
+         */
+        template <typename TFunc>
+        void forEachNear(const arma::vec2& position, TFunc&& f) const {
+            int x = cell(position[0]);
+            int y = cell(position[1]);
+
+            for(int i = x - 1; i <= x + 1; ++i) {
+                for(int j = y - 1; j <= y + 1; ++j) {
+                    auto it = cells.find(key(i, j));
+                    if(it != cells.end()) {
+                        for(auto& id : it->second) {
+                            f(id);
+                        }
+                    }
+                }
+            }
+        }
+
+        Landmark& operator[](uint id) {
+            return landmarks[id];
+        }
+
+        const Landmark& operator[](uint id) const {
+            return landmarks[id];
+        }
+
+        size_t size() const {
+            return landmarks.size();
+        }
+
+        std::vector<Landmark>::const_iterator begin() const {
+            return landmarks.begin();
+        }
+
+        std::vector<Landmark>::const_iterator end() const {
+            return landmarks.end();
+        }
+
+    private:
+        int cell(double v) const {
+            return int(std::floor(v / cellSize));
+        }
+
+        static uint64_t key(int x, int y) {
+            return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+        }
+
+        double cellSize;
+        std::vector<Landmark> landmarks;
+        // The cell each landmark is bucketed into
+        std::vector<uint64_t> landmarkCells;
+        std::unordered_map<uint64_t, std::vector<uint>> cells;
+    };
+
+}
+}
+
+#endif
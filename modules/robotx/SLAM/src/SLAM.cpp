@@ -19,12 +19,131 @@
 
 #include "SLAM.h"
 
+#include <cmath>
+
+#include "messages/support/Configuration.h"
+#include "messages/input/RobotXState.h"
+#include "messages/vision/VisionObjects.h"
+#include "messages/robotx/SLAMPose.h"
+#include "messages/robotx/LandmarkMap.h"
+
 namespace modules {
 namespace robotx {
 
+    using messages::support::Configuration;
+    using messages::input::RobotXState;
+    using messages::vision::Ball;
+    using messages::vision::Goal;
+    using messages::robotx::SLAMPose;
+    using messages::robotx::LandmarkMap;
+
+    namespace {
+
+    /**
+     * Turns the first (spherical) measurement of each detection into a range and bearing on the water.
+     * Vision bearings are positive to port while SLAM works in north-east-down where they are positive to starboard.
+     */
+    template <typename TObject>
+    std::vector<SLAMEngine::Observation> observations(const std::vector<TObject>& objects, const LandmarkMap::Type& type) {
+
+        std::vector<SLAMEngine::Observation> result;
+
+        for(auto& object : objects) {
+            if(object.measurements.empty()) {
+                continue;
+            }
+
+            auto& measurement = object.measurements.front();
+            double elevation = measurement.position[2];
+
+            SLAMEngine::Observation observation;
+            observation.type = type;
+            observation.range = measurement.position[0] * std::cos(elevation);
+            observation.bearing = -measurement.position[1];
+            observation.covariance = measurement.error.submat(0, 0, 1, 1);
+            observation.covariance(0, 1) = -observation.covariance(0, 1);
+            observation.covariance(1, 0) = -observation.covariance(1, 0);
+
+            result.push_back(observation);
+        }
+
+        return result;
+    }
+
+    }
+
     SLAM::SLAM(std::unique_ptr<NUClear::Environment> environment)
-        : Reactor(std::move(environment)) {
+        : Reactor(std::move(environment))
+        , stateIndex({ 0, 1, 5 }) {
+
+        on<Trigger<Configuration<SLAM>>, Options<Sync<SLAM>>>([this] (const Configuration<SLAM>& file) {
+
+            stateIndex = { file.config["stateIndex"]["north"].as<uint>()
+                         , file.config["stateIndex"]["east"].as<uint>()
+                         , file.config["stateIndex"]["yaw"].as<uint>() };
+
+            SLAMEngine::Config config;
+            config.maxActiveLandmarks    = file.config["maxActiveLandmarks"].as<uint>();
+            config.windowKeyframes       = file.config["windowKeyframes"].as<uint>();
+            config.keyframeDistance      = file.config["keyframeDistance"].as<double>();
+            config.keyframeAngle         = file.config["keyframeAngle"].as<double>();
+            config.associationRadius     = file.config["associationRadius"].as<double>();
+            config.associationGate       = file.config["associationGate"].as<double>();
+            config.newLandmarkGate       = file.config["newLandmarkGate"].as<double>();
+            config.odometryPositionNoise = file.config["odometryPositionNoise"].as<double>();
+            config.odometryHeadingNoise  = file.config["odometryHeadingNoise"].as<double>();
+            config.insCovarianceScale    = file.config["insCovarianceScale"].as<double>();
+
+            // Changing the filter parameters starts a new map
+            engine.configure(config);
+        });
+
+        on<Trigger<RobotXState>, Options<Sync<SLAM>>>([this] (const RobotXState& state) {
+
+            arma::vec3 pose = arma::conv_to<arma::vec>::from(state.state.elem(stateIndex));
+            arma::mat33 covariance = arma::conv_to<arma::mat>::from(state.covariance.submat(stateIndex, stateIndex));
+
+            engine.insUpdate(pose, covariance);
+            lastTimestamp = state.timestamp;
+
+            auto msg = std::make_unique<SLAMPose>();
+            msg->timestamp = state.timestamp;
+            msg->pose = engine.pose();
+            msg->covariance = engine.poseCovariance();
+            emit(std::move(msg));
+        });
+
+        on<Trigger<std::vector<Ball<0>>>, Options<Sync<SLAM>>>([this] (const std::vector<Ball<0>>& buoys) {
+            engine.observe(observations(buoys, LandmarkMap::Type::BUOY));
+        });
+
+        // On the boat only the MarkerDetector emits goals
+        on<Trigger<std::vector<Goal<0>>>, Options<Sync<SLAM>>>([this] (const std::vector<Goal<0>>& markers) {
+            engine.observe(observations(markers, LandmarkMap::Type::MARKER));
+        });
+
+        // The map can hold thousands of landmarks so it is sent less often than the pose
+        on<Trigger<Every<1, Per<std::chrono::seconds>>>, Options<Sync<SLAM>>>([this] (const time_t&) {
+
+            auto msg = std::make_unique<LandmarkMap>();
+            msg->timestamp = lastTimestamp;
+
+            auto& landmarks = engine.landmarks();
+            msg->landmarks.reserve(landmarks.size());
+
+            for(auto& landmark : landmarks) {
+                msg->landmarks.push_back(LandmarkMap::Landmark {
+                    landmark.id
+                  , landmark.type
+                  , landmark.position
+                  , landmark.covariance
+                  , landmark.observations
+                  , landmark.slot != Landmark::NONE
+                });
+            }
 
+            emit(std::move(msg));
+        });
     }
 
 }
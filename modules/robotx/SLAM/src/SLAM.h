@@ -22,13 +22,23 @@
 
 #include <nuclear>
 
+#include "SLAMEngine.h"
+
 namespace modules {
 namespace robotx {
 
     class SLAM : public NUClear::Reactor {
+    private:
+        SLAMEngine engine;
+
+        // Where north, east and yaw are in RobotXState::state
+        arma::uvec stateIndex;
+        uint64_t lastTimestamp = 0;
+
     public:
         /// @brief Called by the powerplant to build and setup the SLAM reactor.
         explicit SLAM(std::unique_ptr<NUClear::Environment> environment);
+        static constexpr const char* CONFIGURATION_PATH = "SLAM.yaml";
     };
 
 }
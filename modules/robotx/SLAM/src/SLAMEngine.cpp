@@ -0,0 +1,400 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "SLAMEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "utility/math/angle.h"
+
+namespace modules {
+namespace robotx {
+
+    using utility::math::angle::normalizeAngle;
+
+    namespace {
+        // The range jacobians divide by the range, so landmarks closer than this (metres) are treated as this far away
+        constexpr double MINIMUM_RANGE = 0.01;
+    }
+
+    SLAMEngine::SLAMEngine() : SLAMEngine(Config()) {
+    }
+
+    SLAMEngine::SLAMEngine(const Config& config) {
+        configure(config);
+    }
+
+    void SLAMEngine::configure(const Config& newConfig) {
+        config = newConfig;
+        initialised = false;
+
+        state.zeros(3);
+        covariance.zeros(3, 3);
+        active.clear();
+        grid.clear(config.associationRadius);
+
+        lastIns.zeros();
+        keyframePose.zeros();
+        currentKeyframe = 0;
+    }
+
+    void SLAMEngine::insUpdate(const arma::vec3& pose, const arma::mat33& insCovariance) {
+
+        if(!initialised) {
+            state.rows(0, 2) = pose;
+            covariance.submat(0, 0, 2, 2) = insCovariance;
+            lastIns = pose;
+            keyframePose = pose;
+            initialised = true;
+            return;
+        }
+
+        // The INS motion since the last update in the boat frame of the last update
+        double c = std::cos(lastIns[2]);
+        double s = std::sin(lastIns[2]);
+        double dx = pose[0] - lastIns[0];
+        double dy = pose[1] - lastIns[1];
+        arma::vec2 translation({ c * dx + s * dy, -s * dx + c * dy });
+
+        predict(translation, normalizeAngle(pose[2] - lastIns[2]));
+        correctPose(pose, insCovariance * config.insCovarianceScale);
+
+        lastIns = pose;
+
+        checkKeyframe();
+        syncGrid();
+    }
+
+    void SLAMEngine::observe(const std::vector<Observation>& observations) {
+
+        if(!initialised) {
+            return;
+        }
+
+        for(auto& observation : observations) {
+
+            double angle = state[2] + observation.bearing;
+            arma::vec2 guess({ state[0] + observation.range * std::cos(angle), state[1] + observation.range * std::sin(angle) });
+
+            uint best = Landmark::NONE;
+            double bestDistance = std::numeric_limits<double>::infinity();
+
+            grid.forEachNear(guess, [&] (uint id) {
+                const Landmark& landmark = grid[id];
+
+                if(landmark.type == observation.type) {
+                    double distance = mahalanobis(landmark, observation);
+                    if(distance < bestDistance) {
+                        best = id;
+                        bestDistance = distance;
+                    }
+                }
+            });
+
+            if(bestDistance < config.associationGate) {
+                if(grid[best].slot == Landmark::NONE) {
+                    activate(best);
+                }
+
+                update(grid[best].slot, observation);
+                ++grid[best].observations;
+                grid[best].keyframe = currentKeyframe;
+            }
+            // Observations between the gates are too ambiguous to use either way
+            else if(bestDistance > config.newLandmarkGate) {
+                addLandmark(observation);
+            }
+        }
+
+        syncGrid();
+    }
+
+    arma::vec3 SLAMEngine::pose() const {
+        return state.rows(0, 2);
+    }
+
+    arma::mat33 SLAMEngine::poseCovariance() const {
+        return covariance.submat(0, 0, 2, 2);
+    }
+
+    const LandmarkGrid& SLAMEngine::landmarks() {
+
+        syncGrid();
+        for(uint slot = 0; slot < active.size(); ++slot) {
+            uint l = 3 + 2 * slot;
+            grid[active[slot]].covariance = covariance.submat(l, l, l + 1, l + 1);
+        }
+
+        return grid;
+    }
+
+    uint SLAMEngine::activeLandmarks() const {
+        return active.size();
+    }
+
+    uint SLAMEngine::keyframe() const {
+        return currentKeyframe;
+    }
+
+    SLAMEngine::Innovation SLAMEngine::innovation(const arma::vec2& landmark, const Observation& observation) const {
+
+        double dx = landmark[0] - state[0];
+        double dy = landmark[1] - state[1];
+        double q = std::max(dx * dx + dy * dy, MINIMUM_RANGE * MINIMUM_RANGE);
+        double r = std::sqrt(q);
+
+        Innovation i;
+        i.innovation[0] = observation.range - r;
+        i.innovation[1] = normalizeAngle(observation.bearing - (std::atan2(dy, dx) - state[2]));
+
+        i.poseJacobian(0, 0) = -dx / r;
+        i.poseJacobian(0, 1) = -dy / r;
+        i.poseJacobian(0, 2) = 0;
+        i.poseJacobian(1, 0) = dy / q;
+        i.poseJacobian(1, 1) = -dx / q;
+        i.poseJacobian(1, 2) = -1;
+
+        i.landmarkJacobian(0, 0) = dx / r;
+        i.landmarkJacobian(0, 1) = dy / r;
+        i.landmarkJacobian(1, 0) = -dy / q;
+        i.landmarkJacobian(1, 1) = dx / q;
+
+        return i;
+    }
+
+    double SLAMEngine::mahalanobis(const Landmark& landmark, const Observation& observation) const {
+
+        arma::mat22 variance;
+        Innovation i;
+
+        if(landmark.slot == Landmark::NONE) {
+            // A marginalised landmark is independent of the pose
+            i = innovation(landmark.position, observation);
+            variance = i.poseJacobian * covariance.submat(0, 0, 2, 2) * i.poseJacobian.t()
+                     + i.landmarkJacobian * landmark.covariance * i.landmarkJacobian.t();
+        }
+        else {
+            uint l = 3 + 2 * landmark.slot;
+            i = innovation(state.rows(l, l + 1), observation);
+
+            arma::mat::fixed<2, 3> cross = i.landmarkJacobian * covariance.submat(l, 0, l + 1, 2);
+            variance = i.poseJacobian * covariance.submat(0, 0, 2, 2) * i.poseJacobian.t()
+                     + i.poseJacobian * cross.t() + cross * i.poseJacobian.t()
+                     + i.landmarkJacobian * covariance.submat(l, l, l + 1, l + 1) * i.landmarkJacobian.t();
+        }
+
+        variance += observation.covariance;
+
+        return arma::as_scalar(i.innovation.t() * variance.i() * i.innovation);
+    }
+
+    void SLAMEngine::addLandmark(const Observation& observation) {
+
+        makeRoom();
+
+        double r = observation.range;
+        double c = std::cos(state[2] + observation.bearing);
+        double s = std::sin(state[2] + observation.bearing);
+
+        arma::vec2 position({ state[0] + r * c, state[1] + r * s });
+
+        // Jacobians of the position with respect to the pose and the observation
+        arma::mat::fixed<2, 3> poseJacobian;
+        poseJacobian(0, 0) = 1;
+        poseJacobian(0, 1) = 0;
+        poseJacobian(0, 2) = -r * s;
+        poseJacobian(1, 0) = 0;
+        poseJacobian(1, 1) = 1;
+        poseJacobian(1, 2) = r * c;
+
+        arma::mat22 observationJacobian;
+        observationJacobian(0, 0) = c;
+        observationJacobian(0, 1) = -r * s;
+        observationJacobian(1, 0) = s;
+        observationJacobian(1, 1) = r * c;
+
+        uint n = state.n_elem;
+        arma::mat cross = poseJacobian * covariance.rows(0, 2);
+        arma::mat22 variance = poseJacobian * covariance.submat(0, 0, 2, 2) * poseJacobian.t()
+                             + observationJacobian * observation.covariance * observationJacobian.t();
+
+        state.resize(n + 2);
+        covariance.resize(n + 2, n + 2);
+
+        state.rows(n, n + 1) = position;
+        covariance.submat(n, 0, n + 1, n - 1) = cross;
+        covariance.submat(0, n, n - 1, n + 1) = cross.t();
+        covariance.submat(n, n, n + 1, n + 1) = variance;
+
+        uint id = grid.add(observation.type, position, variance);
+        grid[id].slot = active.size();
+        grid[id].observations = 1;
+        grid[id].keyframe = currentKeyframe;
+        active.push_back(id);
+    }
+
+    void SLAMEngine::activate(uint id) {
+
+        makeRoom();
+
+        Landmark& landmark = grid[id];
+        uint n = state.n_elem;
+
+        // The correlation with the pose was lost when the landmark was marginalised
+        state.resize(n + 2);
+        covariance.resize(n + 2, n + 2);
+
+        state.rows(n, n + 1) = landmark.position;
+        covariance.submat(n, n, n + 1, n + 1) = landmark.covariance;
+
+        landmark.slot = active.size();
+        active.push_back(id);
+    }
+
+    void SLAMEngine::marginalise(uint slot) {
+
+        uint id = active[slot];
+        uint l = 3 + 2 * slot;
+        uint last = state.n_elem - 2;
+
+        grid.move(id, state.rows(l, l + 1));
+        grid[id].covariance = covariance.submat(l, l, l + 1, l + 1);
+        grid[id].slot = Landmark::NONE;
+
+        // Move the last landmark into the hole rather than shifting everything after it
+        if(l != last) {
+            state.rows(l, l + 1) = state.rows(last, last + 1);
+            covariance.rows(l, l + 1) = covariance.rows(last, last + 1);
+            covariance.cols(l, l + 1) = covariance.cols(last, last + 1);
+
+            active[slot] = active.back();
+            grid[active[slot]].slot = slot;
+        }
+
+        active.pop_back();
+        state.resize(last);
+        covariance.resize(last, last);
+    }
+
+    void SLAMEngine::makeRoom() {
+
+        if(active.size() < config.maxActiveLandmarks || active.empty()) {
+            return;
+        }
+
+        // Marginalise the landmark that has gone unseen the longest
+        uint oldest = 0;
+        for(uint slot = 1; slot < active.size(); ++slot) {
+            const Landmark& a = grid[active[slot]];
+            const Landmark& b = grid[active[oldest]];
+
+            if(a.keyframe < b.keyframe || (a.keyframe == b.keyframe && a.observations < b.observations)) {
+                oldest = slot;
+            }
+        }
+
+        marginalise(oldest);
+    }
+
+    void SLAMEngine::update(uint slot, const Observation& observation) {
+
+        uint l = 3 + 2 * slot;
+        Innovation i = innovation(state.rows(l, l + 1), observation);
+
+        // Only the pose and this landmark's columns of the jacobian are non zero
+        arma::mat pht = covariance.cols(0, 2) * i.poseJacobian.t() + covariance.cols(l, l + 1) * i.landmarkJacobian.t();
+        arma::mat22 variance = i.poseJacobian * pht.rows(0, 2) + i.landmarkJacobian * pht.rows(l, l + 1) + observation.covariance;
+        arma::mat gain = pht * variance.i();
+
+        state += gain * i.innovation;
+        state[2] = normalizeAngle(state[2]);
+
+        covariance -= gain * pht.t();
+        covariance = (covariance + covariance.t()) * 0.5;
+    }
+
+    void SLAMEngine::predict(const arma::vec2& translation, double rotation) {
+
+        double c = std::cos(state[2]);
+        double s = std::sin(state[2]);
+
+        state[0] += c * translation[0] - s * translation[1];
+        state[1] += s * translation[0] + c * translation[1];
+        state[2] = normalizeAngle(state[2] + rotation);
+
+        arma::mat33 jacobian = arma::eye(3, 3);
+        jacobian(0, 2) = -s * translation[0] - c * translation[1];
+        jacobian(1, 2) = c * translation[0] - s * translation[1];
+
+        // Landmarks do not move so only the pose rows and columns change
+        covariance.rows(0, 2) = jacobian * covariance.rows(0, 2);
+        covariance.cols(0, 2) = covariance.cols(0, 2) * jacobian.t();
+
+        double distance = arma::norm(translation, 2);
+        covariance(0, 0) += config.odometryPositionNoise * distance;
+        covariance(1, 1) += config.odometryPositionNoise * distance;
+        covariance(2, 2) += config.odometryHeadingNoise * std::abs(rotation);
+    }
+
+    void SLAMEngine::correctPose(const arma::vec3& pose, const arma::mat33& poseVariance) {
+
+        arma::vec3 innovation = pose - state.rows(0, 2);
+        innovation[2] = normalizeAngle(innovation[2]);
+
+        arma::mat33 variance = covariance.submat(0, 0, 2, 2) + poseVariance;
+        arma::mat gain = covariance.cols(0, 2) * variance.i();
+
+        state += gain * innovation;
+        state[2] = normalizeAngle(state[2]);
+
+        covariance -= gain * covariance.rows(0, 2);
+        covariance = (covariance + covariance.t()) * 0.5;
+    }
+
+    void SLAMEngine::checkKeyframe() {
+
+        double distance = arma::norm(state.rows(0, 1) - keyframePose.rows(0, 1), 2);
+        double angle = std::abs(normalizeAngle(state[2] - keyframePose[2]));
+
+        if(distance < config.keyframeDistance && angle < config.keyframeAngle) {
+            return;
+        }
+
+        ++currentKeyframe;
+        keyframePose = state.rows(0, 2);
+
+        // Going backwards means the landmark moved into a marginalised slot has already been checked
+        for(uint slot = active.size(); slot-- > 0;) {
+            if(grid[active[slot]].keyframe + config.windowKeyframes < currentKeyframe) {
+                marginalise(slot);
+            }
+        }
+    }
+
+    void SLAMEngine::syncGrid() {
+        for(uint slot = 0; slot < active.size(); ++slot) {
+            uint l = 3 + 2 * slot;
+            grid.move(active[slot], state.rows(l, l + 1));
+        }
+    }
+
+}
+}
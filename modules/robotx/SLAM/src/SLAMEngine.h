@@ -0,0 +1,148 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_ROBOTX_SLAMENGINE_H
+#define MODULES_ROBOTX_SLAMENGINE_H
+
+#include <vector>
+#include <armadillo>
+
+#include "messages/robotx/LandmarkMap.h"
+#include "LandmarkGrid.h"
+
+namespace modules {
+namespace robotx {
+
+    /**
+     * @brief Landmark SLAM for the boat, kept separate from the reactor so it can be run without a powerplant.
+     *
+     * @details
+     *  The filter is an EKF over the boat pose (x, y, heading) and the positions of a bounded window of active
+     *  landmarks. Every landmark ever seen lives in a LandmarkGrid, which is also used to find association
+     *  candidates. When the boat has moved far enough a keyframe is made, and landmarks that have not been seen
+     *  for a number of keyframes (or that need to make room for newer ones) are marginalised out of the filter:
+     *  their marginal mean and covariance are written back to the grid and their rows and columns are dropped.
+     *  A marginalised landmark that is seen again is put back into the filter from its marginal. This keeps the
+     *  state at most 3 + 2 * maxActiveLandmarks long, so an update costs the same after an hour as after a minute.
+     *
+     *  Angles are measured from the x axis towards the y axis, so with x north and y east the heading is the
+     *  yaw of a north-east-down frame and bearings are positive to starboard.
+     */
+    class SLAMEngine {
+    public:
+        struct Config {
+            // The most landmarks kept in the filter at once
+            uint maxActiveLandmarks = 32;
+            // How many keyframes a landmark stays in the filter after it was last observed
+            uint windowKeyframes = 8;
+            // How far the boat moves (metres) or turns (radians) between keyframes
+            double keyframeDistance = 2.0;
+            double keyframeAngle = 0.35;
+            // The size (metres) of the grid cells, only landmarks in the cells around an observation are considered for it
+            double associationRadius = 5.0;
+            // Squared Mahalanobis distance under which an observation is associated (99% for 2 dof)
+            double associationGate = 9.21;
+            // Squared Mahalanobis distance every landmark must be over before an observation makes a new landmark
+            double newLandmarkGate = 25.0;
+            // Variance added per metre travelled and per radian turned when the pose is predicted
+            double odometryPositionNoise = 0.01;
+            double odometryHeadingNoise = 0.001;
+            // How much the INS covariance is inflated when it is used as an absolute pose measurement
+            double insCovarianceScale = 10.0;
+        };
+
+        struct Observation {
+            messages::robotx::LandmarkMap::Type type;
+            double range;
+            double bearing;
+            // Of range and bearing
+            arma::mat22 covariance;
+        };
+
+        SLAMEngine();
+        explicit SLAMEngine(const Config& config);
+
+        /**
+         * Replaces the configuration and forgets the map
+         */
+        void configure(const Config& config);
+
+        /**
+         * Moves the pose by the change in the INS pose since the last call, and pulls it towards the INS pose
+         */
+        void insUpdate(const arma::vec3& pose, const arma::mat33& covariance);
+
+        /**
+         * Associates each observation with a landmark and updates the filter, or adds new landmarks
+         */
+        void observe(const std::vector<Observation>& observations);
+
+        arma::vec3 pose() const;
+        arma::mat33 poseCovariance() const;
+
+        /**
+         * Every landmark mapped so far with the active ones brought up to date from the filter
+         */
+        const LandmarkGrid& landmarks();
+
+        uint activeLandmarks() const;
+        uint keyframe() const;
+
+    private:
+        struct Innovation {
+            arma::vec2 innovation;
+            arma::mat22 variance;
+            // The measurement jacobians with respect to the pose and the landmark
+            arma::mat::fixed<2, 3> poseJacobian;
+            arma::mat22 landmarkJacobian;
+        };
+
+        Innovation innovation(const arma::vec2& landmark, const Observation& observation) const;
+        double mahalanobis(const Landmark& landmark, const Observation& observation) const;
+
+        void addLandmark(const Observation& observation);
+        void activate(uint id);
+        void marginalise(uint slot);
+        void makeRoom();
+        void update(uint slot, const Observation& observation);
+        void predict(const arma::vec2& translation, double rotation);
+        void correctPose(const arma::vec3& pose, const arma::mat33& covariance);
+        void checkKeyframe();
+        void syncGrid();
+
+        Config config;
+        bool initialised;
+
+        // [x y heading l0x l0y l1x l1y ...]
+        arma::vec state;
+        arma::mat covariance;
+        // The landmark id in each slot of the state
+        std::vector<uint> active;
+
+        LandmarkGrid grid;
+
+        arma::vec3 lastIns;
+        arma::vec3 keyframePose;
+        uint currentKeyframe;
+    };
+
+}
+}
+
+#endif
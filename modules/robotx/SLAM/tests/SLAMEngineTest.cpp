@@ -0,0 +1,328 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "utility/math/angle.h"
+#include "SLAMEngine.h"
+
+using messages::robotx::LandmarkMap;
+using modules::robotx::Landmark;
+using modules::robotx::SLAMEngine;
+using utility::math::angle::normalizeAngle;
+
+namespace {
+
+    constexpr double TIME_STEP = 0.1;
+    constexpr double SENSOR_RANGE = 25;
+    constexpr double SENSOR_FIELD_OF_VIEW = M_PI / 3;
+    constexpr double RANGE_DEVIATION = 0.3;
+    constexpr double BEARING_DEVIATION = 0.02;
+
+    /**
+     * A field of buoys on a jittered grid, so no two are closer than half the spacing
+     */
+    std::vector<arma::vec2> buoyField(uint columns, uint rows, double spacing, std::mt19937& rng) {
+        std::uniform_real_distribution<double> jitter(-spacing / 4, spacing / 4);
+
+        std::vector<arma::vec2> buoys;
+        for(uint i = 0; i < columns; ++i) {
+            for(uint j = 0; j < rows; ++j) {
+                buoys.push_back(arma::vec2({ i * spacing + jitter(rng), j * spacing + jitter(rng) }));
+            }
+        }
+        return buoys;
+    }
+
+    /**
+     * Poses (x, y, heading) every TIME_STEP for a lawnmower pattern of lanes along x, so the sensor sweeps each
+     * buoy from neighbouring lanes and revisits landmarks that have been marginalised
+     */
+    std::vector<arma::vec3> lawnmower(double length, uint lanes, double laneSpacing, double speed) {
+        std::vector<arma::vec3> poses;
+        double step = speed * TIME_STEP;
+
+        for(uint lane = 0; lane < lanes; ++lane) {
+            double y = lane * laneSpacing;
+            bool forward = lane % 2 == 0;
+
+            for(double d = 0; d < length; d += step) {
+                poses.push_back(arma::vec3({ forward ? d : length - d, y, forward ? 0 : M_PI }));
+            }
+
+            // Turn across to the next lane
+            if(lane + 1 < lanes) {
+                for(double d = 0; d < laneSpacing; d += step) {
+                    poses.push_back(arma::vec3({ forward ? length : 0, y + d, M_PI / 2 }));
+                }
+            }
+        }
+        return poses;
+    }
+
+    /**
+     * The buoys in front of the boat and in range, with noise on the range and bearing
+     */
+    std::vector<SLAMEngine::Observation> sense(const arma::vec3& pose, const std::vector<arma::vec2>& buoys, std::mt19937& rng) {
+        std::normal_distribution<double> rangeNoise(0, RANGE_DEVIATION);
+        std::normal_distribution<double> bearingNoise(0, BEARING_DEVIATION);
+
+        arma::mat22 covariance;
+        covariance.zeros();
+        covariance(0, 0) = RANGE_DEVIATION * RANGE_DEVIATION;
+        covariance(1, 1) = BEARING_DEVIATION * BEARING_DEVIATION;
+
+        std::vector<SLAMEngine::Observation> observations;
+        for(auto& buoy : buoys) {
+            double dx = buoy[0] - pose[0];
+            double dy = buoy[1] - pose[1];
+            double range = std::sqrt(dx * dx + dy * dy);
+            double bearing = normalizeAngle(std::atan2(dy, dx) - pose[2]);
+
+            if(range < SENSOR_RANGE && std::abs(bearing) < SENSOR_FIELD_OF_VIEW) {
+                observations.push_back({ LandmarkMap::Type::BUOY, range + rangeNoise(rng), bearing + bearingNoise(rng), covariance });
+            }
+        }
+        return observations;
+    }
+
+    /**
+     * An INS that drifts slowly away from the true pose but claims a metre of accuracy
+     */
+    class DriftingINS {
+    public:
+        DriftingINS(std::mt19937& rng) : rng(rng), walk(0, 0.01), drift({ 0, 0, 0 }) {
+            covariance.zeros();
+            covariance(0, 0) = 1;
+            covariance(1, 1) = 1;
+            covariance(2, 2) = 0.001;
+        }
+
+        arma::vec3 measure(const arma::vec3& pose) {
+            drift[0] += walk(rng);
+            drift[1] += walk(rng);
+            drift[2] += walk(rng) * 0.01;
+
+            // Keep the drift bounded like a GPS aided INS would
+            drift *= 0.999;
+
+            arma::vec3 measured = pose + drift;
+            measured[2] = normalizeAngle(measured[2]);
+            return measured;
+        }
+
+        arma::mat33 covariance;
+
+    private:
+        std::mt19937& rng;
+        std::normal_distribution<double> walk;
+        arma::vec3 drift;
+    };
+
+    // The distance from each buoy that was seen to the closest mapped landmark
+    std::vector<double> mapErrors(SLAMEngine& slam, const std::vector<arma::vec2>& buoys, const std::vector<bool>& seen) {
+        std::vector<double> errors;
+        for(uint i = 0; i < buoys.size(); ++i) {
+            if(seen[i]) {
+                double best = std::numeric_limits<double>::infinity();
+                for(auto& landmark : slam.landmarks()) {
+                    best = std::min(best, arma::norm(landmark.position - buoys[i], 2));
+                }
+                errors.push_back(best);
+            }
+        }
+        return errors;
+    }
+}
+
+TEST_CASE("SLAM maps a synthetic buoy field without duplicating landmarks", "[robotx][slam]") {
+
+    std::mt19937 rng(42);
+    auto buoys = buoyField(12, 8, 12, rng);
+    auto path = lawnmower(140, 5, 20, 2);
+
+    SLAMEngine::Config config;
+    SLAMEngine slam(config);
+    DriftingINS ins(rng);
+
+    std::vector<bool> seen(buoys.size(), false);
+    double slamError = 0;
+
+    for(auto& pose : path) {
+        auto measured = ins.measure(pose);
+        slam.insUpdate(measured, ins.covariance);
+        slam.observe(sense(pose, buoys, rng));
+
+        for(uint i = 0; i < buoys.size(); ++i) {
+            double dx = buoys[i][0] - pose[0];
+            double dy = buoys[i][1] - pose[1];
+            if(std::sqrt(dx * dx + dy * dy) < SENSOR_RANGE && std::abs(normalizeAngle(std::atan2(dy, dx) - pose[2])) < SENSOR_FIELD_OF_VIEW) {
+                seen[i] = true;
+            }
+        }
+
+        REQUIRE(slam.activeLandmarks() <= config.maxActiveLandmarks);
+
+        slamError = std::max(slamError, arma::norm(arma::vec(slam.pose().rows(0, 1) - pose.rows(0, 1)), 2));
+    }
+
+    uint seenCount = std::count(seen.begin(), seen.end(), true);
+    REQUIRE(seenCount > 50);
+
+    // Every buoy that was seen is mapped close to where it really is
+    auto errors = mapErrors(slam, buoys, seen);
+    double meanError = 0;
+    for(auto& error : errors) {
+        meanError += error / errors.size();
+        REQUIRE(error < 1.0);
+    }
+    REQUIRE(meanError < 0.5);
+
+    // Revisited buoys were associated with their old landmarks rather than added again
+    uint mapped = 0;
+    for(auto& landmark : slam.landmarks()) {
+        mapped += landmark.observations >= 3;
+    }
+    REQUIRE(mapped <= seenCount * 1.05);
+
+    // The pose stays near the truth and the filter was kept small by marginalising
+    REQUIRE(slamError < 1.0);
+    REQUIRE(slam.keyframe() > 100);
+}
+
+TEST_CASE("SLAM reactivates a marginalised landmark when it is seen again", "[robotx][slam]") {
+
+    SLAMEngine::Config config;
+    config.maxActiveLandmarks = 2;
+    SLAMEngine slam(config);
+
+    arma::mat33 insCovariance = arma::eye(3, 3) * 0.01;
+    slam.insUpdate(arma::vec3({ 0, 0, 0 }), insCovariance);
+
+    arma::mat22 covariance;
+    covariance.zeros();
+    covariance(0, 0) = 0.01;
+    covariance(1, 1) = 0.0001;
+
+    auto see = [&] (double range, double bearing) {
+        slam.observe({ { LandmarkMap::Type::BUOY, range, bearing, covariance } });
+    };
+
+    // Three buoys with room for two in the filter pushes the first one out
+    see(10, 0);
+    see(10, 0.5);
+    see(10, -0.5);
+    REQUIRE(slam.landmarks().size() == 3);
+    REQUIRE(slam.activeLandmarks() == 2);
+    REQUIRE(slam.landmarks()[0].slot == Landmark::NONE);
+
+    // Seeing it again brings it back rather than adding a fourth
+    see(10, 0);
+    REQUIRE(slam.landmarks().size() == 3);
+    REQUIRE(slam.landmarks()[0].slot != Landmark::NONE);
+    REQUIRE(slam.landmarks()[0].observations == 2);
+    REQUIRE(slam.activeLandmarks() == 2);
+
+    // A marker in the same place is a different landmark
+    slam.observe({ { LandmarkMap::Type::MARKER, 10, 0, covariance } });
+    REQUIRE(slam.landmarks().size() == 4);
+
+    // Landmarks that are not seen for a window of keyframes are marginalised
+    for(uint i = 1; i <= (config.windowKeyframes + 2) * 2; ++i) {
+        slam.insUpdate(arma::vec3({ i * config.keyframeDistance / 2, 0, 0 }), insCovariance);
+    }
+    REQUIRE(slam.activeLandmarks() == 0);
+    REQUIRE(slam.landmarks()[0].position[0] == Approx(10).epsilon(0.01));
+}
+
+TEST_CASE("SLAM stays finite when a landmark is observed on top of the boat", "[robotx][slam]") {
+
+    SLAMEngine slam;
+    slam.insUpdate(arma::vec3({ 0, 0, 0 }), arma::eye(3, 3) * 0.01);
+
+    arma::mat22 covariance;
+    covariance.zeros();
+    covariance(0, 0) = 0.01;
+    covariance(1, 1) = 0.0001;
+
+    // The range and bearing jacobians divide by the range, which is zero here
+    slam.observe({ { LandmarkMap::Type::BUOY, 0, 0, covariance } });
+    slam.observe({ { LandmarkMap::Type::BUOY, 0, 0, covariance } });
+
+    REQUIRE(slam.landmarks().size() == 1);
+    REQUIRE(slam.pose().is_finite());
+    REQUIRE(slam.poseCovariance().is_finite());
+    REQUIRE(slam.landmarks()[0].position.is_finite());
+}
+
+TEST_CASE("Benchmark SLAM update latency as the map grows to thousands of landmarks", "[robotx][slam][benchmark][.]") {
+
+    std::mt19937 rng(7);
+    auto buoys = buoyField(72, 72, 12, rng);
+    auto path = lawnmower(72 * 12, 36, 24, 6);
+
+    SLAMEngine slam;
+    DriftingINS ins(rng);
+
+    // Latencies grouped by how many landmarks were mapped at the time
+    const std::vector<uint> bounds = { 100, 500, 1000, 2000, 3000, 4000, 5000, 6000 };
+    std::vector<std::vector<double>> latencies(bounds.size());
+
+    for(auto& pose : path) {
+        auto measured = ins.measure(pose);
+        auto observations = sense(pose, buoys, rng);
+
+        auto start = std::chrono::steady_clock::now();
+        slam.insUpdate(measured, ins.covariance);
+        slam.observe(observations);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        size_t mapped = slam.landmarks().size();
+        uint bucket = std::lower_bound(bounds.begin(), bounds.end(), mapped + 1) - bounds.begin();
+        latencies[std::min<uint>(bucket, bounds.size() - 1)].push_back(micros);
+    }
+
+    for(uint i = 0; i < bounds.size(); ++i) {
+        auto& bucket = latencies[i];
+        if(bucket.empty()) {
+            continue;
+        }
+
+        std::sort(bucket.begin(), bucket.end());
+        double mean = 0;
+        for(auto& latency : bucket) {
+            mean += latency / bucket.size();
+        }
+
+        std::cout << "Up to " << bounds[i] << " landmarks: "
+                  << mean << "us mean, "
+                  << bucket[bucket.size() * 99 / 100] << "us 99th percentile, "
+                  << bucket.back() << "us max over " << bucket.size() << " updates" << std::endl;
+    }
+
+    std::cout << slam.landmarks().size() << " landmarks mapped from " << buoys.size() << " buoys" << std::endl;
+
+    REQUIRE(slam.landmarks().size() > 1000);
+}
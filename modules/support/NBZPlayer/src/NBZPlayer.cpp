@@ -20,188 +20,265 @@
 #include "NBZPlayer.h"
 
 #include "messages/support/Configuration.h"
-#include "messages/support/nubugger/proto/Message.pb.h"
 #include "messages/input/Image.h"
 
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
-
 namespace modules {
 namespace support {
 
     using messages::support::Configuration;
     using messages::input::Image;
     using messages::support::nubugger::proto::Message;
+    using ProtoImage = messages::input::proto::Image;
 
-    NBZPlayer::NBZPlayer(std::unique_ptr<NUClear::Environment> environment)
-        : Reactor(std::move(environment)) {
+    // How long lock step waits for the system to let go of an image before giving up on it
+    constexpr std::chrono::seconds LOCKSTEP_TIMEOUT = std::chrono::seconds(10);
 
+    NBZPlayer::NBZPlayer(std::unique_ptr<NUClear::Environment> environment)
+        : Reactor(std::move(environment))
+        , pool(8)
+        , outstanding(std::make_shared<Outstanding>()) {
 
             on<Trigger<Configuration<NBZPlayer>>>([this](const Configuration<NBZPlayer>& config) {
 
                 std::string path = config["file"].as<std::string>();
+                std::string modeName = config["mode"].as<std::string>();
 
-                // Setup the file
-                // input.push(boost::iostreams::gzip_decompressor());
-                input.push(boost::iostreams::file_descriptor_source(path, std::ios_base::in | std::ios_base::binary));
+                std::lock_guard<std::mutex> lock(inputMutex);
+
+                if(modeName == "realtime") {
+                    mode = Mode::REALTIME;
+                }
+                else if(modeName == "speed") {
+                    mode = Mode::SPEED;
+                }
+                else if(modeName == "fast") {
+                    mode = Mode::FAST;
+                }
+                else if(modeName == "lockstep") {
+                    mode = Mode::LOCKSTEP;
+                }
+                else {
+                    log<NUClear::ERROR>("Unknown NBZ player mode", modeName, "playing in realtime");
+                    mode = Mode::REALTIME;
+                }
 
-                // Read the first 32 bit int to work out the size
-                uint32_t size;
-                input >> size;
+                speed = mode == Mode::SPEED ? config["speed"].as<double>() : 1.0;
+                loop = config["loop"].as<bool>();
+                startTime = config["start"]["time"].as<double>();
+                startRecord = config["start"]["record"].as<int64_t>();
 
-                // Read that much into a string
-                std::vector<char> data(size);
-                input.read(data.data(), size);
+                // Open the log and only read the images
+                try {
+                    input = std::make_unique<utility::nbz::NBZReader>(path);
+                }
+                catch(const std::exception& e) {
+                    log<NUClear::ERROR>("Could not play", path, ":", e.what());
+                    input.reset();
+                    return;
+                }
+                input->filter({ utility::nbz::typeHash(Message::Type_Name(Message::IMAGE)) });
 
-                // Read the message
-                Message message;
-                message.ParsePartialFromArray(data.data(), data.size());
+                if(input->recovered()) {
+                    log<NUClear::WARN>(path, "was not closed properly, its index was rebuilt from", input->blocks().size(), "blocks");
+                }
 
-                offset = NUClear::clock::now() - time_t(std::chrono::milliseconds(message.utc_timestamp()));
+                restart();
+                inputReady.notify_one();
             });
 
 
             powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask([this] {
+
+                std::unique_lock<std::mutex> lock(inputMutex, std::defer_lock);
+
                 while(true) {
 
-                    // Read the first 32 bit int to work out the size
-                    uint32_t size;
-                    input >> size;
-
-                    // Read that much into a string
-                    std::vector<char> data(size);
-                    input.read(data.data(), size);
-
-                    // Read the message
-                    Message message;
-                    message.ParsePartialFromArray(data.data(), data.size());
-
-                    // If it's an image
-                    if(message.type() == Message::IMAGE) {
-
-                        // Work out our time to run
-                        time_t timeToRun = time_t(std::chrono::milliseconds(message.utc_timestamp())) + offset;
-
-                        // Wait until it's time to display it
-                        std::this_thread::sleep_until(timeToRun);
-
-                        // Send it!
-
-                        // Get the width and height
-                        int width = message.image().dimensions().y();
-                        int height = message.image().dimensions().x();
-                        const std::string& source = message.image().data();
-
-                        // Get the image data
-                        std::vector<uint8_t> data(source.begin(), source.end());
-
-                        switch(message.image().camera_id()) {
-                            case 0: {
-                                auto image = std::make_unique<Image<0>>();
-                                image->timestamp = NUClear::clock::now();
-                                image->format =  Image<0>::SourceFormat::BGGR;
-                                image->dimensions = { 1280, 960 };
-                                image->cameraToGround = arma::eye(4,4);
-                                image->source = std::move(data);
-
-                                // The lens! (hardcoded :P)
-                                image->lens.type = Image<0>::Lens::Type::RADIAL;
-                                image->lens.parameters.radial.fov = M_PI;
-                                image->lens.parameters.radial.pitch = 0.0025;
-                                image->lens.parameters.radial.centre[0] = 640;
-                                image->lens.parameters.radial.centre[1] = 480;
-
-                                emit(std::move(image));
-
-                            } break;
-
-                            case 1: {
-                                auto image = std::make_unique<Image<1>>();
-                                image->timestamp = NUClear::clock::now();
-                                image->format =  Image<1>::SourceFormat::BGGR;
-                                image->dimensions = { 1280, 960 };
-                                image->cameraToGround = arma::eye(4,4);
-                                image->source = std::move(data);
-
-                                // The lens! (hardcoded :P)
-                                image->lens.type = Image<1>::Lens::Type::RADIAL;
-                                image->lens.parameters.radial.fov = M_PI;
-                                image->lens.parameters.radial.pitch = 0.0025;
-                                image->lens.parameters.radial.centre[0] = 640;
-                                image->lens.parameters.radial.centre[1] = 480;
-
-                                emit(std::move(image));
-
-                            } break;
-
-                            case 2: {
-                                auto image = std::make_unique<Image<2>>();
-                                image->timestamp = NUClear::clock::now();
-                                image->format =  Image<2>::SourceFormat::BGGR;
-                                image->dimensions = { 1280, 960 };
-                                image->cameraToGround = arma::eye(4,4);
-                                image->source = std::move(data);
-
-                                // The lens! (hardcoded :P)
-                                image->lens.type = Image<2>::Lens::Type::RADIAL;
-                                image->lens.parameters.radial.fov = M_PI;
-                                image->lens.parameters.radial.pitch = 0.0025;
-                                image->lens.parameters.radial.centre[0] = 640;
-                                image->lens.parameters.radial.centre[1] = 480;
-
-                                emit(std::move(image));
-
-                            } break;
-
-                            case 3: {
-                                auto image = std::make_unique<Image<3>>();
-                                image->timestamp = NUClear::clock::now();
-                                image->format =  Image<3>::SourceFormat::BGGR;
-                                image->dimensions = { 1280, 960 };
-                                image->cameraToGround = arma::eye(4,4);
-                                image->source = std::move(data);
-
-                                // The lens! (hardcoded :P)
-                                image->lens.type = Image<3>::Lens::Type::RADIAL;
-                                image->lens.parameters.radial.fov = M_PI;
-                                image->lens.parameters.radial.pitch = 0.0025;
-                                image->lens.parameters.radial.centre[0] = 640;
-                                image->lens.parameters.radial.centre[1] = 480;
-
-                                emit(std::move(image));
-
-                            } break;
-                        }
+                    // We let go of the log while we wait to play and emit each message
+                    if(!lock.owns_lock()) {
+                        lock.lock();
                     }
-                    else if(message.type() == Message::GPS) {
-                        continue;
-                        // Print GPS as csv
-                        // print timestamp
-                        std::cout.precision(std::numeric_limits<double>::digits10);
-                        std::cout << message.utc_timestamp()
-                           << "," << message.gps().latitude()
-                           << "," << message.gps().longitude()
-                           << "," << message.gps().altitude()
-                           << std::endl;
+
+                    if(!running) {
+                        break;
                     }
-                    else if(message.type() == Message::ROBOTX_STATE) {
+
+                    // Wait until we have a log to play
+                    if(!input) {
+                        inputReady.wait(lock);
                         continue;
-                        std::cout.precision(std::numeric_limits<double>::digits10);
-                        std::cout << message.utc_timestamp();
-                        for(int i = 0; i < 15; ++i) {
-                            std::cout << "," << message.robotx_state().state(i);
+                    }
+
+                    utility::nbz::NBZReader::Record record;
+                    if(!input->next(record)) {
+
+                        double seconds = std::chrono::duration<double>(NUClear::clock::now() - playStart).count();
+                        log("Played", played, "images in", seconds, "seconds (", played / seconds, "fps )");
+
+                        // Only go around again if there was something to play
+                        if(loop && played > 0) {
+                            restart();
+                        }
+                        else {
+                            input.reset();
                         }
-                        std::cout << std::endl;
+                        continue;
+                    }
+
+                    // Read the message into the one we reuse (the record is only valid while we hold the log)
+                    message.ParsePartialFromArray(record.data, record.length);
+                    Mode playMode = mode;
+                    double playSpeed = speed;
+                    auto start = playStart;
+                    int64_t startTimestamp = logStart;
+                    ++played;
+
+                    lock.unlock();
+
+                    // Wait until it's time to play it
+                    if(playMode == Mode::REALTIME || playMode == Mode::SPEED) {
+                        auto logTime = std::chrono::duration<double, std::milli>(record.timestamp - startTimestamp) / playSpeed;
+                        std::this_thread::sleep_until(start + std::chrono::duration_cast<NUClear::clock::duration>(logTime));
                     }
 
+                    play(message, playMode);
                 }
             },
-            [] {
-                // This is a buggy module! recode me!
+            [this] {
+                std::lock_guard<std::mutex> lock(inputMutex);
+                running = false;
+                inputReady.notify_one();
             }));
 
     }
 
+    void NBZPlayer::restart() {
+
+        if(startRecord >= 0) {
+            input->seekRecord(startRecord);
+        }
+        else {
+            input->seek(input->firstTimestamp() + int64_t(startTime * 1000));
+        }
+
+        // Peek at where we ended up so the first image plays straight away
+        utility::nbz::NBZReader::Record record;
+        logStart = input->next(record) ? record.timestamp : input->firstTimestamp();
+
+        if(startRecord >= 0) {
+            input->seekRecord(startRecord);
+        }
+        else {
+            input->seek(logStart);
+        }
+
+        playStart = NUClear::clock::now();
+        played = 0;
+    }
+
+    void NBZPlayer::play(const Message& message, Mode playMode) {
+
+        if(message.type() != Message::IMAGE || message.image().data().empty()) {
+            return;
+        }
+
+        switch(message.image().camera_id()) {
+            case 0: emitImage<0>(message.image(), playMode); break;
+            case 1: emitImage<1>(message.image(), playMode); break;
+            case 2: emitImage<2>(message.image(), playMode); break;
+            case 3: emitImage<3>(message.image(), playMode); break;
+        }
+    }
+
+    template <int camID>
+    void NBZPlayer::emitImage(const ProtoImage& proto, Mode playMode) {
+
+        using Format = typename Image<camID>::SourceFormat;
+        using LensType = typename Image<camID>::Lens::Type;
+
+        auto image = std::make_unique<Image<camID>>();
+        image->timestamp = NUClear::clock::now();
+        image->dimensions = { proto.dimensions().x(), proto.dimensions().y() };
+        image->cameraToGround = arma::eye(4,4);
+
+        switch(proto.format()) {
+            case ProtoImage::YCbCr422:  image->format = Format::YCbCr422; break;
+            case ProtoImage::YCbCr444:  image->format = Format::YCbCr444; break;
+            case ProtoImage::RGB:       image->format = Format::RGB;      break;
+            case ProtoImage::JPEG:      image->format = Format::JPEG;     break;
+            case ProtoImage::BGGR:      image->format = Format::BGGR;     break;
+        }
+
+        if(proto.has_lens() && proto.lens().type() == ProtoImage::Lens::EQUIRECTANGULAR) {
+            image->lens.type = LensType::EQUIRECTANGULAR;
+            image->lens.parameters.equirectangular.fov[0] = proto.lens().equirectangular().fov().x();
+            image->lens.parameters.equirectangular.fov[1] = proto.lens().equirectangular().fov().y();
+            image->lens.parameters.equirectangular.focalLength = proto.lens().equirectangular().focal_length();
+        }
+        else if(proto.has_lens()) {
+            image->lens.type = proto.lens().type() == ProtoImage::Lens::BARREL ? LensType::BARREL : LensType::RADIAL;
+            image->lens.parameters.radial.fov = proto.lens().radial().fov();
+            image->lens.parameters.radial.pitch = proto.lens().radial().pitch();
+            image->lens.parameters.radial.centre[0] = proto.lens().radial().centre().x();
+            image->lens.parameters.radial.centre[1] = proto.lens().radial().centre().y();
+        }
+        else {
+            // Older logs did not record the lens, these are the values they were played with
+            image->format = Format::BGGR;
+            image->lens.type = LensType::RADIAL;
+            image->lens.parameters.radial.fov = M_PI;
+            image->lens.parameters.radial.pitch = 0.0025;
+            image->lens.parameters.radial.centre[0] = image->width() / 2;
+            image->lens.parameters.radial.centre[1] = image->height() / 2;
+        }
+        image->lens.cameraID = camID;
+
+        // Copy the pixels into a pooled buffer which comes back to us when the system is done with the image
+        bool reused;
+        const std::string& data = proto.data();
+        image->source = pool.acquire(data.size(), reused);
+        std::copy(data.begin(), data.end(), image->source.begin());
+
+        auto recycle = pool.recycler();
+        auto state = outstanding;
+        image->recycle = [recycle, state] (std::vector<uint8_t>&& buffer) {
+            recycle(std::move(buffer));
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            --state->count;
+            state->released.notify_all();
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(outstanding->mutex);
+            ++outstanding->count;
+        }
+        cameras |= 1 << camID;
+
+        if(playMode == Mode::LOCKSTEP) {
+            // Run the reactions to the image now rather than on the thread pool where they could be dropped
+            emit<Scope::DIRECT>(std::move(image));
+            waitForDownstream();
+        }
+        else {
+            emit(std::move(image));
+        }
+    }
+
+    void NBZPlayer::waitForDownstream() {
+
+        // The latest image from each camera is kept by the system, everything older must be finished with
+        uint cached = __builtin_popcount(cameras);
+
+        std::unique_lock<std::mutex> lock(outstanding->mutex);
+        bool drained = outstanding->released.wait_for(lock, LOCKSTEP_TIMEOUT, [this, cached] {
+            return outstanding->count <= cached;
+        });
+
+        if(!drained) {
+            log<NUClear::WARN>("Images are still in use after", LOCKSTEP_TIMEOUT.count(), "seconds, moving on without them");
+            outstanding->count = cached;
+        }
+    }
+
 }
 }
-
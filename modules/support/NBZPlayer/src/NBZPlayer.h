@@ -21,16 +21,73 @@
 #define MODULES_SUPPORT_NBZPLAYER_H
 
 #include <nuclear>
+#include <condition_variable>
+#include <mutex>
 
-#include <boost/iostreams/filtering_stream.hpp>
+#include "messages/support/nubugger/proto/Message.pb.h"
+#include "utility/image/FramePool.h"
+#include "utility/nbz/NBZReader.h"
 
 namespace modules {
 namespace support {
 
+    /**
+     * Plays the images in an NBZ log back into the system.
+     *
+     * The log can be played in real time, at some multiple of real time, as fast as it can be read, or in lock step
+     * where each image is processed directly and the player waits for everything downstream of the previous image to
+     * let go of it before sending the next one (so nothing is dropped however slow the pipeline is).
+     */
     class NBZPlayer : public NUClear::Reactor {
     private:
-        NUClear::clock::duration offset;
-        boost::iostreams::filtering_istream input;
+        enum class Mode {
+            REALTIME,
+            SPEED,
+            FAST,
+            LOCKSTEP
+        };
+
+        /**
+         * Tracks the images we have emitted that are still alive somewhere in the system
+         */
+        struct Outstanding {
+            std::mutex mutex;
+            std::condition_variable released;
+            uint count = 0;
+        };
+
+        // The log we are playing and how to play it
+        std::unique_ptr<utility::nbz::NBZReader> input;
+        Mode mode = Mode::REALTIME;
+        double speed = 1.0;
+        bool loop = false;
+        double startTime = 0;
+        int64_t startRecord = -1;
+
+        // The wall clock time we started playing and the log time we started from
+        NUClear::clock::time_point playStart;
+        int64_t logStart = 0;
+
+        // The message and image buffers are reused so playing does not allocate
+        messages::support::nubugger::proto::Message message;
+        utility::image::FramePool pool;
+        std::shared_ptr<Outstanding> outstanding;
+        uint cameras = 0;
+
+        // How many images we have played since we started
+        size_t played = 0;
+
+        std::mutex inputMutex;
+        std::condition_variable inputReady;
+        bool running = true;
+
+        void restart();
+        void play(const messages::support::nubugger::proto::Message& message, Mode playMode);
+        void waitForDownstream();
+
+        template <int camID>
+        void emitImage(const messages::input::proto::Image& image, Mode playMode);
+
     public:
         static constexpr const char* CONFIGURATION_PATH = "NBZPlayer.yaml";
         /// @brief Called by the powerplant to build and setup the NBZPlayer reactor.
@@ -41,4 +98,4 @@ namespace support {
 }
 
 
-#endif
\ No newline at end of file
+#endif
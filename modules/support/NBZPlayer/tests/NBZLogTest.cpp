@@ -0,0 +1,277 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "utility/nbz/NBZReader.h"
+#include "utility/nbz/NBZWriter.h"
+
+using utility::nbz::Codec;
+using utility::nbz::NBZReader;
+using utility::nbz::NBZWriter;
+using utility::nbz::typeHash;
+
+namespace {
+
+    std::string tempPath(const std::string& name) {
+        return "/tmp/" + name + "_" + std::to_string(getpid()) + ".nbz";
+    }
+
+    // Something shaped like a log: mostly repetitive with some noise
+    std::vector<uint8_t> makePayload(std::mt19937& rng, size_t size) {
+        std::vector<uint8_t> data(size);
+        for(size_t i = 0; i < size; ++i) {
+            data[i] = (i % 16 < 12) ? uint8_t(i / 64) : uint8_t(rng());
+        }
+        return data;
+    }
+
+    struct Written {
+        int64_t timestamp;
+        uint32_t type;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Written> writeLog(const std::string& path, Codec codec, size_t count, uint32_t blockSize) {
+
+        std::mt19937 rng(42);
+        uint32_t types[] = { typeHash("IMAGE"), typeHash("SENSOR_DATA"), typeHash("GPS") };
+
+        std::vector<Written> written;
+        NBZWriter writer(path, codec, blockSize);
+
+        for(size_t i = 0; i < count; ++i) {
+            Written w { int64_t(1000 + i * 10), types[i % 3], makePayload(rng, 1 + rng() % 3000) };
+            writer.write(w.timestamp, w.type, w.data.data(), uint32_t(w.data.size()));
+            written.push_back(std::move(w));
+        }
+
+        return written;
+    }
+
+    bool matches(const NBZReader::Record& record, const Written& w) {
+        return record.timestamp == w.timestamp
+            && record.type == w.type
+            && record.length == w.data.size()
+            && std::equal(w.data.begin(), w.data.end(), record.data);
+    }
+}
+
+TEST_CASE("NBZ logs read back the records that were written", "[nbz]") {
+
+    for(auto codec : { Codec::STORED, Codec::LZ4 }) {
+
+        std::string path = tempPath("roundtrip");
+        auto written = writeLog(path, codec, 2000, 64 * 1024);
+
+        NBZReader reader(path);
+        REQUIRE_FALSE(reader.recovered());
+        REQUIRE(reader.blocks().size() > 1);
+        REQUIRE(reader.firstTimestamp() == written.front().timestamp);
+        REQUIRE(reader.lastTimestamp() == written.back().timestamp);
+
+        NBZReader::Record record;
+        for(auto& w : written) {
+            REQUIRE(reader.next(record));
+            REQUIRE(matches(record, w));
+        }
+        REQUIRE_FALSE(reader.next(record));
+
+        unlink(path.c_str());
+    }
+}
+
+TEST_CASE("NBZ logs seek by time and filter by type using the index", "[nbz]") {
+
+    std::string path = tempPath("seek");
+    auto written = writeLog(path, Codec::LZ4, 3000, 32 * 1024);
+
+    NBZReader reader(path);
+    NBZReader::Record record;
+
+    // Seek to a time in the middle and between two records
+    reader.seek(written[1234].timestamp - 5);
+    REQUIRE(reader.next(record));
+    REQUIRE(matches(record, written[1234]));
+
+    // Seek past the end
+    reader.seek(written.back().timestamp + 1);
+    REQUIRE_FALSE(reader.next(record));
+
+    // Seek by record number
+    for(size_t n : { size_t(0), size_t(1), size_t(777), written.size() - 1 }) {
+        reader.seekRecord(n);
+        REQUIRE(reader.next(record));
+        REQUIRE(matches(record, written[n]));
+    }
+    reader.seekRecord(written.size());
+    REQUIRE_FALSE(reader.next(record));
+    REQUIRE(reader.size() == written.size());
+
+    // Only GPS records from the start
+    reader.rewind();
+    reader.filter({ typeHash("GPS") });
+
+    size_t count = 0;
+    while(reader.next(record)) {
+        REQUIRE(matches(record, written[count * 3 + 2]));
+        ++count;
+    }
+    REQUIRE(count == written.size() / 3);
+
+    unlink(path.c_str());
+}
+
+TEST_CASE("NBZ logs that were not closed are recovered up to the last complete record", "[nbz]") {
+
+    std::string path = tempPath("recover");
+    auto written = writeLog(path, Codec::LZ4, 2000, 64 * 1024);
+
+    NBZReader full(path);
+    auto blocks = full.blocks();
+    REQUIRE(blocks.size() > 3);
+
+    // Cut the file part way through its third last block (losing the index as a crash would)
+    uint64_t cut = blocks[blocks.size() - 3].offset + sizeof(utility::nbz::BlockHeader) + 20000;
+    REQUIRE(truncate(path.c_str(), cut) == 0);
+
+    NBZReader reader(path);
+    REQUIRE(reader.recovered());
+
+    // Every record we get back must be the one that was written, and we must get all of the complete blocks
+    NBZReader::Record record;
+    size_t count = 0;
+    while(reader.next(record)) {
+        REQUIRE(count < written.size());
+        REQUIRE(matches(record, written[count]));
+        ++count;
+    }
+
+    size_t complete = 0;
+    for(size_t i = 0; i < blocks.size() - 3; ++i) {
+        complete += blocks[i].records;
+    }
+
+    // The torn block gives us some records of its own
+    REQUIRE(count > complete);
+    REQUIRE(count < complete + blocks[blocks.size() - 3].records);
+
+    unlink(path.c_str());
+}
+
+TEST_CASE("NBZ logs write out old blocks even when nothing else is written", "[nbz]") {
+
+    std::string path = tempPath("aged");
+    NBZWriter writer(path, Codec::LZ4, 64 * 1024, std::chrono::milliseconds(20));
+
+    std::string data = "quiet";
+    writer.write(1000, typeHash("GPS"), data);
+
+    // Too young to write out yet
+    writer.flushAged();
+    REQUIRE(writer.size() == sizeof(utility::nbz::FileHeader));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    writer.flushAged();
+    REQUIRE(writer.size() > sizeof(utility::nbz::FileHeader));
+
+    // It can be read back (from its block, as a crash would leave it) without the log being closed
+    NBZReader reader(path);
+    REQUIRE(reader.recovered());
+
+    NBZReader::Record record;
+    REQUIRE(reader.next(record));
+    REQUIRE(record.timestamp == 1000);
+    REQUIRE(std::string(reinterpret_cast<const char*>(record.data), record.length) == data);
+    REQUIRE_FALSE(reader.next(record));
+
+    writer.close();
+    unlink(path.c_str());
+}
+
+TEST_CASE("Benchmark NBZ write and read throughput", "[nbz][benchmark][.]") {
+
+    // The size of the log to write in megabytes (NBZ_BENCHMARK_MB to change it)
+    const char* env = std::getenv("NBZ_BENCHMARK_MB");
+    const size_t megabytes = env ? std::stoul(env) : 4096;
+    const size_t total = megabytes << 20;
+
+    std::string path = tempPath("benchmark");
+
+    // A pool of record payloads to cycle through so we measure the log and not the generator
+    std::mt19937 rng(7);
+    std::vector<std::vector<uint8_t>> payloads;
+    for(int i = 0; i < 64; ++i) {
+        payloads.push_back(makePayload(rng, 512 + rng() % (64 * 1024)));
+    }
+
+    for(auto codec : { Codec::STORED, Codec::LZ4 }) {
+
+        size_t bytes = 0;
+        size_t records = 0;
+        uint64_t fileSize = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            NBZWriter writer(path, codec);
+            while(bytes < total) {
+                auto& payload = payloads[records % payloads.size()];
+                writer.write(int64_t(records), uint32_t(records % 5), payload.data(), uint32_t(payload.size()));
+                bytes += payload.size();
+                ++records;
+            }
+            writer.close();
+            fileSize = writer.size();
+        }
+        double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t readRecords = 0;
+        size_t readBytes = 0;
+
+        start = std::chrono::steady_clock::now();
+        {
+            NBZReader reader(path);
+            NBZReader::Record record;
+            while(reader.next(record)) {
+                readBytes += record.length;
+                ++readRecords;
+            }
+        }
+        double readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (codec == Codec::LZ4 ? "LZ4" : "Stored") << ": "
+                  << bytes / writeSeconds / (1 << 20) << " MB/s write, "
+                  << readBytes / readSeconds / (1 << 20) << " MB/s read, "
+                  << "ratio " << double(bytes) / fileSize << " over " << records << " records" << std::endl;
+
+        REQUIRE(readRecords == records);
+        REQUIRE(readBytes == bytes);
+    }
+
+    unlink(path.c_str());
+}
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "ImageStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "utility/image/Demosaic.h"
+
+namespace modules {
+namespace support {
+
+    using messages::input::proto::Image;
+
+    using utility::image::demosaic;
+    using utility::image::PlaneFormat;
+    using utility::image::Conversion;
+
+    ImageStreamer::ImageStreamer(std::function<void (Message& message, const std::vector<uint8_t>& data, std::shared_ptr<const void> owner)> send)
+        : send(std::move(send))
+        , pool(4) {
+    }
+
+    void ImageStreamer::configure(const Settings& newSettings) {
+
+        // downscale averages whole Bayer quads, which only works for powers of two (checked before anything changes)
+        uint scale = newSettings.scale;
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+            throw std::invalid_argument("image_stream scale must be 1, 2, 4 or 8, not " + std::to_string(scale));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        settings = newSettings;
+
+        settings.fps = std::max(settings.fps, 1.0);
+        settings.minQuality = std::min(std::max(settings.minQuality, 1), 100);
+        settings.maxQuality = std::min(std::max(settings.maxQuality, settings.minQuality), 100);
+
+        quality = std::min(std::max(settings.quality, settings.minQuality), settings.maxQuality);
+        stats.quality = quality;
+    }
+
+    void ImageStreamer::submit(Message&& message, const uint8_t* bayer, uint width, uint height, std::shared_ptr<const void> owner) {
+
+        // A frame we replace is released once we have unlocked, as its owner may have more work to do (e.g. recycling)
+        Frame replaced;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto& frame = pending[message.filter_id()];
+            if (frame.owner) {
+                replaced = std::move(frame);
+                ++stats.skipped;
+            }
+
+            frame = Frame { std::move(message), bayer, width, height, std::move(owner) };
+        }
+
+        wake.notify_one();
+    }
+
+    ImageStreamer::Statistics ImageStreamer::statistics() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    void ImageStreamer::run() {
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (running) {
+
+            if (pending.empty()) {
+                wake.wait(lock);
+                continue;
+            }
+
+            // Top up the budget, holding at most half a second of it so we can't burst after being idle
+            auto now = clock::now();
+            double bytesPerSecond = settings.bitrate / 8;
+            budget = std::min(budget + bytesPerSecond * std::chrono::duration<double>(now - refilled).count(), bytesPerSecond / 2);
+            refilled = now;
+
+            // Wait for our next frame time and until we have paid off what we overspent
+            auto ready = next;
+            if (budget < 0) {
+                ready = std::max(ready, now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(-budget / bytesPerSecond)));
+            }
+            if (now < ready) {
+                wake.wait_until(lock, ready);
+                continue;
+            }
+
+            // Take the next camera's frame after the one we did last
+            auto it = pending.upper_bound(last);
+            if (it == pending.end()) {
+                it = pending.begin();
+            }
+            last = it->first;
+            Frame frame = std::move(it->second);
+            pending.erase(it);
+
+            Settings current = settings;
+            int frameQuality = quality;
+            next = now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / current.fps));
+
+            lock.unlock();
+            auto start = clock::now();
+            size_t bytes = encode(frame, current, frameQuality);
+            auto encodeTime = clock::now() - start;
+            lock.lock();
+
+            budget -= bytes;
+
+            // Move the quality towards making frames their share of the bitrate, ignoring small differences
+            double ratio = bytes / (bytesPerSecond / current.fps);
+            if (bytes > 0 && (ratio > 1.1 || ratio < 0.8)) {
+                int step = int(std::round(std::min(std::max((1.0 - ratio) * 20, -10.0), 10.0)));
+                quality = std::min(std::max(quality + step, settings.minQuality), settings.maxQuality);
+            }
+
+            ++stats.encoded;
+            stats.bytes += bytes;
+            stats.quality = quality;
+            stats.encodeTime = encodeTime;
+        }
+    }
+
+    size_t ImageStreamer::encode(Frame& frame, const Settings& current, int frameQuality) {
+
+        uint width = frame.width / current.scale;
+        uint height = frame.height / current.scale;
+
+        downscale(frame.bayer, frame.width, frame.height, current.scale, rgb);
+
+        // We are done with the raw frame
+        frame.owner.reset();
+
+        // Start with a buffer that fit the last frame, and hand it back to the pool once it has been sent
+        bool reused;
+        auto buffer = pool.acquire(std::max<size_t>(lastSize * 2, 64 * 1024), reused);
+        if (!encoder.encode(rgb.data(), width, height, frameQuality, buffer)) {
+            return 0;
+        }
+        lastSize = buffer.size();
+
+        auto recycle = pool.recycler();
+        std::shared_ptr<std::vector<uint8_t>> jpeg(new std::vector<uint8_t>(std::move(buffer)), [recycle] (std::vector<uint8_t>* data) {
+            recycle(std::move(*data));
+            delete data;
+        });
+
+        // Describe the image we made rather than the one we were given
+        auto* image = frame.message.mutable_image();
+        image->set_format(Image::JPEG);
+        image->mutable_dimensions()->set_x(width);
+        image->mutable_dimensions()->set_y(height);
+
+        if (image->has_lens()) {
+            auto* lens = image->mutable_lens();
+            if (lens->has_radial()) {
+                auto* centre = lens->mutable_radial()->mutable_centre();
+                centre->set_x(centre->x() / current.scale);
+                centre->set_y(centre->y() / current.scale);
+            }
+            if (lens->has_equirectangular()) {
+                lens->mutable_equirectangular()->set_focal_length(lens->equirectangular().focal_length() / current.scale);
+            }
+        }
+
+        send(frame.message, *jpeg, jpeg);
+
+        return lastSize;
+    }
+
+    void ImageStreamer::downscale(const uint8_t* bayer, uint width, uint height, uint scale, std::vector<uint8_t>& output) {
+
+        if (scale <= 1) {
+            demosaic(bayer, width, height, PlaneFormat::YCbCr444, Conversion::NONE, output);
+            return;
+        }
+
+        // Each output pixel averages block x block Bayer quads
+        const uint block = scale / 2;
+        const uint outWidth = width / scale;
+        const uint outHeight = height / scale;
+        const uint quads = block * block;
+
+        output.resize(outWidth * outHeight * 3);
+        uint8_t* out = output.data();
+
+        for (uint y = 0; y < outHeight; ++y) {
+            for (uint x = 0; x < outWidth; ++x, out += 3) {
+
+                uint r = 0;
+                uint g = 0;
+                uint b = 0;
+
+                for (uint qy = 0; qy < block; ++qy) {
+                    // Green is where the row and column parity match, blue on even rows and red on odd rows
+                    const uint8_t* even = bayer + (y * scale + qy * 2) * width + x * scale;
+                    const uint8_t* odd = even + width;
+
+                    for (uint qx = 0; qx < block; ++qx, even += 2, odd += 2) {
+                        g += even[0] + odd[1];
+                        b += even[1];
+                        r += odd[0];
+                    }
+                }
+
+                out[0] = uint8_t(r / quads);
+                out[1] = uint8_t(g / (quads * 2));
+                out[2] = uint8_t(b / quads);
+            }
+        }
+    }
+
+    void ImageStreamer::kill() {
+
+        // Give back the frames we won't get to
+        std::map<uint, Frame> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            std::swap(dropped, pending);
+        }
+        wake.notify_all();
+    }
+
+} // support
+} // modules
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_SUPPORT_NUBUGGER_IMAGESTREAMER_H
+#define MODULES_SUPPORT_NUBUGGER_IMAGESTREAMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "messages/support/nubugger/proto/Message.pb.h"
+#include "utility/image/FramePool.h"
+
+#include "JpegEncoder.h"
+
+namespace modules {
+    namespace support {
+
+        /**
+         * Demosaics, downscales and JPEG compresses camera images on its own thread before they are sent.
+         *
+         * Each camera has one waiting frame, which a newer frame replaces, so a camera that is faster than the
+         * stream has its frames skipped rather than queued. Frames are compressed no more often than the frame rate
+         * and only while there is bitrate to spend on them (a budget that refills at the bitrate). The JPEG quality
+         * moves so each frame is about its share of the bitrate. Compressed frames are pooled and sent without being
+         * copied.
+         */
+        class ImageStreamer {
+        public:
+            using clock = std::chrono::steady_clock;
+            using Message = messages::support::nubugger::proto::Message;
+
+            struct Settings {
+                // Divide the width and height by this (1, 2, 4 or 8)
+                uint scale = 2;
+                // Bits a second to spend on images from every camera
+                double bitrate = 20e6;
+                // Most images a second to send from every camera
+                double fps = 15;
+                // The range the JPEG quality can move in and where it starts
+                int minQuality = 30;
+                int maxQuality = 90;
+                int quality = 75;
+            };
+
+            struct Statistics {
+                uint64_t encoded = 0;
+                uint64_t skipped = 0;
+                uint64_t bytes = 0;
+                int quality = 0;
+                // How long the last frame took to demosaic, downscale and compress
+                clock::duration encodeTime = clock::duration::zero();
+            };
+
+            explicit ImageStreamer(std::function<void (Message& message, const std::vector<uint8_t>& data, std::shared_ptr<const void> owner)> send);
+
+            void configure(const Settings& settings);
+
+            /**
+             * Offers a BGGR frame for streaming, replacing any of its camera's (filter id's) frames that are waiting
+             *
+             * @param message an image message with everything but the image's data filled in
+             * @param owner   keeps the frame alive until it is compressed
+             */
+            void submit(Message&& message, const uint8_t* bayer, uint width, uint height, std::shared_ptr<const void> owner);
+
+            Statistics statistics();
+
+            /// Compresses and sends frames until killed (run as a service task)
+            void run();
+            void kill();
+
+            /**
+             * Demosaics a Bayer frame into RGB with its width and height divided by scale (1 or a power of two).
+             * Scales above 1 average 2x2 Bayer quads, so they never interpolate.
+             */
+            static void downscale(const uint8_t* bayer, uint width, uint height, uint scale, std::vector<uint8_t>& output);
+
+        private:
+            struct Frame {
+                Message message;
+                const uint8_t* bayer;
+                uint width;
+                uint height;
+                std::shared_ptr<const void> owner;
+            };
+
+            size_t encode(Frame& frame, const Settings& settings, int quality);
+
+            std::function<void (Message& message, const std::vector<uint8_t>& data, std::shared_ptr<const void> owner)> send;
+
+            std::mutex mutex;
+            std::condition_variable wake;
+            bool running = true;
+
+            Settings settings;
+            Statistics stats;
+
+            // The newest frame from each camera by filter id, served in turn
+            std::map<uint, Frame> pending;
+            uint last = 0;
+
+            // Bytes we can spend and when we last topped them up
+            double budget = 0;
+            clock::time_point refilled = clock::now();
+            clock::time_point next = clock::now();
+            int quality = 75;
+
+            // Only used by the thread running us
+            JpegEncoder encoder;
+            std::vector<uint8_t> rgb;
+            utility::image::FramePool pool;
+            size_t lastSize = 0;
+        };
+
+    }  // support
+}  // modules
+
+#endif  // MODULES_SUPPORT_NUBUGGER_IMAGESTREAMER_H
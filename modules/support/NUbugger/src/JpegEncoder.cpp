@@ -0,0 +1,119 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "JpegEncoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace modules {
+namespace support {
+
+    namespace {
+        // How big a buffer we start with if we are given an empty one
+        constexpr size_t INITIAL_SIZE = 64 * 1024;
+    }
+
+    JpegEncoder::JpegEncoder() {
+        std::memset(&cinfo, 0, sizeof(cinfo));
+        cinfo.err = jpeg_std_error(&error.manager);
+        error.manager.error_exit = &JpegEncoder::errorExit;
+        error.manager.output_message = [] (j_common_ptr) {};
+        jpeg_create_compress(&cinfo);
+
+        destination.manager.init_destination = &JpegEncoder::initDestination;
+        destination.manager.empty_output_buffer = &JpegEncoder::emptyOutputBuffer;
+        destination.manager.term_destination = &JpegEncoder::termDestination;
+        destination.output = nullptr;
+        cinfo.dest = &destination.manager;
+    }
+
+    JpegEncoder::~JpegEncoder() {
+        jpeg_destroy_compress(&cinfo);
+    }
+
+    void JpegEncoder::errorExit(j_common_ptr cinfo) {
+        // The error manager is the first member so we can get back to our jump buffer
+        ErrorManager* error = reinterpret_cast<ErrorManager*>(cinfo->err);
+        std::longjmp(error->jump, 1);
+    }
+
+    void JpegEncoder::initDestination(j_compress_ptr cinfo) {
+        // The destination manager is the first member so we can get back to our buffer
+        std::vector<uint8_t>& output = *reinterpret_cast<Destination*>(cinfo->dest)->output;
+
+        // Use all of the buffer we were given
+        output.resize(std::max(output.capacity(), INITIAL_SIZE));
+        cinfo->dest->next_output_byte = output.data();
+        cinfo->dest->free_in_buffer = output.size();
+    }
+
+    boolean JpegEncoder::emptyOutputBuffer(j_compress_ptr cinfo) {
+        std::vector<uint8_t>& output = *reinterpret_cast<Destination*>(cinfo->dest)->output;
+
+        // libjpeg only calls this when the buffer is full, so double it and carry on after what is there
+        size_t used = output.size();
+        output.resize(used * 2);
+        cinfo->dest->next_output_byte = output.data() + used;
+        cinfo->dest->free_in_buffer = output.size() - used;
+
+        return TRUE;
+    }
+
+    void JpegEncoder::termDestination(j_compress_ptr cinfo) {
+        std::vector<uint8_t>& output = *reinterpret_cast<Destination*>(cinfo->dest)->output;
+        output.resize(output.size() - cinfo->dest->free_in_buffer);
+    }
+
+    bool JpegEncoder::encode(const uint8_t* input, size_t width, size_t height, int quality, std::vector<uint8_t>& output) {
+
+        if (setjmp(error.jump)) {
+            // libjpeg hit an error part way through, get ready for the next image
+            jpeg_abort_compress(&cinfo);
+            return false;
+        }
+
+        destination.output = &output;
+
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+
+        // Set our options
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, true);
+        cinfo.dct_method = JDCT_IFAST;
+
+        jpeg_start_compress(&cinfo, true);
+
+        // Compress the image a scanline at a time from where it is
+        const size_t stride = width * 3;
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = const_cast<uint8_t*>(input + cinfo.next_scanline * stride);
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_compress(&cinfo);
+
+        return true;
+    }
+
+} // support
+} // modules
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_SUPPORT_NUBUGGER_JPEGENCODER_H
+#define MODULES_SUPPORT_NUBUGGER_JPEGENCODER_H
+
+#include <csetjmp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+    #include <jpeglib.h>
+}
+
+namespace modules {
+    namespace support {
+
+        /**
+         * @brief Compresses RGB images to JPEG, writing them into a buffer we already own.
+         *
+         * @details
+         *  The JPEG compressor is made once and reused for every image. It writes straight into the output buffer,
+         *  only growing it when the image doesn't fit, so a buffer that is reused stops allocating.
+         */
+        class JpegEncoder {
+        public:
+            JpegEncoder();
+            ~JpegEncoder();
+
+            JpegEncoder(const JpegEncoder&) = delete;
+            JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+            /**
+             * @brief Compresses an image with three channels per pixel
+             *
+             * @param input   the image, width * height * 3 bytes
+             * @param quality the JPEG quality (1 to 100)
+             * @param output  resized to hold the compressed image
+             *
+             * @return false if libjpeg failed
+             */
+            bool encode(const uint8_t* input, size_t width, size_t height, int quality, std::vector<uint8_t>& output);
+
+        private:
+            /// @brief libjpeg's error manager with somewhere to jump back to instead of exiting
+            struct ErrorManager {
+                jpeg_error_mgr manager;
+                std::jmp_buf jump;
+            };
+
+            /// @brief libjpeg's destination manager with the buffer it is writing into
+            struct Destination {
+                jpeg_destination_mgr manager;
+                std::vector<uint8_t>* output;
+            };
+
+            static void errorExit(j_common_ptr cinfo);
+            static void initDestination(j_compress_ptr cinfo);
+            static boolean emptyOutputBuffer(j_compress_ptr cinfo);
+            static void termDestination(j_compress_ptr cinfo);
+
+            jpeg_compress_struct cinfo;
+            ErrorManager error;
+            Destination destination;
+        };
+
+    }  // support
+}  // modules
+
+#endif  // MODULES_SUPPORT_NUBUGGER_JPEGENCODER_H
@@ -20,8 +20,6 @@
 #include "NUbugger.h"
 
 #include <zmq.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "messages/vision/LookUpTable.h"
 #include "messages/support/Configuration.h"
@@ -55,9 +53,16 @@ namespace support {
     NUbugger::NUbugger(std::unique_ptr<NUClear::Environment> environment)
         : Reactor(std::move(environment))
         , pub(NUClear::extensions::Networking::ZMQ_CONTEXT, ZMQ_PUB)
-        , sub(NUClear::extensions::Networking::ZMQ_CONTEXT, ZMQ_SUB) {
+        , sub(NUClear::extensions::Networking::ZMQ_CONTEXT, ZMQ_SUB)
+        , sendQueue([this](std::vector<zmq::message_t>& frame) { send(frame); })
+        , imageStreamer([this](Message& message, const std::vector<uint8_t>& data, std::shared_ptr<const void> owner) {
+            // Compressed frames are only for watching live, the file is sent the raw frames
+            sendImage(message, data.data(), data.size(), std::move(owner), false, true);
+        }) {
 
         powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask(std::bind(std::mem_fn(&NUbugger::run), this), std::bind(std::mem_fn(&NUbugger::kill), this)));
+        powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask(std::bind(std::mem_fn(&SendQueue::run), &sendQueue), std::bind(std::mem_fn(&SendQueue::kill), &sendQueue)));
+        powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask(std::bind(std::mem_fn(&ImageStreamer::run), &imageStreamer), std::bind(std::mem_fn(&ImageStreamer::kill), &imageStreamer)));
 
         on<Trigger<Configuration<NUbugger>>>([this] (const Configuration<NUbugger>& config) {
 
@@ -67,6 +72,57 @@ namespace support {
 
             // TODO if the file location is different, close the file and open a new one
 
+            // Limit how often each type of message is sent and how many of them can wait to be
+            std::map<uint8_t, SendQueue::Limit> limits;
+            SendQueue::Limit defaultLimit;
+            for (auto& setting : config["output"]["network"]["limits"]) {
+                std::string name = setting.first.as<std::string>();
+
+                SendQueue::Limit limit;
+                limit.rate = setting.second["rate"].as<double>();
+                limit.depth = setting.second["depth"].as<size_t>();
+
+                Message::Type type;
+                if (name == "default") {
+                    defaultLimit = limit;
+                }
+                else if (Message::Type_Parse(name, &type)) {
+                    limits[uint8_t(type)] = limit;
+                }
+                else {
+                    log<NUClear::WARN>("There is no message type", name, "to limit");
+                }
+            }
+            sendQueue.setLimits(limits, defaultLimit);
+            sendQueue.setFrameSize(config["output"]["network"]["frame_size"].as<size_t>());
+
+            // Only batch messages into frames for clients that know how to split them apart again
+            std::string framing = config["output"]["network"]["framing"].as<std::string>();
+            if (framing == "batched") {
+                sendQueue.setFraming(SendQueue::Framing::BATCHED);
+            }
+            else {
+                if (framing != "single") {
+                    log<NUClear::WARN>("Unknown network framing", framing, "sending single messages");
+                }
+                sendQueue.setFraming(SendQueue::Framing::SINGLE);
+            }
+
+            // Compress camera images to fit in a bitrate, or send them raw
+            imageStreaming = config["image_stream"]["enabled"].as<bool>();
+
+            ImageStreamer::Settings imageSettings;
+            imageSettings.scale = config["image_stream"]["scale"].as<uint>();
+            imageSettings.bitrate = config["image_stream"]["bitrate"].as<double>();
+            imageSettings.fps = config["image_stream"]["fps"].as<double>();
+            imageSettings.minQuality = config["image_stream"]["quality"]["min"].as<int>();
+            imageSettings.maxQuality = config["image_stream"]["quality"]["max"].as<int>();
+            imageSettings.quality = config["image_stream"]["quality"]["initial"].as<int>();
+            imageStreamer.configure(imageSettings);
+
+            // The send queue's thread uses the publisher too
+            std::unique_lock<std::mutex> networkLock(networkMutex);
+
             // If we are using the network
             if(config["output"]["network"]["enabled"].as<bool>()) {
 
@@ -105,6 +161,8 @@ namespace support {
                 networkEnabled = false;
             }
 
+            networkLock.unlock();
+
             // If we are using files and haven't set one up yet
             if(!fileEnabled && config["output"]["file"]["enabled"].as<bool>()) {
 
@@ -114,35 +172,48 @@ namespace support {
                 // Get our timestamp
                 std::string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(NUClear::clock::now().time_since_epoch()).count());
 
-                // Reset the file if one exists
-                if(outputFile) {
-                    boost::iostreams::close(outputFile);
-                }
+                // Reset the file if one exists (this writes its index)
+                outputFile.reset();
 
                 std::string outputFilePath = config["output"]["file"]["path"].as<std::string>();
                 outputFilePath += "/";
                 outputFilePath += timestamp;
                 outputFilePath += ".nbz";
 
-                // outputFile.push(boost::iostreams::gzip_compressor(9));
-                outputFile.push(boost::iostreams::file_descriptor_sink(outputFilePath, std::ios_base::out | std::ios_base::binary));
+                outputFile = std::make_unique<utility::nbz::NBZWriter>(outputFilePath);
 
                 fileEnabled = true;
             }
             else if(fileEnabled && !config["output"]["file"]["enabled"].as<bool>()) {
 
-
-                // TODO close the file
-
                 // Lock the file
                 std::lock_guard<std::mutex> lock(fileMutex);
 
                 // Close the file
-                boost::iostreams::close(outputFile);
+                outputFile.reset();
 
                 fileEnabled = false;
             }
 
+            // Write every reaction to a trace file while it's enabled
+            if(!traceEnabled && config["reaction_profile"]["trace"]["enabled"].as<bool>()) {
+
+                std::string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(NUClear::clock::now().time_since_epoch()).count());
+                std::string tracePath = config["reaction_profile"]["trace"]["path"].as<std::string>() + "/" + timestamp + ".json";
+
+                if(profiler.openTrace(tracePath, config["reaction_profile"]["trace"]["max_events"].as<size_t>())) {
+                    log("Tracing reactions to", tracePath);
+                    traceEnabled = true;
+                }
+                else {
+                    log<NUClear::WARN>("Could not open", tracePath, "to trace reactions to");
+                }
+            }
+            else if(traceEnabled && !config["reaction_profile"]["trace"]["enabled"].as<bool>()) {
+                profiler.closeTrace();
+                traceEnabled = false;
+            }
+
             for (auto& setting : config["reaction_handles"]) {
                 std::string name = setting.first.as<std::string>();
                 bool enabled = setting.second.as<bool>();
@@ -178,6 +249,14 @@ namespace support {
             send(message);
         });
 
+        // Write out the file's block once it is old enough even if nothing else is logged
+        on<Trigger<Every<250, std::chrono::milliseconds>>, Options<Single, Priority<NUClear::LOW>>>([this] (const time_t&) {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if(outputFile) {
+                outputFile->flushAged();
+            }
+        });
+
         on<Trigger<CurrentTask>, With<AutonomousMode>, With<Configuration<NUbugger>>>([this](const CurrentTask& newTask, const AutonomousMode& au, const Configuration<NUbugger>& config) {
             // If we are changing tasks
             if(task != newTask.ID || autonomous != au.on) {
@@ -191,10 +270,8 @@ namespace support {
                 // Get our timestamp
                 std::string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(NUClear::clock::now().time_since_epoch()).count());
 
-                // Reset the file if one exists
-                if(outputFile) {
-                    boost::iostreams::close(outputFile);
-                }
+                // Reset the file if one exists (this writes its index)
+                outputFile.reset();
 
                 std::string outputFilePath = config["output"]["file"]["path"].as<std::string>();
                 outputFilePath += "/";
@@ -205,8 +282,7 @@ namespace support {
                 outputFilePath += au.on ? "Autonomous" : "RemoteControl";
                 outputFilePath += ".nbs";
 
-                // outputFile.push(boost::iostreams::gzip_compressor(9));
-                outputFile.push(boost::iostreams::file_descriptor_sink(outputFilePath, std::ios_base::out | std::ios_base::binary));
+                outputFile = std::make_unique<utility::nbz::NBZWriter>(outputFilePath);
             }
         });
 
@@ -223,10 +299,8 @@ namespace support {
                 // Get our timestamp
                 std::string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(NUClear::clock::now().time_since_epoch()).count());
 
-                // Reset the file if one exists
-                if(outputFile) {
-                    boost::iostreams::close(outputFile);
-                }
+                // Reset the file if one exists (this writes its index)
+                outputFile.reset();
 
                 std::string outputFilePath = config["output"]["file"]["path"].as<std::string>();
                 outputFilePath += "/";
@@ -237,8 +311,7 @@ namespace support {
                 outputFilePath += au.on ? "Autonomous" : "RemoteControl";
                 outputFilePath += ".nbs";
 
-                // outputFile.push(boost::iostreams::gzip_compressor(9));
-                outputFile.push(boost::iostreams::file_descriptor_sink(outputFilePath, std::ios_base::out | std::ios_base::binary));
+                outputFile = std::make_unique<utility::nbz::NBZWriter>(outputFilePath);
             }
         });
 
@@ -253,12 +326,20 @@ namespace support {
 
         // When we shutdown, close our publisher and our file if we have one
         on<Trigger<Shutdown>>([this](const Shutdown&) {
-            pub.close();
+            {
+                std::lock_guard<std::mutex> lock(networkMutex);
+                networkEnabled = false;
+                pub.close();
+            }
 
             // Close the file if it exists
             if(fileEnabled) {
-                boost::iostreams::close(outputFile);
+                std::lock_guard<std::mutex> lock(fileMutex);
+                outputFile.reset();
             }
+
+            // Finish the trace so it is valid JSON
+            profiler.closeTrace();
         });
     }
 
@@ -368,32 +449,35 @@ namespace support {
     /**
      * This method needs to be used over pub.send as all calls to
      * pub.send need to be synchronized with a concurrency primitive
-     * (such as a mutex)
+     * (such as a mutex). It is called from the send queue's thread.
      */
-    void NUbugger::send(zmq::message_t& packet) {
+    void NUbugger::send(std::vector<zmq::message_t>& frame) {
         std::lock_guard<std::mutex> lock(networkMutex);
-        pub.send(packet);
+
+        if(networkEnabled) {
+            for (size_t i = 0; i < frame.size(); ++i) {
+                pub.send(frame[i], i + 1 < frame.size() ? ZMQ_SNDMORE : 0);
+            }
+        }
     }
 
     void NUbugger::send(Message message) {
 
         if(networkEnabled) {
-            // Make a ZMQ packet and send it
-            size_t messageSize = message.ByteSize();
-            zmq::message_t packet(messageSize + 2);
-            char* dataPtr = static_cast<char*>(packet.data());
-            message.SerializeToArray(dataPtr + 2, messageSize);
-            dataPtr[0] = uint8_t(message.type());
-            dataPtr[1] = uint8_t(message.filter_id());
-            send(packet);
+            // Queue it to be sent, the network is only touched by the send queue's thread
+            std::string payload;
+            message.SerializeToString(&payload);
+            sendQueue.push(uint8_t(message.type()), uint8_t(message.filter_id()), std::move(payload));
         }
 
-        if(fileEnabled && outputFile) {
+        if(fileEnabled) {
             std::lock_guard<std::mutex> lock(fileMutex);
-            // Append the number of bytes to the file (so we can re-read it)
-            outputFile << uint32_t(message.ByteSize());
-            // Append the protocol buffer to the file
-            message.SerializeToOstream(&outputFile);
+
+            if(outputFile) {
+                // Log the message under its type so players can pick out the ones they want without parsing them
+                message.SerializeToString(&fileBuffer);
+                outputFile->write(message.utc_timestamp(), utility::nbz::typeHash(Message::Type_Name(message.type())), fileBuffer);
+            }
         }
 
 
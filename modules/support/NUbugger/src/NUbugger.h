@@ -26,7 +26,11 @@
 #include "messages/localisation/FieldObject.h"
 #include "messages/input/gameevents/GameEvents.h"
 
-#include <boost/iostreams/filtering_stream.hpp>
+#include "utility/nbz/NBZWriter.h"
+
+#include "ImageStreamer.h"
+#include "ReactionProfiler.h"
+#include "SendQueue.h"
 
 namespace modules {
     namespace support {
@@ -60,11 +64,24 @@ namespace modules {
             bool networkEnabled = false;
             bool fileEnabled = false;
 
-            boost::iostreams::filtering_ostream outputFile;
+            std::unique_ptr<utility::nbz::NBZWriter> outputFile;
+            // Messages are serialised into this before being logged so we don't allocate for each one
+            std::string fileBuffer;
 
             std::mutex networkMutex;
             std::mutex fileMutex;
 
+            // Messages for the network wait here so whoever sends them never waits on the network
+            SendQueue sendQueue;
+
+            // Camera images are compressed here rather than on the vision threads
+            ImageStreamer imageStreamer;
+            bool imageStreaming = false;
+
+            // Reaction statistics are aggregated here and sent as periodic profiles
+            ReactionProfiler profiler;
+            bool traceEnabled = false;
+
             void provideDataPoints();
             void provideDrawObjects();
             void provideBehaviour();
@@ -79,8 +96,9 @@ namespace modules {
             messages::input::proto::GameState::Data::Mode getMode(const messages::input::gameevents::Mode& phase);
             messages::input::proto::GameState::Data::PenaltyReason getPenaltyReason(const messages::input::gameevents::PenaltyReason& penaltyReason);
 
-            void send(zmq::message_t& packet);
+            void send(std::vector<zmq::message_t>& frame);
             void send(messages::support::nubugger::proto::Message message);
+            void sendImage(messages::support::nubugger::proto::Message message, const uint8_t* data, size_t bytes, std::shared_ptr<const void> owner, bool toFile = true, bool toNetwork = true);
 
             void recvMessage(const messages::support::nubugger::proto::Message& message);
             void recvCommand(const messages::support::nubugger::proto::Message& message);
@@ -0,0 +1,193 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "ReactionProfiler.h"
+
+#include <algorithm>
+
+namespace modules {
+    namespace support {
+
+        using messages::support::nuclear::proto::ReactionProfile;
+
+        namespace {
+            uint64_t micros(const NUClear::clock::duration& duration) {
+                // Clocks can step backwards, treat that as no time at all
+                return std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+            }
+
+            void writeJSONString(std::ostream& out, const std::string& value) {
+                out << '"';
+                for(char c : value) {
+                    switch(c) {
+                        case '"':  out << "\\\""; break;
+                        case '\\': out << "\\\\"; break;
+                        case '\n': out << "\\n";  break;
+                        case '\t': out << "\\t";  break;
+                        default:
+                            if(uint8_t(c) < 0x20) {
+                                const char* hex = "0123456789abcdef";
+                                out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+                            }
+                            else {
+                                out << c;
+                            }
+                    }
+                }
+                out << '"';
+            }
+        }
+
+        void ReactionProfiler::record(uint64_t reactionId
+            , const std::string& name
+            , const std::string& triggerName
+            , uint64_t taskId
+            , uint64_t causeTaskId
+            , const NUClear::clock::time_point& emitted
+            , const NUClear::clock::time_point& started
+            , const NUClear::clock::time_point& finished
+            , bool exception) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto& reaction = reactions[reactionId];
+            if(reaction.name.empty() && reaction.triggerName.empty()) {
+                reaction.name = name;
+                reaction.triggerName = triggerName;
+            }
+
+            reaction.latency.record(micros(finished - started));
+            reaction.queue.record(micros(started - emitted));
+            reaction.exceptions += exception;
+
+            if(trace.is_open()) {
+                writeTraceEvent(reaction, reactionId, taskId, causeTaskId, emitted, started, finished);
+            }
+        }
+
+        bool ReactionProfiler::snapshot(ReactionProfile& profile, const NUClear::clock::time_point& now) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            double seconds = std::chrono::duration<double>(now - periodStart).count();
+            profile.Clear();
+            profile.set_period(micros(now - periodStart));
+            periodStart = now;
+
+            for(auto& entry : reactions) {
+                auto& reaction = entry.second;
+
+                if(reaction.latency.count() == 0) {
+                    continue;
+                }
+
+                auto* out = profile.add_reactions();
+                out->set_name(reaction.name);
+                out->set_triggername(reaction.triggerName);
+                out->set_reactionid(entry.first);
+                out->set_count(reaction.latency.count());
+                out->set_rate(seconds > 0 ? reaction.latency.count() / seconds : 0);
+                out->set_exceptions(reaction.exceptions);
+                out->set_latencyp50(reaction.latency.percentile(0.5));
+                out->set_latencyp99(reaction.latency.percentile(0.99));
+                out->set_latencymax(reaction.latency.max());
+                out->set_queuep50(reaction.queue.percentile(0.5));
+                out->set_queuep99(reaction.queue.percentile(0.99));
+                out->set_queuemax(reaction.queue.max());
+
+                reaction.latency.clear();
+                reaction.queue.clear();
+                reaction.exceptions = 0;
+            }
+
+            return profile.reactions_size() > 0;
+        }
+
+        bool ReactionProfiler::openTrace(const std::string& path, size_t maxEvents) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(trace.is_open()) {
+                trace << "\n]\n";
+                trace.close();
+            }
+
+            trace.open(path, std::ios::out | std::ios::trunc);
+            if(!trace) {
+                return false;
+            }
+
+            trace << "[\n";
+            traceEvents = 0;
+            maxTraceEvents = maxEvents;
+            return true;
+        }
+
+        void ReactionProfiler::closeTrace() {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(trace.is_open()) {
+                trace << "\n]\n";
+                trace.close();
+            }
+        }
+
+        ReactionProfiler::~ReactionProfiler() {
+            closeTrace();
+        }
+
+        void ReactionProfiler::writeTraceEvent(const Reaction& reaction
+            , uint64_t reactionId
+            , uint64_t taskId
+            , uint64_t causeTaskId
+            , const NUClear::clock::time_point& emitted
+            , const NUClear::clock::time_point& started
+            , const NUClear::clock::time_point& finished) {
+
+            if(traceEvents >= maxTraceEvents) {
+                // The file is still valid JSON once we stop adding to it
+                trace << "\n]\n";
+                trace.close();
+                return;
+            }
+
+            // Each reaction gets its own track, named after the reaction
+            if(traceEvents > 0) {
+                trace << ",\n";
+            }
+
+            trace << "{\"name\":";
+            writeJSONString(trace, reaction.name.empty() ? reaction.triggerName : reaction.name);
+            trace << ",\"cat\":\"reaction\",\"ph\":\"X\""
+                  << ",\"ts\":" << micros(started.time_since_epoch())
+                  << ",\"dur\":" << micros(finished - started)
+                  << ",\"pid\":1,\"tid\":" << reactionId
+                  << ",\"args\":{\"task\":" << taskId
+                  << ",\"cause\":" << causeTaskId
+                  << ",\"queue\":" << micros(started - emitted)
+                  << ",\"trigger\":";
+            writeJSONString(trace, reaction.triggerName);
+            trace << "}}";
+
+            ++traceEvents;
+        }
+
+    }  // support
+}  // modules
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_SUPPORT_NUBUGGER_REACTIONPROFILER_H
+#define MODULES_SUPPORT_NUBUGGER_REACTIONPROFILER_H
+
+#include <nuclear>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "messages/support/nuclear/proto/ReactionProfile.pb.h"
+#include "utility/time/LatencyHistogram.h"
+
+namespace modules {
+    namespace support {
+
+        /**
+         * Aggregates reaction statistics per reaction into latency (started to finished) and queue delay (emitted to
+         * started) histograms, which are turned into compact snapshots periodically. Can also write every reaction to a
+         * Chrome trace (JSON) file that chrome://tracing and Perfetto can open.
+         */
+        class ReactionProfiler {
+        public:
+            void record(uint64_t reactionId
+                , const std::string& name
+                , const std::string& triggerName
+                , uint64_t taskId
+                , uint64_t causeTaskId
+                , const NUClear::clock::time_point& emitted
+                , const NUClear::clock::time_point& started
+                , const NUClear::clock::time_point& finished
+                , bool exception);
+
+            /**
+             * Fills the profile with every reaction that ran since the last snapshot and starts a new period
+             *
+             * @return if any reaction ran in the period
+             */
+            bool snapshot(messages::support::nuclear::proto::ReactionProfile& profile, const NUClear::clock::time_point& now);
+
+            /**
+             * Starts writing every reaction to a trace file, until maxEvents have been written
+             */
+            bool openTrace(const std::string& path, size_t maxEvents);
+            void closeTrace();
+
+            ~ReactionProfiler();
+
+        private:
+            struct Reaction {
+                std::string name;
+                std::string triggerName;
+                utility::time::LatencyHistogram latency;
+                utility::time::LatencyHistogram queue;
+                uint32_t exceptions = 0;
+            };
+
+            std::mutex mutex;
+            std::map<uint64_t, Reaction> reactions;
+            NUClear::clock::time_point periodStart = NUClear::clock::now();
+
+            std::ofstream trace;
+            size_t traceEvents = 0;
+            size_t maxTraceEvents = 0;
+
+            void writeTraceEvent(const Reaction& reaction
+                , uint64_t reactionId
+                , uint64_t taskId
+                , uint64_t causeTaskId
+                , const NUClear::clock::time_point& emitted
+                , const NUClear::clock::time_point& started
+                , const NUClear::clock::time_point& finished);
+        };
+
+    }  // support
+}  // modules
+
+#endif  // MODULES_SUPPORT_NUBUGGER_REACTIONPROFILER_H
@@ -52,6 +52,32 @@ namespace support {
 
             send(message);
         }));
+
+        // Aggregate every reaction rather than sending each one
+        handles["reaction_profile"].push_back(on<Trigger<NUClear::ReactionStatistics>>([this](const NUClear::ReactionStatistics& stats) {
+            profiler.record(stats.reactionId
+                , stats.identifier[0]
+                , stats.identifier[1]
+                , stats.taskId
+                , stats.causeTaskId
+                , stats.emitted
+                , stats.started
+                , stats.finished
+                , bool(stats.exception));
+        }));
+
+        handles["reaction_profile"].push_back(on<Trigger<Every<1, std::chrono::seconds>>, Options<Single, Priority<NUClear::LOW>>>([this](const time_t&) {
+            Message message;
+
+            // Only send a profile when something ran
+            if(profiler.snapshot(*message.mutable_reaction_profile(), NUClear::clock::now())) {
+                message.set_type(Message::REACTION_PROFILE);
+                message.set_filter_id(1);
+                message.set_utc_timestamp(getUtcTimestamp());
+
+                send(message);
+            }
+        }));
     }
 }
 }
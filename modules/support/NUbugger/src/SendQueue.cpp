@@ -0,0 +1,266 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "SendQueue.h"
+
+#include <algorithm>
+
+namespace modules {
+namespace support {
+
+    namespace {
+
+        /**
+         * Makes a zmq message that uses data in place, keeping owner alive until zmq has sent it
+         */
+        zmq::message_t borrow(const void* data, size_t size, std::shared_ptr<const void> owner) {
+            return zmq::message_t(const_cast<void*>(data), size, [] (void*, void* hint) {
+                delete static_cast<std::shared_ptr<const void>*>(hint);
+            }, new std::shared_ptr<const void>(std::move(owner)));
+        }
+    }
+
+    SendQueue::SendQueue(std::function<void (std::vector<zmq::message_t>& frame)> sendFrame)
+        : sendFrame(std::move(sendFrame)) {
+    }
+
+    void SendQueue::setLimits(const std::map<uint8_t, Limit>& newLimits, const Limit& newDefaultLimit) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        limits = newLimits;
+        defaultLimit = newDefaultLimit;
+
+        for(auto& stream : streams) {
+            setLimit(stream.second, uint8_t(stream.first >> 8));
+        }
+    }
+
+    void SendQueue::setFraming(Framing newFraming) {
+        std::lock_guard<std::mutex> lock(mutex);
+        framing = newFraming;
+    }
+
+    void SendQueue::setFrameSize(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameSize = bytes;
+    }
+
+    void SendQueue::setLimit(Stream& stream, uint8_t type) const {
+        auto limit = limits.find(type);
+        stream.limit = limit == limits.end() ? defaultLimit : limit->second;
+        stream.limit.depth = std::max<size_t>(stream.limit.depth, 1);
+        stream.period = stream.limit.rate > 0
+            ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / stream.limit.rate))
+            : clock::duration::zero();
+    }
+
+    void SendQueue::push(uint8_t type, uint8_t filter, std::string&& payload) {
+        push(Packet { type, filter, std::move(payload), nullptr, 0, nullptr });
+    }
+
+    void SendQueue::push(uint8_t type, uint8_t filter, std::string&& payload, const void* data, size_t size, std::shared_ptr<const void> owner) {
+        push(Packet { type, filter, std::move(payload), data, size, std::move(owner) });
+    }
+
+    void SendQueue::push(Packet&& packet) {
+
+        // Anything we drop is released once we have unlocked, as its owner may have more work to do (e.g. recycling)
+        std::vector<Packet> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            uint16_t key = uint16_t(packet.type) << 8 | packet.filter;
+            auto stream = streams.find(key);
+            if(stream == streams.end()) {
+                stream = streams.emplace(key, Stream()).first;
+                setLimit(stream->second, packet.type);
+            }
+
+            auto& packets = stream->second.packets;
+            while(packets.size() >= stream->second.limit.depth) {
+                dropped.push_back(std::move(packets.front()));
+                packets.pop_front();
+                ++stats.dropped;
+            }
+
+            packets.push_back(std::move(packet));
+            ++stats.queued;
+        }
+
+        wake.notify_one();
+    }
+
+    SendQueue::Statistics SendQueue::statistics() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    void SendQueue::run() {
+
+        std::vector<Packet> packets;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while(running) {
+
+            auto now = clock::now();
+            auto next = clock::time_point::max();
+
+            // Take everything that is allowed to go now, and work out when the next rate limited packet can
+            for(auto& s : streams) {
+                auto& stream = s.second;
+
+                while(!stream.packets.empty()) {
+                    if(stream.limit.rate > 0) {
+                        if(now < stream.next) {
+                            next = std::min(next, stream.next);
+                            break;
+                        }
+                        stream.next = now + stream.period;
+                    }
+
+                    packets.push_back(std::move(stream.packets.front()));
+                    stream.packets.pop_front();
+                }
+            }
+
+            if(packets.empty()) {
+                if(next == clock::time_point::max()) {
+                    wake.wait(lock);
+                }
+                else {
+                    wake.wait_until(lock, next);
+                }
+            }
+            else {
+                size_t maxBytes = frameSize;
+                Framing current = framing;
+
+                lock.unlock();
+                if(current == Framing::BATCHED) {
+                    send(packets, maxBytes);
+                }
+                else {
+                    sendSingle(packets);
+                }
+                packets.clear();
+                lock.lock();
+            }
+        }
+    }
+
+    void SendQueue::send(std::vector<Packet>& packets, size_t maxBytes) {
+
+        std::vector<zmq::message_t> frame;
+        std::string buffer;
+        size_t frameBytes = 0;
+
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+
+        // Hands the packets we have buffered to zmq as one part
+        auto flush = [&] {
+            if(!buffer.empty()) {
+                auto part = std::make_shared<std::string>(std::move(buffer));
+                frame.push_back(borrow(part->data(), part->size(), part));
+                buffer.clear();
+            }
+        };
+
+        auto finish = [&] {
+            flush();
+            if(!frame.empty()) {
+                sendFrame(frame);
+                frame.clear();
+
+                ++frames;
+                bytes += frameBytes;
+                frameBytes = 0;
+            }
+        };
+
+        for(auto& packet : packets) {
+
+            uint32_t length = uint32_t(2 + packet.payload.size() + packet.size);
+
+            // Start a new frame rather than grow this one past the frame size
+            if(frameBytes > 0 && frameBytes + 4 + length > maxBytes) {
+                finish();
+            }
+
+            const char header[] = {
+                char(length), char(length >> 8), char(length >> 16), char(length >> 24),
+                char(packet.type), char(packet.filter)
+            };
+            buffer.append(header, sizeof(header));
+            buffer.append(packet.payload);
+            frameBytes += 4 + length;
+
+            // Borrowed data goes in its own part so it is never copied
+            if(packet.size > 0) {
+                flush();
+                frame.push_back(borrow(packet.data, packet.size, std::move(packet.owner)));
+            }
+        }
+        finish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.sent += packets.size();
+        stats.frames += frames;
+        stats.bytes += bytes;
+    }
+
+    void SendQueue::sendSingle(std::vector<Packet>& packets) {
+
+        std::vector<zmq::message_t> frame(1);
+        uint64_t bytes = 0;
+
+        for(auto& packet : packets) {
+
+            // Borrowed data is copied in, existing clients expect the whole packet in one message
+            frame[0] = zmq::message_t(2 + packet.payload.size() + packet.size);
+            char* out = static_cast<char*>(frame[0].data());
+            out[0] = char(packet.type);
+            out[1] = char(packet.filter);
+            std::copy(packet.payload.begin(), packet.payload.end(), out + 2);
+            if(packet.size > 0) {
+                const char* data = static_cast<const char*>(packet.data);
+                std::copy(data, data + packet.size, out + 2 + packet.payload.size());
+            }
+            bytes += frame[0].size();
+
+            sendFrame(frame);
+            packet.owner.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.sent += packets.size();
+        stats.frames += packets.size();
+        stats.bytes += bytes;
+    }
+
+    void SendQueue::kill() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+    }
+
+} // support
+} // modules
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_SUPPORT_NUBUGGER_SENDQUEUE_H
+#define MODULES_SUPPORT_NUBUGGER_SENDQUEUE_H
+
+#include <zmq.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace modules {
+    namespace support {
+
+        /**
+         * Queues packets for the network and sends them from its own thread, so whoever emits a message only waits
+         * for a short lock and never for the network.
+         *
+         * Packets are queued per stream (message type and filter id). Each stream can be rate limited and holds at
+         * most a set number of packets, dropping its oldest when it falls behind.
+         *
+         * By default each packet is sent the way NUsight has always read them, as a single zmq message of
+         * [type][filter id][payload]. With BATCHED framing whatever is ready when the sender wakes is batched into
+         * frames instead: zmq multipart messages whose parts, joined together, are a sequence of
+         * [uint32 little endian length][type][filter id][payload] packets. A packet can borrow the end of its payload
+         * (e.g. an image's pixels), which in a batched frame is sent as its own zero copy part and kept alive until
+         * zmq is done (a single message has to copy it in).
+         */
+        class SendQueue {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            enum class Framing {
+                // One zmq message per packet, which is what existing clients read
+                SINGLE,
+                // Length prefixed packets batched into multipart frames, which clients have to ask for
+                BATCHED
+            };
+
+            struct Limit {
+                // Most packets a second to send for each stream (0 for no limit)
+                double rate = 0;
+                // Most packets to hold for each stream before dropping the oldest
+                size_t depth = 100;
+            };
+
+            struct Statistics {
+                uint64_t queued = 0;
+                uint64_t sent = 0;
+                uint64_t dropped = 0;
+                uint64_t frames = 0;
+                uint64_t bytes = 0;
+            };
+
+            explicit SendQueue(std::function<void (std::vector<zmq::message_t>& frame)> sendFrame);
+
+            /// Replaces the limits for each message type, types without one use defaultLimit
+            void setLimits(const std::map<uint8_t, Limit>& limits, const Limit& defaultLimit);
+
+            /// Whether packets go out one message each (the default) or batched into frames
+            void setFraming(Framing framing);
+
+            /// Batched frames are closed once they would hold more than this many bytes (a single larger packet gets its own)
+            void setFrameSize(size_t bytes);
+
+            /// Queues a serialised message
+            void push(uint8_t type, uint8_t filter, std::string&& payload);
+
+            /// Queues a message that is payload followed by size bytes at data, which owner keeps alive until sent
+            void push(uint8_t type, uint8_t filter, std::string&& payload, const void* data, size_t size, std::shared_ptr<const void> owner);
+
+            Statistics statistics();
+
+            /// Sends packets until killed (run as a service task)
+            void run();
+            void kill();
+
+        private:
+            struct Packet {
+                uint8_t type;
+                uint8_t filter;
+                std::string payload;
+                const void* data;
+                size_t size;
+                std::shared_ptr<const void> owner;
+            };
+
+            struct Stream {
+                Limit limit;
+                clock::duration period;
+                clock::time_point next;
+                std::deque<Packet> packets;
+            };
+
+            void push(Packet&& packet);
+            void setLimit(Stream& stream, uint8_t type) const;
+            void send(std::vector<Packet>& packets, size_t maxBytes);
+            void sendSingle(std::vector<Packet>& packets);
+
+            std::function<void (std::vector<zmq::message_t>& frame)> sendFrame;
+
+            std::mutex mutex;
+            std::condition_variable wake;
+            bool running = true;
+
+            std::map<uint8_t, Limit> limits;
+            Limit defaultLimit;
+            Framing framing = Framing::SINGLE;
+            size_t frameSize = 65536;
+
+            // Keyed by type << 8 | filter id
+            std::map<uint16_t, Stream> streams;
+            Statistics stats;
+        };
+
+    }  // support
+}  // modules
+
+#endif  // MODULES_SUPPORT_NUBUGGER_SENDQUEUE_H
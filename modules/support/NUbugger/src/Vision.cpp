@@ -19,6 +19,10 @@
 
 #include "NUbugger.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include "messages/support/nubugger/proto/Message.pb.h"
 #include "messages/input/Image.h"
 #include "messages/vision/VisualHorizon.h"
@@ -40,117 +44,178 @@ namespace support {
     using messages::vision::ImagePointScan;
     using messages::input::Image;
 
-    void NUbugger::provideVision() {
-        handles["image"].push_back(on<Trigger<Image<0>>, Options<Single, Priority<NUClear::LOW>>>([this](const Image<0>& image) {
-
-            Message message;
-            message.set_type(Message::IMAGE);
-            message.set_filter_id(1);
-            message.set_utc_timestamp(getUtcTimestamp());
-
-            auto* imageData = message.mutable_image();
+    using google::protobuf::io::CodedOutputStream;
+    using google::protobuf::io::StringOutputStream;
+    using google::protobuf::internal::WireFormatLite;
 
-            imageData->mutable_dimensions()->set_x(image.width());
-            imageData->mutable_dimensions()->set_y(image.height());
+    namespace {
 
-            std::string* imageBytes = imageData->mutable_data();
+        /**
+         * Fills in an image message with everything but its data, which is sent separately so it isn't copied
+         */
+        template <int camID>
+        void encodeImage(messages::input::proto::Image& proto, const Image<camID>& image, uint cameraID) {
 
-            imageData->set_camera_id(0);
+            using Format = typename Image<camID>::SourceFormat;
+            using LensType = typename Image<camID>::Lens::Type;
+            using ProtoImage = messages::input::proto::Image;
 
-            // TODO work out the format
-            imageData->set_format(messages::input::proto::Image::YCbCr444);
+            proto.set_camera_id(cameraID);
+            proto.mutable_dimensions()->set_x(image.width());
+            proto.mutable_dimensions()->set_y(image.height());
 
-            // Reserve enough space in the image data to store the output
-            imageBytes->reserve(image.source.size());
+            switch(image.format) {
+                case Format::YCbCr422:  proto.set_format(ProtoImage::YCbCr422); break;
+                case Format::YCbCr444:  proto.set_format(ProtoImage::YCbCr444); break;
+                case Format::RGB:       proto.set_format(ProtoImage::RGB);      break;
+                case Format::JPEG:      proto.set_format(ProtoImage::JPEG);     break;
+                case Format::BGGR:      proto.set_format(ProtoImage::BGGR);     break;
+            }
 
-            imageBytes->insert(imageBytes->begin(), std::begin(image.source), std::end(image.source));
+            auto* lens = proto.mutable_lens();
+            switch(image.lens.type) {
+                case LensType::EQUIRECTANGULAR: {
+                    lens->set_type(ProtoImage::Lens::EQUIRECTANGULAR);
+                    auto* equirectangular = lens->mutable_equirectangular();
+                    equirectangular->mutable_fov()->set_x(image.lens.parameters.equirectangular.fov[0]);
+                    equirectangular->mutable_fov()->set_y(image.lens.parameters.equirectangular.fov[1]);
+                    equirectangular->set_focal_length(image.lens.parameters.equirectangular.focalLength);
+                } break;
+
+                case LensType::RADIAL:
+                case LensType::BARREL: {
+                    lens->set_type(image.lens.type == LensType::RADIAL ? ProtoImage::Lens::RADIAL : ProtoImage::Lens::BARREL);
+                    auto* radial = lens->mutable_radial();
+                    radial->set_fov(image.lens.parameters.radial.fov);
+                    radial->set_pitch(image.lens.parameters.radial.pitch);
+                    radial->mutable_centre()->set_x(image.lens.parameters.radial.centre[0]);
+                    radial->mutable_centre()->set_y(image.lens.parameters.radial.centre[1]);
+                } break;
+            }
+        }
+    }
 
+    /**
+     * Sends an image message with data as its image's data, without copying it. A parser merges repeated occurrences
+     * of a message field, so the message is serialised without the data and followed by another image field holding
+     * only the data, which the send queue reads from where it is while owner keeps it alive.
+     * It goes to the file and the network if they are enabled and toFile and toNetwork allow it.
+     */
+    void NUbugger::sendImage(Message message, const uint8_t* data, size_t bytes, std::shared_ptr<const void> owner, bool toFile, bool toNetwork) {
+
+        std::string payload;
+        message.SerializePartialToString(&payload);
+        {
+            StringOutputStream stream(&payload);
+            CodedOutputStream output(&stream);
+
+            uint32_t dataTag = WireFormatLite::MakeTag(messages::input::proto::Image::kDataFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+            uint32_t size = uint32_t(bytes);
+
+            output.WriteTag(WireFormatLite::MakeTag(Message::kImageFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+            output.WriteVarint32(CodedOutputStream::VarintSize32(dataTag) + CodedOutputStream::VarintSize32(size) + size);
+            output.WriteTag(dataTag);
+            output.WriteVarint32(size);
+        }
+
+        if(fileEnabled && toFile) {
+            std::lock_guard<std::mutex> lock(fileMutex);
+
+            if(outputFile) {
+                fileBuffer = payload;
+                fileBuffer.append(data, data + bytes);
+                outputFile->write(message.utc_timestamp(), utility::nbz::typeHash(Message::Type_Name(message.type())), fileBuffer);
+            }
+        }
 
-            send(message);
-        }));
+        if(networkEnabled && toNetwork) {
+            sendQueue.push(uint8_t(message.type()), uint8_t(message.filter_id()), std::move(payload), data, bytes, std::move(owner));
+        }
+    }
 
-        handles["image"].push_back(on<Trigger<Image<1>>, Options<Single, Priority<NUClear::LOW>>>([this](const Image<1>& image) {
+    void NUbugger::provideVision() {
+        handles["image"].push_back(on<Trigger<Raw<Image<0>>>, Options<Single, Priority<NUClear::LOW>>>([this](const std::shared_ptr<const Image<0>>& image) {
 
             Message message;
             message.set_type(Message::IMAGE);
-            message.set_filter_id(2);
+            message.set_filter_id(1);
             message.set_utc_timestamp(getUtcTimestamp());
 
-            auto* imageData = message.mutable_image();
-
-            imageData->mutable_dimensions()->set_x(image.width());
-            imageData->mutable_dimensions()->set_y(image.height());
-
-            std::string* imageBytes = imageData->mutable_data();
+            encodeImage(*message.mutable_image(), *image, 0);
 
-            imageData->set_camera_id(1);
-
-            // TODO work out the format
-            imageData->set_format(messages::input::proto::Image::YCbCr444);
+            if(imageStreaming && image->format == Image<0>::SourceFormat::BGGR) {
+                // The file keeps the raw frame so it can be replayed, only the network gets the compressed copy
+                sendImage(message, image->data(), image->bytes(), image, true, false);
+                if(networkEnabled) {
+                    imageStreamer.submit(std::move(message), image->data(), image->width(), image->height(), image);
+                }
+            }
+            else {
+                sendImage(message, image->data(), image->bytes(), image);
+            }
+        }));
 
-            // Reserve enough space in the image data to store the output
-            imageBytes->reserve(image.source.size());
+        handles["image"].push_back(on<Trigger<Raw<Image<1>>>, Options<Single, Priority<NUClear::LOW>>>([this](const std::shared_ptr<const Image<1>>& image) {
 
-            imageBytes->insert(imageBytes->begin(), std::begin(image.source), std::end(image.source));
+            Message message;
+            message.set_type(Message::IMAGE);
+            message.set_filter_id(2);
+            message.set_utc_timestamp(getUtcTimestamp());
 
+            encodeImage(*message.mutable_image(), *image, 1);
 
-            send(message);
+            if(imageStreaming && image->format == Image<1>::SourceFormat::BGGR) {
+                // The file keeps the raw frame so it can be replayed, only the network gets the compressed copy
+                sendImage(message, image->data(), image->bytes(), image, true, false);
+                if(networkEnabled) {
+                    imageStreamer.submit(std::move(message), image->data(), image->width(), image->height(), image);
+                }
+            }
+            else {
+                sendImage(message, image->data(), image->bytes(), image);
+            }
         }));
 
-        handles["image"].push_back(on<Trigger<Image<2>>, Options<Single, Priority<NUClear::LOW>>>([this](const Image<2>& image) {
+        handles["image"].push_back(on<Trigger<Raw<Image<2>>>, Options<Single, Priority<NUClear::LOW>>>([this](const std::shared_ptr<const Image<2>>& image) {
 
             Message message;
             message.set_type(Message::IMAGE);
             message.set_filter_id(3);
             message.set_utc_timestamp(getUtcTimestamp());
 
-            auto* imageData = message.mutable_image();
-
-            imageData->mutable_dimensions()->set_x(image.width());
-            imageData->mutable_dimensions()->set_y(image.height());
+            encodeImage(*message.mutable_image(), *image, 2);
 
-            std::string* imageBytes = imageData->mutable_data();
-
-            imageData->set_camera_id(2);
-
-            // TODO work out the format
-            imageData->set_format(messages::input::proto::Image::YCbCr444);
-
-            // Reserve enough space in the image data to store the output
-            imageBytes->reserve(image.source.size());
-
-            imageBytes->insert(imageBytes->begin(), std::begin(image.source), std::end(image.source));
-
-
-            send(message);
+            if(imageStreaming && image->format == Image<2>::SourceFormat::BGGR) {
+                // The file keeps the raw frame so it can be replayed, only the network gets the compressed copy
+                sendImage(message, image->data(), image->bytes(), image, true, false);
+                if(networkEnabled) {
+                    imageStreamer.submit(std::move(message), image->data(), image->width(), image->height(), image);
+                }
+            }
+            else {
+                sendImage(message, image->data(), image->bytes(), image);
+            }
         }));
 
-        handles["image"].push_back(on<Trigger<Image<3>>, Options<Single, Priority<NUClear::LOW>>>([this](const Image<3>& image) {
+        handles["image"].push_back(on<Trigger<Raw<Image<3>>>, Options<Single, Priority<NUClear::LOW>>>([this](const std::shared_ptr<const Image<3>>& image) {
 
             Message message;
             message.set_type(Message::IMAGE);
             message.set_filter_id(4);
             message.set_utc_timestamp(getUtcTimestamp());
 
-            auto* imageData = message.mutable_image();
-
-            imageData->mutable_dimensions()->set_x(image.width());
-            imageData->mutable_dimensions()->set_y(image.height());
-
-            std::string* imageBytes = imageData->mutable_data();
-
-            imageData->set_camera_id(3);
-
-            // TODO work out the format
-            imageData->set_format(messages::input::proto::Image::YCbCr444);
+            encodeImage(*message.mutable_image(), *image, 3);
 
-            // Reserve enough space in the image data to store the output
-            imageBytes->reserve(image.source.size());
-
-            imageBytes->insert(imageBytes->begin(), std::begin(image.source), std::end(image.source));
-
-
-            send(message);
+            if(imageStreaming && image->format == Image<3>::SourceFormat::BGGR) {
+                // The file keeps the raw frame so it can be replayed, only the network gets the compressed copy
+                sendImage(message, image->data(), image->bytes(), image, true, false);
+                if(networkEnabled) {
+                    imageStreamer.submit(std::move(message), image->data(), image->width(), image->height(), image);
+                }
+            }
+            else {
+                sendImage(message, image->data(), image->bytes(), image);
+            }
         }));
 
         // handles["visual_horizon"].push_back(on<Trigger<VisualHorizon<0>>, Options<Single, Priority<NUClear::LOW>>>([this] (const VisualHorizon<0>& horizon) {
@@ -0,0 +1,266 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "utility/vision/SyntheticFrames.h"
+
+#include "ImageStreamer.h"
+
+using modules::support::ImageStreamer;
+using modules::support::JpegEncoder;
+using messages::support::nubugger::proto::Message;
+
+namespace {
+
+    struct Decoded {
+        uint width;
+        uint height;
+        std::vector<uint8_t> rgb;
+    };
+
+    Decoded decode(const std::vector<uint8_t>& jpeg) {
+        jpeg_decompress_struct cinfo;
+        jpeg_error_mgr error;
+        cinfo.err = jpeg_std_error(&error);
+        jpeg_create_decompress(&cinfo);
+
+        jpeg_mem_src(&cinfo, const_cast<uint8_t*>(jpeg.data()), jpeg.size());
+        jpeg_read_header(&cinfo, true);
+        cinfo.out_color_space = JCS_RGB;
+        jpeg_start_decompress(&cinfo);
+
+        Decoded decoded { cinfo.output_width, cinfo.output_height, std::vector<uint8_t>(cinfo.output_width * cinfo.output_height * 3) };
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = decoded.rgb.data() + cinfo.output_scanline * decoded.width * 3;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        return decoded;
+    }
+
+    // Mosaics a single colour in the same layout as the cameras
+    std::vector<uint8_t> mosaic(uint width, uint height, uint8_t r, uint8_t g, uint8_t b) {
+        std::vector<uint8_t> bayer(width * height);
+        for (uint y = 0; y < height; ++y) {
+            for (uint x = 0; x < width; ++x) {
+                bool oX = x % 2;
+                bool oY = y % 2;
+                bayer[y * width + x] = oX == oY ? g : oY ? r : b;
+            }
+        }
+        return bayer;
+    }
+}
+
+TEST_CASE("JPEG encoder compresses into a buffer it reuses", "[nubugger][imagestreamer]") {
+
+    const uint width = 320;
+    const uint height = 240;
+
+    std::vector<uint8_t> rgb(width * height * 3);
+    for (uint y = 0; y < height; ++y) {
+        for (uint x = 0; x < width; ++x) {
+            rgb[(y * width + x) * 3 + 0] = uint8_t(x * 255 / width);
+            rgb[(y * width + x) * 3 + 1] = uint8_t(y * 255 / height);
+            rgb[(y * width + x) * 3 + 2] = 128;
+        }
+    }
+
+    JpegEncoder encoder;
+    std::vector<uint8_t> jpeg;
+    REQUIRE(encoder.encode(rgb.data(), width, height, 90, jpeg));
+    REQUIRE(jpeg.size() > 0);
+    REQUIRE(jpeg.size() < rgb.size() / 4);
+
+    auto decoded = decode(jpeg);
+    REQUIRE(decoded.width == width);
+    REQUIRE(decoded.height == height);
+
+    double error = 0;
+    for (size_t i = 0; i < rgb.size(); ++i) {
+        error += std::abs(int(rgb[i]) - int(decoded.rgb[i]));
+    }
+    REQUIRE(error / rgb.size() < 3);
+
+    // Encoding again into the same buffer doesn't reallocate it
+    const uint8_t* data = jpeg.data();
+    REQUIRE(encoder.encode(rgb.data(), width, height, 90, jpeg));
+    REQUIRE(jpeg.data() == data);
+
+    // Lower qualities are smaller
+    std::vector<uint8_t> low;
+    REQUIRE(encoder.encode(rgb.data(), width, height, 30, low));
+    REQUIRE(low.size() < jpeg.size());
+}
+
+TEST_CASE("Downscaling averages Bayer quads into RGB", "[nubugger][imagestreamer]") {
+
+    auto bayer = mosaic(64, 48, 200, 100, 50);
+    std::vector<uint8_t> rgb;
+
+    for (uint scale : { 2u, 4u, 8u }) {
+        ImageStreamer::downscale(bayer.data(), 64, 48, scale, rgb);
+        REQUIRE(rgb.size() == (64 / scale) * (48 / scale) * 3);
+
+        for (size_t i = 0; i < rgb.size(); i += 3) {
+            REQUIRE(int(rgb[i + 0]) == 200);
+            REQUIRE(int(rgb[i + 1]) == 100);
+            REQUIRE(int(rgb[i + 2]) == 50);
+        }
+    }
+
+    // At full size it is the same as the demosaic everything else uses
+    ImageStreamer::downscale(bayer.data(), 64, 48, 1, rgb);
+    REQUIRE(rgb.size() == 64 * 48 * 3);
+    const uint8_t* middle = &rgb[(24 * 64 + 32) * 3];
+    REQUIRE(int(middle[0]) == 200);
+    REQUIRE(int(middle[1]) == 100);
+    REQUIRE(int(middle[2]) == 50);
+}
+
+TEST_CASE("Image streamer only accepts scales that keep the Bayer quads whole", "[nubugger][imagestreamer]") {
+
+    ImageStreamer streamer([](Message&, const std::vector<uint8_t>&, std::shared_ptr<const void>) {});
+
+    ImageStreamer::Settings settings;
+    for (uint scale : { 1u, 2u, 4u, 8u }) {
+        settings.scale = scale;
+        REQUIRE_NOTHROW(streamer.configure(settings));
+    }
+
+    for (uint scale : { 0u, 3u, 6u, 16u }) {
+        settings.scale = scale;
+        REQUIRE_THROWS_AS(streamer.configure(settings), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Image streamer skips frames and lowers quality to hold its bitrate", "[nubugger][imagestreamer]") {
+
+    const uint width = 640;
+    const uint height = 480;
+
+    // Noise compresses badly, so the streamer has to work to hold the bitrate
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> noise(0, 255);
+    auto frame = std::make_shared<std::vector<uint8_t>>(width * height);
+    for (auto& pixel : *frame) {
+        pixel = uint8_t(noise(random));
+    }
+    std::weak_ptr<std::vector<uint8_t>> released = frame;
+
+    std::mutex mutex;
+    size_t bytes = 0;
+    std::vector<Message> messages;
+    std::vector<uint8_t> last;
+    ImageStreamer streamer([&](Message& message, const std::vector<uint8_t>& data, std::shared_ptr<const void>) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bytes += data.size();
+        messages.push_back(message);
+        last = data;
+    });
+
+    ImageStreamer::Settings settings;
+    settings.scale = 2;
+    settings.bitrate = 2e6;
+    settings.fps = 100;
+    settings.quality = 90;
+    settings.minQuality = 5;
+    streamer.configure(settings);
+
+    std::thread worker([&] { streamer.run(); });
+
+    // Offer frames much faster than the bitrate lets us send them
+    auto start = ImageStreamer::clock::now();
+    auto end = start + std::chrono::seconds(2);
+    while (ImageStreamer::clock::now() < end) {
+        Message message;
+        message.set_type(Message::IMAGE);
+        message.set_filter_id(1);
+        auto* image = message.mutable_image();
+        image->set_camera_id(0);
+        image->set_format(messages::input::proto::Image::BGGR);
+        image->mutable_dimensions()->set_x(width);
+        image->mutable_dimensions()->set_y(height);
+
+        streamer.submit(std::move(message), frame->data(), width, height, frame);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    frame.reset();
+
+    streamer.kill();
+    worker.join();
+    double seconds = std::chrono::duration<double>(ImageStreamer::clock::now() - start).count();
+
+    auto stats = streamer.statistics();
+    REQUIRE(stats.encoded == messages.size());
+    REQUIRE(stats.skipped > 0);
+    REQUIRE(stats.quality < 90);
+
+    // Within the budget it could have saved up at the start
+    double bitrate = bytes * 8 / seconds;
+    REQUIRE(bitrate < settings.bitrate * 1.3);
+    REQUIRE(bitrate > settings.bitrate * 0.5);
+
+    REQUIRE(messages.back().image().format() == messages::input::proto::Image::JPEG);
+    REQUIRE(messages.back().image().dimensions().x() == width / 2);
+    REQUIRE(messages.back().image().dimensions().y() == height / 2);
+    REQUIRE(decode(last).width == width / 2);
+
+    // Frames aren't held once they have been compressed or skipped
+    REQUIRE(released.expired());
+}
+
+TEST_CASE("Benchmark encoding camera images at each scale and quality", "[nubugger][imagestreamer][benchmark][.]") {
+
+    constexpr int FRAMES = 20;
+
+    auto image = utility::vision::synthetic::makeScene(1280, 960, 0);
+
+    JpegEncoder encoder;
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> jpeg;
+
+    for (uint scale : { 1u, 2u, 4u }) {
+        for (int quality : { 50, 75, 90 }) {
+
+            auto start = ImageStreamer::clock::now();
+            for (int i = 0; i < FRAMES; ++i) {
+                ImageStreamer::downscale(image.source.data(), image.width(), image.height(), scale, rgb);
+            }
+            auto downscaled = ImageStreamer::clock::now();
+            for (int i = 0; i < FRAMES; ++i) {
+                encoder.encode(rgb.data(), image.width() / scale, image.height() / scale, quality, jpeg);
+            }
+            auto encoded = ImageStreamer::clock::now();
+
+            std::cout << image.width() / scale << "x" << image.height() / scale << " quality " << quality << ": "
+                      << std::chrono::duration<double, std::milli>(downscaled - start).count() / FRAMES << "ms demosaic, "
+                      << std::chrono::duration<double, std::milli>(encoded - downscaled).count() / FRAMES << "ms encode, "
+                      << jpeg.size() / 1024.0 << "KB (raw frame " << image.source.size() / 1024 << "KB)" << std::endl;
+        }
+    }
+}
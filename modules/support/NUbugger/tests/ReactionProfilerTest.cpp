@@ -0,0 +1,168 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <random>
+#include <yaml-cpp/yaml.h>
+
+#include "ReactionProfiler.h"
+
+using utility::time::LatencyHistogram;
+using modules::support::ReactionProfiler;
+using messages::support::nuclear::proto::ReactionProfile;
+
+namespace {
+    NUClear::clock::time_point at(uint64_t micros) {
+        return NUClear::clock::time_point(std::chrono::duration_cast<NUClear::clock::duration>(std::chrono::microseconds(micros)));
+    }
+}
+
+TEST_CASE("Latency histogram buckets are within a sixteenth of their values", "[nubugger][profiler]") {
+
+    for(uint64_t value : { 0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 65535ull, 123456789ull, 0xFFFFFFFFull }) {
+        uint bucket = LatencyHistogram::bucket(value);
+
+        REQUIRE(bucket < LatencyHistogram::BUCKETS);
+        REQUIRE(LatencyHistogram::lowest(bucket) <= value);
+        REQUIRE(value < LatencyHistogram::lowest(bucket) + LatencyHistogram::width(bucket));
+        REQUIRE(LatencyHistogram::width(bucket) * 16 <= std::max<uint64_t>(16, value));
+    }
+
+    // Buckets follow on from each other
+    for(uint i = 1; i < LatencyHistogram::BUCKETS; ++i) {
+        REQUIRE(LatencyHistogram::lowest(i) == LatencyHistogram::lowest(i - 1) + LatencyHistogram::width(i - 1));
+    }
+
+    LatencyHistogram histogram;
+    REQUIRE(histogram.percentile(0.5) == 0);
+
+    for(uint64_t v = 1; v <= 10000; ++v) {
+        histogram.record(v);
+    }
+
+    REQUIRE(histogram.count() == 10000);
+    REQUIRE(histogram.max() == 10000);
+    REQUIRE(std::abs(double(histogram.percentile(0.5)) - 5000) <= 5000 / 16.0);
+    REQUIRE(std::abs(double(histogram.percentile(0.99)) - 9900) <= 9900 / 16.0);
+    REQUIRE(histogram.percentile(1.0) <= 10000);
+
+    histogram.clear();
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.max() == 0);
+}
+
+TEST_CASE("Reaction profiler snapshots each reaction over the period", "[nubugger][profiler]") {
+
+    ReactionProfiler profiler;
+    ReactionProfile profile;
+
+    // Prime the period so it starts at zero
+    profiler.snapshot(profile, at(0));
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint64_t> jitter(0, 100);
+
+    for(uint i = 0; i < 200; ++i) {
+        uint64_t emitted = i * 10000;
+
+        // A vision reaction that takes around 5ms and waits 1ms to start
+        profiler.record(7, "Classify Image", "Trigger<Image>", i, 0, at(emitted), at(emitted + 1000), at(emitted + 6000 + jitter(rng)), false);
+
+        // A quick reaction that runs every other time and throws once
+        if(i % 2 == 0) {
+            profiler.record(9, "", "Trigger<Every<10ms>>", 1000 + i, i, at(emitted), at(emitted + 10), at(emitted + 60), i == 100);
+        }
+    }
+
+    REQUIRE(profiler.snapshot(profile, at(2000000)));
+    REQUIRE(profile.period() == 2000000);
+    REQUIRE(profile.reactions_size() == 2);
+
+    const auto& classify = profile.reactions(0);
+    REQUIRE(classify.name() == "Classify Image");
+    REQUIRE(classify.reactionid() == 7);
+    REQUIRE(classify.count() == 200);
+    REQUIRE(classify.rate() == Approx(100));
+    REQUIRE(classify.exceptions() == 0);
+    REQUIRE(classify.latencyp50() >= 5000 - 5000 / 16);
+    REQUIRE(classify.latencyp50() <= 5100 + 5100 / 16);
+    REQUIRE(classify.latencymax() <= 5100);
+    REQUIRE(classify.latencyp99() <= classify.latencymax());
+    REQUIRE(classify.queuep50() >= 1000 - 1000 / 16);
+    REQUIRE(classify.queuep50() <= 1000 + 1000 / 16);
+    REQUIRE(classify.queuemax() == 1000);
+
+    const auto& every = profile.reactions(1);
+    REQUIRE(every.triggername() == "Trigger<Every<10ms>>");
+    REQUIRE(every.count() == 100);
+    REQUIRE(every.rate() == Approx(50));
+    REQUIRE(every.exceptions() == 1);
+    REQUIRE(every.latencymax() == 50);
+    REQUIRE(every.queuemax() == 10);
+
+    // Nothing ran in the next period
+    REQUIRE_FALSE(profiler.snapshot(profile, at(3000000)));
+    REQUIRE(profile.reactions_size() == 0);
+    REQUIRE(profile.period() == 1000000);
+}
+
+TEST_CASE("Reaction profiler writes a Chrome trace", "[nubugger][profiler]") {
+
+    std::string path = "/tmp/ReactionProfilerTest.json";
+
+    SECTION("Every reaction is an event") {
+        ReactionProfiler profiler;
+        REQUIRE(profiler.openTrace(path, 100));
+
+        profiler.record(3, "Say \"hello\"", "Trigger<Startup>", 1, 0, at(1000), at(1500), at(4000), false);
+        profiler.record(4, "", "Trigger<Sensors>", 2, 1, at(2000), at(2000), at(2250), false);
+        profiler.closeTrace();
+
+        // JSON is YAML too
+        YAML::Node trace = YAML::LoadFile(path);
+        REQUIRE(trace.IsSequence());
+        REQUIRE(trace.size() == 2);
+
+        REQUIRE(trace[0]["name"].as<std::string>() == "Say \"hello\"");
+        REQUIRE(trace[0]["ph"].as<std::string>() == "X");
+        REQUIRE(trace[0]["ts"].as<uint64_t>() == 1500);
+        REQUIRE(trace[0]["dur"].as<uint64_t>() == 2500);
+        REQUIRE(trace[0]["tid"].as<uint64_t>() == 3);
+        REQUIRE(trace[0]["args"]["queue"].as<uint64_t>() == 500);
+
+        REQUIRE(trace[1]["name"].as<std::string>() == "Trigger<Sensors>");
+        REQUIRE(trace[1]["args"]["cause"].as<uint64_t>() == 1);
+    }
+
+    SECTION("The trace stops at its limit and is still valid") {
+        ReactionProfiler profiler;
+        REQUIRE(profiler.openTrace(path, 10));
+
+        for(uint i = 0; i < 50; ++i) {
+            profiler.record(1, "Loop", "Trigger<Every>", i, 0, at(i * 100), at(i * 100), at(i * 100 + 10), false);
+        }
+
+        YAML::Node trace = YAML::LoadFile(path);
+        REQUIRE(trace.size() == 10);
+    }
+
+    std::remove(path.c_str());
+}
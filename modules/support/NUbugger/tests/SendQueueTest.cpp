@@ -0,0 +1,519 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#include "ReactionProfiler.h"
+#include "SendQueue.h"
+
+using utility::time::LatencyHistogram;
+using modules::support::SendQueue;
+
+namespace {
+
+    struct Packet {
+        uint8_t type;
+        uint8_t filter;
+        std::string payload;
+    };
+
+    /**
+     * Joins a frame's parts and splits them back into packets
+     */
+    std::vector<Packet> decode(const std::vector<std::string>& parts) {
+        std::string frame;
+        for (auto& part : parts) {
+            frame += part;
+        }
+
+        std::vector<Packet> packets;
+        for (size_t i = 0; i + 6 <= frame.size();) {
+            const uint8_t* header = reinterpret_cast<const uint8_t*>(frame.data() + i);
+            uint32_t length = header[0] | header[1] << 8 | header[2] << 16 | uint32_t(header[3]) << 24;
+
+            packets.push_back(Packet { header[4], header[5], frame.substr(i + 6, length - 2) });
+            i += 4 + length;
+        }
+        return packets;
+    }
+
+    /**
+     * Runs a send queue on its own thread and keeps what it sends
+     */
+    class Capture {
+    public:
+        explicit Capture(SendQueue::Framing framing = SendQueue::Framing::BATCHED)
+            : queue([this](std::vector<zmq::message_t>& frame) {
+                std::vector<std::string> parts;
+                for (auto& part : frame) {
+                    parts.emplace_back(static_cast<const char*>(part.data()), part.size());
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                frames.push_back(std::move(parts));
+                times.push_back(SendQueue::clock::now());
+            }) {
+            queue.setFraming(framing);
+        }
+
+        ~Capture() {
+            stop();
+        }
+
+        void start() {
+            thread = std::thread([this] { queue.run(); });
+        }
+
+        void stop() {
+            if (thread.joinable()) {
+                queue.kill();
+                thread.join();
+            }
+        }
+
+        // Waits for the queue to send this many packets in total
+        bool waitFor(uint64_t sent) {
+            auto end = SendQueue::clock::now() + std::chrono::seconds(5);
+            while (queue.statistics().sent < sent) {
+                if (SendQueue::clock::now() > end) {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+        std::vector<Packet> packets() {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Packet> all;
+            for (auto& frame : frames) {
+                auto decoded = decode(frame);
+                all.insert(all.end(), decoded.begin(), decoded.end());
+            }
+            return all;
+        }
+
+        SendQueue queue;
+        std::mutex mutex;
+        std::vector<std::vector<std::string>> frames;
+        std::vector<SendQueue::clock::time_point> times;
+
+    private:
+        std::thread thread;
+    };
+}
+
+TEST_CASE("Send queue sends one message per packet unless batching is asked for", "[nubugger][sendqueue]") {
+
+    Capture capture(SendQueue::Framing::SINGLE);
+
+    auto image = std::make_shared<std::vector<uint8_t>>(1000, 42);
+    std::weak_ptr<std::vector<uint8_t>> released = image;
+
+    capture.queue.push(7, 1, "first");
+    capture.queue.push(3, 2, "header", image->data(), image->size(), image);
+    capture.queue.push(7, 1, "second");
+    image.reset();
+
+    capture.start();
+    REQUIRE(capture.waitFor(3));
+
+    // Every message is [type][filter id][payload] on its own, with borrowed data copied onto the end
+    REQUIRE(capture.frames.size() == 3);
+    std::map<std::string, std::string> messages;
+    for (auto& frame : capture.frames) {
+        REQUIRE(frame.size() == 1);
+        messages[frame[0].substr(0, 2)] += frame[0].substr(2) + ";";
+    }
+
+    REQUIRE(messages[std::string("\x07\x01", 2)] == "first;second;");
+    REQUIRE(messages[std::string("\x03\x02", 2)] == "header" + std::string(1000, char(42)) + ";");
+    REQUIRE(capture.queue.statistics().frames == 3);
+
+    // The data is let go once it has been copied
+    REQUIRE(released.expired());
+}
+
+TEST_CASE("Send queue batches small messages into frames", "[nubugger][sendqueue]") {
+
+    Capture capture;
+
+    // Everything waiting when the sender wakes goes in one frame
+    for (int i = 0; i < 100; ++i) {
+        capture.queue.push(7, 1, "message " + std::to_string(i));
+    }
+    capture.start();
+    REQUIRE(capture.waitFor(100));
+
+    REQUIRE(capture.frames.size() == 1);
+    REQUIRE(capture.frames[0].size() == 1);
+
+    auto packets = capture.packets();
+    REQUIRE(packets.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(int(packets[i].type) == 7);
+        REQUIRE(int(packets[i].filter) == 1);
+        REQUIRE(packets[i].payload == "message " + std::to_string(i));
+    }
+
+    auto stats = capture.queue.statistics();
+    REQUIRE(stats.queued == 100);
+    REQUIRE(stats.sent == 100);
+    REQUIRE(stats.dropped == 0);
+    REQUIRE(stats.frames == 1);
+}
+
+TEST_CASE("Send queue keeps frames within the frame size", "[nubugger][sendqueue]") {
+
+    Capture capture;
+    capture.queue.setFrameSize(1000);
+
+    // Each of these is 100 bytes with its header
+    for (int i = 0; i < 100; ++i) {
+        capture.queue.push(7, 2, std::string(94, char(i)));
+    }
+    capture.start();
+    REQUIRE(capture.waitFor(100));
+
+    REQUIRE(capture.frames.size() == 10);
+    for (auto& frame : capture.frames) {
+        REQUIRE(frame.size() == 1);
+        REQUIRE(frame[0].size() == 1000);
+    }
+    REQUIRE(capture.packets().size() == 100);
+
+    // A packet bigger than a frame gets one to itself
+    capture.queue.push(7, 2, std::string(5000, 'x'));
+    REQUIRE(capture.waitFor(101));
+    REQUIRE(capture.frames.back()[0].size() == 5006);
+}
+
+TEST_CASE("Send queue drops the oldest messages of a type that falls behind", "[nubugger][sendqueue]") {
+
+    Capture capture;
+
+    SendQueue::Limit images;
+    images.depth = 4;
+    capture.queue.setLimits({ { 3, images } }, SendQueue::Limit());
+
+    // Each filter id gets its own queue
+    for (int i = 0; i < 10; ++i) {
+        capture.queue.push(3, 1, std::to_string(i));
+        capture.queue.push(3, 2, std::to_string(i));
+        capture.queue.push(9, 1, std::to_string(i));
+    }
+    capture.start();
+    REQUIRE(capture.waitFor(18));
+
+    std::map<std::pair<int, int>, std::vector<std::string>> streams;
+    for (auto& packet : capture.packets()) {
+        streams[std::make_pair(int(packet.type), int(packet.filter))].push_back(packet.payload);
+    }
+
+    std::vector<std::string> newest = { "6", "7", "8", "9" };
+    REQUIRE(streams[std::make_pair(3, 1)] == newest);
+    REQUIRE(streams[std::make_pair(3, 2)] == newest);
+    REQUIRE(streams[std::make_pair(9, 1)].size() == 10);
+    REQUIRE(capture.queue.statistics().dropped == 12);
+}
+
+TEST_CASE("Send queue rate limits each stream", "[nubugger][sendqueue]") {
+
+    Capture capture;
+
+    SendQueue::Limit limited;
+    limited.rate = 20;
+    capture.queue.setLimits({ { 3, limited } }, SendQueue::Limit());
+
+    for (int i = 0; i < 5; ++i) {
+        capture.queue.push(3, 1, std::to_string(i));
+    }
+    capture.queue.push(9, 1, "unlimited");
+
+    auto start = SendQueue::clock::now();
+    capture.start();
+    REQUIRE(capture.waitFor(6));
+
+    // The limited packets are spread out, everything else goes straight away
+    std::vector<SendQueue::clock::time_point> sent;
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        for (size_t i = 0; i < capture.frames.size(); ++i) {
+            for (auto& packet : decode(capture.frames[i])) {
+                if (packet.type == 3) {
+                    sent.push_back(capture.times[i]);
+                }
+                else {
+                    REQUIRE(capture.times[i] - start < std::chrono::milliseconds(25));
+                }
+            }
+        }
+    }
+
+    REQUIRE(sent.size() == 5);
+    for (size_t i = 1; i < sent.size(); ++i) {
+        REQUIRE(sent[i] - sent[i - 1] >= std::chrono::milliseconds(49));
+    }
+}
+
+TEST_CASE("Send queue borrows data instead of copying it", "[nubugger][sendqueue]") {
+
+    auto image = std::make_shared<std::vector<uint8_t>>(1280 * 1024);
+    for (size_t i = 0; i < image->size(); ++i) {
+        (*image)[i] = uint8_t(i * 7);
+    }
+    std::weak_ptr<std::vector<uint8_t>> released = image;
+    const void* pixels = image->data();
+
+    std::atomic<bool> borrowed(false);
+    std::vector<Packet> packets;
+    SendQueue queue([&](std::vector<zmq::message_t>& frame) {
+        std::vector<std::string> parts;
+        for (auto& part : frame) {
+            // The pixels are a part of their own and are still where we left them
+            borrowed = borrowed || (part.data() == pixels && part.size() == 1280 * 1024);
+            parts.emplace_back(static_cast<const char*>(part.data()), part.size());
+        }
+        auto decoded = decode(parts);
+        packets.insert(packets.end(), decoded.begin(), decoded.end());
+    });
+
+    queue.setFraming(SendQueue::Framing::BATCHED);
+    queue.push(1, 1, "before");
+    queue.push(3, 1, "header", image->data(), image->size(), image);
+    queue.push(5, 1, "after");
+    image.reset();
+
+    // The queue keeps the pixels alive until it has sent them
+    REQUIRE_FALSE(released.expired());
+
+    std::thread sender([&] { queue.run(); });
+    auto end = SendQueue::clock::now() + std::chrono::seconds(5);
+    while (queue.statistics().sent < 3 && SendQueue::clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    queue.kill();
+    sender.join();
+
+    REQUIRE(borrowed);
+    REQUIRE(released.expired());
+
+    // Around it the packets read as though it had been copied in
+    REQUIRE(packets.size() == 3);
+    for (auto& packet : packets) {
+        if (packet.type == 3) {
+            REQUIRE(packet.payload.size() == 6 + 1280 * 1024);
+            REQUIRE(packet.payload.substr(0, 6) == "header");
+            REQUIRE(uint8_t(packet.payload[6 + 1000]) == uint8_t(1000 * 7));
+        }
+        else {
+            REQUIRE((packet.payload == "before" || packet.payload == "after"));
+        }
+    }
+}
+
+TEST_CASE("Benchmark emitting through the send queue to a subscriber", "[nubugger][sendqueue][benchmark][.]") {
+
+    constexpr int PRODUCERS = 4;
+    constexpr int MESSAGES = 50000;
+    constexpr int IMAGES = 60;
+
+    zmq::context_t context(1);
+    std::atomic<uint64_t> received(0);
+
+    // Counts packets as the subscriber gets them, a frame at a time when batched or a message at a time when not
+    auto subscribe = [&](const char* address, bool batched) {
+        return std::thread([&received, &context, address, batched] {
+            zmq::socket_t sub(context, ZMQ_SUB);
+            int hwm = 0;
+            sub.setsockopt(ZMQ_RCVHWM, &hwm, sizeof(hwm));
+            sub.setsockopt(ZMQ_SUBSCRIBE, 0, 0);
+            sub.connect(address);
+
+            std::vector<std::string> parts;
+            while (true) {
+                zmq::message_t part;
+                sub.recv(&part);
+                parts.emplace_back(static_cast<const char*>(part.data()), part.size());
+
+                int more = 0;
+                size_t moreSize = sizeof(more);
+                sub.getsockopt(ZMQ_RCVMORE, &more, &moreSize);
+                if (more) {
+                    continue;
+                }
+
+                bool done = false;
+                if (batched) {
+                    for (auto& packet : decode(parts)) {
+                        done |= packet.type == 0;
+                        ++received;
+                    }
+                }
+                else {
+                    done = parts[0][0] == 0;
+                    ++received;
+                }
+                parts.clear();
+
+                if (done) {
+                    return;
+                }
+            }
+        });
+    };
+
+    // Several threads emit small messages while one emits images, timing how long each emit takes
+    auto produce = [](std::function<void (uint8_t, std::string&&, const std::shared_ptr<std::vector<uint8_t>>&)> emit) {
+        std::mutex mutex;
+        LatencyHistogram small;
+        LatencyHistogram images;
+
+        auto image = std::make_shared<std::vector<uint8_t>>(1280 * 1024, 128);
+
+        auto start = SendQueue::clock::now();
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&] {
+                LatencyHistogram latency;
+                for (int i = 0; i < MESSAGES; ++i) {
+                    auto begin = SendQueue::clock::now();
+                    emit(7, std::string(100, char(i)), nullptr);
+                    latency.record(std::chrono::duration_cast<std::chrono::microseconds>(SendQueue::clock::now() - begin).count());
+                }
+                // Report the slowest producer
+                std::lock_guard<std::mutex> lock(mutex);
+                if (latency.percentile(0.99) > small.percentile(0.99)) {
+                    small = latency;
+                }
+            });
+        }
+        producers.emplace_back([&] {
+            for (int i = 0; i < IMAGES; ++i) {
+                auto begin = SendQueue::clock::now();
+                emit(3, std::string(32, 'h'), image);
+                images.record(std::chrono::duration_cast<std::chrono::microseconds>(SendQueue::clock::now() - begin).count());
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        double seconds = std::chrono::duration<double>(SendQueue::clock::now() - start).count();
+
+        std::cout << "  small emit median " << small.percentile(0.5) << "us, 99% " << small.percentile(0.99)
+                  << "us, max " << small.max() << "us" << std::endl;
+        std::cout << "  image emit median " << images.percentile(0.5) << "us, 99% " << images.percentile(0.99)
+                  << "us, max " << images.max() << "us" << std::endl;
+        std::cout << "  " << (PRODUCERS * MESSAGES + IMAGES) / seconds << " emits a second" << std::endl;
+    };
+
+    uint64_t total = PRODUCERS * MESSAGES + IMAGES + 1;
+
+    // What NUbugger used to do, serialise and send from the emitting thread under a lock
+    {
+        zmq::socket_t pub(context, ZMQ_PUB);
+        int hwm = 0;
+        pub.setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+        pub.bind("tcp://127.0.0.1:12100");
+        auto sub = subscribe("tcp://127.0.0.1:12100", false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        std::mutex networkMutex;
+        auto emit = [&](uint8_t type, std::string&& payload, const std::shared_ptr<std::vector<uint8_t>>& image) {
+            size_t size = payload.size() + (image ? image->size() : 0);
+            zmq::message_t packet(size + 2);
+            char* data = static_cast<char*>(packet.data());
+            data[0] = char(type);
+            data[1] = 1;
+            std::copy(payload.begin(), payload.end(), data + 2);
+            if (image) {
+                std::copy(image->begin(), image->end(), data + 2 + payload.size());
+            }
+            std::lock_guard<std::mutex> lock(networkMutex);
+            pub.send(packet);
+        };
+
+        received = 0;
+        auto start = SendQueue::clock::now();
+        std::cout << "Sending from the emitting thread:" << std::endl;
+        produce(emit);
+        emit(0, "", nullptr);
+        sub.join();
+        std::cout << "  " << received / std::chrono::duration<double>(SendQueue::clock::now() - start).count()
+                  << " messages a second received" << std::endl;
+        REQUIRE(received == total);
+    }
+
+    // Through the send queue
+    {
+        zmq::socket_t pub(context, ZMQ_PUB);
+        int hwm = 0;
+        pub.setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+        pub.bind("tcp://127.0.0.1:12101");
+        auto sub = subscribe("tcp://127.0.0.1:12101", true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        SendQueue queue([&](std::vector<zmq::message_t>& frame) {
+            for (size_t i = 0; i < frame.size(); ++i) {
+                pub.send(frame[i], i + 1 < frame.size() ? ZMQ_SNDMORE : 0);
+            }
+        });
+        SendQueue::Limit limit;
+        limit.depth = MESSAGES * PRODUCERS;
+        queue.setLimits({}, limit);
+        queue.setFraming(SendQueue::Framing::BATCHED);
+        std::thread sender([&] { queue.run(); });
+
+        auto emit = [&](uint8_t type, std::string&& payload, const std::shared_ptr<std::vector<uint8_t>>& image) {
+            if (image) {
+                queue.push(type, 1, std::move(payload), image->data(), image->size(), image);
+            }
+            else {
+                queue.push(type, 1, std::move(payload));
+            }
+        };
+
+        received = 0;
+        auto start = SendQueue::clock::now();
+        std::cout << "Sending through the send queue:" << std::endl;
+        produce(emit);
+
+        // Streams aren't ordered between each other, so only say we are done once everything else is out
+        while (queue.statistics().sent < total - 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        emit(0, "", nullptr);
+        sub.join();
+        std::cout << "  " << received / std::chrono::duration<double>(SendQueue::clock::now() - start).count()
+                  << " messages a second received" << std::endl;
+
+        auto stats = queue.statistics();
+        std::cout << "  " << stats.sent << " messages in " << stats.frames << " frames" << std::endl;
+
+        queue.kill();
+        sender.join();
+        REQUIRE(received == total);
+    }
+}
@@ -0,0 +1,389 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "VisionBenchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "messages/support/Configuration.h"
+#include "messages/support/nubugger/proto/Message.pb.h"
+#include "messages/vision/ClassifierTiming.h"
+#include "messages/vision/LookUpTable.h"
+#include "messages/vision/VisionObjects.h"
+#include "utility/nbz/NBZReader.h"
+#include "utility/vision/SyntheticFrames.h"
+
+namespace {
+    std::atomic<size_t> allocations(0);
+}
+
+// Count every heap allocation made by the process (this module is only installed in the benchmark role)
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+namespace modules {
+namespace support {
+
+    using messages::support::Configuration;
+    using messages::input::Image;
+    using messages::vision::ClassifierTiming;
+    using messages::vision::LookUpTable;
+    using messages::vision::Ball;
+    using messages::support::nubugger::proto::Message;
+    using ProtoImage = messages::input::proto::Image;
+
+    // How long a frame waits for the pipeline before we give up on it
+    constexpr std::chrono::seconds FRAME_TIMEOUT = std::chrono::seconds(10);
+
+    // The name of the classifier's reaction and of the stages it times
+    const std::string CLASSIFIER = "Classify Image";
+    const std::string FRAME = "Frame";
+    const std::vector<std::string> CLASSIFIER_STAGES = { "Classify once", "Horizon", "Visual horizon", "Ball", "Focus", "Ball enhance", "Classifier total" };
+
+    template <typename Duration>
+    double micros(const Duration& d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    VisionBenchmark::VisionBenchmark(std::unique_ptr<NUClear::Environment> environment)
+        : Reactor(std::move(environment))
+        , pool(8) {
+
+        on<Trigger<Configuration<VisionBenchmark>>>([this](const Configuration<VisionBenchmark>& config) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            sizes.clear();
+            for(const auto& size : config["sizes"]) {
+                sizes.push_back({ size[0].as<uint>(), size[1].as<uint>() });
+            }
+            frames = config["frames"].as<uint>();
+            warmup = config["warmup"].as<uint>();
+            distinct = std::max(1u, config["distinct"].as<uint>());
+            recording = config["recording"].as<std::string>();
+            detectors = config["detectors"].as<std::vector<std::string>>();
+
+            configured = true;
+            changed.notify_all();
+        });
+
+        on<Trigger<ClassifierTiming>>([this](const ClassifierTiming& timing) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(measuring) {
+                samples["Classify once"].push_back(micros(timing.classifyOnce));
+                samples["Horizon"].push_back(micros(timing.horizon));
+                samples["Visual horizon"].push_back(micros(timing.visualHorizon));
+                samples["Ball"].push_back(micros(timing.ball));
+                samples["Focus"].push_back(micros(timing.focus));
+                samples["Ball enhance"].push_back(micros(timing.ballEnhance));
+                samples["Classifier total"].push_back(micros(timing.total));
+            }
+
+            if(pending > 0 && --pending == 0) {
+                changed.notify_all();
+            }
+        });
+
+        // Count the frames a ball was found in, to weigh against how long they took
+        on<Trigger<std::vector<Ball<0>>>>([this](const std::vector<Ball<0>>& balls) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(measuring && !balls.empty()) {
+                ++detected;
+            }
+        });
+
+        on<Trigger<NUClear::ReactionStatistics>>([this](const NUClear::ReactionStatistics& stats) {
+
+            if(stats.identifier.empty()) {
+                return;
+            }
+            const std::string& name = stats.identifier[0];
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            bool detector = std::find(detectors.begin(), detectors.end(), name) != detectors.end();
+            if(!detector && name != CLASSIFIER) {
+                return;
+            }
+
+            if(measuring) {
+                samples[name].push_back(micros(stats.finished - stats.started));
+            }
+
+            if(detector && pending > 0) {
+                finished = std::max(finished, stats.finished);
+                if(--pending == 0) {
+                    changed.notify_all();
+                }
+            }
+        });
+
+        powerplant.addServiceTask(NUClear::threading::ThreadWorker::ServiceTask([this] {
+            run();
+        },
+        [this] {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            changed.notify_all();
+        }));
+    }
+
+    void VisionBenchmark::run() {
+
+        // Wait until we know what to run
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return configured || !running; });
+        }
+
+        if(!recording.empty()) {
+            auto templates = loadRecording();
+
+            if(!templates.empty()) {
+                runFrames(recording, templates);
+            }
+        }
+        else {
+            // Synthetic frames need the colours they were drawn with
+            emit<Scope::DIRECT>(std::make_unique<LookUpTable>(utility::vision::synthetic::makeLUT()));
+
+            for(const auto& size : sizes) {
+
+                std::vector<Image<0>> templates;
+                for(uint i = 0; i < distinct; ++i) {
+                    templates.push_back(utility::vision::synthetic::makeScene(size[0], size[1], i));
+
+                    // The lens NBZPlayer falls back to, centred on the image
+                    auto& image = templates.back();
+                    image.cameraToGround = arma::eye(4,4);
+                    image.lens.type = Image<0>::Lens::Type::RADIAL;
+                    image.lens.parameters.radial.fov = M_PI;
+                    image.lens.parameters.radial.pitch = 0.0025;
+                    image.lens.parameters.radial.centre[0] = size[0] / 2;
+                    image.lens.parameters.radial.centre[1] = size[1] / 2;
+                    image.lens.cameraID = 0;
+                }
+
+                runFrames(std::to_string(size[0]) + "x" + std::to_string(size[1]), templates);
+            }
+        }
+
+        powerplant.shutdown();
+    }
+
+    std::vector<Image<0>> VisionBenchmark::loadRecording() {
+
+        std::vector<Image<0>> templates;
+
+        std::unique_ptr<utility::nbz::NBZReader> input;
+        try {
+            input = std::make_unique<utility::nbz::NBZReader>(recording);
+        }
+        catch(const std::exception& e) {
+            log<NUClear::ERROR>("Could not read", recording, ":", e.what());
+            return templates;
+        }
+        input->filter({ utility::nbz::typeHash(Message::Type_Name(Message::IMAGE)) });
+
+        Message message;
+        utility::nbz::NBZReader::Record record;
+        while(templates.size() < distinct && input->next(record)) {
+
+            message.ParsePartialFromArray(record.data, record.length);
+            const auto& proto = message.image();
+
+            // The detectors only look at the first camera
+            if(message.type() != Message::IMAGE || proto.camera_id() != 0 || proto.data().empty()) {
+                continue;
+            }
+
+            Image<0> image;
+            image.dimensions = { proto.dimensions().x(), proto.dimensions().y() };
+            image.cameraToGround = arma::eye(4,4);
+            image.source.assign(proto.data().begin(), proto.data().end());
+
+            switch(proto.format()) {
+                case ProtoImage::YCbCr422:  image.format = Image<0>::SourceFormat::YCbCr422; break;
+                case ProtoImage::YCbCr444:  image.format = Image<0>::SourceFormat::YCbCr444; break;
+                case ProtoImage::RGB:       image.format = Image<0>::SourceFormat::RGB;      break;
+                case ProtoImage::JPEG:      image.format = Image<0>::SourceFormat::JPEG;     break;
+                case ProtoImage::BGGR:      image.format = Image<0>::SourceFormat::BGGR;     break;
+            }
+
+            // Logs without a lens get the one NBZPlayer plays them with
+            image.lens.type = Image<0>::Lens::Type::RADIAL;
+            image.lens.parameters.radial.fov = M_PI;
+            image.lens.parameters.radial.pitch = 0.0025;
+            image.lens.parameters.radial.centre[0] = image.width() / 2;
+            image.lens.parameters.radial.centre[1] = image.height() / 2;
+
+            if(proto.has_lens() && proto.lens().type() == ProtoImage::Lens::EQUIRECTANGULAR) {
+                image.lens.type = Image<0>::Lens::Type::EQUIRECTANGULAR;
+                image.lens.parameters.equirectangular.fov[0] = proto.lens().equirectangular().fov().x();
+                image.lens.parameters.equirectangular.fov[1] = proto.lens().equirectangular().fov().y();
+                image.lens.parameters.equirectangular.focalLength = proto.lens().equirectangular().focal_length();
+            }
+            else if(proto.has_lens()) {
+                image.lens.type = proto.lens().type() == ProtoImage::Lens::BARREL ? Image<0>::Lens::Type::BARREL : Image<0>::Lens::Type::RADIAL;
+                image.lens.parameters.radial.fov = proto.lens().radial().fov();
+                image.lens.parameters.radial.pitch = proto.lens().radial().pitch();
+                image.lens.parameters.radial.centre[0] = proto.lens().radial().centre().x();
+                image.lens.parameters.radial.centre[1] = proto.lens().radial().centre().y();
+            }
+            image.lens.cameraID = 0;
+
+            templates.push_back(std::move(image));
+        }
+
+        if(templates.empty()) {
+            log<NUClear::ERROR>(recording, "has no images from camera 0");
+        }
+
+        return templates;
+    }
+
+    void VisionBenchmark::runFrames(const std::string& name, const std::vector<Image<0>>& templates) {
+
+        std::vector<double> allocated;
+        std::vector<double> latency;
+        std::chrono::steady_clock::time_point measureStart;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            samples.clear();
+            detected = 0;
+        }
+
+        for(uint i = 0; i < warmup + frames; ++i) {
+
+            const Image<0>& frame = templates[i % templates.size()];
+            bool measure = i >= warmup;
+
+            if(i == warmup) {
+                measureStart = std::chrono::steady_clock::now();
+            }
+
+            // Copy the frame so each one starts without a demosaic and hands its buffer back when it is done
+            auto image = std::make_unique<Image<0>>();
+            image->timestamp = NUClear::clock::now();
+            image->format = frame.format;
+            image->dimensions = frame.dimensions;
+            image->lens = frame.lens;
+            image->cameraToGround = frame.cameraToGround;
+
+            bool reused;
+            image->source = pool.acquire(frame.source.size(), reused);
+            std::copy(frame.source.begin(), frame.source.end(), image->source.begin());
+            image->recycle = pool.recycler();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!running) {
+                    return;
+                }
+                pending = detectors.size() + 1;
+                measuring = measure;
+                finished = NUClear::clock::time_point();
+            }
+
+            size_t before = allocations.load(std::memory_order_relaxed);
+            auto emitted = NUClear::clock::now();
+
+            // The classifier runs on this thread, the detectors on the pool
+            emit<Scope::DIRECT>(std::move(image));
+
+            std::unique_lock<std::mutex> lock(mutex);
+            bool done = changed.wait_for(lock, FRAME_TIMEOUT, [this] { return pending == 0 || !running; });
+
+            if(!running) {
+                return;
+            }
+            if(!done) {
+                log<NUClear::WARN>(name, "frame", i, "was not finished after", FRAME_TIMEOUT.count(), "seconds, are all the detectors installed?");
+                pending = 0;
+            }
+
+            if(measure) {
+                allocated.push_back(allocations.load(std::memory_order_relaxed) - before);
+                latency.push_back(micros(std::max(finished, emitted) - emitted));
+            }
+        }
+
+        if(frames == 0) {
+            return;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        samples[FRAME] = std::move(latency);
+        report(name, seconds, allocated);
+    }
+
+    void VisionBenchmark::report(const std::string& name, double seconds, const std::vector<double>& allocated) {
+
+        std::vector<std::string> stages = CLASSIFIER_STAGES;
+        stages.push_back(CLASSIFIER);
+        stages.insert(stages.end(), detectors.begin(), detectors.end());
+        stages.push_back(FRAME);
+
+        for(const auto& stage : stages) {
+
+            auto& values = samples[stage];
+            if(values.empty()) {
+                continue;
+            }
+            std::sort(values.begin(), values.end());
+
+            auto percentile = [&values] (double fraction) {
+                return values[std::min(values.size() - 1, size_t(fraction * values.size()))];
+            };
+
+            log(name, stage, "p50", percentile(0.5), "p90", percentile(0.9), "p99", percentile(0.99), "max", values.back(), "us");
+        }
+
+        double total = 0;
+        double most = 0;
+        for(double a : allocated) {
+            total += a;
+            most = std::max(most, a);
+        }
+
+        log(name, frames / seconds, "fps,", allocated.empty() ? 0 : total / allocated.size(), "allocations per frame ( max", most, ")");
+        log(name, "balls detected in", 100.0 * detected / frames, "% of frames");
+    }
+
+}
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_SUPPORT_VISIONBENCHMARK_H
+#define MODULES_SUPPORT_VISIONBENCHMARK_H
+
+#include <nuclear>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include "messages/input/Image.h"
+#include "utility/image/FramePool.h"
+
+namespace modules {
+namespace support {
+
+    /**
+     * Pushes recorded or synthetic images through the vision pipeline one at a time and reports how long each stage
+     * took, how many allocations each frame needed and the frame rate.
+     *
+     * Each frame is emitted directly and the next one waits until the classifier and every detector has finished
+     * with it. The stages inside the classifier come from its ClassifierTiming, the detectors from their reaction
+     * statistics. Once every size has been run the powerplant is shut down.
+     */
+    class VisionBenchmark : public NUClear::Reactor {
+    private:
+        // What to run
+        std::vector<arma::uvec2> sizes;
+        uint frames = 0;
+        uint warmup = 0;
+        uint distinct = 1;
+        std::string recording;
+        std::vector<std::string> detectors;
+        bool configured = false;
+        bool running = true;
+
+        // The frame in flight, the reactions it is still waiting on and what they measured (in microseconds)
+        uint pending = 0;
+        bool measuring = false;
+        NUClear::clock::time_point finished;
+        std::map<std::string, std::vector<double>> samples;
+        uint detected = 0;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        // Frames are copied into pooled buffers so emitting them does not count as an allocation
+        utility::image::FramePool pool;
+
+        void run();
+        std::vector<messages::input::Image<0>> loadRecording();
+        void runFrames(const std::string& name, const std::vector<messages::input::Image<0>>& templates);
+        void report(const std::string& name, double seconds, const std::vector<double>& allocations);
+
+    public:
+        static constexpr const char* CONFIGURATION_PATH = "VisionBenchmark.yaml";
+        /// @brief Called by the powerplant to build and setup the VisionBenchmark reactor.
+        explicit VisionBenchmark(std::unique_ptr<NUClear::Environment> environment);
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "utility/math/ransac/Ransac.h"
+#include "utility/math/ransac/RansacCircleModel.h"
+#include "utility/math/ransac/RansacLineModel.h"
+
+using utility::math::ransac::Ransac;
+using utility::math::ransac::RansacParameters;
+using utility::math::ransac::RansacCircleModel;
+using utility::math::ransac::RansacLineModel;
+
+namespace {
+
+    /*
+     * Points on the edge of a ball at (320, 240) with radius 50 mixed with points spread over the image
+     */
+    std::vector<arma::vec2> makeCircle(uint inliers, uint outliers, double noise, std::mt19937& rng) {
+
+        std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+        std::uniform_real_distribution<double> x(0, 640);
+        std::uniform_real_distribution<double> y(0, 480);
+        std::normal_distribution<double> jitter(0, std::max(noise, 1e-9));
+
+        std::vector<arma::vec2> points;
+        for(uint i = 0; i < inliers; ++i) {
+            double a = angle(rng);
+            double r = 50 + jitter(rng);
+            points.push_back({ 320 + r * std::cos(a), 240 + r * std::sin(a) });
+        }
+        for(uint i = 0; i < outliers; ++i) {
+            points.push_back({ x(rng), y(rng) });
+        }
+
+        std::shuffle(points.begin(), points.end(), rng);
+        return points;
+    }
+
+    /*
+     * Points along y = 0.5x + 20 mixed with points spread over the image
+     */
+    std::vector<arma::vec2> makeLine(uint inliers, uint outliers, double noise, std::mt19937& rng) {
+
+        std::uniform_real_distribution<double> x(0, 640);
+        std::uniform_real_distribution<double> y(0, 480);
+        std::normal_distribution<double> jitter(0, std::max(noise, 1e-9));
+
+        std::vector<arma::vec2> points;
+        for(uint i = 0; i < inliers; ++i) {
+            double px = x(rng);
+            points.push_back({ px, 0.5 * px + 20 + jitter(rng) });
+        }
+        for(uint i = 0; i < outliers; ++i) {
+            points.push_back({ x(rng), y(rng) });
+        }
+
+        std::shuffle(points.begin(), points.end(), rng);
+        return points;
+    }
+
+    struct Run {
+        double milliseconds;
+        uint found;
+        size_t consensus;
+    };
+
+    template <typename Model, typename Generate>
+    Run runRansac(const RansacParameters& parameters, uint runs, Generate&& generate) {
+
+        Run run { 0, 0, 0 };
+
+        for(uint i = 0; i < runs; ++i) {
+            auto points = generate();
+
+            auto start = std::chrono::steady_clock::now();
+            auto results = Ransac<Model>::fitModels(points.begin(), points.end(), parameters);
+            run.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            if(!results.empty()) {
+                ++run.found;
+                run.consensus += std::distance(results.front().first, results.front().last);
+            }
+        }
+
+        run.milliseconds /= runs;
+        return run;
+    }
+}
+
+TEST_CASE("Ransac finds a circle among outliers with every search strategy", "[ransac]") {
+
+    std::mt19937 rng(7);
+
+    for(auto& parameters : { RansacParameters(20, 200, 1, 4.0, 1.0)
+                           , RansacParameters(20, 200, 1, 4.0, 0.99)
+                           , RansacParameters(20, 200, 1, 4.0, 0.99, 0)
+                           , RansacParameters(20, 200, 1, 4.0, 0.99, 1, 20) }) {
+
+        auto points = makeCircle(60, 60, 0.5, rng);
+        auto results = Ransac<RansacCircleModel>::fitModels(points.begin(), points.end(), parameters);
+
+        REQUIRE(results.size() == 1);
+        REQUIRE(std::abs(results[0].model.radius - 50) < 2);
+        REQUIRE(std::abs(results[0].model.centre[0] - 320) < 2);
+        REQUIRE(std::abs(results[0].model.centre[1] - 240) < 2);
+        REQUIRE(std::distance(results[0].first, results[0].last) >= 55);
+    }
+}
+
+TEST_CASE("Ransac gives up on data that only makes degenerate models", "[ransac]") {
+
+    std::vector<arma::vec2> points(30, arma::vec2({ 1, 1 }));
+    auto results = Ransac<RansacLineModel>::fitModels(points.begin(), points.end(), 10, 100, 1, 1.0);
+
+    REQUIRE(results.empty());
+}
+
+namespace {
+
+    /*
+     * A line model that counts how many hypotheses ransac makes
+     */
+    struct CountingLineModel : public RansacLineModel {
+        static uint regenerated;
+
+        bool regenerate(const std::vector<DataPoint>& pts) {
+            ++regenerated;
+            return RansacLineModel::regenerate(pts);
+        }
+    };
+    uint CountingLineModel::regenerated = 0;
+}
+
+TEST_CASE("Ransac runs every iteration unless it is asked to stop early", "[ransac]") {
+
+    std::mt19937 rng(3);
+    auto points = makeLine(100, 0, 0.0, rng);
+
+    // The old entry points and default parameters keep their fixed number of iterations
+    CountingLineModel::regenerated = 0;
+    auto results = Ransac<CountingLineModel>::fitModels(points.begin(), points.end(), 10, 100, 1, 1.0);
+    REQUIRE(results.size() == 1);
+    REQUIRE(CountingLineModel::regenerated >= 100);
+
+    // With every point an inlier the first hypothesis is enough once we ask for a confidence
+    CountingLineModel::regenerated = 0;
+    results = Ransac<CountingLineModel>::fitModels(points.begin(), points.end(), RansacParameters(10, 100, 1, 1.0, 0.99));
+    REQUIRE(results.size() == 1);
+    REQUIRE(CountingLineModel::regenerated < 100);
+}
+
+TEST_CASE("Benchmark ransac search strategies over synthetic inlier and outlier sets", "[ransac][benchmark][.]") {
+
+    constexpr uint RUNS = 50;
+
+    struct Strategy {
+        const char* name;
+        double confidence;
+        uint threads;
+        uint preemptiveBlockSize;
+    };
+
+    const Strategy strategies[] = {
+        { "fixed iterations",   1.0,  1, 0 },
+        { "adaptive",           0.99, 1, 0 },
+        { "adaptive threaded",  0.99, 0, 0 },
+        { "preemptive",         0.99, 1, 25 },
+    };
+
+    for(double noise : { 0.0, 0.5, 2.0 }) {
+        for(double outlierRatio : { 0.25, 0.5, 0.75 }) {
+
+            uint inliers = 200;
+            uint outliers = uint(inliers * outlierRatio / (1 - outlierRatio));
+
+            std::cout << "Noise " << noise << " px, " << outlierRatio * 100 << "% outliers (" << inliers + outliers << " points)" << std::endl;
+
+            for(auto& strategy : strategies) {
+                RansacParameters parameters(50, 500, 1, std::max(4.0, 9 * noise * noise), strategy.confidence, strategy.threads, strategy.preemptiveBlockSize);
+
+                std::mt19937 circleRng(1);
+                auto circle = runRansac<RansacCircleModel>(parameters, RUNS, [&] {
+                    return makeCircle(inliers, outliers, noise, circleRng);
+                });
+
+                std::mt19937 lineRng(1);
+                auto line = runRansac<RansacLineModel>(parameters, RUNS, [&] {
+                    return makeLine(inliers, outliers, noise, lineRng);
+                });
+
+                std::cout << "    " << strategy.name << ":" << std::endl
+                          << "        circle " << circle.milliseconds << " ms, found " << circle.found << "/" << RUNS
+                          << ", mean consensus " << (circle.found ? circle.consensus / circle.found : 0) << std::endl
+                          << "        line   " << line.milliseconds << " ms, found " << line.found << "/" << RUNS
+                          << ", mean consensus " << (line.found ? line.consensus / line.found : 0) << std::endl;
+            }
+        }
+    }
+}
@@ -30,7 +30,6 @@
 #include "utility/math/ransac/RansacOriginConeModel.h"
 
 #include "utility/math/vision.h"
-#include "utility/vision/geometry/screen.h"
 #include "utility/nubugger/NUhelpers.h"
 #include "utility/math/coordinates.h"
 
@@ -77,7 +76,7 @@ namespace vision {
             measurement_elevation_variance = config["measurement_elevation_variance"].as<double>();
         });
 
-        on<Trigger<Raw<ClassifiedImage<ObjectClass,0>>>, Options<Single>>("Ball Detector", [this](
+        on<Trigger<Raw<ClassifiedImage<ObjectClass,0>>>, Options<Single>>("Buoy Detector", [this](
             const std::shared_ptr<const ClassifiedImage<ObjectClass,0>>& rawImage) {
             /*if (field == nullptr) {
                 NUClear::log(__FILE__, ", ", __LINE__, ": FieldDescription Update: support::configuration::SoccerConfig module might not be installed.");
@@ -89,8 +88,7 @@ namespace vision {
             const auto& sensors = *image.sensors;
 
             // Get all the points that could make up the ball
-            arma::imat ballPoints( image.horizontalSegments.count(ObjectClass::BALL) + image.verticalSegments.count(ObjectClass::BALL), 2);
-            uint total = 0;
+            ballPoints.clear();
             for(int i = 0; i < 1; ++i) {
 
                 auto segments = i ? image.horizontalSegments.equal_range(ObjectClass::BALL)
@@ -111,27 +109,33 @@ namespace vision {
                         && segment.subsample == 1
                         && segment.next
                         && (!segment.next->next || segment.next->next->colour != ObjectClass::BALL)) {
-                        ballPoints.row(total) = arma::ivec({ (end[0]), (end[1]) }).t();
-                        ++total;
+                        ballPoints.push_back(end[0]);
+                        ballPoints.push_back(end[1]);
                     }
                     if(belowHorizon
                         && segment.subsample == 1
                         && segment.previous
                         && (!segment.previous->previous || segment.previous->previous->colour != ObjectClass::BALL)) {
-                        ballPoints.row(total) = arma::ivec({ (start[0]), (start[1]) }).t();
-                        ++total;
+                        ballPoints.push_back(start[0]);
+                        ballPoints.push_back(start[1]);
                     }
                 }
             }
+            const size_t total = ballPoints.size() / 2;
             if (total == 0) {
                 return;
             }
-            
+
+            if (!projection.describes(*image.image)) {
+                projection.set(*image.image);
+            }
+
             //convert pixels to rays
-            arma::mat tmpRays = utility::vision::geometry::bulkPixel2Ray(ballPoints.rows(0,total-1),*(image.image)).t();
-            std::vector<arma::vec3> ballRays(tmpRays.n_cols);
-            for (int i = 0; i < ballRays.size(); ++i) {
-                ballRays[i] = tmpRays.col(i);
+            ballPointRays.resize(total * 3);
+            projection.pixelsToRays(ballPoints.data(), total, ballPointRays.data());
+            ballRays.resize(total);
+            for (size_t i = 0; i < total; ++i) {
+                ballRays[i] = arma::vec3({ ballPointRays[i * 3 + 0], ballPointRays[i * 3 + 1], ballPointRays[i * 3 + 2] });
             }
             
             // Use ransac to find the ball
@@ -204,7 +208,9 @@ namespace vision {
                     arma::mat pxRay = sensors.orientationCamToGround.submat(0,0,2,2).t() * result.model.centre;
                     
                     b.circle.radius = result.model.radius;
-                    b.circle.centre = utility::vision::geometry::bulkRay2Pixel( pxRay.t(), *(image.image)).t();
+                    int centre[2];
+                    projection.raysToPixels(pxRay.memptr(), 1, centre);
+                    b.circle.centre = arma::vec2({ double(centre[0]), double(centre[1]) });
                     // Angular positions from the camera
                     b.screenAngular = arma::vec2({std::acos(worldBallCentreRay[1]), std::acos(worldBallCentreRay[2])});
                     b.angularSize = { 2.0*std::acos(result.model.radius), 2.0*std::acos(result.model.radius) };
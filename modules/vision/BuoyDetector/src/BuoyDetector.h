@@ -20,7 +20,11 @@
 #ifndef MODULES_VISION_BUOYDETECTOR_H
 #define MODULES_VISION_BUOYDETECTOR_H
 
+#include <vector>
 #include <nuclear>
+#include <armadillo>
+
+#include "utility/vision/geometry/projection.h"
 
 namespace modules {
 namespace vision {
@@ -36,6 +40,12 @@ namespace vision {
         double measurement_bearing_variance;
         double measurement_elevation_variance;
 
+        // Rebuilt when the camera's lens changes, the buffers are reused between frames so they don't allocate
+        utility::vision::geometry::LensProjection projection;
+        std::vector<int> ballPoints;
+        std::vector<double> ballPointRays;
+        std::vector<arma::vec3> ballRays;
+
     public:
 
         static constexpr const char* CONFIGURATION_PATH = "BuoyDetector.yaml";
@@ -0,0 +1,328 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "messages/input/Image.h"
+#include "utility/vision/geometry/projection.h"
+
+using messages::input::Image;
+using utility::vision::geometry::LensProjection;
+using utility::vision::geometry::projectionInstructionSet;
+
+namespace {
+
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+    constexpr double FOV = M_PI;
+    constexpr double PITCH = 0.0026;
+    constexpr double CENTRE[2] = { 640, 480 };
+
+    Image<0> makeImage(Image<0>::Lens::Type type) {
+        Image<0> image;
+        image.dimensions = { WIDTH, HEIGHT };
+        image.lens.type = type;
+
+        if (type == Image<0>::Lens::Type::EQUIRECTANGULAR) {
+            image.lens.parameters.equirectangular.fov[0] = 1.2;
+            image.lens.parameters.equirectangular.fov[1] = 0.9;
+            image.lens.parameters.equirectangular.focalLength = 1000;
+        }
+        else {
+            image.lens.parameters.radial.fov = FOV;
+            image.lens.parameters.radial.pitch = PITCH;
+            image.lens.parameters.radial.centre[0] = CENTRE[0];
+            image.lens.parameters.radial.centre[1] = CENTRE[1];
+        }
+
+        return image;
+    }
+
+    // The sums bulkPixel2Ray does for a radial lens, one pixel at a time
+    void referencePixelToRay(int px, int py, double* ray) {
+        double x = (px - CENTRE[0]) * PITCH;
+        double y = (py - CENTRE[1]) * PITCH;
+        double rads = std::sqrt(x * x + y * y);
+        double sinRadsOnRads = std::sin(rads) / rads;
+
+        ray[0] = std::cos(rads);
+        ray[1] = x * sinRadsOnRads;
+        ray[2] = -y * sinRadsOnRads;
+    }
+
+    // The sums bulkRay2Pixel does for a radial lens, one ray at a time
+    void referenceRayToPixel(const double* ray, int* pixel) {
+        double norm = std::sqrt(ray[1] * ray[1] + ray[2] * ray[2]);
+        double scale = std::acos(ray[0]) / PITCH / norm;
+
+        pixel[0] = int(std::round(ray[1] * scale + CENTRE[0]));
+        pixel[1] = int(std::round(-ray[2] * scale + CENTRE[1]));
+    }
+
+    // Random pixels anywhere in the image (odd counts so the scalar tail after the SIMD lanes gets used)
+    std::vector<int> randomPixels(size_t count) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> x(0, WIDTH - 1);
+        std::uniform_int_distribution<int> y(0, HEIGHT - 1);
+
+        std::vector<int> pixels(count * 2);
+        for (size_t i = 0; i < count; ++i) {
+            pixels[i * 2 + 0] = x(rng);
+            pixels[i * 2 + 1] = y(rng);
+        }
+        return pixels;
+    }
+
+    // Random unit rays in front of a radial lens
+    std::vector<double> randomRays(size_t count) {
+        std::mt19937 rng(7);
+        std::normal_distribution<double> normal;
+
+        std::vector<double> rays(count * 3);
+        for (size_t i = 0; i < count; ++i) {
+            double x = std::fabs(normal(rng));
+            double y = normal(rng);
+            double z = normal(rng);
+            double norm = std::sqrt(x * x + y * y + z * z);
+
+            rays[i * 3 + 0] = x / norm;
+            rays[i * 3 + 1] = y / norm;
+            rays[i * 3 + 2] = z / norm;
+        }
+        return rays;
+    }
+
+    template <typename Function>
+    double microsecondsPerRun(int runs, Function&& f) {
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < runs; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / runs;
+    }
+}
+
+TEST_CASE("Radial pixels project to the same rays as bulkPixel2Ray", "[vision][projection]") {
+
+    auto image = makeImage(Image<0>::Lens::Type::RADIAL);
+    LensProjection projection(image);
+    REQUIRE(projection.describes(image));
+
+    auto pixels = randomPixels(10001);
+    const size_t count = pixels.size() / 2;
+
+    std::vector<double> rays(count * 3);
+    projection.pixelsToRays(pixels.data(), count, rays.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        double expected[3];
+        referencePixelToRay(pixels[i * 2 + 0], pixels[i * 2 + 1], expected);
+
+        REQUIRE(std::fabs(rays[i * 3 + 0] - expected[0]) < 1e-6);
+        REQUIRE(std::fabs(rays[i * 3 + 1] - expected[1]) < 1e-6);
+        REQUIRE(std::fabs(rays[i * 3 + 2] - expected[2]) < 1e-6);
+    }
+
+    // Barrel lenses have the same parameters and project the same way
+    image.lens.type = Image<0>::Lens::Type::BARREL;
+    REQUIRE_FALSE(projection.describes(image));
+    LensProjection barrel(image);
+
+    std::vector<double> barrelRays(count * 3);
+    barrel.pixelsToRays(pixels.data(), count, barrelRays.data());
+    REQUIRE(barrelRays == rays);
+}
+
+TEST_CASE("Radial rays project to the same pixels as bulkRay2Pixel", "[vision][projection]") {
+
+    LensProjection projection(makeImage(Image<0>::Lens::Type::RADIAL));
+
+    auto rays = randomRays(10001);
+    const size_t count = rays.size() / 3;
+
+    std::vector<int> pixels(count * 2);
+    projection.raysToPixels(rays.data(), count, pixels.data());
+
+    // A pixel can only round the other way when the exact answer is within a hair of half way
+    size_t different = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int expected[2];
+        referenceRayToPixel(rays.data() + i * 3, expected);
+
+        REQUIRE(std::abs(pixels[i * 2 + 0] - expected[0]) <= 1);
+        REQUIRE(std::abs(pixels[i * 2 + 1] - expected[1]) <= 1);
+        different += pixels[i * 2 + 0] != expected[0] || pixels[i * 2 + 1] != expected[1];
+    }
+    REQUIRE(different < count / 1000);
+
+    // Going there and back again lands on the same pixels, including the centre which bulkRay2Pixel makes NaN
+    auto original = randomPixels(1001);
+    original[0] = 640;
+    original[1] = 480;
+    std::vector<double> there(original.size() / 2 * 3);
+    std::vector<int> back(original.size());
+
+    projection.pixelsToRays(original.data(), original.size() / 2, there.data());
+    projection.raysToPixels(there.data(), original.size() / 2, back.data());
+    REQUIRE(back == original);
+
+    double ray[3];
+    projection.pixelsToRays(original.data(), 1, ray);
+    REQUIRE(ray[0] == 1);
+    REQUIRE(ray[1] == 0);
+    REQUIRE(ray[2] == 0);
+}
+
+TEST_CASE("Equirectangular lenses project there and back again", "[vision][projection]") {
+
+    LensProjection projection(makeImage(Image<0>::Lens::Type::EQUIRECTANGULAR));
+
+    auto pixels = randomPixels(1001);
+    const size_t count = pixels.size() / 2;
+
+    std::vector<double> rays(count * 3);
+    std::vector<int> back(count * 2);
+    projection.pixelsToRays(pixels.data(), count, rays.data());
+    projection.raysToPixels(rays.data(), count, back.data());
+
+    REQUIRE(back == pixels);
+
+    // The middle of the image looks straight down z
+    const int middle[2] = { WIDTH / 2, HEIGHT / 2 };
+    double ray[3];
+    projection.pixelsToRays(middle, 1, ray);
+    REQUIRE(ray[0] == 0);
+    REQUIRE(ray[1] == 0);
+    REQUIRE(ray[2] == 1);
+}
+
+TEST_CASE("Trimming keeps the points trimToFOV and trimToImage keep, in order and in place", "[vision][projection]") {
+
+    LensProjection projection(makeImage(Image<0>::Lens::Type::RADIAL));
+
+    auto rays = randomRays(1001);
+    std::vector<double> expectedRays;
+    for (size_t i = 0; i < rays.size(); i += 3) {
+        if (rays[i] > std::cos(FOV / 2)) {
+            expectedRays.insert(expectedRays.end(), rays.begin() + i, rays.begin() + i + 3);
+        }
+    }
+
+    size_t keptRays = projection.trimToFOV(rays.data(), rays.size() / 3, rays.data());
+    rays.resize(keptRays * 3);
+    REQUIRE(rays == expectedRays);
+
+    std::vector<int> pixels = { -1, 0, 0, 0, 1279, 959, 1280, 959, 12, -5, 5, 960, 100, 200 };
+    size_t keptPixels = projection.trimToImage(pixels.data(), pixels.size() / 2, pixels.data());
+    pixels.resize(keptPixels * 2);
+    REQUIRE(pixels == std::vector<int>({ 0, 0, 1279, 959, 100, 200 }));
+}
+
+TEST_CASE("Snapping to the screen matches snapToScreen", "[vision][projection]") {
+
+    LensProjection projection(makeImage(Image<0>::Lens::Type::RADIAL));
+
+    const double positions[] = { 640, 480, 100, 300, 900, 50, 640, 900 };
+    const double radius = FOV / 2.0 / PITCH;
+
+    for (double angle = 0; angle < 2 * M_PI; angle += 0.1) {
+        const double direction[2] = { std::cos(angle), std::sin(angle) };
+
+        double ends[8];
+        projection.snapToScreen(positions, 4, direction, ends);
+
+        for (size_t i = 0; i < 4; ++i) {
+            double x = positions[i * 2 + 0];
+            double y = positions[i * 2 + 1];
+
+            // snapToScreen's sums, in its order
+            double b = 2.0 * ((x - CENTRE[0]) * direction[0] + (y - CENTRE[1]) * direction[1]);
+            double c = x * x + y * y + CENTRE[0] * CENTRE[0] + CENTRE[1] * CENTRE[1] - 2.0 * (x * CENTRE[0] + y * CENTRE[1]) - radius * radius;
+            double scale = (-b + std::sqrt(b * b - 4.0 * c)) / 2.0;
+
+            if (direction[0] > 0) {
+                scale = std::min((WIDTH / 2 - x) / direction[0], scale);
+            }
+            else if (direction[0] < 0) {
+                scale = std::min((x - WIDTH / 2) / direction[0], scale);
+            }
+            if (direction[1] > 0) {
+                scale = std::min((HEIGHT - y) / direction[1], scale);
+            }
+            else if (direction[1] < 0) {
+                scale = std::min((y - HEIGHT) / direction[1], scale);
+            }
+
+            REQUIRE(std::fabs(ends[i * 2 + 0] - std::round(direction[0] * scale + x)) <= 1);
+            REQUIRE(std::fabs(ends[i * 2 + 1] - std::round(direction[1] * scale + y)) <= 1);
+        }
+    }
+}
+
+TEST_CASE("Benchmark batched projection against per point trigonometry on 10k points", "[vision][projection][benchmark][.]") {
+
+    constexpr int RUNS = 200;
+    LensProjection projection(makeImage(Image<0>::Lens::Type::RADIAL));
+
+    auto pixels = randomPixels(10000);
+    auto inputRays = randomRays(10000);
+    std::vector<double> rays(inputRays.size());
+    std::vector<int> output(pixels.size());
+
+    double referenceToRays = microsecondsPerRun(RUNS, [&] {
+        for (size_t i = 0; i < 10000; ++i) {
+            referencePixelToRay(pixels[i * 2 + 0], pixels[i * 2 + 1], rays.data() + i * 3);
+        }
+    });
+    double checksum = rays[0];
+
+    double batchToRays = microsecondsPerRun(RUNS, [&] {
+        projection.pixelsToRays(pixels.data(), 10000, rays.data());
+    });
+    checksum += rays[0];
+
+    double referenceToPixels = microsecondsPerRun(RUNS, [&] {
+        for (size_t i = 0; i < 10000; ++i) {
+            referenceRayToPixel(inputRays.data() + i * 3, output.data() + i * 2);
+        }
+    });
+    checksum += output[0];
+
+    double batchToPixels = microsecondsPerRun(RUNS, [&] {
+        projection.raysToPixels(inputRays.data(), 10000, output.data());
+    });
+    checksum += output[0];
+
+    std::cout << "Radial projection of 10k points (" << projectionInstructionSet() << ")" << std::endl
+              << "    pixels to rays per point: " << referenceToRays   << " us" << std::endl
+              << "    pixels to rays batched:   " << batchToRays       << " us" << std::endl
+              << "    rays to pixels per point: " << referenceToPixels << " us" << std::endl
+              << "    rays to pixels batched:   " << batchToPixels     << " us" << std::endl
+              << "    (checksum " << checksum << ")" << std::endl;
+
+    REQUIRE(batchToRays < referenceToRays);
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "messages/input/Image.h"
+#include "utility/vision/geometry/projection.h"
+#include "utility/vision/geometry/raytable.h"
+
+using messages::input::Image;
+using utility::vision::geometry::LensProjection;
+using utility::vision::geometry::RayTable;
+
+namespace {
+
+    template <int camID>
+    Image<camID> makeImage(double pitch) {
+        Image<camID> image;
+        image.dimensions = { 1280, 960 };
+        image.lens.type = Image<camID>::Lens::Type::RADIAL;
+        image.lens.parameters.radial.fov = M_PI;
+        image.lens.parameters.radial.pitch = pitch;
+        image.lens.parameters.radial.centre[0] = 640;
+        image.lens.parameters.radial.centre[1] = 480;
+        return image;
+    }
+
+    std::vector<int> randomPixels(size_t count) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> x(0, 1279);
+        std::uniform_int_distribution<int> y(0, 959);
+
+        std::vector<int> pixels(count * 2);
+        for (size_t i = 0; i < count; ++i) {
+            pixels[i * 2 + 0] = x(rng);
+            pixels[i * 2 + 1] = y(rng);
+        }
+        return pixels;
+    }
+
+    // The largest angle between the table's rays and the exact ones
+    double maximumError(const RayTable& table, const LensProjection& projection, const std::vector<int>& pixels) {
+        const size_t count = pixels.size() / 2;
+        std::vector<double> expected(count * 3);
+        std::vector<double> actual(count * 3);
+
+        projection.pixelsToRays(pixels.data(), count, expected.data());
+        table.pixelsToRays(pixels.data(), count, actual.data());
+
+        double error = 0;
+        for (size_t i = 0; i < count; ++i) {
+            double x = expected[i * 3 + 1] * actual[i * 3 + 2] - expected[i * 3 + 2] * actual[i * 3 + 1];
+            double y = expected[i * 3 + 2] * actual[i * 3 + 0] - expected[i * 3 + 0] * actual[i * 3 + 2];
+            double z = expected[i * 3 + 0] * actual[i * 3 + 1] - expected[i * 3 + 1] * actual[i * 3 + 0];
+            error = std::max(error, std::asin(std::min(std::sqrt(x * x + y * y + z * z), 1.0)));
+        }
+        return error;
+    }
+}
+
+TEST_CASE("Ray tables look up the rays the lens projects to", "[vision][raytable]") {
+
+    auto image = makeImage<0>(0.0026);
+    LensProjection projection(image);
+    auto pixels = randomPixels(10001);
+
+    // Every corner and edge has to land in a cell
+    pixels.insert(pixels.end(), { 0, 0, 1279, 0, 0, 959, 1279, 959 });
+
+    RayTable exact(projection, 1280, 960, 1);
+    REQUIRE(maximumError(exact, projection, pixels) < 1e-6);
+
+    for (uint spacing : { 2, 4, 8, 16 }) {
+        RayTable table(projection, 1280, 960, spacing);
+        double bound = (spacing * 0.0026) * (spacing * 0.0026) / 8;
+
+        INFO("Spacing " << spacing);
+        REQUIRE(maximumError(table, projection, pixels) < bound);
+    }
+}
+
+TEST_CASE("Ray tables are built once per lens and shared", "[vision][raytable]") {
+
+    auto image = makeImage<0>(0.0026);
+    auto table = RayTable::get(image, 4);
+
+    // The same camera, spacing and lens get the same table
+    REQUIRE(RayTable::get(image, 4) == table);
+    REQUIRE(table->spacing() == 4);
+
+    // Another camera with the same lens shares it, a different spacing doesn't
+    REQUIRE(RayTable::get(makeImage<1>(0.0026), 4) == table);
+    REQUIRE(RayTable::get(image, 8) != table);
+
+    // When the lens changes the old table stays valid for whoever has it
+    auto changed = makeImage<0>(0.0025);
+    auto rebuilt = RayTable::get(changed, 4);
+    REQUIRE(rebuilt != table);
+    REQUIRE(RayTable::get(changed, 4) == rebuilt);
+
+    auto pixels = randomPixels(100);
+    std::vector<double> rays(300);
+    table->pixelsToRays(pixels.data(), 100, rays.data());
+    REQUIRE(maximumError(*table, LensProjection(image), pixels) < 1e-4);
+}
+
+TEST_CASE("Benchmark ray lookups per second by table spacing", "[vision][raytable][benchmark][.]") {
+
+    constexpr int RUNS = 100;
+    auto image = makeImage<0>(0.0026);
+    LensProjection projection(image);
+
+    // Detectors mostly look up points along scanlines, which is kinder to the cache than points anywhere
+    auto pixels = randomPixels(10000);
+    std::vector<int> scanlines(20000);
+    for (size_t i = 0; i < 10000; ++i) {
+        scanlines[i * 2 + 0] = int(i % 1250);
+        scanlines[i * 2 + 1] = int(i / 1250) * 120;
+    }
+    std::vector<double> rays(30000);
+
+    auto lookupsPerSecond = [&] (const std::function<void ()>& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < RUNS; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return 10000.0 * RUNS / std::chrono::duration<double>(end - start).count();
+    };
+
+    double perPoint = lookupsPerSecond([&] {
+        for (size_t i = 0; i < 10000; ++i) {
+            double x = (pixels[i * 2 + 0] - 640) * 0.0026;
+            double y = (pixels[i * 2 + 1] - 480) * 0.0026;
+            double rads = std::sqrt(x * x + y * y);
+            rays[i * 3 + 0] = std::cos(rads);
+            rays[i * 3 + 1] = x * std::sin(rads) / rads;
+            rays[i * 3 + 2] = -y * std::sin(rads) / rads;
+        }
+    });
+
+    double batched = lookupsPerSecond([&] {
+        projection.pixelsToRays(pixels.data(), 10000, rays.data());
+    });
+
+    std::cout << "Ray lookups per second (1280x960 radial lens)" << std::endl
+              << "    per point trigonometry: " << perPoint << std::endl
+              << "    LensProjection:         " << batched << std::endl;
+
+    for (uint spacing : { 1, 2, 4, 8, 16 }) {
+        auto build = std::chrono::steady_clock::now();
+        RayTable table(projection, 1280, 960, spacing);
+        double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build).count();
+
+        double lookups = lookupsPerSecond([&] {
+            table.pixelsToRays(pixels.data(), 10000, rays.data());
+        });
+
+        double scanlineLookups = lookupsPerSecond([&] {
+            table.pixelsToRays(scanlines.data(), 10000, rays.data());
+        });
+
+        std::cout << "    spacing " << spacing << ": " << lookups << " per second anywhere, "
+                  << scanlineLookups << " per second along scanlines, "
+                  << maximumError(table, projection, pixels) << " rad worst error, "
+                  << table.bytes() / 1024 << " KB, built in " << buildTime << " ms" << std::endl;
+    }
+
+    REQUIRE(rays[0] == rays[0]);
+}
@@ -21,6 +21,7 @@
 
 #include "messages/vision/LookUpTable.h"
 #include "messages/support/Configuration.h"
+#include "utility/vision/LookUpTableFile.h"
 
 namespace modules {
 namespace vision {
@@ -35,11 +36,12 @@ namespace LUT {
         : Reactor(std::move(environment)) {
 
         on<Trigger<Configuration<LUTLoader>>>([this](const Configuration<LUTLoader>& config) {
-            emit(std::make_unique<LookUpTable>(config.config.as<LookUpTable>()));
+            emit(std::make_unique<LookUpTable>(utility::vision::loadLookUpTable(config.config)));
         });
 
         on<Trigger<SaveLookUpTable>, With<LookUpTable>>([this](const SaveLookUpTable&, const LookUpTable& lut) {
-            emit(std::make_unique<SaveConfiguration>(SaveConfiguration{ LUTLoader::CONFIGURATION_PATH, YAML::Node(lut) }));
+            auto config = utility::vision::saveLookUpTableConfig(LUTLoader::TABLE_PATH, lut);
+            emit(std::make_unique<SaveConfiguration>(SaveConfiguration{ LUTLoader::CONFIGURATION_PATH, config }));
         });
     }
 
@@ -29,6 +29,8 @@ namespace LUT {
     class LUTLoader : public NUClear::Reactor {
     public:
         static constexpr const char* CONFIGURATION_PATH = "LookUpTable.yaml";
+        // The binary table the config points to once a LUT has been saved
+        static constexpr const char* TABLE_PATH = "LookUpTable.lut";
         /// @brief Called by the powerplant to build and setup the LUTLoader reactor.
         explicit LUTLoader(std::unique_ptr<NUClear::Environment> environment);
     };
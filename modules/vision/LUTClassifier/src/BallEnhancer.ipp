@@ -60,7 +60,7 @@ namespace modules {
                 if(classifiedImage.visualHorizonAtPoint(pt.start[0]) <= pt.start[1] || classifiedImage.visualHorizonAtPoint(pt.end[0]) <= pt.end[1]) {
 
                     // Push back our midpoint offset to be in the middle of the subsample
-                    points.push_back(it->second.midpoint - arma::ivec2{ int(it->second.subsample) / 2, 0 });
+                    points.push_back(arma::ivec2({ pt.midpoint[0] - int(pt.subsample) / 2, pt.midpoint[1] }));
                 }
             }
 
@@ -129,7 +129,7 @@ namespace modules {
                             start[1] = std::max(start[1], 1);
                             end[1] = std::min(end[1], int(image.height() - 2));
 
-                            auto segments = quex->classify(image, lut, start, end);
+                            auto segments = classify(image, lut, start, end);
                             insertSegments(classifiedImage, segments, true);
                         }
 
@@ -143,7 +143,7 @@ namespace modules {
                             start[0] = std::max(start[0], 1);
                             end[0] = std::min(end[0], int(image.width() - 2));
 
-                            auto segments = quex->classify(image, lut, start, end);
+                            auto segments = classify(image, lut, start, end);
                             insertSegments(classifiedImage, segments, false);
                         }
 
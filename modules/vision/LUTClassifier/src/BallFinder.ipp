@@ -59,9 +59,13 @@ namespace modules {
             double radius = image.lens.parameters.radial.fov/2/image.lens.parameters.radial.pitch;
             
             
-            int dx = 3;
+            // Lines are spread out further when the scan planner is backing off
+            int dx = std::max(3, int(3 * scanPlan.sparsity));
             
             
+            // The spacing of each row depends on the one before, so the rows are laid out before any are classified
+            std::vector<Scanline> lines;
+
             for(double y = 0; y <= 400; y += dx) {
                 
                 
@@ -70,11 +74,8 @@ namespace modules {
                 int xEnd = int(image.lens.parameters.radial.centre[0] + radius);
                 
                 
-                auto segments = quex->classify(image, lut, arma::ivec2({xStart,int(y+image.lens.parameters.radial.centre[1])}),
-                                                           arma::ivec2({xEnd,int(y+image.lens.parameters.radial.centre[1])}), dx);
-                
-                
-                insertSegments(classifiedImage, segments, false);
+                lines.push_back(Scanline { arma::ivec2({xStart,int(y+image.lens.parameters.radial.centre[1])}),
+                                           arma::ivec2({xEnd,int(y+image.lens.parameters.radial.centre[1])}), uint(dx) });
                 
                 
                 arma::mat ray = bulkPixel2Ray(arma::ivec2({0, int(y+image.lens.parameters.radial.centre[1])}).t(), image );
@@ -82,11 +83,16 @@ namespace modules {
                                                     0.4826, 
                                                     1.2 )[0];
                 dx = std::max(
-                        int(arcSize / 2.0 /image.lens.parameters.radial.pitch),
+                        int(scanPlan.sparsity * arcSize / 2.0 /image.lens.parameters.radial.pitch),
                         3);
                 
             }
 
+            // Then they are shared out in bands of rows
+            bands.scan(lines, classifiedImage.horizontalSegments, segmentPool, [&] (const Scanline& line) {
+                return classify(image, lut, line.start, line.end, line.subsample);
+            }, [] (const size_t&, const std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment>&) {});
+
         }
 
     }  // vision
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "BandScanner.h"
+
+#include <algorithm>
+
+namespace modules {
+    namespace vision {
+
+        std::vector<size_t> BandScanner::bands(const std::vector<Scanline>& lines, const uint& bands, const size_t& minimumSamples) {
+
+            std::vector<size_t> samples(lines.size());
+            size_t total = 0;
+            for(size_t i = 0; i < lines.size(); ++i) {
+                samples[i] = ScanScheduler::samples(lines[i]);
+                total += samples[i];
+            }
+
+            // Only split as far as the work allows, there is no point waking a thread for a handful of samples
+            size_t count = std::min<size_t>(bands, lines.size());
+            count = std::min(count, total / std::max<size_t>(1, minimumSamples));
+            count = std::max<size_t>(1, count);
+
+            // Cut where the running total passes each equal share, skipping cuts a long line has already passed
+            std::vector<size_t> borders = { 0 };
+            size_t sum = 0;
+            for(size_t i = 0; i < lines.size() && borders.size() < count; ++i) {
+                sum += samples[i];
+                if(sum * count >= total * borders.size() && i + 1 < lines.size()) {
+                    borders.push_back(i + 1);
+                }
+            }
+            borders.push_back(lines.size());
+
+            return borders;
+        }
+
+    }  // vision
+}  // modules
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_VISION_BANDSCANNER_H
+#define MODULES_VISION_BANDSCANNER_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "messages/vision/SegmentStore.h"
+#include "utility/parallel/WorkerPool.h"
+
+#include "ScanScheduler.h"
+
+namespace modules {
+    namespace vision {
+
+        /**
+         * Classifies a set of scanlines on several threads.
+         *
+         * The lines are split into bands of whole, consecutive lines (column ranges for vertical scans and row ranges
+         * for horizontal ones) holding about the same number of samples. Each band is lexed into its own store and the
+         * stores are appended in band order, so the result is exactly what classifying the lines in order on one
+         * thread gives. Lines are never cut at a band border since the lexer looks well past a pixel to decide what
+         * it is, a line split in two would not lex the same.
+         */
+        class BandScanner {
+        public:
+            BandScanner() : threads(1), minimumBandSamples(20000) {}
+
+            /**
+             * Where each band starts in lines followed by the end of the last one, making at most the given number of
+             * bands and none (except a lone band) with fewer than minimumSamples samples
+             */
+            static std::vector<size_t> bands(const std::vector<Scanline>& lines, const uint& bands, const size_t& minimumSamples);
+
+            /**
+             * Classifies every line into target. classify(line) returns the line's segments and visit(index, segments)
+             * is called with them on the thread that classified it, before they are stored.
+             */
+            template <typename TClass, typename TClassify, typename TVisit>
+            void scan(const std::vector<Scanline>& lines
+                , messages::vision::SegmentStore<TClass>& target
+                , typename messages::vision::SegmentStore<TClass>::Pool& pool
+                , TClassify&& classify
+                , TVisit&& visit) const {
+
+                auto& workers = utility::parallel::WorkerPool::instance();
+                auto borders = bands(lines, threads == 0 ? workers.size() : threads, minimumBandSamples);
+                const size_t count = borders.size() - 1;
+
+                // A single band goes straight into the target without the copy
+                if(count <= 1) {
+                    for(size_t i = 0; i < lines.size(); ++i) {
+                        auto segments = classify(lines[i]);
+                        visit(i, segments);
+                        target.insertLine(segments.begin(), segments.end());
+                    }
+                    return;
+                }
+
+                std::vector<messages::vision::SegmentStore<TClass>> stores(count);
+
+                std::atomic<size_t> next(0);
+                std::exception_ptr error;
+                std::mutex errorMutex;
+
+                workers.run(uint(count), [&] (uint) {
+                    for(size_t band = next++; band < count; band = next++) {
+                        try {
+                            stores[band] = messages::vision::SegmentStore<TClass>(pool.acquire());
+
+                            for(size_t i = borders[band]; i < borders[band + 1]; ++i) {
+                                auto segments = classify(lines[i]);
+                                visit(i, segments);
+                                stores[band].insertLine(segments.begin(), segments.end());
+                            }
+                        }
+                        catch(...) {
+                            std::lock_guard<std::mutex> lock(errorMutex);
+                            if(!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                });
+
+                // Exceptions can't leave a worker thread so hand the first one back to the caller
+                if(error) {
+                    std::rethrow_exception(error);
+                }
+
+                // Stitch the bands back together in order, rebasing the links of each onto the ones before it
+                for(auto& store : stores) {
+                    target.append(store);
+                }
+            }
+
+            // The most threads to use, 0 for every thread in the worker pool
+            uint threads;
+
+            // Bands smaller than this aren't worth handing to another thread
+            size_t minimumBandSamples;
+        };
+
+    }  // vision
+}  // modules
+
+#endif  // MODULES_VISION_BANDSCANNER_H
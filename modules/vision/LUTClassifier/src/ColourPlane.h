@@ -0,0 +1,128 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_VISION_COLOURPLANE_H
+#define MODULES_VISION_COLOURPLANE_H
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "messages/input/Image.h"
+#include "messages/vision/LookUpTable.h"
+#include "messages/vision/PackedLookUpTable.h"
+#include "utility/parallel/WorkerPool.h"
+
+namespace modules {
+    namespace vision {
+
+        /**
+         * A whole frame classified through the LUT in a single pass.
+         *
+         * Every subsample'th pixel in each direction is classified, and a lookup returns the sample at or above and to the
+         * left of it (the coordinates are rounded down to a multiple of subsample, not to the nearest sample).
+         * The storage is kept between frames so it is only allocated when the image size changes. Large frames can be
+         * split into bands of rows that are classified on the worker pool, each output pixel only depends on its own
+         * input pixel so the bands need no stitching.
+         */
+        class ColourPlane {
+        public:
+            ColourPlane() : subsample(1), width(0), height(0), data() {}
+
+            template <int camID>
+            void classify(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, const uint& subsampling = 1, const uint& threads = 1) {
+
+                const messages::vision::Colour* table = lut.getRawData();
+                classifyWith(image, subsampling, threads, [&lut, table] (const uint8_t* pixel) {
+                    return table[lut.getLUTIndex(pixel)];
+                });
+            }
+
+            /**
+             * Classifies through a packed LUT, which stays in the cache where a large LookUpTable would not
+             */
+            template <int camID>
+            void classify(const messages::input::Image<camID>& image, const messages::vision::PackedLookUpTable& lut, const uint& subsampling = 1, const uint& threads = 1) {
+
+                classifyWith(image, subsampling, threads, [&lut] (const uint8_t* pixel) {
+                    return lut(pixel);
+                });
+            }
+
+            inline messages::vision::Colour operator()(const uint& x, const uint& y) const {
+                return data[(y / subsample) * width + (x / subsample)];
+            }
+
+            uint subsample;
+            uint width;
+            uint height;
+            std::vector<messages::vision::Colour> data;
+
+        private:
+            // Bands smaller than this many classified pixels aren't worth handing to another thread
+            static constexpr uint MINIMUM_BAND_PIXELS = 64 * 1024;
+
+            template <int camID, typename Lookup>
+            void classifyWith(const messages::input::Image<camID>& image, const uint& subsampling, const uint& threads, Lookup&& lookup) {
+
+                // Demosaic the whole frame once (or reuse it if someone already has) before the workers read it
+                const auto& pixels = image.demosaiced(threads);
+
+                subsample = std::max(1u, subsampling);
+                width = (image.width() + subsample - 1) / subsample;
+                height = (image.height() + subsample - 1) / subsample;
+                data.resize(width * height);
+
+                // Walk the demosaiced plane in memory order so each row is streamed through the cache once
+                const size_t step = subsample * 3;
+                auto classifyRows = [&] (uint first, uint last) {
+                    for(uint y = first; y < last; ++y) {
+
+                        const uint8_t* in = pixels(0, y * subsample);
+                        messages::vision::Colour* out = &data[y * width];
+
+                        for(uint x = 0; x < width; ++x, in += step) {
+                            out[x] = lookup(in);
+                        }
+                    }
+                };
+
+                auto& workers = utility::parallel::WorkerPool::instance();
+                uint bands = std::min(threads == 0 ? workers.size() : threads, std::max(1u, width * height / MINIMUM_BAND_PIXELS));
+                bands = std::max(1u, std::min(bands, height));
+
+                if(bands == 1) {
+                    classifyRows(0, height);
+                    return;
+                }
+
+                // Workers take the next band until there are none left (the lookups can't throw)
+                std::atomic<uint> next(0);
+                workers.run(bands, [&] (uint) {
+                    for(uint band = next++; band < bands; band = next++) {
+                        classifyRows(height * band / bands, height * (band + 1) / bands);
+                    }
+                });
+            }
+        };
+
+    }  // vision
+}  // modules
+
+#endif  // MODULES_VISION_COLOURPLANE_H
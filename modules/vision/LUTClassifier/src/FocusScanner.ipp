@@ -0,0 +1,99 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "LUTClassifier.h"
+#include "QuexClassifier.h"
+
+#include "utility/math/vision.h"
+
+namespace modules {
+    namespace vision {
+
+        using messages::input::Image;
+        using messages::vision::LookUpTable;
+        using messages::vision::ObjectClass;
+        using messages::vision::ClassifiedImage;
+
+        using utility::math::vision::projectWorldPointToScreen;
+        using utility::math::vision::screenToImage;
+
+        template <int camID>
+        void LUTClassifier::planScans(const std::shared_ptr<const std::vector<messages::vision::Ball<camID>>>& balls
+            , const std::shared_ptr<const messages::localisation::Ball>& ball
+            , ClassifiedImage<ObjectClass, camID>& classifiedImage) {
+
+            // Tell the planner about balls we haven't told it about yet (the same ones stay in the cache for many frames)
+            if(balls && (balls.owner_before(plannedBalls) || plannedBalls.owner_before(balls))) {
+
+                std::vector<ScanPlanner::Target> targets;
+                for(auto& b : *balls) {
+                    targets.push_back(ballTarget(b, FOCAL_LENGTH_PIXELS));
+                }
+
+                planner.detected(targets);
+                plannedBalls = balls;
+            }
+
+            std::vector<ScanPlanner::Target> expected;
+
+            // Where the localisation thinks the ball is, as long as it is in front of us
+            if(ball) {
+
+                auto& camToGround = classifiedImage.sensors->orientationCamToGround;
+
+                arma::vec3 position = { ball->position[0], ball->position[1], BALL_RADIUS };
+                arma::vec3 camera = camToGround.submat(0, 3, 2, 3);
+                arma::vec3 forward = camToGround.submat(0, 0, 2, 0);
+                double distance = arma::dot(position - camera, forward);
+
+                if(distance > BALL_RADIUS) {
+                    // Grow the ball by how unsure we are where it is
+                    double uncertainty = std::sqrt(std::max(0.0, arma::trace(ball->position_cov)));
+                    double radius = (BALL_RADIUS + SCAN_PLANNER_LOCALISATION_DEVIATIONS * uncertainty) * FOCAL_LENGTH_PIXELS / distance;
+
+                    arma::ivec2 centre = screenToImage(projectWorldPointToScreen(position, camToGround, FOCAL_LENGTH_PIXELS), classifiedImage.dimensions);
+                    expected.push_back(ScanPlanner::Target{ arma::vec2({ double(centre[0]), double(centre[1]) }), radius });
+                }
+            }
+
+            scanPlan = planner.plan(classifiedImage.dimensions, classifiedImage.horizon, expected);
+        }
+
+        template <int camID>
+        void LUTClassifier::scanFocus(const Image<camID>& image, const LookUpTable& lut, ClassifiedImage<ObjectClass, camID>& classifiedImage) {
+
+            // The planner only casts horizontal and vertical lines, each goes with the rest of its direction
+            std::vector<Scanline> horizontal;
+            std::vector<Scanline> vertical;
+
+            for(auto& line : scanPlan.focus) {
+                (line.start[0] == line.end[0] && line.start[1] != line.end[1] ? vertical : horizontal).push_back(line);
+            }
+
+            auto scan = [&] (const Scanline& line) {
+                return classify(image, lut, line.start, line.end, line.subsample);
+            };
+            auto ignore = [] (const size_t&, const std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment>&) {};
+
+            bands.scan(horizontal, classifiedImage.horizontalSegments, segmentPool, scan, ignore);
+            bands.scan(vertical, classifiedImage.verticalSegments, segmentPool, scan, ignore);
+        }
+
+    }  // vision
+}  // modules
@@ -70,7 +70,7 @@ namespace modules {
 
                     // Check our Y is within the bounds (no need to check the end since they are the same)
                     if(element(1) >= 0 && element(1) < int(image.height())) {
-                        auto segments = quex->classify(image, lut, { int(element(0)), int(element(1)) }, { int(element(2)), int(element(3)) });
+                        auto segments = classify(image, lut, { int(element(0)), int(element(1)) }, { int(element(2)), int(element(3)) });
                         newSegments.insert(newSegments.begin(), segments.begin(), segments.end());
                     }
                 }
@@ -49,7 +49,7 @@ namespace modules {
                 arma::ivec2 end = { int(image.width() - 1), y };
 
                 // Insert our segments
-                auto segments = quex->classify(image, lut, start, end, GOAL_SUBSAMPLING);
+                auto segments = classify(image, lut, start, end, GOAL_SUBSAMPLING);
                 insertSegments(classifiedImage, segments, false);
             }
         }
@@ -22,7 +22,12 @@
 #include "messages/input/Image.h"
 #include "messages/input/Sensors.h"
 #include "messages/vision/LookUpTable.h"
+#include "messages/vision/PackedLookUpTable.h"
+#include "messages/vision/ClassifierTiming.h"
+#include "messages/vision/VisionObjects.h"
+#include "messages/localisation/FieldObject.h"
 #include "messages/support/Configuration.h"
+#include "utility/vision/LookUpTableFile.h"
 
 #include "QuexClassifier.h"
 
@@ -36,8 +41,13 @@ namespace modules {
         using messages::input::Sensors;
         using messages::vision::LookUpTable;
         using messages::vision::SaveLookUpTable;
+        using messages::vision::PackedLookUpTable;
         using messages::vision::ObjectClass;
         using messages::vision::ClassifiedImage;
+        using messages::vision::SegmentStore;
+        using messages::vision::ClassifierTiming;
+        using messages::vision::Ball;
+        using LocalisationBall = messages::localisation::Ball;
         using messages::support::Configuration;
         using messages::support::SaveConfiguration;
 
@@ -48,12 +58,30 @@ namespace modules {
             fakeSensors->orientationCamToGround.eye();
             emit(std::move(fakeSensors));
 
+            // The table is fully loaded before it is emitted, so reactions still using the old one keep it until they finish
             on<Trigger<Configuration<LUTLocation>>>([this](const Configuration<LUTLocation>& config) {
-                emit(std::make_unique<LookUpTable>(config.config.as<LookUpTable>()));
+                emit(std::make_unique<LookUpTable>(utility::vision::loadLookUpTable(config.config)));
             });
 
+            // Write the table as a binary file, then point the config at it so it is reloaded from there
             on<Trigger<SaveLookUpTable>, With<LookUpTable>>([this](const SaveLookUpTable&, const LookUpTable& lut) {
-                emit(std::make_unique<SaveConfiguration>(SaveConfiguration{ LUTLocation::CONFIGURATION_PATH, YAML::Node(lut) }));
+                auto config = utility::vision::saveLookUpTableConfig(LUTLocation::TABLE_PATH, lut);
+                emit(std::make_unique<SaveConfiguration>(SaveConfiguration{ LUTLocation::CONFIGURATION_PATH, config }));
+            });
+
+            // Keep a packed copy of the LUT to classify the whole frame through (until it is packed we use the LUT)
+            on<Trigger<LookUpTable>, Options<Sync<LUTClassifier>>>([this](const LookUpTable& lut) {
+                packedLutCurrent = false;
+                if(CLASSIFY_ONCE_PACKED) {
+                    packLookUpTable(lut);
+                }
+            });
+
+            // Pack the LUT we already have if packing was just turned on, or it changed while packing was off
+            on<Trigger<Configuration<LUTClassifier>>, With<LookUpTable>, Options<Sync<LUTClassifier>>>([this](const Configuration<LUTClassifier>& config, const LookUpTable& lut) {
+                if(config["classify_once"]["packed_lut"].as<bool>() && !packedLutCurrent) {
+                    packLookUpTable(lut);
+                }
             });
 
             // Trigger the same function when either update
@@ -83,16 +111,62 @@ namespace modules {
                 BALL_MAXIMUM_VERTICAL_CLUSTER_SPACING = std::max(1, int(cam.focalLengthPixels * config["ball"]["maximum_vertical_cluster_spacing"].as<double>()));
                 BALL_HORIZONTAL_SUBSAMPLE_FACTOR = config["ball"]["horizontal_subsample_factor"].as<double>();
 
+                // Classify once
+                CLASSIFY_ONCE = config["classify_once"]["enabled"].as<bool>();
+                CLASSIFY_ONCE_SUBSAMPLING = std::max(1, config["classify_once"]["subsampling"].as<int>());
+                CLASSIFY_ONCE_PACKED = config["classify_once"]["packed_lut"].as<bool>();
+
+                // Parallel classification
+                bands.threads = config["parallel"]["threads"].as<uint>();
+                bands.minimumBandSamples = config["parallel"]["minimum_band_samples"].as<uint>();
+
+                // Scan planner
+                ScanPlanner::Settings settings;
+                settings.enabled = config["scan_planner"]["enabled"].as<bool>();
+                settings.latencyBudget = std::chrono::duration_cast<ScanPlanner::Duration>(std::chrono::duration<double, std::milli>(config["scan_planner"]["latency_budget"].as<double>()));
+                settings.focusShare = config["scan_planner"]["focus_share"].as<double>();
+                settings.focusedSparsity = config["scan_planner"]["focused_sparsity"].as<double>();
+                settings.maximumSparsity = config["scan_planner"]["maximum_sparsity"].as<double>();
+                settings.regionScale = config["scan_planner"]["region_scale"].as<double>();
+                settings.regionGrowth = cam.focalLengthPixels * config["scan_planner"]["region_growth"].as<double>();
+                settings.detectionMemory = config["scan_planner"]["detection_memory"].as<uint>();
+                settings.localisationWeight = config["scan_planner"]["localisation_weight"].as<double>();
+                settings.smoothing = config["scan_planner"]["latency_smoothing"].as<double>();
+                planner.configure(settings);
+                SCAN_PLANNER_LOCALISATION_DEVIATIONS = config["scan_planner"]["localisation_deviations"].as<double>();
+
                 // Camera settings
                 ALPHA = cam.pixelsToTanThetaFactor[1];
                 FOCAL_LENGTH_PIXELS = cam.focalLengthPixels;
             });
 
-            on<Trigger<Raw<Image<0>>>, With<LookUpTable>, With<Raw<Sensors>>, Options<Single>>("Classify Image", [this](
-                const std::shared_ptr<const Image<0>>& rawImage, const LookUpTable& lut, const std::shared_ptr<const Sensors>& sensors) {
+            on<Trigger<Raw<Image<0>>>
+             , With<LookUpTable>
+             , With<Optional<PackedLookUpTable>>
+             , With<Raw<Sensors>>
+             , With<Optional<std::vector<Ball<0>>>>
+             , With<Optional<LocalisationBall>>
+             , Options<Single>>("Classify Image", [this](
+                const std::shared_ptr<const Image<0>>& rawImage
+              , const LookUpTable& lut
+              , const std::shared_ptr<const PackedLookUpTable>& packedLut
+              , const std::shared_ptr<const Sensors>& sensors
+              , const std::shared_ptr<const std::vector<Ball<0>>>& balls
+              , const std::shared_ptr<const LocalisationBall>& ball) {
 
                 const auto& image = *rawImage;
 
+                // Time each stage so the cost of the pipeline can be broken down
+                auto timing = std::make_unique<ClassifierTiming>();
+                auto start = std::chrono::steady_clock::now();
+                auto stageStart = start;
+                auto lap = [&stageStart] {
+                    auto now = std::chrono::steady_clock::now();
+                    auto elapsed = now - stageStart;
+                    stageStart = now;
+                    return elapsed;
+                };
+
                 // Our classified image
                 auto classifiedImage = std::make_unique<ClassifiedImage<ObjectClass, 0>>();
 
@@ -105,11 +179,33 @@ namespace modules {
                 // Attach the image
                 classifiedImage->image = rawImage;
 
+                // Reuse the segment storage from a previous frame if it has been released
+                classifiedImage->horizontalSegments = SegmentStore<ObjectClass>(segmentPool.acquire());
+                classifiedImage->verticalSegments = SegmentStore<ObjectClass>(segmentPool.acquire());
+
+                // The stages are timed from here, setting up only counts towards the total
+                lap();
+
+                // Classify the whole frame in one pass so overlapping scans don't classify the same pixels again
+                if(CLASSIFY_ONCE && CLASSIFY_ONCE_PACKED && packedLut && packedLut->LUT_SIZE > 0) {
+                    plane.classify(image, *packedLut, CLASSIFY_ONCE_SUBSAMPLING, bands.threads);
+                }
+                else if(CLASSIFY_ONCE) {
+                    plane.classify(image, lut, CLASSIFY_ONCE_SUBSAMPLING, bands.threads);
+                }
+                timing->classifyOnce = lap();
+
                 // Find our horizon
                 findHorizon(image, lut, *classifiedImage);
+                timing->horizon = lap();
+
+                // Decide how densely to scan the rest of the frame (planning counts towards the focus scans)
+                planScans(balls, ball, *classifiedImage);
+                auto planning = lap();
 
                 // Find our visual horizon
                 findVisualHorizon(image, lut, *classifiedImage);
+                timing->visualHorizon = lap();
 
                 // Find our goals
                 // findGoals(image, lut, *classifiedImage);
@@ -119,16 +215,52 @@ namespace modules {
 
                 // Find our ball (also helps with the bottom of goals)
                 findBall(image, lut, *classifiedImage);
+                timing->ball = lap();
+
+                // Look closer where we expect to find things
+                scanFocus(image, lut, *classifiedImage);
+                timing->focus = planning + lap();
 
                 // Enhance our ball
                 enhanceBall(image, lut, *classifiedImage);
+                timing->ballEnhance = lap();
 
                 // Emit our classified image
                 emit(std::move(classifiedImage));
+
+                timing->total = std::chrono::steady_clock::now() - start;
+                planner.observe(timing->total, timing->focus);
+                emit(std::move(timing));
             });
 
         }
 
+        void LUTClassifier::packLookUpTable(const LookUpTable& lut) {
+
+            // Check the whole table first so a bad entry can't leave us classifying through the previous table's packing
+            if(PackedLookUpTable::canPack(lut)) {
+                emit(std::make_unique<PackedLookUpTable>(lut, PackedLookUpTable::Layout::MORTON));
+            }
+            else {
+                NUClear::log<NUClear::WARN>("The LUT holds colours that can't be packed, classifying through the unpacked LUT");
+
+                // An empty table replaces the stale one so frames go back to the LUT
+                emit(std::make_unique<PackedLookUpTable>());
+            }
+            packedLutCurrent = true;
+        }
+
+        template <int camID>
+        std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment> LUTClassifier::classify(const Image<camID>& image
+            , const LookUpTable& lut
+            , const arma::ivec2& start
+            , const arma::ivec2& end
+            , const uint& subsample) {
+
+            return CLASSIFY_ONCE ? quex->classify<camID>(plane, start, end, subsample)
+                                 : quex->classify(image, lut, start, end, subsample);
+        }
+
         LUTClassifier::~LUTClassifier() {
             // TODO work out how to fix pimpl and fix it damnit!!
             delete quex;
@@ -143,3 +275,4 @@ namespace modules {
 #include "GoalEnhancer.ipp"
 #include "BallFinder.ipp"
 #include "BallEnhancer.ipp"
+#include "FocusScanner.ipp"
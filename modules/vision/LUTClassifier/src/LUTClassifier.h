@@ -26,12 +26,20 @@
 #include "messages/input/Sensors.h"
 #include "messages/vision/ClassifiedImage.h"
 #include "messages/vision/LookUpTable.h"
+#include "messages/vision/VisionObjects.h"
+#include "messages/localisation/FieldObject.h"
+
+#include "BandScanner.h"
+#include "ColourPlane.h"
+#include "ScanPlanner.h"
 
 namespace modules {
     namespace vision {
 
         struct LUTLocation {
             static constexpr const char* CONFIGURATION_PATH = "LookUpTable.yaml";
+            // The binary table the config points to once a LUT has been saved
+            static constexpr const char* TABLE_PATH = "LookUpTable.lut";
         };
 
         class QuexClassifier;
@@ -46,6 +54,29 @@ namespace modules {
             // A pointer to our quex class (since it is generated it is not defined at this point)
             QuexClassifier* quex;
 
+            // The whole frame classified up front when we are classifying once
+            ColourPlane plane;
+
+            // Segment storage that is handed back once the classified images using it are gone
+            messages::vision::SegmentStore<messages::vision::ObjectClass>::Pool segmentPool;
+
+            // Shares the scanlines of each stage out between threads
+            BandScanner bands;
+
+            // Decides how densely to scan each frame, and its plan for the frame being classified
+            ScanPlanner planner;
+            ScanPlan scanPlan;
+
+            // The last detections we gave the planner, so the same ones aren't given again on later frames
+            std::weak_ptr<const std::vector<messages::vision::Ball<0>>> plannedBalls;
+
+            bool CLASSIFY_ONCE = false;
+            uint CLASSIFY_ONCE_SUBSAMPLING = 1;
+            bool CLASSIFY_ONCE_PACKED = false;
+
+            // If the packed LUT we last emitted was made from the current LUT (it is empty if the LUT couldn't be packed)
+            bool packedLutCurrent = false;
+
             int VISUAL_HORIZON_SPACING = 100;
             int VISUAL_HORIZON_BUFFER = 0;
             uint VISUAL_HORIZON_MINIMUM_SEGMENT_SIZE = 0;
@@ -66,32 +97,42 @@ namespace modules {
             double FOCAL_LENGTH_PIXELS = 2.0;
             double ALPHA = 2.0;
 
+            double SCAN_PLANNER_LOCALISATION_DEVIATIONS = 2.0;
+
+            /**
+             * Emits a packed copy of the LUT, or an empty one if the LUT can't be packed
+             */
+            void packLookUpTable(const messages::vision::LookUpTable& lut);
+
             template <int camID>
             void insertSegments(messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& image
                 , std::vector<typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment>& segments
                 , bool vertical) {
 
-                typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment* previous = nullptr;
-                typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment* current = nullptr;
-
                 auto& target = vertical ? image.verticalSegments : image.horizontalSegments;
 
-                for (auto& s : segments) {
-
-                    // Move in the data
-                    current = &(target.insert(std::make_pair(s.colour, std::move(s)))->second);
-
-                    // Link up the results
-                    current->previous = previous;
-                    if(previous) {
-                        previous->next = current;
-                    }
-
-                    // Get ready for our next one
-                    previous = current;
-                }
+                // Copy in the data and link up the results
+                target.insertLine(segments.begin(), segments.end());
             }
 
+            /**
+             * Classifies a line, reading from the classified plane when we are classifying once and from the image otherwise
+             */
+            template <int camID>
+            std::vector<typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment> classify(const messages::input::Image<camID>& image
+                , const messages::vision::LookUpTable& lut
+                , const arma::ivec2& start
+                , const arma::ivec2& end
+                , const uint& subsample = 1);
+
+            /**
+             * Plans how densely to scan this frame from the last frame's balls and where the localisation expects the ball
+             */
+            template <int camID>
+            void planScans(const std::shared_ptr<const std::vector<messages::vision::Ball<camID>>>& balls
+                , const std::shared_ptr<const messages::localisation::Ball>& ball
+                , messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& classifiedImage);
+
             template <int camID>
             void findHorizon(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& classifiedImage);
 
@@ -104,6 +145,12 @@ namespace modules {
             template <int camID>
             void findGoals(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& classifiedImage);
 
+            /**
+             * Scans the regions of interest the planner chose for this frame
+             */
+            template <int camID>
+            void scanFocus(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& classifiedImage);
+
             template <int camID>
             void enhanceBall(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>& classifiedImage);
 
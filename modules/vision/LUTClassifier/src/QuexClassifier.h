@@ -30,17 +30,32 @@
 #include "messages/input/Image.h"
 #include "messages/vision/LookUpTable.h"
 #include "messages/vision/ClassifiedImage.h"
+#include "ColourPlane.h"
 
 namespace modules {
     namespace vision {
         class QuexClassifier {
-        private:
+        public:
+            // The most samples (plus two for the lexer) a line can have, longer lines are cut short
             static constexpr size_t BUFFER_SIZE = 2000;
 
+        private:
+            template <int camID, typename Sampler>
+            std::vector<typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment> lex(const Sampler& sample, const arma::ivec2& start, const arma::ivec2& end, const uint& subsample);
 
         public:
+            /**
+             * Classifies the line from start to end, taking a sample every stratification pixels along its major axis.
+             * Lines can run in any direction and at any angle (angled lines step their minor axis Bresenham style).
+             * Segments run from their first sample to the sample after their last, and their length counts pixels
+             * along the major axis.
+             */
             template <int camID>
             std::vector<typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment> classify(const messages::input::Image<camID>& image, const messages::vision::LookUpTable& lut, const arma::ivec2& start, const arma::ivec2& end, const uint& stratification = 1);
+
+            // Classifies a line by reading an already classified plane rather then the image
+            template <int camID>
+            std::vector<typename messages::vision::ClassifiedImage<messages::vision::ObjectClass, camID>::Segment> classify(const ColourPlane& plane, const arma::ivec2& start, const arma::ivec2& end, const uint& stratification = 1);
         };
     }
 }
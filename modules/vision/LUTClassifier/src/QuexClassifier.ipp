@@ -19,6 +19,8 @@
 
 #include "QuexClassifier.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 namespace modules {
@@ -31,6 +33,18 @@ namespace modules {
 
         template <int camID>
         std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment> QuexClassifier::classify(const Image<camID>& image, const LookUpTable& lut, const arma::ivec2& start, const arma::ivec2& end, const uint& subsample) {
+            return lex<camID>([&image, &lut] (const uint& x, const uint& y) {
+                return lut(image(x, y));
+            }, start, end, subsample);
+        }
+
+        template <int camID>
+        std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment> QuexClassifier::classify(const ColourPlane& plane, const arma::ivec2& start, const arma::ivec2& end, const uint& subsample) {
+            return lex<camID>(plane, start, end, subsample);
+        }
+
+        template <int camID, typename Sampler>
+        std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment> QuexClassifier::lex(const Sampler& sample, const arma::ivec2& start, const arma::ivec2& end, const uint& subsample) {
             // Setup useful things
             uint8_t buffer[BUFFER_SIZE];
             quex::Lexer lexer(buffer, BUFFER_SIZE, buffer + 1);
@@ -39,80 +53,108 @@ namespace modules {
             // Start reading data
             lexer.buffer_fill_region_prepare();
 
-            // For vertical runs
-            if(start[0] == end[0]) {
+            // Walk the line a subsample at a time along its major axis, stepping the minor axis Bresenham style
+            const int dx = end[0] - start[0];
+            const int dy = end[1] - start[1];
+            const bool xMajor = std::abs(dx) >= std::abs(dy);
+            const int major = xMajor ? std::abs(dx) : std::abs(dy);
+            const int minor = xMajor ? std::abs(dy) : std::abs(dx);
+            const int majorStep = (xMajor ? dx : dy) < 0 ? -int(subsample) : int(subsample);
+            const int minorSign = (xMajor ? dy : dx) < 0 ? -1 : 1;
 
-                size_t length = end[1] - start[1] + 1;
+            // Leave room in the buffer for the lexer's start and end markers
+            const size_t samples = std::min(size_t(major + 1) / subsample, BUFFER_SIZE - 2);
 
-                for(uint i = 0; i < length / subsample; ++i) {
-                    buffer[i + 1] = lut(image(start[0], start[1] + (i * subsample)));
+            // For vertical runs
+            if(dx == 0) {
+                for(uint i = 0; i < samples; ++i) {
+                    buffer[i + 1] = sample(start[0], start[1] + int(i) * majorStep);
                 }
-
-                lexer.buffer_fill_region_finish(length / subsample);
             }
 
             // For horizontal runs
-            else if(start[1] == end[1]) {
-
-                size_t length = end[0] - start[0] + 1;
-
-                for(uint i = 0; i < length / subsample; ++i) {
-                    buffer[i + 1] = lut(image(start[0] + (i * subsample), start[1]));
+            else if(dy == 0) {
+                for(uint i = 0; i < samples; ++i) {
+                    buffer[i + 1] = sample(start[0] + int(i) * majorStep, start[1]);
                 }
-
-                lexer.buffer_fill_region_finish(length / subsample);
             }
 
-            // Diagonal run
+            // Diagonal and other angled runs
             else {
-                // TODO not implemented (and probably won't implement)
+                // Each sample moves subsample pixels along the major axis and (whole + fraction / major) along the minor
+                const int whole = (int(subsample) * minor) / major;
+                const int fraction = (int(subsample) * minor) % major;
+
+                int a = xMajor ? start[0] : start[1];
+                int b = xMajor ? start[1] : start[0];
+                int error = major / 2;
+
+                for(uint i = 0; i < samples; ++i) {
+                    buffer[i + 1] = xMajor ? sample(a, b) : sample(b, a);
+
+                    a += majorStep;
+                    b += minorSign * whole;
+                    error += fraction;
+                    if(error >= major) {
+                        b += minorSign;
+                        error -= major;
+                    }
+                }
             }
 
+            lexer.buffer_fill_region_finish(samples);
+
             // Our output
             std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment> output;
             output.reserve(64);
 
-            // Our vector of position
-            arma::ivec2 position = start;
+            // Where the given sample along the line is (the same rounding as the walk above)
+            auto pointAt = [&] (const size_t& i) {
+                const int along = int(i) * majorStep;
+                const int across = major == 0 ? 0 : minorSign * int((int64_t(i) * subsample * minor + major / 2) / major);
+
+                return xMajor ? arma::ivec2({ start[0] + along, start[1] + across })
+                              : arma::ivec2({ start[0] + across, start[1] + along });
+            };
 
-            // A reference to the relevant movement direction
-            int& movement = start[1] == end[1] ? position[0] : position[1];
+            size_t sampled = 0;
 
             for(uint32_t typeID = lexer.receive(); typeID != QUEX_TKN_TERMINATION; typeID = lexer.receive()) {
 
-                // Update our position
-                arma::ivec2 s = position;
+                // Update our position, segments run from their first sample to the sample after their last
+                arma::ivec2 s = pointAt(sampled);
+                sampled += tknNumber;
+                arma::ivec2 position = pointAt(sampled);
                 uint len = tknNumber * subsample;
-                movement += len;
                 arma::ivec2 m = (s + position) / 2;
 
                 switch(typeID) {
                     case QUEX_TKN_FIELD:
-                        output.push_back({ObjectClass::FIELD, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::FIELD, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_BALL:
-                        output.push_back({ObjectClass::BALL, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::BALL, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_GOAL:
-                        output.push_back({ObjectClass::GOAL, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::GOAL, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_LINE:
-                        output.push_back({ObjectClass::LINE, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::LINE, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_CYAN_TEAM:
-                        output.push_back({ObjectClass::CYAN_TEAM, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::CYAN_TEAM, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_MAGENTA_TEAM:
-                        output.push_back({ObjectClass::MAGENTA_TEAM, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::MAGENTA_TEAM, len, subsample, s, position, m});
                         break;
 
                     case QUEX_TKN_UNCLASSIFIED:
-                        output.push_back({ObjectClass::UNKNOWN, len, subsample, s, position, m, nullptr, nullptr});
+                        output.push_back({ObjectClass::UNKNOWN, len, subsample, s, position, m});
                         break;
                 }
             }
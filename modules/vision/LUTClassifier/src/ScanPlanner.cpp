@@ -0,0 +1,189 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "ScanPlanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace modules {
+    namespace vision {
+
+        using utility::math::geometry::Line;
+
+        ScanPlanner::ScanPlanner() : ScanPlanner(Settings()) {
+        }
+
+        ScanPlanner::ScanPlanner(const Settings& settings)
+            : settings(settings)
+            , focusScheduler({ { 0, 1 }, { M_PI / 2, 1 } }) {
+        }
+
+        void ScanPlanner::configure(const Settings& newSettings) {
+            settings = newSettings;
+        }
+
+        void ScanPlanner::detected(const std::vector<Target>& targets) {
+
+            // Losing sight of something for a frame doesn't mean it is gone, so keep looking where it was
+            if(targets.empty()) {
+                return;
+            }
+
+            std::vector<Track> updated;
+            for(auto& target : targets) {
+                Track track = { target, arma::zeros(2), 0 };
+
+                // Work out how fast it is moving from the previous detection that was closest, if it could be the same
+                double closest = std::numeric_limits<double>::max();
+                for(auto& previous : tracks) {
+                    double distance = arma::norm(target.centre - previous.target.centre);
+                    double reach = previous.target.radius * settings.regionScale + settings.regionGrowth * previous.age;
+
+                    if(previous.age > 0 && distance < closest && distance <= reach) {
+                        closest = distance;
+                        track.velocity = (target.centre - previous.target.centre) / double(previous.age);
+                    }
+                }
+
+                updated.push_back(track);
+            }
+            tracks = std::move(updated);
+        }
+
+        ScanPlan ScanPlanner::plan(const arma::uvec2& dimensions, const Line& horizon, const std::vector<Target>& expected) {
+
+            ScanPlan result;
+            sparsity = 1;
+            focusSamples = 0;
+
+            if(!settings.enabled || dimensions[0] == 0 || dimensions[1] == 0) {
+                return result;
+            }
+
+            struct Region {
+                arma::ivec2 topLeft;
+                arma::ivec2 bottomRight;
+                double weight;
+            };
+            std::vector<Region> regions;
+
+            auto addRegion = [&] (const Target& target, const double& radius, const double& weight) {
+
+                arma::ivec2 topLeft = { std::max(int(std::floor(target.centre[0] - radius)), 0)
+                                      , std::max(int(std::floor(target.centre[1] - radius)), 0) };
+                arma::ivec2 bottomRight = { std::min(int(std::ceil(target.centre[0] + radius)), int(dimensions[0] - 1))
+                                          , std::min(int(std::ceil(target.centre[1] + radius)), int(dimensions[1] - 1)) };
+
+                // Off the screen
+                if(weight <= 0 || topLeft[0] > bottomRight[0] || topLeft[1] > bottomRight[1]) {
+                    return;
+                }
+
+                // Objects rest on the ground so nothing entirely above the horizon is worth scanning
+                if(!horizon.isVertical() && bottomRight[1] < std::min(horizon.y(topLeft[0]), horizon.y(bottomRight[0]))) {
+                    return;
+                }
+
+                regions.push_back(Region{ topLeft, bottomRight, weight });
+            };
+
+            // Detections move on to where they are heading, and get less certain and their regions grow as they age
+            for(auto& track : tracks) {
+                Target predicted = { track.target.centre + track.velocity * double(track.age + 1), track.target.radius };
+
+                addRegion(predicted
+                        , track.target.radius * settings.regionScale + settings.regionGrowth * track.age
+                        , 1.0 - double(track.age) / double(settings.detectionMemory + 1));
+            }
+            for(auto& target : expected) {
+                addRegion(target, target.radius * settings.regionScale, settings.localisationWeight);
+            }
+
+            // Age our tracks and forget the ones we haven't seen for too long
+            for(auto& track : tracks) {
+                ++track.age;
+            }
+            tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this] (const Track& track) {
+                return track.age > settings.detectionMemory;
+            }), tracks.end());
+
+            const double budgetSeconds = std::chrono::duration<double>(settings.latencyBudget).count();
+            const bool focusing = !regions.empty();
+
+            // How sure we are of the best region, as a detection goes stale the coarse scans get their time back
+            double confidence = 0;
+            for(auto& region : regions) {
+                confidence = std::max(confidence, std::min(region.weight, 1.0));
+            }
+
+            // Back off the coarse scans while we know where to look, and further if they alone won't fit in their share
+            const double coarseBudget = budgetSeconds * (1.0 - settings.focusShare * confidence);
+            double target = 1.0 + (settings.focusedSparsity - 1.0) * confidence;
+            if(coarseBudget > 0) {
+                target = std::max(target, coarseCost / coarseBudget);
+            }
+            sparsity = std::max(1.0, std::min(target, settings.maximumSparsity));
+            result.sparsity = sparsity;
+
+            if(!focusing) {
+                return result;
+            }
+
+            // Whatever time the coarse scans leave is spent on the regions, shared by how much we expect to find there
+            const double remaining = std::max(0.0, budgetSeconds - coarseCost / sparsity);
+            const size_t budget = size_t(remaining * focusRate);
+
+            double totalWeight = 0;
+            for(auto& region : regions) {
+                totalWeight += region.weight;
+            }
+
+            for(auto& region : regions) {
+                auto lines = focusScheduler.schedule(region.topLeft, region.bottomRight, size_t(budget * region.weight / totalWeight));
+                for(auto& line : lines) {
+                    focusSamples += ScanScheduler::samples(line);
+                }
+                result.focus.insert(result.focus.end(), lines.begin(), lines.end());
+            }
+
+            return result;
+        }
+
+        void ScanPlanner::observe(const Duration& total, const Duration& focus) {
+
+            if(!settings.enabled) {
+                return;
+            }
+
+            const double totalSeconds = std::chrono::duration<double>(total).count();
+            const double focusSeconds = std::chrono::duration<double>(focus).count();
+
+            // Put the coarse scans' latency in terms of a sparsity of 1 so it can be scaled to whatever we choose next
+            const double coarse = std::max(0.0, totalSeconds - focusSeconds) * sparsity;
+            coarseCost = coarseCost == 0 ? coarse : coarseCost + settings.smoothing * (coarse - coarseCost);
+
+            if(focusSamples > 0 && focusSeconds > 0) {
+                focusRate += settings.smoothing * (focusSamples / focusSeconds - focusRate);
+            }
+        }
+
+    }  // vision
+}  // modules
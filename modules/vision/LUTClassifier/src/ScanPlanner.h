@@ -0,0 +1,150 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_VISION_SCANPLANNER_H
+#define MODULES_VISION_SCANPLANNER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <armadillo>
+
+#include "messages/vision/VisionObjects.h"
+#include "utility/math/geometry/Line.h"
+
+#include "ScanScheduler.h"
+
+namespace modules {
+    namespace vision {
+
+        /**
+         * How densely to scan one frame
+         */
+        struct ScanPlan {
+            // Multiplies the configured spacing of the coarse scans (1 scans them as configured)
+            double sparsity = 1;
+
+            // Extra lines over the regions objects are expected in
+            std::vector<Scanline> focus;
+        };
+
+        /**
+         * Plans how densely each frame is scanned from where objects were last seen and how long frames are taking.
+         *
+         * Recent detections and the localisation's estimate become regions of interest that get their own dense
+         * horizontal and vertical lines, while the coarse scans over the rest of the frame back off. The planner
+         * watches its own latency and trades coarse density and focus samples against each other to keep each frame
+         * within its time budget.
+         */
+        class ScanPlanner {
+        public:
+            using Duration = std::chrono::steady_clock::duration;
+
+            struct Settings {
+                // Plan anything at all (otherwise every plan scans as configured)
+                bool enabled = false;
+                // How long we want to spend on a frame
+                Duration latencyBudget = std::chrono::milliseconds(10);
+                // The share of the budget kept for regions of interest when there are any
+                double focusShare = 0.3;
+                // How much the coarse scan spacing is multiplied by while we have regions of interest
+                double focusedSparsity = 1.5;
+                // The most the coarse scan spacing is multiplied by to keep within the budget
+                double maximumSparsity = 3;
+                // How many times the object's radius the region scanned around it is
+                double regionScale = 2;
+                // How many pixels the region around a detection grows for each frame it is not seen again
+                double regionGrowth = 8;
+                // How many frames a detection is scanned around after it was last seen
+                uint detectionMemory = 10;
+                // How much a region from the localisation counts compared to a fresh detection
+                double localisationWeight = 0.5;
+                // How quickly the latency estimates follow new frames (0 never moves, 1 is only the last frame)
+                double smoothing = 0.2;
+            };
+
+            // An object on the screen in image coordinates
+            struct Target {
+                arma::vec2 centre;
+                double radius;
+            };
+
+            ScanPlanner();
+            explicit ScanPlanner(const Settings& settings);
+
+            void configure(const Settings& settings);
+
+            /**
+             * Replaces what we are tracking with the objects detected in the last frame, taking their velocity from the
+             * nearest previous detection. When nothing was detected the previous detections are kept until they are too
+             * old.
+             */
+            void detected(const std::vector<Target>& targets);
+
+            /**
+             * Plans the next frame. Regions entirely above the horizon (in image coordinates) are dropped, and the
+             * expected targets (for example from localisation) are scanned for alongside the detections.
+             */
+            ScanPlan plan(const arma::uvec2& dimensions, const utility::math::geometry::Line& horizon, const std::vector<Target>& expected = {});
+
+            /**
+             * Tells the planner how long the frame it last planned took, and how much of that was spent on its regions
+             * of interest.
+             */
+            void observe(const Duration& total, const Duration& focus);
+
+        private:
+            struct Track {
+                Target target;
+                // Pixels per frame
+                arma::vec2 velocity;
+                // Frames since it was detected
+                uint age;
+            };
+
+            Settings settings;
+            ScanScheduler focusScheduler;
+
+            std::vector<Track> tracks;
+
+            // The sparsity of the last plan and the samples it spent on regions of interest
+            double sparsity = 1;
+            size_t focusSamples = 0;
+
+            // The coarse scans' latency in seconds as if they were run at a sparsity of 1 (they cost about 1 / sparsity)
+            double coarseCost = 0;
+            // How many focus samples we classify per second (a guess until we have measured it)
+            double focusRate = 50e6;
+        };
+
+        /**
+         * Where a detected ball is on the screen. Detectors don't agree on what the circle's radius is measured in
+         * (BuoyDetector's is the cosine of the ball's angular radius), so its size in pixels comes from its angular size.
+         */
+        template <int camID>
+        ScanPlanner::Target ballTarget(const messages::vision::Ball<camID>& ball, const double& focalLengthPixels) {
+            double angularRadius = std::max(ball.angularSize[0], ball.angularSize[1]) / 2;
+            return ScanPlanner::Target{ ball.circle.centre, focalLengthPixels * std::tan(angularRadius) };
+        }
+
+    }  // vision
+}  // modules
+
+#endif  // MODULES_VISION_SCANPLANNER_H
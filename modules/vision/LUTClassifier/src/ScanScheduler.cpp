@@ -0,0 +1,186 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "ScanScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "QuexClassifier.h"
+
+namespace modules {
+    namespace vision {
+
+        namespace {
+
+            // Calls f with each line at angle across the region, so they can be counted without storing them
+            template <typename F>
+            void forEachLine(const arma::ivec2& topLeft, const arma::ivec2& bottomRight, const double& angle, const double& spacing, const uint& subsample, F&& f) {
+
+                const double x0 = topLeft[0];
+                const double y0 = topLeft[1];
+                const double x1 = bottomRight[0];
+                const double y1 = bottomRight[1];
+
+                // Direction along the lines and the normal we space them out along
+                const double dx = std::cos(angle);
+                const double dy = std::sin(angle);
+                const double nx = -dy;
+                const double ny = dx;
+
+                // The range of offsets the region's corners cover along the normal
+                double low = std::numeric_limits<double>::max();
+                double high = std::numeric_limits<double>::lowest();
+                for(double x : { x0, x1 }) {
+                    for(double y : { y0, y1 }) {
+                        low = std::min(low, x * nx + y * ny);
+                        high = std::max(high, x * nx + y * ny);
+                    }
+                }
+
+                // Centre the lines in the range so the edges get the same margin
+                const double span = high - low;
+                const int count = int(span / spacing) + 1;
+                const double first = low + (span - (count - 1) * spacing) / 2;
+
+                for(int i = 0; i < count; ++i) {
+                    const double offset = first + i * spacing;
+
+                    // A point on the line, then clip the line to the region
+                    const double px = offset * nx;
+                    const double py = offset * ny;
+
+                    double tMin = std::numeric_limits<double>::lowest();
+                    double tMax = std::numeric_limits<double>::max();
+                    bool inside = true;
+
+                    for(int axis = 0; axis < 2; ++axis) {
+                        const double p = axis == 0 ? px : py;
+                        const double d = axis == 0 ? dx : dy;
+                        const double lo = axis == 0 ? x0 : y0;
+                        const double hi = axis == 0 ? x1 : y1;
+
+                        if(std::abs(d) < 1e-9) {
+                            inside &= p >= lo - 0.5 && p <= hi + 0.5;
+                        }
+                        else {
+                            double a = (lo - p) / d;
+                            double b = (hi - p) / d;
+                            tMin = std::max(tMin, std::min(a, b));
+                            tMax = std::min(tMax, std::max(a, b));
+                        }
+                    }
+
+                    if(!inside || tMin > tMax) {
+                        continue;
+                    }
+
+                    auto clamp = [] (double v, double lo, double hi) {
+                        return int(std::lround(std::max(lo, std::min(hi, v))));
+                    };
+
+                    Scanline line;
+                    line.start = { clamp(px + tMin * dx, x0, x1), clamp(py + tMin * dy, y0, y1) };
+                    line.end = { clamp(px + tMax * dx, x0, x1), clamp(py + tMax * dy, y0, y1) };
+                    line.subsample = subsample;
+                    f(line);
+                }
+            }
+        }
+
+        ScanScheduler::ScanScheduler(const std::vector<Orientation>& orientations, const uint& subsample)
+            : orientations(orientations)
+            , subsample(std::max(1u, subsample)) {
+        }
+
+        size_t ScanScheduler::samples(const Scanline& line) {
+            int major = std::max(std::abs(line.end[0] - line.start[0]), std::abs(line.end[1] - line.start[1]));
+            return std::min(size_t(major + 1) / line.subsample, QuexClassifier::BUFFER_SIZE - 2);
+        }
+
+        std::vector<Scanline> ScanScheduler::parallelLines(const arma::ivec2& topLeft, const arma::ivec2& bottomRight, const double& angle, const double& spacing, const uint& subsample) {
+
+            std::vector<Scanline> lines;
+            forEachLine(topLeft, bottomRight, angle, spacing, subsample, [&lines] (const Scanline& line) {
+                lines.push_back(line);
+            });
+            return lines;
+        }
+
+        std::vector<Scanline> ScanScheduler::schedule(const arma::ivec2& topLeft, const arma::ivec2& bottomRight, const size_t& budget) const {
+
+            std::vector<Scanline> output;
+
+            double totalWeight = 0;
+            for(auto& o : orientations) {
+                totalWeight += o.weight;
+            }
+
+            if(totalWeight <= 0) {
+                return output;
+            }
+
+            const double diagonal = std::hypot(bottomRight[0] - topLeft[0], bottomRight[1] - topLeft[1]) + 1;
+
+            for(auto& o : orientations) {
+
+                const size_t share = size_t(budget * o.weight / totalWeight);
+
+                auto total = [&] (const double& spacing) {
+                    size_t sum = 0;
+                    forEachLine(topLeft, bottomRight, o.angle, spacing, subsample, [&sum] (const Scanline& line) {
+                        sum += samples(line);
+                    });
+                    return sum;
+                };
+
+                // Find the closest spacing that fits in our share (wider spacing means fewer samples), to within 1%
+                double lo = 1;
+                double hi = diagonal;
+
+                if(total(hi) > share) {
+                    continue;
+                }
+
+                if(total(lo) <= share) {
+                    hi = lo;
+                }
+
+                for(int i = 0; i < 24 && hi > lo * 1.01; ++i) {
+                    double mid = (lo + hi) / 2;
+
+                    if(total(mid) <= share) {
+                        hi = mid;
+                    }
+                    else {
+                        lo = mid;
+                    }
+                }
+
+                forEachLine(topLeft, bottomRight, o.angle, hi, subsample, [&output] (const Scanline& line) {
+                    output.push_back(line);
+                });
+            }
+
+            return output;
+        }
+
+    }  // vision
+}  // modules
@@ -0,0 +1,77 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MODULES_VISION_SCANSCHEDULER_H
+#define MODULES_VISION_SCANSCHEDULER_H
+
+#include <vector>
+#include <armadillo>
+
+namespace modules {
+    namespace vision {
+
+        /**
+         * A line to classify, sampled every subsample pixels along its major axis
+         */
+        struct Scanline {
+            arma::ivec2 start;
+            arma::ivec2 end;
+            uint subsample;
+        };
+
+        /**
+         * Shares a fixed number of samples per frame between scanlines at several orientations.
+         *
+         * Each orientation gets a share of the budget by its weight and covers the region with evenly spaced parallel
+         * lines, as close together as its share allows. Angles are in radians from the image's x axis towards its y
+         * axis, so 0 scans horizontally and pi/2 vertically.
+         */
+        class ScanScheduler {
+        public:
+            struct Orientation {
+                double angle;
+                double weight;
+            };
+
+            ScanScheduler(const std::vector<Orientation>& orientations, const uint& subsample = 1);
+
+            /**
+             * Plans the scanlines for the region between topLeft and bottomRight (inclusive) using at most budget samples
+             */
+            std::vector<Scanline> schedule(const arma::ivec2& topLeft, const arma::ivec2& bottomRight, const size_t& budget) const;
+
+            /**
+             * The scanlines at angle across the region, spacing pixels apart
+             */
+            static std::vector<Scanline> parallelLines(const arma::ivec2& topLeft, const arma::ivec2& bottomRight, const double& angle, const double& spacing, const uint& subsample);
+
+            /**
+             * The number of samples QuexClassifier takes along a line
+             */
+            static size_t samples(const Scanline& line);
+
+        private:
+            std::vector<Orientation> orientations;
+            uint subsample;
+        };
+
+    }  // vision
+}  // modules
+
+#endif  // MODULES_VISION_SCANSCHEDULER_H
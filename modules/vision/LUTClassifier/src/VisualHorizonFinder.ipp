@@ -34,100 +34,74 @@ namespace modules {
             // Get some local references to class variables to make text shorter
             auto& horizon = classifiedImage.horizon;
             auto& visualHorizon = classifiedImage.visualHorizon;
-            auto& maxVisualHorizon = classifiedImage.maxVisualHorizon;
-            auto& minVisualHorizon = classifiedImage.minVisualHorizon;
 
-            // Cast lines to find our visual horizon
-            for(uint x = 0; x < image.width(); x += VISUAL_HORIZON_SPACING) {
+            // Spread our lines out further when the scan planner is backing off
+            const int spacing = std::max(1, int(lround(VISUAL_HORIZON_SPACING * scanPlan.sparsity)));
 
-                // Find our point to classify from (slightly above the horizon)
+            // A line from slightly above the horizon to the bottom of the screen
+            auto line = [&] (const uint& x) {
                 int top = std::max(int(lround(horizon.y(x)) - VISUAL_HORIZON_BUFFER), int(0));
                 top = std::min(top, int(image.height() - 1));
 
-                // Classify our segments
-                auto segments = quex->classify(image, lut, { int(x), top }, { int(x), int(image.height() - 1) }, VISUAL_HORIZON_SUBSAMPLING);
+                return Scanline { { int(x), top }, { int(x), int(image.height() - 1) }, uint(VISUAL_HORIZON_SUBSAMPLING) };
+            };
 
-                // Our default green point is the bottom of the screen
-                arma::ivec2 greenPoint = { int(x), int(image.height() - 1) };
-
-                // Loop through our segments to find our first green segment
-                for (auto it = segments.begin(); it != segments.end(); ++it) {
-
-                    // If this a valid green point update our information
-                    if(it->colour == ObjectClass::FIELD && it->length >= VISUAL_HORIZON_MINIMUM_SEGMENT_SIZE) {
-
-                        greenPoint = it->start;
-
-                        // We move our green point up by the scanning size if possible (assume more green horizon rather then less)
-                        greenPoint[1] = std::max(int(greenPoint[1] - (VISUAL_HORIZON_SUBSAMPLING / 2)), 0);
-
-                        // We found our green
-                        break;
-                    }
-                }
+            // One line per spacing plus one on the right edge if the spacing doesn't land there
+            std::vector<Scanline> lines;
+            lines.reserve(image.width() / spacing + 2);
 
-                visualHorizon.push_back(std::move(greenPoint));
-
-                insertSegments(classifiedImage, segments, true);
+            for(uint x = 0; x < image.width(); x += spacing) {
+                lines.push_back(line(x));
             }
 
             // If we don't have a line on the right of the image, make one
-            if(image.width() - 1 % VISUAL_HORIZON_SPACING != 0) {
+            const bool rightEdge = (image.width() - 1) % spacing != 0;
+            if(rightEdge) {
+                lines.push_back(line(image.width() - 1));
+            }
 
-                // Our default green point is the bottom of the screen
-                arma::ivec2 greenPoint = { int(image.width() - 1), int(image.height() - 1) };
+            // One point per line, so the hull is built without reallocating
+            visualHorizon.reserve(lines.size());
 
-                // Find our point to classify from (slightly above the horizon)
-                int top = std::max(int(lround(horizon.y(image.width() - 1)) - VISUAL_HORIZON_BUFFER), int(0));
-                top = std::min(top, int(image.height() - 1));
+            // Each line's green point is found on the thread that classified it, the hull is built from them in order
+            std::vector<arma::ivec2> greenPoints(lines.size());
 
-                arma::ivec2 start = { int(image.width() - 1), top };
-                arma::ivec2 end = { int(image.width() - 1), int(image.height() - 1) };
+            bands.scan(lines, classifiedImage.verticalSegments, segmentPool, [&] (const Scanline& scan) {
+                return classify(image, lut, scan.start, scan.end, scan.subsample);
+            }, [&] (const size_t& i, const std::vector<typename ClassifiedImage<ObjectClass, camID>::Segment>& segments) {
 
-                auto segments = quex->classify(image, lut, start, end, VISUAL_HORIZON_SUBSAMPLING);
+                // Our default green point is the bottom of the screen
+                arma::ivec2 greenPoint = lines[i].end;
 
                 // Loop through our segments to find our first green segment
                 for (auto it = segments.begin(); it != segments.end(); ++it) {
 
                     // If this a valid green point update our information
                     if(it->colour == ObjectClass::FIELD && it->length >= VISUAL_HORIZON_MINIMUM_SEGMENT_SIZE) {
+
                         greenPoint = it->start;
+
+                        // We move our green point up by the scanning size if possible (assume more green horizon rather then less)
+                        // The line on the right edge has always used its green point as is
+                        if(!rightEdge || i + 1 < lines.size()) {
+                            greenPoint[1] = std::max(int(greenPoint[1] - (VISUAL_HORIZON_SUBSAMPLING / 2)), 0);
+                        }
+
                         // We found our green
                         break;
                     }
                 }
 
-                visualHorizon.push_back(std::move(greenPoint));
-                insertSegments(classifiedImage, segments, true);
-            }
-
-            // Do a convex hull on the map points to build the horizon
-            for(auto a = visualHorizon.begin(); a < visualHorizon.end() - 2;) {
-
-                auto b = a + 1;
-                auto c = a + 2;
+                greenPoints[i] = greenPoint;
+            });
 
-                // Get the Z component of a cross product to check if it is concave
-                bool concave = 0 <   (double(a->at(0)) - double(b->at(0))) * (double(c->at(1)) - double(b->at(1)))
-                                   - (double(a->at(1)) - double(b->at(1))) * (double(c->at(0)) - double(b->at(0)));
-
-                if(concave) {
-                    visualHorizon.erase(b);
-                    a = a == visualHorizon.begin() ? a : --a;
-                }
-                else {
-                    ++a;
-                }
+            // Add them to the convex hull from left to right
+            for(auto& greenPoint : greenPoints) {
+                classifiedImage.addVisualHorizonPoint(greenPoint);
             }
 
-            // As this is a convex hull, the max visual horizon will always be at one of the edges
-            maxVisualHorizon = visualHorizon.front()[1] > visualHorizon.back()[1] ? visualHorizon.begin() : visualHorizon.end() - 1;
-
-            // As this is a convex function, we just need to progress till the next point is lower
-            for(minVisualHorizon = visualHorizon.begin();
-                minVisualHorizon < visualHorizon.end() - 1
-                && minVisualHorizon->at(1) > (minVisualHorizon + 1)->at(1);
-                ++minVisualHorizon);
+            // Find the extremes of the hull and its height at each column
+            classifiedImage.finishVisualHorizon();
         }
 
     }  // vision
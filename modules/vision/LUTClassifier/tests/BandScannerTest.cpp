@@ -0,0 +1,334 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "QuexClassifier.h"
+#include "ColourPlane.h"
+#include "BandScanner.h"
+#include "utility/vision/SyntheticFrames.h"
+
+using messages::input::Image;
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+using messages::vision::SegmentStore;
+using modules::vision::QuexClassifier;
+using modules::vision::ColourPlane;
+using modules::vision::BandScanner;
+using modules::vision::Scanline;
+using utility::parallel::WorkerPool;
+
+using utility::vision::synthetic::makeLUT;
+using utility::vision::synthetic::makeScene;
+using utility::vision::synthetic::scanFrame;
+
+namespace {
+
+    using Segment = ClassifiedImage<ObjectClass, 0>::Segment;
+    using Store = SegmentStore<ObjectClass>;
+
+    // The scanlines of scanFrame, split by direction as LUTClassifier stores them
+    void frameLines(uint width, uint height, std::vector<Scanline>& horizontal, std::vector<Scanline>& vertical) {
+        scanFrame(width, height, [&] (const arma::ivec2& s, const arma::ivec2& e, uint subsample) {
+            (s[0] == e[0] ? vertical : horizontal).push_back(Scanline { s, e, subsample });
+            return std::vector<Segment>();
+        });
+    }
+
+    // Every field and link of two stores must match, links compared by handle
+    void requireSame(const Store& a, const Store& b) {
+
+        REQUIRE(a.size() == b.size());
+
+        for(auto cls : { ObjectClass::UNKNOWN, ObjectClass::FIELD, ObjectClass::BALL, ObjectClass::GOAL, ObjectClass::LINE }) {
+
+            REQUIRE(a.count(cls) == b.count(cls));
+
+            auto& x = a.bucket(cls);
+            auto& y = b.bucket(cls);
+            for(size_t i = 0; i < x.size(); ++i) {
+                REQUIRE(x.length[i] == y.length[i]);
+                REQUIRE(x.subsample[i] == y.subsample[i]);
+                REQUIRE(x.start[i].x == y.start[i].x);
+                REQUIRE(x.start[i].y == y.start[i].y);
+                REQUIRE(x.end[i].x == y.end[i].x);
+                REQUIRE(x.end[i].y == y.end[i].y);
+                REQUIRE(x.previous[i] == y.previous[i]);
+                REQUIRE(x.next[i] == y.next[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Appending segment stores rebases their links onto the segments already stored", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+    auto image = makeScene(640, 480, 0);
+
+    std::vector<Scanline> horizontal;
+    std::vector<Scanline> vertical;
+    frameLines(640, 480, horizontal, vertical);
+
+    Store::Pool pool;
+    Store sequential(pool.acquire());
+    Store first(pool.acquire());
+    Store second(pool.acquire());
+
+    for(size_t i = 0; i < horizontal.size(); ++i) {
+        auto segments = quex.classify(image, lut, horizontal[i].start, horizontal[i].end, horizontal[i].subsample);
+        sequential.insertLine(segments.begin(), segments.end());
+        (i < horizontal.size() / 3 ? first : second).insertLine(segments.begin(), segments.end());
+    }
+
+    // Into an empty store and into one that already holds the first part
+    Store stitched;
+    stitched.append(first);
+    stitched.append(second);
+    requireSame(stitched, sequential);
+
+    first.append(second);
+    requireSame(first, sequential);
+
+    // Appending nothing changes nothing
+    first.append(Store());
+    requireSame(first, sequential);
+}
+
+TEST_CASE("Band borders split scanlines into runs of whole lines with similar work", "[vision][classifier]") {
+
+    std::vector<Scanline> horizontal;
+    std::vector<Scanline> vertical;
+    frameLines(1280, 960, horizontal, vertical);
+
+    size_t total = 0;
+    for(auto& line : horizontal) {
+        total += modules::vision::ScanScheduler::samples(line);
+    }
+
+    for(uint bands : { 1u, 2u, 3u, 4u, 7u, 16u }) {
+
+        auto borders = BandScanner::bands(horizontal, bands, 1000);
+
+        REQUIRE(borders.front() == 0);
+        REQUIRE(borders.back() == horizontal.size());
+        REQUIRE(borders.size() - 1 <= bands);
+
+        for(size_t b = 0; b + 1 < borders.size(); ++b) {
+            REQUIRE(borders[b] < borders[b + 1]);
+
+            size_t samples = 0;
+            for(size_t i = borders[b]; i < borders[b + 1]; ++i) {
+                samples += modules::vision::ScanScheduler::samples(horizontal[i]);
+            }
+
+            // Every band has its share give or take a line
+            REQUIRE(samples + 2000 >= total / (borders.size() - 1));
+        }
+    }
+
+    // Small jobs stay in one band, and no lines gives one empty band
+    REQUIRE(BandScanner::bands(horizontal, 8, total).size() == 2);
+    REQUIRE(BandScanner::bands({}, 8, 1) == std::vector<size_t>({ 0, 0 }));
+}
+
+TEST_CASE("Classifying in bands gives the same segments and links as one thread", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+    auto image = makeScene(640, 480, 3);
+
+    ColourPlane plane;
+    plane.classify(image, lut);
+
+    std::vector<Scanline> horizontal;
+    std::vector<Scanline> vertical;
+    frameLines(640, 480, horizontal, vertical);
+
+    Store::Pool pool;
+
+    auto scanAll = [&] (const BandScanner& scanner, Store& h, Store& v, std::vector<size_t>& visits) {
+        for(auto* lines : { &horizontal, &vertical }) {
+            visits.assign(lines->size(), 0);
+            scanner.scan(*lines, lines == &horizontal ? h : v, pool, [&] (const Scanline& line) {
+                return quex.classify<0>(plane, line.start, line.end, line.subsample);
+            }, [&] (const size_t& i, const std::vector<Segment>& segments) {
+                // Catch can't be used off the main thread, so record what we saw and check it after
+                visits[i] += segments.empty() ? 100 : 1;
+            });
+
+            // Each line is visited once, with its own segments
+            for(auto& count : visits) {
+                REQUIRE(count == 1);
+            }
+        }
+    };
+
+    BandScanner single;
+    Store h(pool.acquire());
+    Store v(pool.acquire());
+    std::vector<size_t> visits;
+    scanAll(single, h, v, visits);
+
+    for(uint threads : { 0u, 2u, 3u, 8u }) {
+
+        BandScanner scanner;
+        scanner.threads = threads;
+        scanner.minimumBandSamples = 1;
+
+        // Start both stores with a line in them so the bands have to be rebased onto it
+        auto extra = quex.classify<0>(plane, { 0, 5 }, { 639, 5 });
+        Store expected(pool.acquire());
+        Store banded(pool.acquire());
+        expected.insertLine(extra.begin(), extra.end());
+        banded.insertLine(extra.begin(), extra.end());
+
+        for(auto& line : horizontal) {
+            auto segments = quex.classify<0>(plane, line.start, line.end, line.subsample);
+            expected.insertLine(segments.begin(), segments.end());
+        }
+
+        Store bandedVertical(pool.acquire());
+        scanAll(scanner, banded, bandedVertical, visits);
+
+        requireSame(banded, expected);
+        requireSame(bandedVertical, v);
+    }
+}
+
+TEST_CASE("Exceptions thrown while classifying a band reach the caller", "[vision][classifier]") {
+
+    std::vector<Scanline> horizontal;
+    std::vector<Scanline> vertical;
+    frameLines(640, 480, horizontal, vertical);
+
+    BandScanner scanner;
+    scanner.threads = 4;
+    scanner.minimumBandSamples = 1;
+
+    Store::Pool pool;
+    Store store(pool.acquire());
+
+    REQUIRE_THROWS_AS(scanner.scan(horizontal, store, pool, [&] (const Scanline& line) -> std::vector<Segment> {
+        if(&line == &horizontal.back()) {
+            throw std::runtime_error("bad line");
+        }
+        return {};
+    }, [] (const size_t&, const std::vector<Segment>&) {}), std::runtime_error);
+}
+
+TEST_CASE("Colour planes classified in bands of rows match one thread", "[vision][classifier]") {
+
+    auto lut = makeLUT();
+
+    for(uint subsampling : { 1u, 3u }) {
+
+        auto image = makeScene(1280, 960, 1);
+        auto copy = image;
+
+        ColourPlane single;
+        ColourPlane banded;
+        single.classify(image, lut, subsampling, 1);
+        banded.classify(copy, lut, subsampling, 4);
+
+        REQUIRE(banded.width == single.width);
+        REQUIRE(banded.height == single.height);
+        REQUIRE(banded.data == single.data);
+    }
+}
+
+TEST_CASE("Benchmark classifying 1280x960 frames in bands from 1 to N threads", "[vision][classifier][benchmark][.]") {
+
+    constexpr uint FRAMES = 20;
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+
+    std::vector<Image<0>> frames;
+    for(uint i = 0; i < FRAMES; ++i) {
+        frames.push_back(makeScene(WIDTH, HEIGHT, i));
+    }
+
+    std::vector<Scanline> horizontal;
+    std::vector<Scanline> vertical;
+    frameLines(WIDTH, HEIGHT, horizontal, vertical);
+
+    Store::Pool pool;
+    auto ignore = [] (const size_t&, const std::vector<Segment>&) {};
+
+    uint most = std::max(4u, WorkerPool::instance().size());
+    std::cout << "Worker pool has " << WorkerPool::instance().size() << " threads" << std::endl;
+
+    double baseline = 0;
+    size_t baselineSegments = 0;
+
+    for(uint threads = 1; threads <= most; ++threads) {
+
+        BandScanner scanner;
+        scanner.threads = threads;
+
+        ColourPlane plane;
+
+        // Copies start with an empty demosaic cache so every run demosaics again
+        std::vector<Image<0>> fresh(frames.begin(), frames.end());
+
+        double planeSeconds = 0;
+        double scanSeconds = 0;
+        size_t segments = 0;
+
+        for(auto& image : fresh) {
+
+            auto start = std::chrono::steady_clock::now();
+            plane.classify(image, lut, 1, threads);
+            auto classified = std::chrono::steady_clock::now();
+
+            Store h(pool.acquire());
+            Store v(pool.acquire());
+            auto classify = [&] (const Scanline& line) {
+                return quex.classify<0>(plane, line.start, line.end, line.subsample);
+            };
+            scanner.scan(horizontal, h, pool, classify, ignore);
+            scanner.scan(vertical, v, pool, classify, ignore);
+
+            auto end = std::chrono::steady_clock::now();
+            planeSeconds += std::chrono::duration<double>(classified - start).count();
+            scanSeconds += std::chrono::duration<double>(end - classified).count();
+            segments += h.size() + v.size();
+        }
+
+        double total = planeSeconds + scanSeconds;
+        if(threads == 1) {
+            baseline = total;
+            baselineSegments = segments;
+        }
+
+        std::cout << threads << " threads: " << 1e3 * total / FRAMES << "ms per frame ("
+                  << 1e3 * planeSeconds / FRAMES << "ms classifying the plane, "
+                  << 1e3 * scanSeconds / FRAMES << "ms lexing scanlines), "
+                  << baseline / total << "x" << std::endl;
+
+        REQUIRE(segments == baselineSegments);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+
+#include "QuexClassifier.h"
+#include "ColourPlane.h"
+#include "utility/vision/SyntheticFrames.h"
+
+using messages::input::Image;
+using messages::vision::LookUpTable;
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+using modules::vision::QuexClassifier;
+using modules::vision::ColourPlane;
+
+using utility::vision::synthetic::makeLUT;
+using utility::vision::synthetic::makeScene;
+using utility::vision::synthetic::scanFrame;
+
+TEST_CASE("Classifying from the colour plane gives the same segments as classifying the image", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+    auto image = makeScene(320, 240, 0);
+
+    ColourPlane plane;
+    plane.classify(image, lut);
+
+    for(int y = 1; y < 239; y += 7) {
+        auto direct = quex.classify(image, lut, { 1, y }, { 318, y });
+        auto cached = quex.classify<0>(plane, { 1, y }, { 318, y });
+
+        REQUIRE(direct.size() == cached.size());
+        for(uint i = 0; i < direct.size(); ++i) {
+            REQUIRE(direct[i].colour == cached[i].colour);
+            REQUIRE(direct[i].length == cached[i].length);
+        }
+    }
+}
+
+TEST_CASE("Benchmark classifying once against classifying every scanline at 1280x960", "[vision][classifier][benchmark][.]") {
+
+    constexpr uint FRAMES = 30;
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+
+    std::vector<Image<0>> frames;
+    for(uint i = 0; i < FRAMES; ++i) {
+        frames.push_back(makeScene(WIDTH, HEIGHT, i));
+    }
+
+    // Every scanline demosaics and classifies its own pixels
+    size_t directSegments = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(auto& image : frames) {
+        directSegments += scanFrame(WIDTH, HEIGHT, [&] (const arma::ivec2& s, const arma::ivec2& e, uint subsample) {
+            return quex.classify(image, lut, s, e, subsample);
+        });
+    }
+    double directSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The frame is demosaiced and classified once (the copies start with an empty demosaic cache)
+    std::vector<Image<0>> fresh(frames.begin(), frames.end());
+
+    for(uint subsampling : { 1u, 2u }) {
+
+        ColourPlane plane;
+        size_t onceSegments = 0;
+
+        start = std::chrono::steady_clock::now();
+        for(auto& image : fresh) {
+            plane.classify(image, lut, subsampling);
+            onceSegments += scanFrame(WIDTH, HEIGHT, [&] (const arma::ivec2& s, const arma::ivec2& e, uint subsample) {
+                return quex.classify<0>(plane, s, e, subsample);
+            });
+        }
+        double onceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Classify once (plane subsampling " << subsampling << "): "
+                  << FRAMES / onceSeconds << " fps, " << onceSegments / FRAMES << " segments per frame" << std::endl;
+
+        // Reset the demosaic caches for the next run
+        fresh.assign(frames.begin(), frames.end());
+    }
+
+    std::cout << "Classify per scanline: "
+              << FRAMES / directSeconds << " fps, " << directSegments / FRAMES << " segments per frame" << std::endl;
+
+    REQUIRE(directSegments > 0);
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "messages/input/Image.h"
+#include "utility/image/Demosaic.h"
+
+using messages::input::Image;
+using utility::image::demosaic;
+using utility::image::demosaicInstructionSet;
+using utility::image::PlaneFormat;
+using utility::image::Conversion;
+
+namespace {
+
+    Image<0> makeImage(uint width, uint height) {
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> dist(0, 255);
+
+        Image<0> image;
+        image.format = Image<0>::SourceFormat::BGGR;
+        image.dimensions = { width, height };
+        image.source.resize(width * height);
+
+        for(auto& p : image.source) {
+            p = uint8_t(dist(rng));
+        }
+
+        return image;
+    }
+
+    template <typename Function>
+    double millisecondsPerRun(int runs, Function&& f) {
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < runs; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / runs;
+    }
+}
+
+TEST_CASE("Whole frame demosaic matches Image::operator() away from the border", "[vision][demosaic]") {
+
+    auto image = makeImage(101, 37);
+    const auto& plane = image.demosaiced();
+
+    REQUIRE(plane.width == image.width());
+    REQUIRE(plane.height == image.height());
+    REQUIRE(plane.data.size() == image.width() * image.height() * 3);
+
+    for(uint y = 1; y < image.height() - 1; ++y) {
+        for(uint x = 1; x < image.width() - 1; ++x) {
+            auto expected = image(x, y);
+            const uint8_t* actual = plane(x, y);
+
+            REQUIRE(actual[0] == expected[0]);
+            REQUIRE(actual[1] == expected[1]);
+            REQUIRE(actual[2] == expected[2]);
+        }
+    }
+
+    // The cache must hand back the same plane every time
+    REQUIRE(&image.demosaiced() == &plane);
+}
+
+TEST_CASE("Demosaicing in bands of rows gives the same plane as one thread", "[vision][demosaic]") {
+
+    auto image = makeImage(641, 479);
+
+    for(auto format : { PlaneFormat::YCbCr444, PlaneFormat::YCbCr422 }) {
+        for(auto conversion : { Conversion::NONE, Conversion::YCBCR }) {
+
+            std::vector<uint8_t> single;
+            demosaic(image.source.data(), image.width(), image.height(), format, conversion, single);
+
+            for(uint threads : { 0u, 2u, 3u, 7u }) {
+                std::vector<uint8_t> banded;
+                demosaic(image.source.data(), image.width(), image.height(), format, conversion, banded, threads);
+                REQUIRE(banded == single);
+            }
+        }
+    }
+}
+
+TEST_CASE("Benchmark whole frame demosaic against Image::operator() at 1280x960", "[vision][demosaic][benchmark][.]") {
+
+    constexpr int RUNS = 20;
+    auto image = makeImage(1280, 960);
+
+    uint checksum = 0;
+    double perPixel = millisecondsPerRun(RUNS, [&] {
+        for(uint y = 1; y < image.height() - 1; ++y) {
+            for(uint x = 1; x < image.width() - 1; ++x) {
+                checksum += image(x, y)[1];
+            }
+        }
+    });
+
+    std::vector<uint8_t> output;
+    double raw444 = millisecondsPerRun(RUNS, [&] {
+        demosaic(image.source.data(), image.width(), image.height(), PlaneFormat::YCbCr444, Conversion::NONE, output);
+    });
+
+    double ycbcr444 = millisecondsPerRun(RUNS, [&] {
+        demosaic(image.source.data(), image.width(), image.height(), PlaneFormat::YCbCr444, Conversion::YCBCR, output);
+    });
+
+    double ycbcr422 = millisecondsPerRun(RUNS, [&] {
+        demosaic(image.source.data(), image.width(), image.height(), PlaneFormat::YCbCr422, Conversion::YCBCR, output);
+    });
+
+    std::cout << "Demosaic 1280x960 (" << demosaicInstructionSet() << ")" << std::endl
+              << "    operator() per pixel:   " << perPixel << " ms" << std::endl
+              << "    whole frame (no conv):  " << raw444   << " ms" << std::endl
+              << "    whole frame YCbCr444:   " << ycbcr444 << " ms" << std::endl
+              << "    whole frame YCbCr422:   " << ycbcr422 << " ms" << std::endl
+              << "    (checksum " << checksum << ")" << std::endl;
+
+    REQUIRE(output.size() == 640 * 4 * 960);
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <malloc.h>
+#include <yaml-cpp/yaml.h>
+
+#include "messages/vision/LookUpTable.h"
+#include "utility/vision/LookUpTableFile.h"
+
+using messages::vision::Colour;
+using messages::vision::LookUpTable;
+using utility::vision::LookUpTableEncoding;
+using utility::vision::loadLookUpTable;
+using utility::vision::saveLookUpTable;
+
+namespace {
+
+    const std::string LUT_PATH = std::string(P_tmpdir) + "/LookUpTableFileTest.lut";
+
+    // A table shaped like a real one, large unclassified regions with blobs of each colour
+    LookUpTable makeTable(uint8_t bits) {
+
+        std::vector<Colour> data(size_t(1) << (3 * bits));
+        const int shift = 8 - bits;
+        const uint mask = (1 << bits) - 1;
+
+        for(size_t i = 0; i < data.size(); ++i) {
+            int y = ((i >> (2 * bits)) & mask) << shift;
+            int cb = ((i >> bits) & mask) << shift;
+            int cr = (i & mask) << shift;
+
+            data[i] = y > 200 && std::abs(cb - 128) < 20 && std::abs(cr - 128) < 20 ? Colour::WHITE
+                    : y > 40 && y < 180 && cb < 110 && cr < 110                    ? Colour::GREEN
+                    : y > 60 && cb < 120 && cr > 170                               ? Colour::ORANGE
+                    : y > 100 && cb < 70 && cr > 130 && cr < 170                   ? Colour::YELLOW
+                    : Colour::UNCLASSIFIED;
+        }
+
+        return LookUpTable(bits, bits, bits, std::move(data));
+    }
+
+    bool sameTable(const LookUpTable& a, const LookUpTable& b) {
+        return a.BITS_C1 == b.BITS_C1 && a.BITS_C2 == b.BITS_C2 && a.BITS_C3 == b.BITS_C3
+            && a.LUT_SIZE == b.LUT_SIZE
+            && std::equal(a.getRawData(), a.getRawData() + a.LUT_SIZE, b.getRawData());
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& path, const std::string& data) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << data;
+    }
+}
+
+TEST_CASE("Binary LUT files load back the table that was saved", "[vision][lut]") {
+
+    auto lut = makeTable(6);
+
+    for(auto encoding : { LookUpTableEncoding::RAW, LookUpTableEncoding::RUN_LENGTH }) {
+        saveLookUpTable(LUT_PATH, lut, encoding);
+        auto loaded = loadLookUpTable(LUT_PATH);
+
+        REQUIRE(sameTable(lut, loaded));
+
+        // Lookups must go through the same index maths
+        arma::Col<uint8_t>::fixed<3> pixel;
+        pixel[0] = 90; pixel[1] = 60; pixel[2] = 60;
+        REQUIRE(loaded(pixel) == Colour::GREEN);
+        REQUIRE(loaded.getLUTIndex(pixel) == lut.getLUTIndex(pixel));
+    }
+
+    std::remove(LUT_PATH.c_str());
+}
+
+TEST_CASE("Mapped LUTs are copied before they are changed", "[vision][lut]") {
+
+    auto lut = makeTable(6);
+    saveLookUpTable(LUT_PATH, lut);
+
+    const LookUpTable mapped = loadLookUpTable(LUT_PATH);
+    LookUpTable edited = mapped;
+
+    // Copies share the mapping until one of them is written to
+    REQUIRE(edited.getRawData() == mapped.getRawData());
+
+    arma::Col<uint8_t>::fixed<3> pixel;
+    pixel[0] = 0; pixel[1] = 0; pixel[2] = 0;
+    REQUIRE(edited(pixel) == Colour::UNCLASSIFIED);
+    edited(pixel) = Colour::CYAN;
+
+    REQUIRE(edited.getRawData() != mapped.getRawData());
+    REQUIRE(mapped(pixel) == Colour::UNCLASSIFIED);
+    REQUIRE(loadLookUpTable(LUT_PATH)(pixel) == Colour::UNCLASSIFIED);
+
+    // Saving over the file replaces it rather than changing what is already mapped
+    saveLookUpTable(LUT_PATH, edited);
+    REQUIRE(mapped(pixel) == Colour::UNCLASSIFIED);
+    REQUIRE(loadLookUpTable(LUT_PATH)(pixel) == Colour::CYAN);
+
+    std::remove(LUT_PATH.c_str());
+}
+
+TEST_CASE("Damaged LUT files are rejected", "[vision][lut]") {
+
+    saveLookUpTable(LUT_PATH, makeTable(5), LookUpTableEncoding::RUN_LENGTH);
+    std::string good = readFile(LUT_PATH);
+
+    // Truncated
+    writeFile(LUT_PATH, good.substr(0, good.size() - 1));
+    REQUIRE_THROWS(loadLookUpTable(LUT_PATH));
+
+    writeFile(LUT_PATH, good.substr(0, 10));
+    REQUIRE_THROWS(loadLookUpTable(LUT_PATH));
+
+    // Not a LUT
+    writeFile(LUT_PATH, "bits: [6, 6, 6]\nlut: uuuu\n" + std::string(100, ' '));
+    REQUIRE_THROWS(loadLookUpTable(LUT_PATH));
+
+    // A flipped bit in the header or the table
+    for(size_t offset : { size_t(12), good.size() - 2 }) {
+        std::string bad = good;
+        bad[offset] ^= 0x10;
+        writeFile(LUT_PATH, bad);
+        REQUIRE_THROWS(loadLookUpTable(LUT_PATH));
+    }
+
+    std::remove(LUT_PATH.c_str());
+    REQUIRE_THROWS(loadLookUpTable(LUT_PATH));
+}
+
+TEST_CASE("LUT configs can still hold the table inline", "[vision][lut]") {
+
+    auto lut = makeTable(4);
+    YAML::Node config = YAML::Load(YAML::Dump(YAML::Node(lut)));
+
+    REQUIRE(sameTable(lut, loadLookUpTable(config)));
+}
+
+TEST_CASE("Benchmark loading LUTs from YAML and binary files", "[vision][lut][benchmark][.]") {
+
+    for(uint8_t bits : { 6, 7 }) {
+
+        auto lut = makeTable(bits);
+
+        const std::string yamlPath = LUT_PATH + ".yaml";
+        std::ofstream(yamlPath) << YAML::Node(lut);
+
+        saveLookUpTable(LUT_PATH, lut, LookUpTableEncoding::RAW);
+        const std::string rlePath = LUT_PATH + ".rle";
+        saveLookUpTable(rlePath, lut, LookUpTableEncoding::RUN_LENGTH);
+
+        std::cout << int(bits) << "/" << int(bits) << "/" << int(bits) << " bit table (" << lut.LUT_SIZE << " entries)" << std::endl;
+
+        auto measure = [&] (const std::string& name, const std::string& path, std::function<LookUpTable ()> load) {
+
+            size_t heapBefore = mallinfo().uordblks;
+            auto start = std::chrono::steady_clock::now();
+            LookUpTable loaded = load();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            size_t heap = mallinfo().uordblks - heapBefore;
+
+            REQUIRE(sameTable(lut, loaded));
+
+            std::cout << "    " << name << readFile(path).size() / 1024 << " KB on disk, "
+                      << seconds * 1000 << " ms to load, "
+                      << heap / 1024 << " KB of heap held" << std::endl;
+        };
+
+        measure("yaml:          ", yamlPath, [&] { return YAML::LoadFile(yamlPath).as<LookUpTable>(); });
+        measure("raw mapped:    ", LUT_PATH, [&] { return loadLookUpTable(LUT_PATH); });
+        measure("raw unchecked: ", LUT_PATH, [&] { return loadLookUpTable(LUT_PATH, false); });
+        measure("run length:    ", rlePath, [&] { return loadLookUpTable(rlePath); });
+
+        std::remove(yamlPath.c_str());
+        std::remove(rlePath.c_str());
+        std::remove(LUT_PATH.c_str());
+    }
+}
@@ -0,0 +1,288 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <random>
+#include <unordered_set>
+#include <yaml-cpp/yaml.h>
+
+#include "ColourPlane.h"
+#include "messages/vision/LookUpTable.h"
+#include "messages/vision/PackedLookUpTable.h"
+#include "utility/vision/SyntheticFrames.h"
+
+using messages::input::Image;
+using messages::vision::Colour;
+using messages::vision::LookUpTable;
+using messages::vision::PackedLookUpTable;
+using modules::vision::ColourPlane;
+
+using utility::vision::synthetic::makeLUT;
+using utility::vision::synthetic::makeScene;
+
+namespace {
+
+    // A table with every colour scattered through it so a packing mistake can't hide in the unclassified space
+    LookUpTable makeScrambledLUT(uint8_t bits1, uint8_t bits2, uint8_t bits3) {
+
+        const Colour colours[] = { Colour::UNCLASSIFIED, Colour::WHITE, Colour::GREEN, Colour::ORANGE,
+                                   Colour::YELLOW, Colour::CYAN, Colour::MAGENTA, Colour::WHITE_GREEN };
+
+        std::mt19937 rng(bits1 * 100 + bits2 * 10 + bits3);
+        std::vector<Colour> data(size_t(1) << (bits1 + bits2 + bits3));
+        for(auto& d : data) {
+            d = colours[rng() % 8];
+        }
+
+        return LookUpTable(bits1, bits2, bits3, std::move(data));
+    }
+
+    // The LUT the robot was last calibrated with, if we can find it
+    LookUpTable realLUT() {
+
+        std::string path = std::string(__FILE__);
+        path = path.substr(0, path.rfind("tests/")) + "config/LookUpTable.yaml";
+
+        try {
+            return YAML::LoadFile(path).as<LookUpTable>();
+        }
+        catch(const std::exception&) {
+            return makeLUT();
+        }
+    }
+
+    // The synthetic scene with sensor noise so neighbouring pixels wander about the colour space as they do on a camera
+    Image<0> makeNoisyScene(uint width, uint height, uint frame) {
+
+        auto image = makeScene(width, height, frame);
+
+        std::mt19937 rng(frame);
+        std::normal_distribution<double> noise(0, 6);
+        for(auto& p : image.source) {
+            p = uint8_t(std::max(0.0, std::min(255.0, p + noise(rng))));
+        }
+
+        return image;
+    }
+
+    // A set associative LRU cache, used to count how often the table lookups of a frame miss
+    struct CacheModel {
+        CacheModel(size_t bytes, size_t ways) : ways(ways), sets(bytes / 64 / ways), lines(sets), misses(0) {}
+
+        void access(size_t address) {
+            size_t line = address / 64;
+            auto& set = lines[line % sets];
+            for(auto it = set.begin(); it != set.end(); ++it) {
+                if(*it == line) {
+                    set.splice(set.begin(), set, it);
+                    return;
+                }
+            }
+
+            ++misses;
+            set.push_front(line);
+            if(set.size() > ways) {
+                set.pop_back();
+            }
+        }
+
+        size_t ways;
+        size_t sets;
+        std::vector<std::list<size_t>> lines;
+        size_t misses;
+    };
+}
+
+TEST_CASE("Packed LUTs give the same colours as the LUT they were packed from", "[vision][lut]") {
+
+    const uint8_t depths[][3] = { { 4, 5, 6 }, { 6, 6, 6 }, { 7, 7, 7 }, { 8, 4, 3 } };
+
+    for(auto& bits : depths) {
+
+        auto lut = makeScrambledLUT(bits[0], bits[1], bits[2]);
+        const Colour* table = lut.getRawData();
+
+        for(auto layout : { PackedLookUpTable::Layout::LINEAR, PackedLookUpTable::Layout::MORTON }) {
+
+            PackedLookUpTable packed(lut, layout);
+            REQUIRE(packed.getPackedData().size() == (lut.LUT_SIZE + 1) / 2);
+
+            // Every entry lands somewhere different and keeps its colour
+            std::vector<bool> used(lut.LUT_SIZE, false);
+            uint outside = 0;
+            uint collisions = 0;
+            uint wrong = 0;
+            for(uint i = 0; i < lut.LUT_SIZE; ++i) {
+                uint p = packed.position(i);
+                if(p >= lut.LUT_SIZE) {
+                    ++outside;
+                    continue;
+                }
+                collisions += used[p];
+                used[p] = true;
+
+                wrong += packed.getColour(i) != table[i];
+            }
+            REQUIRE(outside == 0);
+            REQUIRE(collisions == 0);
+            REQUIRE(wrong == 0);
+
+            REQUIRE(packed.unpack().getData() == lut.getData());
+
+            // Lookups by pixel agree with the LUT's own index maths
+            std::mt19937 rng(1);
+            for(int i = 0; i < 10000; ++i) {
+                uint8_t pixel[3] = { uint8_t(rng()), uint8_t(rng()), uint8_t(rng()) };
+                arma::Col<uint8_t>::fixed<3> p;
+                p[0] = pixel[0]; p[1] = pixel[1]; p[2] = pixel[2];
+
+                REQUIRE(packed.getLUTIndex(p) == lut.getLUTIndex(p));
+                REQUIRE(packed(pixel) == lut(p));
+                REQUIRE(packed(p) == lut(p));
+
+                auto back = packed.getPixelFromIndex(packed.getLUTIndex(p));
+                auto expected = lut.getPixelFromIndex(lut.getLUTIndex(p));
+                REQUIRE(back[0] == expected[0]);
+                REQUIRE(back[1] == expected[1]);
+                REQUIRE(back[2] == expected[2]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Packed LUT entries can be changed one at a time", "[vision][lut]") {
+
+    auto lut = makeScrambledLUT(5, 5, 5);
+    PackedLookUpTable packed(lut);
+
+    for(uint i : { 0u, 1u, 2u, 1000u, uint(lut.LUT_SIZE - 1) }) {
+        packed.setColour(i, Colour::CYAN);
+        REQUIRE(packed.getColour(i) == Colour::CYAN);
+
+        packed.setColour(i, lut.getRawData()[i]);
+    }
+
+    REQUIRE(packed.unpack().getData() == lut.getData());
+
+    REQUIRE_THROWS_AS(packed.setColour(0, Colour('z')), std::invalid_argument);
+
+    std::vector<Colour> bad(1 << 6, Colour::GREEN);
+    bad[10] = Colour('z');
+    LookUpTable badLut(2, 2, 2, std::move(bad));
+    REQUIRE_FALSE(PackedLookUpTable::canPack(badLut));
+    REQUIRE_THROWS_AS(PackedLookUpTable(badLut), std::invalid_argument);
+
+    REQUIRE(PackedLookUpTable::canPack(lut));
+}
+
+TEST_CASE("Classifying a frame through a packed LUT gives the same plane", "[vision][lut]") {
+
+    auto lut = makeLUT();
+    auto image = makeNoisyScene(320, 240, 3);
+
+    ColourPlane expected;
+    expected.classify(image, lut);
+
+    for(auto layout : { PackedLookUpTable::Layout::LINEAR, PackedLookUpTable::Layout::MORTON }) {
+        ColourPlane plane;
+        plane.classify(image, PackedLookUpTable(lut, layout));
+
+        REQUIRE(plane.data == expected.data);
+    }
+}
+
+TEST_CASE("Benchmark classifying frames through packed LUTs", "[vision][lut][benchmark][.]") {
+
+    constexpr uint FRAMES = 20;
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+
+    std::vector<Image<0>> frames;
+    for(uint i = 0; i < FRAMES; ++i) {
+        frames.push_back(makeNoisyScene(WIDTH, HEIGHT, i));
+        frames.back().demosaiced();
+    }
+
+    std::vector<std::pair<std::string, LookUpTable>> luts;
+    luts.emplace_back("synthetic 6/6/6", makeLUT());
+    luts.emplace_back("calibrated", realLUT());
+
+    for(auto& named : luts) {
+        auto& lut = named.second;
+
+        auto packStart = std::chrono::steady_clock::now();
+        PackedLookUpTable linear(lut, PackedLookUpTable::Layout::LINEAR);
+        PackedLookUpTable morton(lut, PackedLookUpTable::Layout::MORTON);
+        double packSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - packStart).count() / 2;
+
+        std::cout << named.first << " LUT (" << int(lut.BITS_C1) << "/" << int(lut.BITS_C2) << "/" << int(lut.BITS_C3)
+                  << ", " << lut.LUT_SIZE / 1024 << " KB unpacked, " << linear.getPackedData().size() / 1024
+                  << " KB packed, " << packSeconds * 1000 << " ms to pack)" << std::endl;
+
+        ColourPlane expected;
+        auto run = [&] (const std::string& name, std::function<void (ColourPlane&, const Image<0>&)> classify, std::function<size_t (uint)> address) {
+
+            // Throughput over the whole set
+            ColourPlane plane;
+            auto start = std::chrono::steady_clock::now();
+            for(auto& image : frames) {
+                classify(plane, image);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Misses in an Atom sized L1 (24 KB 6 way) and L2 (512 KB 8 way) for the table lookups of one frame
+            CacheModel l1(24 * 1024, 6);
+            CacheModel l2(512 * 1024, 8);
+            std::unordered_set<size_t> touched;
+            const auto& pixels = frames.back().demosaiced();
+            for(uint y = 0; y < HEIGHT; ++y) {
+                const uint8_t* in = pixels(0, y);
+                for(uint x = 0; x < WIDTH; ++x, in += 3) {
+                    size_t a = address(lut.getLUTIndex(in));
+                    size_t before = l1.misses;
+                    l1.access(a);
+                    if(l1.misses != before) {
+                        l2.access(a);
+                    }
+                    touched.insert(a / 64);
+                }
+            }
+
+            if(expected.data.empty()) {
+                expected = plane;
+            }
+            REQUIRE(plane.data == expected.data);
+
+            std::cout << "    " << name << (WIDTH * HEIGHT * FRAMES) / seconds / 1e6 << " Mpixels/s, "
+                      << touched.size() << " table lines touched, "
+                      << l1.misses << " L1 / " << l2.misses << " L2 misses per frame" << std::endl;
+        };
+
+        run("bytes:         ", [&] (ColourPlane& p, const Image<0>& i) { p.classify(i, lut); },
+                               [&] (uint index) { return size_t(index); });
+        run("packed linear: ", [&] (ColourPlane& p, const Image<0>& i) { p.classify(i, linear); },
+                               [&] (uint index) { return size_t(linear.position(index) / 2); });
+        run("packed morton: ", [&] (ColourPlane& p, const Image<0>& i) { p.classify(i, morton); },
+                               [&] (uint index) { return size_t(morton.position(index) / 2); });
+    }
+}
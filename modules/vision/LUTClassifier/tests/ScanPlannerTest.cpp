@@ -0,0 +1,383 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "QuexClassifier.h"
+#include "ColourPlane.h"
+#include "ScanPlanner.h"
+
+using messages::vision::Ball;
+using messages::vision::Colour;
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+using modules::vision::QuexClassifier;
+using modules::vision::ColourPlane;
+using modules::vision::Scanline;
+using modules::vision::ScanScheduler;
+using modules::vision::ScanPlan;
+using modules::vision::ScanPlanner;
+using modules::vision::ballTarget;
+using utility::math::geometry::Line;
+
+namespace {
+
+    using Segment = ClassifiedImage<ObjectClass, 0>::Segment;
+    using Duration = ScanPlanner::Duration;
+
+    const arma::uvec2 DIMENSIONS = { 640, 480 };
+
+    Line horizonAt(double y) {
+        return Line({ 0, y }, { double(DIMENSIONS[0] - 1), y });
+    }
+
+    size_t focusSamples(const ScanPlan& plan) {
+        size_t samples = 0;
+        for(auto& line : plan.focus) {
+            samples += ScanScheduler::samples(line);
+        }
+        return samples;
+    }
+
+    ScanPlanner::Settings enabled() {
+        ScanPlanner::Settings settings;
+        settings.enabled = true;
+        settings.latencyBudget = std::chrono::milliseconds(10);
+        settings.detectionMemory = 5;
+        return settings;
+    }
+
+    Duration micros(double us) {
+        return std::chrono::duration_cast<Duration>(std::chrono::duration<double, std::micro>(us));
+    }
+}
+
+TEST_CASE("A disabled scan planner scans as configured", "[vision][classifier]") {
+
+    ScanPlanner planner;
+    planner.detected({ { { 320, 300 }, 20 } });
+
+    auto plan = planner.plan(DIMENSIONS, horizonAt(100), { { { 100, 300 }, 10 } });
+    REQUIRE(plan.sparsity == 1);
+    REQUIRE(plan.focus.empty());
+}
+
+TEST_CASE("The scan planner looks around recent detections until it forgets them", "[vision][classifier]") {
+
+    auto settings = enabled();
+    ScanPlanner planner(settings);
+
+    // Nothing to look at yet
+    auto plan = planner.plan(DIMENSIONS, horizonAt(100));
+    REQUIRE(plan.sparsity == 1);
+    REQUIRE(plan.focus.empty());
+
+    planner.detected({ { { 320, 300 }, 20 } });
+
+    for(uint frame = 0; frame <= settings.detectionMemory + 1; ++frame) {
+
+        // Losing the ball keeps the region it was in
+        planner.detected({});
+        plan = planner.plan(DIMENSIONS, horizonAt(100));
+
+        if(frame <= settings.detectionMemory) {
+            // Backing off the coarse scans less as the detection gets older
+            double confidence = 1.0 - double(frame) / (settings.detectionMemory + 1);
+            REQUIRE(plan.sparsity == Approx(1.0 + (settings.focusedSparsity - 1.0) * confidence));
+            REQUIRE_FALSE(plan.focus.empty());
+
+            // The region grows as the detection gets older
+            double radius = 20 * settings.regionScale + settings.regionGrowth * frame;
+            for(auto& line : plan.focus) {
+                for(auto& p : { line.start, line.end }) {
+                    REQUIRE(std::abs(p[0] - 320) <= radius + 1);
+                    REQUIRE(std::abs(p[1] - 300) <= radius + 1);
+                }
+            }
+        }
+        else {
+            REQUIRE(plan.sparsity == 1);
+            REQUIRE(plan.focus.empty());
+        }
+    }
+}
+
+TEST_CASE("The scan planner looks around detected buoys at their size on the screen", "[vision][classifier]") {
+
+    auto settings = enabled();
+    ScanPlanner planner(settings);
+
+    // A buoy as BuoyDetector gives it, whose circle radius is the cosine of its angular radius rather than pixels
+    const double focalLength = 400;
+    const double angularRadius = 0.05;
+    Ball<0> buoy;
+    buoy.circle.centre = { 320, 300 };
+    buoy.circle.radius = std::cos(angularRadius);
+    buoy.angularSize = { 2 * std::acos(buoy.circle.radius), 2 * std::acos(buoy.circle.radius) };
+
+    auto target = ballTarget(buoy, focalLength);
+    double radius = focalLength * std::tan(angularRadius);
+    REQUIRE(target.radius == Approx(radius));
+
+    planner.detected({ target });
+    auto plan = planner.plan(DIMENSIONS, horizonAt(100));
+    REQUIRE_FALSE(plan.focus.empty());
+
+    // The region covers the whole buoy, not a couple of pixels around its centre
+    double reach = 0;
+    for(auto& line : plan.focus) {
+        for(auto& p : { line.start, line.end }) {
+            reach = std::max({ reach, std::abs(p[0] - 320.0), std::abs(p[1] - 300.0) });
+        }
+    }
+    REQUIRE(reach >= radius * settings.regionScale - 1);
+    REQUIRE(reach <= radius * settings.regionScale + 1);
+}
+
+TEST_CASE("The scan planner ignores regions above the horizon", "[vision][classifier]") {
+
+    ScanPlanner planner(enabled());
+
+    // A ball in the sky and one the localisation expects off the screen
+    planner.detected({ { { 320, 40 }, 10 } });
+    auto plan = planner.plan(DIMENSIONS, horizonAt(200), { { { -200, 300 }, 10 } });
+    REQUIRE(plan.focus.empty());
+    REQUIRE(plan.sparsity == 1);
+
+    // The localisation's estimate on the field gets scanned
+    plan = planner.plan(DIMENSIONS, horizonAt(200), { { { 500, 400 }, 10 } });
+    REQUIRE_FALSE(plan.focus.empty());
+    for(auto& line : plan.focus) {
+        REQUIRE(line.start[0] >= 480);
+        REQUIRE(line.start[1] >= 380);
+    }
+}
+
+TEST_CASE("The scan planner keeps frames within its latency budget", "[vision][classifier]") {
+
+    auto settings = enabled();
+    settings.smoothing = 1;
+    ScanPlanner planner(settings);
+
+    // Coarse scans alone take 12ms at the configured spacing and focus samples cost 100ns each
+    const double coarse = 12000;
+    auto run = [&] {
+        planner.detected({ { { 320, 300 }, 30 } });
+        auto plan = planner.plan(DIMENSIONS, horizonAt(100));
+        double focus = focusSamples(plan) * 0.1;
+        planner.observe(micros(coarse / plan.sparsity + focus), micros(focus));
+        return plan;
+    };
+
+    ScanPlan plan;
+    for(int i = 0; i < 5; ++i) {
+        plan = run();
+    }
+
+    // Backed off far enough that the coarse scans leave the focus its share
+    REQUIRE(plan.sparsity == Approx(coarse / (10000 * (1 - settings.focusShare))));
+    double focus = focusSamples(plan) * 0.1;
+    REQUIRE(coarse / plan.sparsity + focus <= 10000);
+    REQUIRE(coarse / plan.sparsity + focus > 9000);
+
+    // With nothing to spare the coarse scans stop at the most they can back off and the focus gets nothing
+    settings.maximumSparsity = 1.2;
+    planner.configure(settings);
+    plan = run();
+    plan = run();
+    REQUIRE(plan.sparsity == Approx(1.2));
+    REQUIRE(plan.focus.empty());
+}
+
+TEST_CASE("Benchmark latency and detection rate with and without the scan planner over a replayed sequence", "[vision][classifier][benchmark][.]") {
+
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+    constexpr uint FRAMES = 600;
+    constexpr int HORIZON = HEIGHT / 3;
+
+    // A ball rolling about the field, sometimes leaving the frame and coming back somewhere else
+    struct Truth {
+        bool visible;
+        double x, y, radius;
+    };
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> ux(100, WIDTH - 100);
+    std::uniform_real_distribution<double> uy(HORIZON + 60, HEIGHT - 60);
+    std::normal_distribution<double> step(0, 6);
+    std::uniform_real_distribution<double> chance(0, 1);
+
+    std::vector<Truth> truth;
+    std::vector<ColourPlane> frames;
+
+    Truth ball = { true, ux(rng), uy(rng), 0 };
+    double vx = 8, vy = 3;
+    for(uint f = 0; f < FRAMES; ++f) {
+
+        if(chance(rng) < 0.01) {
+            ball.visible = !ball.visible;
+            ball.x = ux(rng);
+            ball.y = uy(rng);
+        }
+        vx = std::max(-12.0, std::min(vx + step(rng) * 0.2, 12.0));
+        vy = std::max(-12.0, std::min(vy + step(rng) * 0.2, 12.0));
+        ball.x += vx;
+        ball.y += vy;
+        if(ball.x < 60 || ball.x > WIDTH - 60) { vx = -vx; ball.x = std::max(60.0, std::min(ball.x, WIDTH - 60.0)); }
+        if(ball.y < HORIZON + 30 || ball.y > HEIGHT - 60) { vy = -vy; ball.y = std::max(HORIZON + 30.0, std::min(ball.y, HEIGHT - 60.0)); }
+
+        // Balls look bigger closer to the camera
+        ball.radius = 6 + 24 * (ball.y - HORIZON) / (HEIGHT - HORIZON);
+        truth.push_back(ball);
+
+        ColourPlane plane;
+        plane.subsample = 1;
+        plane.width = WIDTH;
+        plane.height = HEIGHT;
+        plane.data.assign(WIDTH * HEIGHT, Colour::GREEN);
+        std::fill(plane.data.begin(), plane.data.begin() + WIDTH * HORIZON, Colour::UNCLASSIFIED);
+
+        if(ball.visible) {
+            for(int y = int(ball.y - ball.radius); y <= int(ball.y + ball.radius); ++y) {
+                for(int x = int(ball.x - ball.radius); x <= int(ball.x + ball.radius); ++x) {
+                    if((x - ball.x) * (x - ball.x) + (y - ball.y) * (y - ball.y) < ball.radius * ball.radius) {
+                        plane.data[y * WIDTH + x] = Colour::ORANGE;
+                    }
+                }
+            }
+        }
+
+        frames.push_back(std::move(plane));
+    }
+
+    QuexClassifier quex;
+    const Line horizon({ 0, double(HORIZON) }, { double(WIDTH - 1), double(HORIZON) });
+
+    // Scans like the classifier does, coarse vertical lines for the visual horizon and horizontal ball lines
+    // below it, then the focus lines. A ball is found when three of its segments are within it
+    auto replay = [&] (ScanPlanner& planner, double fixedSparsity, std::vector<double>& latency, double& detectionRate) {
+
+        uint found = 0;
+        uint visible = 0;
+        latency.clear();
+
+        for(uint f = 0; f < FRAMES; ++f) {
+
+            auto start = std::chrono::steady_clock::now();
+
+            auto plan = planner.plan({ WIDTH, HEIGHT }, horizon);
+            double sparsity = std::max(fixedSparsity, plan.sparsity);
+
+            std::vector<Segment> balls;
+            auto scan = [&] (const Scanline& line) {
+                auto segments = quex.classify<0>(frames[f], line.start, line.end, line.subsample);
+                for(auto& s : segments) {
+                    if(s.colour == ObjectClass::BALL) {
+                        balls.push_back(s);
+                    }
+                }
+            };
+
+            const int vertical = std::max(1, int(40 * sparsity));
+            for(int x = 0; x < int(WIDTH); x += vertical) {
+                scan({ { x, HORIZON - 20 }, { x, int(HEIGHT) - 1 }, 4 });
+            }
+            const int horizontal = std::max(3, int(16 * sparsity));
+            for(int y = HORIZON; y < int(HEIGHT); y += horizontal) {
+                scan({ { 0, y }, { int(WIDTH) - 1, y }, uint(horizontal / 2) });
+            }
+
+            auto focusStart = std::chrono::steady_clock::now();
+            for(auto& line : plan.focus) {
+                scan(line);
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            planner.observe(end - start, end - focusStart);
+            latency.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+            // Detect the ball as the middle of its segments
+            std::vector<ScanPlanner::Target> detections;
+            if(balls.size() >= 3) {
+                double x = 0, y = 0, radius = 0;
+                for(auto& s : balls) {
+                    x += s.midpoint[0];
+                    y += s.midpoint[1];
+                    radius = std::max(radius, s.length / 2.0);
+                }
+                detections.push_back({ { x / balls.size(), y / balls.size() }, radius });
+            }
+            planner.detected(detections);
+
+            if(truth[f].visible) {
+                ++visible;
+                if(!detections.empty()
+                    && std::hypot(detections[0].centre[0] - truth[f].x, detections[0].centre[1] - truth[f].y) < truth[f].radius) {
+                    ++found;
+                }
+            }
+        }
+
+        detectionRate = double(found) / visible;
+    };
+
+    auto report = [] (const std::string& name, std::vector<double> latency, double detectionRate) {
+        std::sort(latency.begin(), latency.end());
+        double mean = 0;
+        for(double l : latency) {
+            mean += l / latency.size();
+        }
+        std::cout << "    " << name << mean << " us mean, " << latency[latency.size() * 99 / 100] << " us p99, "
+                  << detectionRate * 100 << "% of visible balls found" << std::endl;
+        return mean;
+    };
+
+    std::vector<double> latency;
+    double rate;
+
+    std::cout << "Latency and detection rate over " << FRAMES << " frames at " << WIDTH << "x" << HEIGHT << std::endl;
+
+    // The fixed spacings, as they are configured and backed off by hand
+    double configured = 0;
+    for(double sparsity : { 1.0, 1.5, 2.0, 3.0 }) {
+        ScanPlanner fixed;
+        replay(fixed, sparsity, latency, rate);
+        double mean = report("fixed, sparsity " + std::to_string(sparsity).substr(0, 3) + ":    ", latency, rate);
+        configured = sparsity == 1.0 ? mean : configured;
+    }
+
+    // The planner asked to fit into shares of what the configured spacing takes
+    for(double share : { 1.0, 0.75, 0.5 }) {
+        auto settings = enabled();
+        settings.latencyBudget = micros(configured * share);
+        settings.detectionMemory = 10;
+        settings.regionGrowth = 10;
+        settings.maximumSparsity = 4;
+        ScanPlanner planner(settings);
+        replay(planner, 1, latency, rate);
+        report("planned, " + std::to_string(int(share * 100)) + "% budget:   ", latency, rate);
+    }
+}
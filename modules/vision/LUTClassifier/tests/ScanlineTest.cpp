@@ -0,0 +1,309 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "QuexClassifier.h"
+#include "ColourPlane.h"
+#include "ScanScheduler.h"
+
+using messages::vision::Colour;
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+using modules::vision::QuexClassifier;
+using modules::vision::ColourPlane;
+using modules::vision::Scanline;
+using modules::vision::ScanScheduler;
+
+namespace {
+
+    using Segment = ClassifiedImage<ObjectClass, 0>::Segment;
+
+    ColourPlane makePlane(uint width, uint height, Colour colour) {
+        ColourPlane plane;
+        plane.subsample = 1;
+        plane.width = width;
+        plane.height = height;
+        plane.data.assign(width * height, colour);
+        return plane;
+    }
+
+    // The pixels a line visits, worked out independently of the classifier
+    std::vector<arma::ivec2> referenceSamples(const arma::ivec2& start, const arma::ivec2& end, uint subsample) {
+
+        const double dx = end[0] - start[0];
+        const double dy = end[1] - start[1];
+        const double major = std::max(std::abs(dx), std::abs(dy));
+
+        std::vector<arma::ivec2> points;
+        for(uint i = 0; i < uint(major + 1) / subsample; ++i) {
+            double t = major == 0 ? 0 : i * subsample / major;
+            // Halves round away from the start, as the classifier's error term does
+            auto round = [] (double v, double d) { return d < 0 ? -std::floor(-v + 0.5) : std::floor(v + 0.5); };
+            points.push_back({ start[0] + int(round(t * dx, dx)), start[1] + int(round(t * dy, dy)) });
+        }
+        return points;
+    }
+
+    // Ball in a field, a few pixels of each, then unclassified for the rest
+    void paint(ColourPlane& plane, int x, int y, Colour colour) {
+        if(x >= 0 && y >= 0 && x < int(plane.width) && y < int(plane.height)) {
+            plane.data[y * plane.width + x] = colour;
+        }
+    }
+}
+
+TEST_CASE("Scanlines at any angle visit the pixels of a Bresenham line", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> coordinate(0, 199);
+
+    for(int trial = 0; trial < 300; ++trial) {
+
+        arma::ivec2 start = { coordinate(rng), coordinate(rng) };
+        arma::ivec2 end = { coordinate(rng), coordinate(rng) };
+        uint subsample = 1 + trial % 4;
+
+        auto expected = referenceSamples(start, end, subsample);
+        if(expected.size() < 3) {
+            continue;
+        }
+
+        // Mark every sample the line should take, then a pixel it should step over
+        auto plane = makePlane(200, 200, Colour::GREEN);
+        uint which = trial % expected.size();
+        paint(plane, expected[which][0], expected[which][1], Colour::ORANGE);
+
+        auto segments = quex.classify<0>(plane, start, end, subsample);
+
+        // The segments tile the line from end to end
+        REQUIRE(segments.front().start[0] == start[0]);
+        REQUIRE(segments.front().start[1] == start[1]);
+        uint samples = 0;
+        for(uint i = 0; i < segments.size(); ++i) {
+            samples += segments[i].length / subsample;
+            if(i + 1 < segments.size()) {
+                REQUIRE(segments[i].end[0] == segments[i + 1].start[0]);
+                REQUIRE(segments[i].end[1] == segments[i + 1].start[1]);
+            }
+        }
+        REQUIRE(samples == expected.size());
+
+        // The ball is exactly where we put it and one sample long
+        auto ball = std::find_if(segments.begin(), segments.end(), [] (const Segment& s) { return s.colour == ObjectClass::BALL; });
+        REQUIRE(ball != segments.end());
+        REQUIRE(ball->start[0] == expected[which][0]);
+        REQUIRE(ball->start[1] == expected[which][1]);
+        REQUIRE(ball->length == subsample);
+        if(which + 1 < expected.size()) {
+            REQUIRE(ball->end[0] == expected[which + 1][0]);
+            REQUIRE(ball->end[1] == expected[which + 1][1]);
+        }
+    }
+}
+
+TEST_CASE("Horizontal and vertical scanlines keep their geometry", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    auto plane = makePlane(100, 100, Colour::GREEN);
+    for(int i = 20; i < 30; ++i) {
+        paint(plane, i, 50, Colour::ORANGE);
+        paint(plane, 50, i, Colour::ORANGE);
+    }
+
+    auto horizontal = quex.classify<0>(plane, { 0, 50 }, { 99, 50 }, 2);
+    REQUIRE(horizontal.size() == 3);
+    REQUIRE(horizontal[1].colour == ObjectClass::BALL);
+    REQUIRE(horizontal[1].start[0] == 20);
+    REQUIRE(horizontal[1].end[0] == 30);
+    REQUIRE(horizontal[1].length == 10);
+    REQUIRE(horizontal[1].midpoint[0] == 25);
+    REQUIRE(horizontal[2].end[0] == 100);
+
+    auto vertical = quex.classify<0>(plane, { 50, 0 }, { 50, 99 }, 1);
+    REQUIRE(vertical.size() == 3);
+    REQUIRE(vertical[1].start[1] == 20);
+    REQUIRE(vertical[1].end[1] == 30);
+
+    // Backwards works too
+    auto backwards = quex.classify<0>(plane, { 99, 50 }, { 0, 50 }, 1);
+    REQUIRE(backwards.size() == 3);
+    REQUIRE(backwards[1].start[0] == 29);
+    REQUIRE(backwards[1].end[0] == 19);
+}
+
+TEST_CASE("Scan scheduler spends its sample budget across orientations", "[vision][classifier]") {
+
+    const arma::ivec2 topLeft = { 0, 0 };
+    const arma::ivec2 bottomRight = { 639, 479 };
+
+    ScanScheduler scheduler({ { 0, 2 }, { M_PI / 2, 1 }, { M_PI / 4, 1 }, { 3 * M_PI / 4, 1 } }, 2);
+
+    for(size_t budget : { 2000u, 20000u, 100000u }) {
+        auto lines = scheduler.schedule(topLeft, bottomRight, budget);
+        REQUIRE_FALSE(lines.empty());
+
+        size_t total = 0;
+        size_t horizontal = 0;
+        for(auto& l : lines) {
+            for(auto& p : { l.start, l.end }) {
+                REQUIRE(p[0] >= topLeft[0]);
+                REQUIRE(p[1] >= topLeft[1]);
+                REQUIRE(p[0] <= bottomRight[0]);
+                REQUIRE(p[1] <= bottomRight[1]);
+            }
+            total += ScanScheduler::samples(l);
+            horizontal += l.start[1] == l.end[1] ? ScanScheduler::samples(l) : 0;
+        }
+
+        // Within the budget but not wasting it, with horizontal lines getting their weight
+        REQUIRE(total <= budget);
+        REQUIRE(total >= budget * 0.8);
+        REQUIRE(horizontal <= budget * 2 / 5);
+        REQUIRE(horizontal >= budget * 2 / 5 * 0.8);
+    }
+
+    // Too small a budget for even one line at an angle gets no lines at that angle
+    REQUIRE(ScanScheduler({ { M_PI / 4, 1 } }).schedule(topLeft, bottomRight, 10).empty());
+}
+
+TEST_CASE("Benchmark samples and latency for equal recall with and without angled scanlines", "[vision][classifier][benchmark][.]") {
+
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+    constexpr uint FRAMES = 40;
+    constexpr double TARGET_RECALL = 0.95;
+
+    // Frames of field with balls and thin line markings at random angles, the markings are what axis scans miss
+    struct Object {
+        bool ball;
+        double x, y, angle;
+    };
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> ux(60, WIDTH - 60);
+    std::uniform_real_distribution<double> uy(60, HEIGHT - 60);
+    std::uniform_real_distribution<double> ua(0, M_PI);
+
+    std::vector<std::pair<ColourPlane, std::vector<Object>>> frames;
+    for(uint f = 0; f < FRAMES; ++f) {
+        auto plane = makePlane(WIDTH, HEIGHT, Colour::GREEN);
+        std::vector<Object> objects;
+
+        for(int i = 0; i < 6; ++i) {
+            Object o = { i % 2 == 0, ux(rng), uy(rng), ua(rng) };
+            objects.push_back(o);
+
+            for(int y = int(o.y) - 60; y <= int(o.y) + 60; ++y) {
+                for(int x = int(o.x) - 60; x <= int(o.x) + 60; ++x) {
+                    double rx = x - o.x;
+                    double ry = y - o.y;
+                    if(o.ball ? rx * rx + ry * ry < 12 * 12
+                              : std::abs(rx * std::cos(o.angle) + ry * std::sin(o.angle)) < 50
+                                && std::abs(-rx * std::sin(o.angle) + ry * std::cos(o.angle)) < 3) {
+                        paint(plane, x, y, o.ball ? Colour::ORANGE : Colour::YELLOW);
+                    }
+                }
+            }
+        }
+
+        frames.emplace_back(std::move(plane), std::move(objects));
+    }
+
+    QuexClassifier quex;
+
+    // Found when at least two scanlines cross it
+    auto evaluate = [&] (const ScanScheduler& scheduler, size_t budget, double& recall, double& seconds, size_t& samples) {
+
+        size_t found = 0;
+        size_t total = 0;
+        samples = 0;
+        seconds = 0;
+
+        auto lines = scheduler.schedule({ 0, 0 }, { int(WIDTH) - 1, int(HEIGHT) - 1 }, budget);
+        for(auto& l : lines) {
+            samples += ScanScheduler::samples(l);
+        }
+
+        for(auto& frame : frames) {
+            std::vector<std::vector<Segment>> results;
+
+            auto start = std::chrono::steady_clock::now();
+            for(auto& l : lines) {
+                results.push_back(quex.classify<0>(frame.first, l.start, l.end, l.subsample));
+            }
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            for(auto& o : frame.second) {
+                int hits = 0;
+                for(auto& segments : results) {
+                    for(auto& s : segments) {
+                        double dx = s.midpoint[0] - o.x;
+                        double dy = s.midpoint[1] - o.y;
+                        if(s.colour == (o.ball ? ObjectClass::BALL : ObjectClass::GOAL) && dx * dx + dy * dy < 60 * 60) {
+                            ++hits;
+                            break;
+                        }
+                    }
+                }
+                found += hits >= 2;
+                ++total;
+            }
+        }
+
+        recall = double(found) / total;
+        seconds /= FRAMES;
+    };
+
+    std::vector<std::pair<std::string, ScanScheduler>> configurations = {
+        { "horizontal:            ", ScanScheduler({ { 0, 1 } }) },
+        { "horizontal + vertical: ", ScanScheduler({ { 0, 1 }, { M_PI / 2, 1 } }) },
+        { "diagonals:             ", ScanScheduler({ { M_PI / 4, 1 }, { 3 * M_PI / 4, 1 } }) },
+        { "all four:              ", ScanScheduler({ { 0, 1 }, { M_PI / 2, 1 }, { M_PI / 4, 1 }, { 3 * M_PI / 4, 1 } }) },
+        { "six at 30 degrees:     ", ScanScheduler({ { 0, 1 }, { M_PI / 6, 1 }, { M_PI / 3, 1 }, { M_PI / 2, 1 }, { 2 * M_PI / 3, 1 }, { 5 * M_PI / 6, 1 } }) }
+    };
+
+    std::cout << "Smallest budget reaching " << TARGET_RECALL * 100 << "% recall at " << WIDTH << "x" << HEIGHT << std::endl;
+
+    for(auto& c : configurations) {
+
+        // Find the smallest budget that reaches the recall we want
+        size_t lo = 1000;
+        size_t hi = WIDTH * HEIGHT;
+        double recall = 0, seconds = 0;
+        size_t samples = 0;
+        while(hi - lo > hi / 100) {
+            size_t mid = (lo + hi) / 2;
+            evaluate(c.second, mid, recall, seconds, samples);
+            (recall >= TARGET_RECALL ? hi : lo) = mid;
+        }
+        evaluate(c.second, hi, recall, seconds, samples);
+
+        std::cout << "    " << c.first << samples << " samples, " << seconds * 1e6 << " us per frame, "
+                  << recall * 100 << "% recall" << std::endl;
+
+        REQUIRE(recall >= TARGET_RECALL);
+    }
+}
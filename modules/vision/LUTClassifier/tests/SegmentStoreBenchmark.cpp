@@ -0,0 +1,214 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+
+#include "QuexClassifier.h"
+#include "ColourPlane.h"
+#include "utility/vision/SyntheticFrames.h"
+
+using messages::input::Image;
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+using messages::vision::SegmentStore;
+using modules::vision::QuexClassifier;
+using modules::vision::ColourPlane;
+
+using utility::vision::synthetic::makeLUT;
+using utility::vision::synthetic::makeScene;
+using utility::vision::synthetic::scanFrame;
+
+namespace {
+    std::atomic<size_t> allocations(0);
+}
+
+// Count every heap allocation made by this test binary
+void* operator new(std::size_t size) {
+    ++allocations;
+    void* p = std::malloc(size ? size : 1);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+    using Segment = ClassifiedImage<ObjectClass, 0>::Segment;
+
+    // The multimap layout segments were stored in before, kept here to measure against
+    struct LegacySegment {
+        ObjectClass colour;
+        uint length;
+        uint subsample;
+        arma::ivec2 start;
+        arma::ivec2 end;
+        arma::ivec2 midpoint;
+        LegacySegment* previous;
+        LegacySegment* next;
+    };
+
+    using LegacyStore = std::multimap<ObjectClass, LegacySegment>;
+
+    void insertLegacy(LegacyStore& target, const std::vector<Segment>& segments) {
+
+        LegacySegment* previous = nullptr;
+
+        for(auto& s : segments) {
+            auto it = target.insert(std::make_pair(s.colour, LegacySegment { s.colour, s.length, s.subsample, s.start, s.end, s.midpoint, previous, nullptr }));
+            LegacySegment* current = &it->second;
+
+            if(previous) {
+                previous->next = current;
+            }
+            previous = current;
+        }
+    }
+
+    // The access patterns the detectors use: every segment of a class and the neighbours of some of them
+    template <typename Store>
+    long consume(const Store& store) {
+
+        long total = 0;
+
+        for(auto cls : { ObjectClass::BALL, ObjectClass::GOAL, ObjectClass::FIELD }) {
+            auto range = store.equal_range(cls);
+            for(auto it = range.first; it != range.second; ++it) {
+                auto& s = it->second;
+                total += s.start[0] + s.end[1] + s.midpoint[0];
+
+                if(s.previous && s.next && s.next->next) {
+                    total += s.previous->length + s.next->next->length;
+                }
+            }
+        }
+
+        return total;
+    }
+}
+
+TEST_CASE("Segment store keeps the segments and links of each scanline", "[vision][classifier]") {
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+    auto image = makeScene(320, 240, 0);
+
+    SegmentStore<ObjectClass>::Pool pool;
+    SegmentStore<ObjectClass> store(pool.acquire());
+    LegacyStore legacy;
+
+    scanFrame(320, 240, [&] (const arma::ivec2& s, const arma::ivec2& e, uint subsample) {
+        auto segments = quex.classify(image, lut, s, e, subsample);
+        store.insertLine(segments.begin(), segments.end());
+        insertLegacy(legacy, segments);
+        return segments;
+    });
+
+    REQUIRE(store.size() == legacy.size());
+    REQUIRE(consume(store) == consume(legacy));
+
+    for(auto cls : { ObjectClass::UNKNOWN, ObjectClass::FIELD, ObjectClass::BALL, ObjectClass::GOAL, ObjectClass::LINE }) {
+        REQUIRE(store.count(cls) == legacy.count(cls));
+    }
+
+    // Walking forward then back along a scanline must return to where we started
+    for(auto& pair : store) {
+        auto& s = pair.second;
+        if(s.next) {
+            REQUIRE(s.next->start[0] >= s.start[0]);
+            REQUIRE(s.next->previous->start[0] == s.start[0]);
+            REQUIRE(s.next->previous->start[1] == s.start[1]);
+        }
+    }
+}
+
+TEST_CASE("Benchmark segment storage allocations and latency over a replayed image set", "[vision][classifier][benchmark][.]") {
+
+    constexpr uint FRAMES = 20;
+    constexpr uint WIDTH = 1280;
+    constexpr uint HEIGHT = 960;
+
+    QuexClassifier quex;
+    auto lut = makeLUT();
+
+    // Classify the image set once and replay the scanlines into each store
+    std::vector<std::vector<std::vector<Segment>>> replay(FRAMES);
+    for(uint i = 0; i < FRAMES; ++i) {
+        auto image = makeScene(WIDTH, HEIGHT, i);
+        ColourPlane plane;
+        plane.classify(image, lut);
+
+        scanFrame(WIDTH, HEIGHT, [&] (const arma::ivec2& s, const arma::ivec2& e, uint subsample) {
+            replay[i].push_back(quex.classify<0>(plane, s, e, subsample));
+            return replay[i].back();
+        });
+    }
+
+    long legacyTotal = 0;
+    size_t legacyAllocations = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for(auto& frame : replay) {
+        LegacyStore store;
+        for(auto& line : frame) {
+            insertLegacy(store, line);
+        }
+        legacyTotal += consume(store);
+    }
+    double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    legacyAllocations = allocations - legacyAllocations;
+
+    // Run the pooled store twice so the second pass shows the steady state once the arena has grown
+    SegmentStore<ObjectClass>::Pool pool;
+    long flatTotal = 0;
+    size_t flatAllocations = 0;
+    double flatSeconds = 0;
+    for(int pass = 0; pass < 2; ++pass) {
+        flatTotal = 0;
+        flatAllocations = allocations;
+        start = std::chrono::steady_clock::now();
+        for(auto& frame : replay) {
+            SegmentStore<ObjectClass> store(pool.acquire());
+            for(auto& line : frame) {
+                store.insertLine(line.begin(), line.end());
+            }
+            flatTotal += consume(store);
+        }
+        flatSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        flatAllocations = allocations - flatAllocations;
+    }
+
+    std::cout << "Segment storage over " << FRAMES << " replayed frames" << std::endl
+              << "    multimap:     " << legacyAllocations / FRAMES << " allocations, "
+              << legacySeconds * 1000 / FRAMES << " ms per frame" << std::endl
+              << "    pooled flat:  " << flatAllocations / FRAMES << " allocations, "
+              << flatSeconds * 1000 / FRAMES << " ms per frame" << std::endl;
+
+    REQUIRE(flatTotal == legacyTotal);
+}
@@ -0,0 +1,210 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "messages/vision/ClassifiedImage.h"
+
+using messages::vision::ObjectClass;
+using messages::vision::ClassifiedImage;
+
+namespace {
+
+    using Image = ClassifiedImage<ObjectClass, 0>;
+
+    // The green points a scan of the given spacing could find, either noisy or a bowl that keeps every point
+    std::vector<arma::ivec2> greenPoints(int width, int height, int spacing, bool bowl, std::mt19937& rng) {
+
+        std::uniform_int_distribution<int> height_dist(0, height - 1);
+        std::vector<arma::ivec2> points;
+
+        for(int x = 0; x < width; x += spacing) {
+            double t = double(x) / width - 0.5;
+            points.push_back({ x, bowl ? int(height / 4 + t * t * height) : height_dist(rng) });
+        }
+
+        if((width - 1) % spacing != 0) {
+            points.push_back({ width - 1, bowl ? int(height / 2) : height_dist(rng) });
+        }
+
+        return points;
+    }
+
+    // The erase based hull the visual horizon finder used before, kept here to measure against
+    void legacyHull(std::vector<arma::ivec2>& visualHorizon) {
+
+        for(auto a = visualHorizon.begin(); a < visualHorizon.end() - 2;) {
+
+            auto b = a + 1;
+            auto c = a + 2;
+
+            bool concave = 0 <   (double(a->at(0)) - double(b->at(0))) * (double(c->at(1)) - double(b->at(1)))
+                               - (double(a->at(1)) - double(b->at(1))) * (double(c->at(0)) - double(b->at(0)));
+
+            if(concave) {
+                visualHorizon.erase(b);
+                a = a == visualHorizon.begin() ? a : --a;
+            }
+            else {
+                ++a;
+            }
+        }
+    }
+
+    // The binary search lookup visualHorizonAtPoint did on every call before
+    int legacyAtPoint(const std::vector<arma::ivec2>& visualHorizon, int x) {
+
+        auto p2 = std::upper_bound(visualHorizon.begin(), visualHorizon.end(), x, [] (const int& k, const arma::ivec2& v) {
+            return k < v[0];
+        });
+        p2 -= p2 == visualHorizon.end() ? 1 : 0;
+        auto p1 = p2 - 1;
+
+        utility::math::geometry::Line l({ double(p1->at(0)), double(p1->at(1))}, {double(p2->at(0)), double(p2->at(1))});
+
+        return int(lround(l.y(x)));
+    }
+
+    void buildHorizon(Image& image, const std::vector<arma::ivec2>& points) {
+        image.visualHorizon.clear();
+        for(auto& p : points) {
+            image.addVisualHorizonPoint(p);
+        }
+        image.finishVisualHorizon();
+    }
+}
+
+TEST_CASE("Incremental visual horizon matches the erase based hull and lookup", "[vision][classifier]") {
+
+    constexpr int WIDTH = 320;
+    constexpr int HEIGHT = 240;
+
+    std::mt19937 rng(42);
+
+    for(int spacing : { 1, 3, 8, 30, 400 }) {
+        for(bool bowl : { false, true }) {
+            for(int trial = 0; trial < 20; ++trial) {
+
+                auto points = greenPoints(WIDTH, HEIGHT, spacing, bowl, rng);
+
+                auto legacy = points;
+                legacyHull(legacy);
+
+                Image image;
+                image.dimensions = { uint(WIDTH), uint(HEIGHT) };
+                buildHorizon(image, points);
+
+                REQUIRE(image.visualHorizon.size() == legacy.size());
+                for(uint i = 0; i < legacy.size(); ++i) {
+                    REQUIRE(image.visualHorizon[i][0] == legacy[i][0]);
+                    REQUIRE(image.visualHorizon[i][1] == legacy[i][1]);
+                }
+
+                // The extremes must be where the finder used to put them
+                REQUIRE(image.maxVisualHorizon->at(1) == std::max(legacy.front()[1], legacy.back()[1]));
+                for(auto& p : legacy) {
+                    REQUIRE(image.minVisualHorizon->at(1) <= p[1]);
+                }
+
+                // Every column, and a little past each edge, must give the old answer
+                for(int x = -10; x < WIDTH + 10; ++x) {
+                    if(x >= legacy.front()[0]) {
+                        REQUIRE(image.visualHorizonAtPoint(x) == legacyAtPoint(legacy, x));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Benchmark the visual horizon hull and lookups at high scan densities", "[vision][classifier][benchmark][.]") {
+
+    constexpr int WIDTH = 1280;
+    constexpr int HEIGHT = 960;
+    constexpr int FRAMES = 200;
+
+    // Roughly the lookups the detectors make per frame (every segment start and end is checked)
+    constexpr int LOOKUPS = 20000;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> column(0, WIDTH - 1);
+    std::vector<int> queries(LOOKUPS);
+    for(auto& q : queries) {
+        q = column(rng);
+    }
+
+    for(int spacing : { 1, 2, 4, 8 }) {
+        for(bool bowl : { false, true }) {
+
+            std::vector<std::vector<arma::ivec2>> frames;
+            for(int i = 0; i < FRAMES; ++i) {
+                frames.push_back(greenPoints(WIDTH, HEIGHT, spacing, bowl, rng));
+            }
+
+            long legacyTotal = 0;
+            double legacyHullSeconds = 0;
+            double legacyLookupSeconds = 0;
+            for(auto& frame : frames) {
+                auto start = std::chrono::steady_clock::now();
+                auto hull = frame;
+                legacyHull(hull);
+                auto middle = std::chrono::steady_clock::now();
+                for(int q : queries) {
+                    legacyTotal += legacyAtPoint(hull, q);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                legacyHullSeconds += std::chrono::duration<double>(middle - start).count();
+                legacyLookupSeconds += std::chrono::duration<double>(end - middle).count();
+            }
+
+            long total = 0;
+            double hullSeconds = 0;
+            double lookupSeconds = 0;
+            for(auto& frame : frames) {
+                Image image;
+                image.dimensions = { uint(WIDTH), uint(HEIGHT) };
+                image.visualHorizon.reserve(frame.size());
+
+                auto start = std::chrono::steady_clock::now();
+                buildHorizon(image, frame);
+                auto middle = std::chrono::steady_clock::now();
+                for(int q : queries) {
+                    total += image.visualHorizonAtPoint(q);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                hullSeconds += std::chrono::duration<double>(middle - start).count();
+                lookupSeconds += std::chrono::duration<double>(end - middle).count();
+            }
+
+            std::cout << "Visual horizon, spacing " << spacing << (bowl ? " bowl" : " noisy") << " (" << frames.front().size() << " points)" << std::endl
+                      << "    erase hull:       " << legacyHullSeconds * 1e6 / FRAMES << " us, "
+                      << "binary search lookups: " << legacyLookupSeconds * 1e6 / FRAMES << " us per frame" << std::endl
+                      << "    monotone chain:   " << hullSeconds * 1e6 / FRAMES << " us, "
+                      << "column table lookups:  " << lookupSeconds * 1e6 / FRAMES << " us per frame" << std::endl;
+
+            REQUIRE(total == legacyTotal);
+        }
+    }
+}
@@ -25,7 +25,7 @@
 #include "messages/localisation/FieldObject.h"
 #include "messages/input/Sensors.h"
 #include "messages/support/Configuration.h"
-#include "utility/math/kalman/UKF.h"
+#include "utility/math/kalman/FixedUKF.h"
 #include "utility/math/vision.h"
 #include "utility/math/matrix.h"
 #include "utility/math/angle.h"
@@ -43,7 +43,7 @@ namespace modules{
         private:
             std::vector<float> featureStrengths;
             std::vector<typename FeatureDetectorClass::ExtractedFeature> features;
-            std::vector<utility::math::kalman::UKF<utility::math::kalman::InverseDepthPointModel>> featureFilters;
+            std::vector<utility::math::kalman::FixedUKF<utility::math::kalman::InverseDepthPointModel>> featureFilters;
 
             static constexpr size_t MODEL_SIZE = utility::math::kalman::InverseDepthPointModel::size;
             using StateVector = arma::vec::fixed<MODEL_SIZE>;
@@ -246,7 +246,7 @@ namespace modules{
                         expectations.push_back(false);
                         auto initialMean = getInitialMean(extractedFeatures[eFI].screenAngular, worldToCameraTransform, self, sensors);
                         auto initialCovariance = getInitialCovariance(extractedFeatures[eFI].screenAngular, worldToCameraTransform, self, sensors);
-                        featureFilters.push_back(utility::math::kalman::UKF<utility::math::kalman::InverseDepthPointModel>(initialMean, initialCovariance));
+                        featureFilters.push_back(utility::math::kalman::FixedUKF<utility::math::kalman::InverseDepthPointModel>(initialMean, initialCovariance));
                     }
                 }
 
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MESSAGES_INPUT_CAMERAFRAMESET_H
+#define MESSAGES_INPUT_CAMERAFRAMESET_H
+
+#include <cstdint>
+#include <vector>
+#include <nuclear>
+
+namespace messages {
+    namespace input {
+
+        /**
+         * One frame from every synchronised camera, captured at (close enough to) the same time.
+         *
+         * Each camera's Image<N> is emitted before the set that contains it, so a reaction on the set can get the
+         * matching images With<Image<N>> and check their timestamps against the frames here.
+         */
+        struct CameraFrameSet {
+            struct Frame {
+                /// The camera (the N of its Image<N>) this frame came from
+                uint cameraID;
+                /// The frame number the camera gave this frame
+                uint32_t sequence;
+                /// When the camera captured the frame, the same as its image's timestamp
+                NUClear::clock::time_point timestamp;
+            };
+
+            /// Counts up by one for each set
+            uint64_t sequence;
+            /// When the earliest frame in the set was captured
+            NUClear::clock::time_point timestamp;
+            /// How long after the earliest frame the latest one was captured
+            NUClear::clock::duration spread;
+            /// One frame per camera, ordered by camera
+            std::vector<Frame> frames;
+        };
+
+    }  // input
+}  // messages
+
+#endif  // MESSAGES_INPUT_CAMERAFRAMESET_H
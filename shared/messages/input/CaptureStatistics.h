@@ -0,0 +1,62 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MESSAGES_INPUT_CAPTURESTATISTICS_H
+#define MESSAGES_INPUT_CAPTURESTATISTICS_H
+
+#include <cstdint>
+#include <string>
+
+namespace messages {
+    namespace input {
+
+        /**
+         * How well a camera has been keeping up since its last statistics were emitted
+         */
+        struct CaptureStatistics {
+            /// The device the frames came from
+            std::string device;
+            /// The number of buffers the device captures into
+            uint buffers;
+
+            /// Frames that were captured and emitted
+            uint64_t frames;
+            /// Frames the device skipped because it had no free buffer to capture them into
+            uint64_t dropped;
+            /// Frames that were captured but could not be decoded
+            uint64_t corrupt;
+            /// Frames that needed a new output buffer because none were free to reuse
+            uint64_t allocations;
+            /// Frames that were copied out of the device's buffer rather than lent to their image
+            uint64_t copied;
+
+            /// The most frames that were waiting in the device's buffers to be read at once (0 if it can't tell us)
+            uint maxQueued;
+            /// The most of the device's buffers that were lent to images at once
+            uint maxLent;
+
+            /// Seconds from the frame being captured to the image being emitted
+            double meanLatency;
+            double maxLatency;
+        };
+
+    }  // input
+}  // messages
+
+#endif  // MESSAGES_INPUT_CAPTURESTATISTICS_H
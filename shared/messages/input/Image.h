@@ -22,10 +22,14 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <nuclear>
 #include <armadillo>
 
+#include "utility/image/Demosaic.h"
+
 namespace messages {
     namespace input {
 
@@ -64,8 +68,21 @@ namespace messages {
                 uint cameraID;
             };
 
+            Image() = default;
+            Image(const Image&) = default;
+            Image(Image&&) = default;
+            Image& operator=(const Image&) = default;
+            Image& operator=(Image&&) = default;
+
+            // Hand the source buffer back to whoever lent it to us (e.g. a camera's buffer pool)
+            ~Image() {
+                if(recycle && source.capacity() > 0) {
+                    recycle(std::move(source));
+                }
+            }
+
             inline uint get(const uint& x, const uint& y) const {
-                return source[y * width() + x];
+                return data()[y * width() + x];
             }
 
             inline arma::Col<uint8_t>::fixed<3> operator()(const uint& x, const uint& y) const {
@@ -89,6 +106,26 @@ namespace messages {
                 return output;
             }
 
+            /**
+             * Gets the whole frame demosaiced into a YCbCr444 plane with the same values as operator().
+             * The first call does the demosaic (in one vectorised pass, split into bands of rows over up to threads
+             * threads) and every later call shares it.
+             */
+            inline const utility::image::DemosaicedPlane& demosaiced(const uint& threads = 1) const {
+                return demosaicCache.get(data(), width(), height(), threads);
+            }
+
+            /**
+             * Gets the raw pixels, which are in the borrowed buffer if there is one or source if not.
+             */
+            inline const uint8_t* data() const {
+                return borrowed ? borrowed.get() : source.data();
+            }
+
+            inline size_t bytes() const {
+                return borrowed ? borrowedBytes : source.size();
+            }
+
             inline uint width() const {
                 return dimensions[0];
             }
@@ -104,6 +141,17 @@ namespace messages {
             std::vector<uint8_t> source;
             Lens lens;
             arma::mat44 cameraToGround;
+
+            // If set this is given the source buffer when the image is destroyed so it can be reused
+            std::function<void (std::vector<uint8_t>&&)> recycle;
+
+            // If set the pixels are in this buffer instead of source. It belongs to someone else (e.g. a camera's DMA
+            // ring) and is given back to them when the last image sharing it is destroyed
+            std::shared_ptr<const uint8_t> borrowed;
+            size_t borrowedBytes = 0;
+
+        private:
+            utility::image::DemosaicCache demosaicCache;
         };
 
     }  // input
@@ -0,0 +1,37 @@
+#ifndef MESSAGES_ROBOTX_LANDMARKMAP_H
+#define MESSAGES_ROBOTX_LANDMARKMAP_H
+
+#include <vector>
+#include <armadillo>
+
+namespace messages {
+    namespace robotx {
+
+        /**
+         * Every landmark robotx::SLAM has mapped, in north/east coordinates
+         */
+        struct LandmarkMap {
+
+            enum class Type {
+                BUOY,
+                MARKER
+            };
+
+            struct Landmark {
+                uint id;
+                Type type;
+                arma::vec2 position;
+                arma::mat22 covariance;
+                uint observations;
+                // False once the landmark has been marginalised out of the filter
+                bool active;
+            };
+
+            uint64_t timestamp;
+            std::vector<Landmark> landmarks;
+
+        };
+    }
+}
+
+#endif // MESSAGES_ROBOTX_LANDMARKMAP_H
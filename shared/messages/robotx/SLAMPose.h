@@ -0,0 +1,24 @@
+#ifndef MESSAGES_ROBOTX_SLAMPOSE_H
+#define MESSAGES_ROBOTX_SLAMPOSE_H
+
+#include <armadillo>
+
+namespace messages {
+    namespace robotx {
+
+        /**
+         * The boat pose from robotx::SLAM, in the same north/east/yaw frame as RobotXState
+         */
+        struct SLAMPose {
+
+            uint64_t timestamp;
+
+            // North, east and yaw (radians clockwise from north)
+            arma::vec3 pose;
+            arma::mat33 covariance;
+
+        };
+    }
+}
+
+#endif // MESSAGES_ROBOTX_SLAMPOSE_H
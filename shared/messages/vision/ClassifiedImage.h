@@ -20,11 +20,13 @@
 #ifndef MESSAGES_VISION_CLASSIFIEDIMAGE_H
 #define MESSAGES_VISION_CLASSIFIEDIMAGE_H
 
-#include <map>
+#include <algorithm>
+#include <cmath>
 #include <armadillo>
 
 #include "messages/input/Sensors.h"
 #include "messages/input/Image.h"
+#include "messages/vision/SegmentStore.h"
 #include "utility/math/geometry/Line.h"
 
 namespace messages {
@@ -60,9 +62,6 @@ namespace messages {
                 arma::ivec2 start;
                 arma::ivec2 end;
                 arma::ivec2 midpoint;
-
-                Segment* previous;
-                Segment* next;
             };
 
             // The sensor frame that happened with this image
@@ -82,12 +81,82 @@ namespace messages {
             std::vector<arma::ivec2>::iterator maxVisualHorizon;
             std::vector<arma::ivec2>::iterator minVisualHorizon;
 
-            // Our segments, split into vertical and horizontal components
-            std::multimap<TClass, Segment> horizontalSegments;
-            std::multimap<TClass, Segment> verticalSegments;
+            // The height of the visual horizon at each column of the image
+            std::vector<int> visualHorizonColumns;
+
+            // Our segments, split into vertical and horizontal components (neighbours on a scanline are linked)
+            SegmentStore<TClass> horizontalSegments;
+            SegmentStore<TClass> verticalSegments;
+
+            /**
+             * Adds the next point of the visual horizon (they are added from left to right). Points this would leave
+             * concave are removed so the visual horizon is always a convex hull (Andrew's monotone chain).
+             */
+            void addVisualHorizonPoint(const arma::ivec2& c) {
+
+                while(visualHorizon.size() >= 2) {
+                    const auto& a = visualHorizon[visualHorizon.size() - 2];
+                    const auto& b = visualHorizon[visualHorizon.size() - 1];
+
+                    // Get the Z component of a cross product to check if it is concave
+                    bool concave = 0 <   (double(a[0]) - double(b[0])) * (double(c[1]) - double(b[1]))
+                                       - (double(a[1]) - double(b[1])) * (double(c[0]) - double(b[0]));
+
+                    if(!concave) {
+                        break;
+                    }
+                    visualHorizon.pop_back();
+                }
+
+                visualHorizon.push_back(c);
+            }
+
+            /**
+             * Once all the visual horizon points are added, finds its highest and lowest points and works out its
+             * height at every column of the image.
+             */
+            void finishVisualHorizon() {
+
+                // As this is a convex hull, the max visual horizon will always be at one of the edges
+                maxVisualHorizon = visualHorizon.front()[1] > visualHorizon.back()[1] ? visualHorizon.begin() : visualHorizon.end() - 1;
+
+                // As this is a convex function, we just need to progress till the next point is lower
+                for(minVisualHorizon = visualHorizon.begin();
+                    minVisualHorizon < visualHorizon.end() - 1
+                    && minVisualHorizon->at(1) > (minVisualHorizon + 1)->at(1);
+                    ++minVisualHorizon);
+
+                // Each column takes its height from the segment that starts at or before it, the first and last
+                // segments carry on to the edges of the image
+                const int width = int(dimensions[0]);
+                visualHorizonColumns.resize(width);
+
+                if(visualHorizon.size() < 2) {
+                    std::fill(visualHorizonColumns.begin(), visualHorizonColumns.end(), visualHorizon.empty() ? int(dimensions[1]) - 1 : int(visualHorizon.front()[1]));
+                    return;
+                }
+
+                for(auto p2 = visualHorizon.begin() + 1; p2 != visualHorizon.end(); ++p2) {
+                    auto p1 = p2 - 1;
+
+                    int first = p1 == visualHorizon.begin() ? 0 : std::max(int(p1->at(0)), 0);
+                    int last = p2 + 1 == visualHorizon.end() ? width - 1 : std::min(int(p2->at(0)), width) - 1;
+
+                    utility::math::geometry::Line l({ double(p1->at(0)), double(p1->at(1))}, {double(p2->at(0)), double(p2->at(1))});
+
+                    for(int x = first; x <= last; ++x) {
+                        visualHorizonColumns[x] = int(lround(l.y(x)));
+                    }
+                }
+            }
 
             int visualHorizonAtPoint(int x) const {
 
+                // Inside the image we worked it out when we found the visual horizon
+                if(x >= 0 && x < int(visualHorizonColumns.size())) {
+                    return visualHorizonColumns[x];
+                }
+
                 struct {
                     bool operator()(const int& k, const arma::ivec& v) {
                         return k < v[0];
@@ -102,6 +171,7 @@ namespace messages {
 
                 auto p2 = std::upper_bound(visualHorizon.begin(), visualHorizon.end(), x, comparator);
                 p2 -= p2 == visualHorizon.end() ? 1 : 0;
+                p2 += p2 == visualHorizon.begin() ? 1 : 0;
                 auto p1 = p2 - 1;
 
                 utility::math::geometry::Line l({ double(p1->at(0)), double(p1->at(1))}, {double(p2->at(0)), double(p2->at(1))});
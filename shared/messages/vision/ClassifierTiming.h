@@ -0,0 +1,49 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MESSAGES_VISION_CLASSIFIERTIMING_H
+#define MESSAGES_VISION_CLASSIFIERTIMING_H
+
+#include <chrono>
+
+namespace messages {
+    namespace vision {
+
+        /**
+         * How long each stage of classifying an image took, emitted by the classifier after every image
+         */
+        struct ClassifierTiming {
+            using Duration = std::chrono::steady_clock::duration;
+
+            /// Classifying the whole frame up front (zero when we are not classifying once)
+            Duration classifyOnce;
+            Duration horizon;
+            Duration visualHorizon;
+            Duration ball;
+            /// Scanning the scan planner's regions of interest (zero when it is not planning)
+            Duration focus;
+            Duration ballEnhance;
+            /// The whole reaction including setting up the classified image
+            Duration total;
+        };
+
+    }  // vision
+}  // messages
+
+#endif  // MESSAGES_VISION_CLASSIFIERTIMING_H
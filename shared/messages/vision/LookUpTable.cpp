@@ -25,7 +25,7 @@
 namespace messages {
     namespace vision {
 
-        LookUpTable::LookUpTable(uint8_t bitsY, uint8_t bitsCb, uint8_t bitsCr, std::vector<Colour>&& data)
+        LookUpTable::LookUpTable(uint8_t bitsY, uint8_t bitsCb, uint8_t bitsCr)
             : BITS_C1(bitsY)
             , BITS_C2(bitsCb)
             , BITS_C3(bitsCr)
@@ -36,26 +36,77 @@ namespace messages {
             , BITS_C2_C3(BITS_C2 + BITS_C3)
             , BITS_C2_MASK(std::pow(2, BITS_C2) - 1)
             , BITS_C3_MASK(std::pow(2, BITS_C3) - 1)
-            , data(std::move(data)) {
+            , data()
+            , shared()
+            , table(nullptr) {
+        }
+
+        LookUpTable::LookUpTable(uint8_t bitsY, uint8_t bitsCb, uint8_t bitsCr, std::vector<Colour>&& data)
+            : LookUpTable(bitsY, bitsCb, bitsCr) {
+
+            this->data = std::move(data);
+            table = this->data.data();
+        }
+
+        LookUpTable::LookUpTable(uint8_t bitsY, uint8_t bitsCb, uint8_t bitsCr, std::shared_ptr<const Colour> table)
+            : LookUpTable(bitsY, bitsCb, bitsCr) {
+
+            shared = std::move(table);
+            this->table = shared.get();
+        }
+
+        LookUpTable::LookUpTable() : LUT_SIZE(0), table(nullptr) {
         }
 
-        LookUpTable::LookUpTable() {
+        LookUpTable::LookUpTable(const LookUpTable& other) : table(nullptr) {
+            *this = other;
+        }
+
+        LookUpTable& LookUpTable::operator=(const LookUpTable& other) {
+
+            if(this != &other) {
+                BITS_C1 = other.BITS_C1;
+                BITS_C2 = other.BITS_C2;
+                BITS_C3 = other.BITS_C3;
+                LUT_SIZE = other.LUT_SIZE;
+                BITS_C1_REMOVED = other.BITS_C1_REMOVED;
+                BITS_C2_REMOVED = other.BITS_C2_REMOVED;
+                BITS_C3_REMOVED = other.BITS_C3_REMOVED;
+                BITS_C2_C3 = other.BITS_C2_C3;
+                BITS_C2_MASK = other.BITS_C2_MASK;
+                BITS_C3_MASK = other.BITS_C3_MASK;
+
+                // Shared tables are never written to so copies can share them too
+                data = other.data;
+                shared = other.shared;
+                table = shared ? shared.get() : data.data();
+            }
+
+            return *this;
         }
 
         const Colour& LookUpTable::operator()(const arma::Col<uint8_t>::fixed<3>& p) const {
-            return data[getLUTIndex(p)];
+            return table[getLUTIndex(p)];
         }
 
         Colour& LookUpTable::operator()(const arma::Col<uint8_t>::fixed<3>& p) {
+
+            // Take our own copy before we change anything
+            if(shared) {
+                data.assign(table, table + LUT_SIZE);
+                shared.reset();
+                table = data.data();
+            }
+
             return data[getLUTIndex(p)];
         }
 
         std::string LookUpTable::getData() const {
-            return std::string(data.begin(), data.end());
+            return std::string(table, table + LUT_SIZE);
         }
 
-        const std::vector<Colour>& LookUpTable::getRawData() const {
-            return data;
+        const Colour* LookUpTable::getRawData() const {
+            return table;
         }
 
         uint LookUpTable::getLUTIndex(const arma::Col<uint8_t>::fixed<3>& colour) const {
@@ -63,8 +63,23 @@ namespace messages {
             LookUpTable();
             LookUpTable(uint8_t bitsC1, uint8_t bitsC2, uint8_t bitsC3, std::vector<Colour>&& data);
 
+            /*!
+                @brief Builds a table over memory someone else owns (e.g. a mapped LUT file)
+                @param table the LUT_SIZE colours of the table, they are never written to
+             */
+            LookUpTable(uint8_t bitsC1, uint8_t bitsC2, uint8_t bitsC3, std::shared_ptr<const Colour> table);
+
+            LookUpTable(const LookUpTable& other);
+            LookUpTable(LookUpTable&& other) = default;
+            LookUpTable& operator=(const LookUpTable& other);
+            LookUpTable& operator=(LookUpTable&& other) = default;
+
             std::string getData() const;
-            const std::vector<Colour>& getRawData() const;
+
+            /*!
+                @brief Gets the LUT_SIZE colours of the table, indexed by getLUTIndex
+             */
+            const Colour* getRawData() const;
 
             /*!
                 @brief Classifies a pixel
@@ -72,6 +87,9 @@ namespace messages {
                 @return Returns the colour classification of this pixel
              */
             const messages::vision::Colour& operator()(const arma::Col<uint8_t>::fixed<3>& p) const;
+            /*!
+                @brief Gets a pixel's classification to change it. A table over shared memory is copied first.
+             */
             messages::vision::Colour& operator()(const arma::Col<uint8_t>::fixed<3>& p);
 
             /*!
@@ -81,12 +99,24 @@ namespace messages {
              */
             uint getLUTIndex(const arma::Col<uint8_t>::fixed<3>& colour) const;
 
+            /*!
+             *   @brief Gets the index of a pixel stored as three packed bytes (e.g. a demosaiced plane)
+             *   @param colour A pointer to the three channels of the pixel.
+             *   @return Returns the colour index for the given pixel.
+             */
+            inline uint getLUTIndex(const uint8_t* colour) const {
+                return ((colour[0] >> BITS_C1_REMOVED) << BITS_C2_C3)
+                     + ((colour[1] >> BITS_C2_REMOVED) << BITS_C3)
+                     +  (colour[2] >> BITS_C3_REMOVED);
+            }
+
             /*!
              *   @brief The inverse of getLUTIndex
              *   NOTE: This inverse is NOT injective (e.g. not 1-to-1)
              */
             arma::Col<uint8_t>::fixed<3> getPixelFromIndex(const uint& index) const;
         private:
+            LookUpTable(uint8_t bitsC1, uint8_t bitsC2, uint8_t bitsC3);
 
             uint8_t BITS_C1_REMOVED;
             uint8_t BITS_C2_REMOVED;
@@ -94,7 +124,11 @@ namespace messages {
             uint8_t BITS_C2_C3;
             uint8_t BITS_C2_MASK;
             uint8_t BITS_C3_MASK;
+
+            // The table is either held here, or in the shared memory it was built over
             std::vector<Colour> data;
+            std::shared_ptr<const Colour> shared;
+            const Colour* table;
         };
 
         struct SaveLookUpTable {
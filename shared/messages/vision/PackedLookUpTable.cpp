@@ -0,0 +1,165 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "PackedLookUpTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace messages {
+    namespace vision {
+
+        // The colour each code stands for (codes past the eight colours are never written)
+        const std::array<Colour, 16> PackedLookUpTable::COLOURS = {{
+            UNCLASSIFIED, WHITE, GREEN, ORANGE, YELLOW, CYAN, MAGENTA, WHITE_GREEN,
+            UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED, UNCLASSIFIED
+        }};
+
+        uint8_t PackedLookUpTable::code(const Colour& colour) {
+            switch(colour) {
+                case UNCLASSIFIED: return 0;
+                case WHITE:        return 1;
+                case GREEN:        return 2;
+                case ORANGE:       return 3;
+                case YELLOW:       return 4;
+                case CYAN:         return 5;
+                case MAGENTA:      return 6;
+                case WHITE_GREEN:  return 7;
+            }
+            throw std::invalid_argument(std::string("Can't pack the unknown colour '") + char(colour) + "' into a LUT");
+        }
+
+        bool PackedLookUpTable::canPack(const LookUpTable& lut) {
+            const Colour* table = lut.getRawData();
+            return std::all_of(table, table + lut.LUT_SIZE, [] (const Colour& colour) {
+                // Every colour is one of the first eight codes
+                return std::find(COLOURS.begin(), COLOURS.begin() + 8, colour) != COLOURS.begin() + 8;
+            });
+        }
+
+        PackedLookUpTable::PackedLookUpTable()
+            : BITS_C1(0)
+            , BITS_C2(0)
+            , BITS_C3(0)
+            , LUT_SIZE(0)
+            , layout(Layout::LINEAR)
+            , BITS_C1_REMOVED(8)
+            , BITS_C2_REMOVED(8)
+            , BITS_C3_REMOVED(8)
+            , slot()
+            , codes() {
+        }
+
+        PackedLookUpTable::PackedLookUpTable(const LookUpTable& lut, Layout layout)
+            : BITS_C1(lut.BITS_C1)
+            , BITS_C2(lut.BITS_C2)
+            , BITS_C3(lut.BITS_C3)
+            , LUT_SIZE(lut.LUT_SIZE)
+            , layout(layout)
+            , BITS_C1_REMOVED(sizeof(uint8_t) * 8 - BITS_C1)
+            , BITS_C2_REMOVED(sizeof(uint8_t) * 8 - BITS_C2)
+            , BITS_C3_REMOVED(sizeof(uint8_t) * 8 - BITS_C3)
+            , slot()
+            , codes((LUT_SIZE + 1) / 2, 0) {
+
+            const uint8_t bits[3] = { BITS_C1, BITS_C2, BITS_C3 };
+
+            for(auto& s : slot) {
+                s.fill(0);
+            }
+
+            if(layout == Layout::LINEAR) {
+                // Channel one is the most significant, as in getLUTIndex
+                for(uint v = 0; v < (1u << BITS_C1); ++v) slot[0][v] = v << (BITS_C2 + BITS_C3);
+                for(uint v = 0; v < (1u << BITS_C2); ++v) slot[1][v] = v << BITS_C3;
+                for(uint v = 0; v < (1u << BITS_C3); ++v) slot[2][v] = v;
+            }
+            else {
+                // Deal out the bits a level at a time, lowest first, with channel three lowest in each level
+                uint next = 0;
+                for(uint bit = 0; bit < 8; ++bit) {
+                    for(int channel = 2; channel >= 0; --channel) {
+                        if(bit < bits[channel]) {
+                            for(uint v = 0; v < (1u << bits[channel]); ++v) {
+                                slot[channel][v] |= ((v >> bit) & 1) << next;
+                            }
+                            ++next;
+                        }
+                    }
+                }
+            }
+
+            const Colour* table = lut.getRawData();
+            for(uint i = 0; i < LUT_SIZE; ++i) {
+                uint p = position(i);
+                codes[p >> 1] |= code(table[i]) << ((p & 1) << 2);
+            }
+        }
+
+        LookUpTable PackedLookUpTable::unpack() const {
+
+            std::vector<Colour> data(LUT_SIZE);
+            for(uint i = 0; i < LUT_SIZE; ++i) {
+                data[i] = getColour(i);
+            }
+
+            return LookUpTable(BITS_C1, BITS_C2, BITS_C3, std::move(data));
+        }
+
+        uint PackedLookUpTable::position(const uint& index) const {
+            return slot[0][index >> (BITS_C2 + BITS_C3)]
+                 | slot[1][(index >> BITS_C3) & ((1u << BITS_C2) - 1)]
+                 | slot[2][index & ((1u << BITS_C3) - 1)];
+        }
+
+        Colour PackedLookUpTable::operator()(const arma::Col<uint8_t>::fixed<3>& p) const {
+            return get(position(getLUTIndex(p)));
+        }
+
+        Colour PackedLookUpTable::getColour(const uint& index) const {
+            return get(position(index));
+        }
+
+        void PackedLookUpTable::setColour(const uint& index, const Colour& colour) {
+            uint p = position(index);
+            uint shift = (p & 1) << 2;
+            codes[p >> 1] = (codes[p >> 1] & ~(0xF << shift)) | (code(colour) << shift);
+        }
+
+        uint PackedLookUpTable::getLUTIndex(const arma::Col<uint8_t>::fixed<3>& colour) const {
+            return ((colour[0] >> BITS_C1_REMOVED) << (BITS_C2 + BITS_C3))
+                 + ((colour[1] >> BITS_C2_REMOVED) << BITS_C3)
+                 +  (colour[2] >> BITS_C3_REMOVED);
+        }
+
+        arma::Col<uint8_t>::fixed<3> PackedLookUpTable::getPixelFromIndex(const uint& index) const {
+            uint8_t c1 = (index >> (BITS_C2 + BITS_C3)) << BITS_C1_REMOVED;
+            uint8_t c2 = ((index >> BITS_C3) & ((1u << BITS_C2) - 1)) << BITS_C2_REMOVED;
+            uint8_t c3 = (index & ((1u << BITS_C3) - 1)) << BITS_C3_REMOVED;
+
+            return {c1, c2, c3};
+        }
+
+        const std::vector<uint8_t>& PackedLookUpTable::getPackedData() const {
+            return codes;
+        }
+
+    } //vision
+} // messages
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MESSAGES_VISION_PACKEDLOOKUPTABLE_H
+#define MESSAGES_VISION_PACKEDLOOKUPTABLE_H
+
+#include <array>
+#include <vector>
+
+#include "messages/vision/LookUpTable.h"
+
+namespace messages {
+    namespace vision {
+
+        /**
+         * @brief A LookUpTable stored as 4 bit colour codes so much more of it fits in the cache.
+         *
+         * @details
+         *  There are only eight colours so each entry takes half a byte instead of a whole one. The entries can also be
+         *  stored in Morton (Z) order, which interleaves the bits of the three channels so colours that are close
+         *  together in all three channels (as neighbouring pixels are) share a cache line. Indexes are the same ones
+         *  LookUpTable::getLUTIndex gives whatever the layout, the table works out where the entry lives.
+         */
+        class PackedLookUpTable {
+        public:
+            enum class Layout {
+                // The same order as LookUpTable
+                LINEAR,
+                // The bits of the three channels interleaved
+                MORTON
+            };
+
+            uint8_t BITS_C1;
+            uint8_t BITS_C2;
+            uint8_t BITS_C3;
+            size_t LUT_SIZE;
+            Layout layout;
+
+            PackedLookUpTable();
+
+            /*!
+                @brief Packs a LookUpTable
+                @throws std::invalid_argument if the table holds something that is not a Colour
+             */
+            explicit PackedLookUpTable(const LookUpTable& lut, Layout layout = Layout::MORTON);
+
+            /*!
+                @brief If every entry of the table is a Colour, so it can be packed without throwing
+             */
+            static bool canPack(const LookUpTable& lut);
+
+            /*!
+                @brief Unpacks back to a LookUpTable
+             */
+            LookUpTable unpack() const;
+
+            /*!
+                @brief Classifies a pixel stored as three packed bytes (e.g. a demosaiced plane)
+             */
+            inline Colour operator()(const uint8_t* colour) const {
+                return get(slot[0][colour[0] >> BITS_C1_REMOVED] | slot[1][colour[1] >> BITS_C2_REMOVED] | slot[2][colour[2] >> BITS_C3_REMOVED]);
+            }
+
+            Colour operator()(const arma::Col<uint8_t>::fixed<3>& p) const;
+
+            /*!
+                @brief Gets the colour at an index from getLUTIndex
+             */
+            Colour getColour(const uint& index) const;
+
+            /*!
+                @brief Sets the colour at an index from getLUTIndex
+                @throws std::invalid_argument if the colour is not a Colour
+             */
+            void setColour(const uint& index, const Colour& colour);
+
+            /*!
+             *   @brief Gets the index of the pixel, the same as LookUpTable::getLUTIndex
+             */
+            uint getLUTIndex(const arma::Col<uint8_t>::fixed<3>& colour) const;
+
+            /*!
+             *   @brief The inverse of getLUTIndex, the same as LookUpTable::getPixelFromIndex
+             *   NOTE: This inverse is NOT injective (e.g. not 1-to-1)
+             */
+            arma::Col<uint8_t>::fixed<3> getPixelFromIndex(const uint& index) const;
+
+            /*!
+                @brief The packed entries, two to a byte (the low nibble holds the even entry)
+             */
+            const std::vector<uint8_t>& getPackedData() const;
+
+            /*!
+                @brief Where the entry for an index from getLUTIndex is in the packed entries
+             */
+            uint position(const uint& index) const;
+
+        private:
+            inline Colour get(const uint& p) const {
+                return COLOURS[(codes[p >> 1] >> ((p & 1) << 2)) & 0xF];
+            }
+
+            static uint8_t code(const Colour& colour);
+            static const std::array<Colour, 16> COLOURS;
+
+            uint8_t BITS_C1_REMOVED;
+            uint8_t BITS_C2_REMOVED;
+            uint8_t BITS_C3_REMOVED;
+
+            // Where each channel value's bits go in an entry's position
+            std::array<std::array<uint32_t, 256>, 3> slot;
+            std::vector<uint8_t> codes;
+        };
+
+    } //vision
+} // messages
+
+#endif // MESSAGES_VISION_PACKEDLOOKUPTABLE_H
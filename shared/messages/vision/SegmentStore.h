@@ -0,0 +1,477 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef MESSAGES_VISION_SEGMENTSTORE_H
+#define MESSAGES_VISION_SEGMENTSTORE_H
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <armadillo>
+
+namespace messages {
+    namespace vision {
+
+        /**
+         * A pixel location on a segment, two plain ints rather than an arma vector so it can be stored flat
+         */
+        struct SegmentPoint {
+            int x;
+            int y;
+
+            inline int operator[](const uint& i) const {
+                return i ? y : x;
+            }
+
+            inline int at(const uint& i) const {
+                return i ? y : x;
+            }
+
+            inline operator arma::ivec2() const {
+                return arma::ivec2({ x, y });
+            }
+        };
+
+        /**
+         * @brief Flat storage for the segments of a classified image.
+         *
+         * @details
+         *  Segments are stored as a structure of arrays with one contiguous range per class, so looking up every
+         *  segment of a class is a linear walk over a few arrays. Segments from the same scanline are linked to their
+         *  neighbours by handles (the class in the top 8 bits and the index within the class in the rest) rather than
+         *  pointers. The arrays live in an Arena which can come from a Pool, in which case it goes back to the pool
+         *  with its capacity intact when the store is destroyed and the next frame reuses it without allocating.
+         *
+         *  The interface mimics the std::multimap<TClass, Segment> it replaces: equal_range, count, and iteration
+         *  yield std::pair<TClass, Reference> where a Reference has the same fields as a Segment and its
+         *  previous/next links can be tested and dereferenced like the pointers they replace.
+         *
+         * @tparam TClass the object that divides the different classes in the image (must convert to an index)
+         */
+        template <typename TClass>
+        class SegmentStore {
+        public:
+            using Handle = uint32_t;
+
+            enum : Handle {
+                NONE = 0xFFFFFFFF,
+                INDEX_BITS = 24,
+                INDEX_MASK = (1 << INDEX_BITS) - 1
+            };
+
+            struct Bucket {
+                std::vector<uint> length;
+                std::vector<uint> subsample;
+                std::vector<SegmentPoint> start;
+                std::vector<SegmentPoint> end;
+                std::vector<Handle> previous;
+                std::vector<Handle> next;
+
+                inline size_t size() const {
+                    return length.size();
+                }
+
+                void clear() {
+                    length.clear();
+                    subsample.clear();
+                    start.clear();
+                    end.clear();
+                    previous.clear();
+                    next.clear();
+                }
+
+                void reserve(const size_t& n) {
+                    length.reserve(n);
+                    subsample.reserve(n);
+                    start.reserve(n);
+                    end.reserve(n);
+                    previous.reserve(n);
+                    next.reserve(n);
+                }
+            };
+
+            class Reference;
+            struct ArrowProxy;
+
+            /**
+             * Acts like the Segment* it replaces: it is false when there is no neighbour and -> reaches the neighbour
+             */
+            class Link {
+            public:
+                Link() : handle(NONE), buckets(nullptr) {}
+                Link(const Handle& handle, const std::vector<Bucket>* buckets) : handle(handle), buckets(buckets) {}
+
+                explicit operator bool() const {
+                    return handle != NONE;
+                }
+
+                Reference operator*() const {
+                    return Reference(handle, *buckets);
+                }
+
+                ArrowProxy operator->() const {
+                    return ArrowProxy { Reference(handle, *buckets) };
+                }
+
+                Handle handle;
+
+            private:
+                const std::vector<Bucket>* buckets;
+            };
+
+            /**
+             * A copy of one segment's fields gathered from the arrays
+             */
+            class Reference {
+            public:
+                Reference() : colour(), length(0), subsample(0), start(), end(), midpoint(), previous(), next() {}
+
+                Reference(const Handle& handle, const std::vector<Bucket>& buckets) {
+                    const Bucket& bucket = buckets[handle >> INDEX_BITS];
+                    const uint i = handle & INDEX_MASK;
+
+                    colour    = TClass(handle >> INDEX_BITS);
+                    length    = bucket.length[i];
+                    subsample = bucket.subsample[i];
+                    start     = bucket.start[i];
+                    end       = bucket.end[i];
+                    midpoint  = { (start.x + end.x) / 2, (start.y + end.y) / 2 };
+                    previous  = Link(bucket.previous[i], &buckets);
+                    next      = Link(bucket.next[i], &buckets);
+                }
+
+                TClass colour;
+
+                uint length;
+                uint subsample;
+
+                SegmentPoint start;
+                SegmentPoint end;
+                SegmentPoint midpoint;
+
+                Link previous;
+                Link next;
+            };
+
+            /**
+             * Holds the neighbour a Link points to for the length of a -> expression
+             */
+            struct ArrowProxy {
+                Reference reference;
+
+                const Reference* operator->() const {
+                    return &reference;
+                }
+            };
+
+            /**
+             * Walks the segments in class order (the same order a multimap gives).
+             * The pair it points at lives in the iterator, so references to it stay valid while the iterator does.
+             */
+            class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<TClass, Reference>> {
+            public:
+                using value_type = std::pair<TClass, Reference>;
+
+                const_iterator() : buckets(nullptr), c(0), i(0), value() {}
+                const_iterator(const std::vector<Bucket>* buckets, size_t c, size_t i) : buckets(buckets), c(c), i(i), value() {
+                    normalise();
+                }
+
+                const value_type& operator*() const {
+                    Handle handle = Handle((c << INDEX_BITS) | i);
+                    value.first = TClass(c);
+                    value.second = Reference(handle, *buckets);
+                    return value;
+                }
+
+                const value_type* operator->() const {
+                    return &operator*();
+                }
+
+                const_iterator& operator++() {
+                    ++i;
+                    normalise();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator old = *this;
+                    ++(*this);
+                    return old;
+                }
+
+                bool operator==(const const_iterator& other) const {
+                    return c == other.c && i == other.i;
+                }
+
+                bool operator!=(const const_iterator& other) const {
+                    return !(*this == other);
+                }
+
+            private:
+                // Skip past the end of empty or finished classes, every position past the last class is the end
+                void normalise() {
+                    while(buckets && c < buckets->size() && i >= (*buckets)[c].size()) {
+                        ++c;
+                        i = 0;
+                    }
+
+                    if(buckets && c >= buckets->size()) {
+                        c = buckets->size();
+                        i = 0;
+                    }
+                }
+
+                const std::vector<Bucket>* buckets;
+                size_t c;
+                size_t i;
+                mutable value_type value;
+            };
+
+            using iterator = const_iterator;
+
+            struct Arena {
+                std::vector<Bucket> buckets;
+
+                void clear() {
+                    for(auto& bucket : buckets) {
+                        bucket.clear();
+                    }
+                }
+            };
+
+            /**
+             * Hands out arenas and takes them back (without freeing their memory) when their store is destroyed
+             */
+            class Pool {
+            public:
+                Pool() : state(std::make_shared<State>()) {}
+
+                std::shared_ptr<Arena> acquire() {
+
+                    Arena* arena = nullptr;
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if(!state->free.empty()) {
+                            arena = state->free.back().release();
+                            state->free.pop_back();
+                        }
+                    }
+
+                    if(arena) {
+                        arena->clear();
+                    }
+                    else {
+                        arena = new Arena();
+                    }
+
+                    // The deleter keeps the free list alive even if the pool itself is gone
+                    std::shared_ptr<State> s = state;
+                    return std::shared_ptr<Arena>(arena, [s] (Arena* a) {
+                        std::lock_guard<std::mutex> lock(s->mutex);
+                        s->free.emplace_back(a);
+                    });
+                }
+
+            private:
+                struct State {
+                    std::mutex mutex;
+                    std::vector<std::unique_ptr<Arena>> free;
+                };
+
+                std::shared_ptr<State> state;
+            };
+
+            SegmentStore() : arena() {}
+            explicit SegmentStore(std::shared_ptr<Arena> arena) : arena(std::move(arena)) {}
+
+            // Copies get their own arrays so changing one does not change the other
+            SegmentStore(const SegmentStore& other) : arena(other.arena ? std::make_shared<Arena>(*other.arena) : nullptr) {}
+            SegmentStore(SegmentStore&& other) = default;
+
+            SegmentStore& operator=(const SegmentStore& other) {
+                arena = other.arena ? std::make_shared<Arena>(*other.arena) : nullptr;
+                return *this;
+            }
+            SegmentStore& operator=(SegmentStore&& other) = default;
+
+            /**
+             * Adds the segments from one scanline, linking each one to the segments either side of it
+             */
+            template <typename Iterator>
+            void insertLine(Iterator first, Iterator last) {
+
+                if(!arena) {
+                    arena = std::make_shared<Arena>();
+                }
+
+                Handle previous = NONE;
+
+                for(auto it = first; it != last; ++it) {
+
+                    size_t c = size_t(it->colour);
+                    if(arena->buckets.size() <= c) {
+                        arena->buckets.resize(c + 1);
+                    }
+
+                    Bucket& bucket = arena->buckets[c];
+                    Handle current = Handle((c << INDEX_BITS) | bucket.size());
+
+                    bucket.length.push_back(it->length);
+                    bucket.subsample.push_back(it->subsample);
+                    bucket.start.push_back({ int(it->start[0]), int(it->start[1]) });
+                    bucket.end.push_back({ int(it->end[0]), int(it->end[1]) });
+                    bucket.previous.push_back(previous);
+                    bucket.next.push_back(NONE);
+
+                    if(previous != NONE) {
+                        arena->buckets[previous >> INDEX_BITS].next[previous & INDEX_MASK] = current;
+                    }
+
+                    previous = current;
+                }
+            }
+
+            /**
+             * Adds every segment of another store after this store's segments.
+             *
+             * The other store's links are rebased onto where its segments land here, so appending stores that were
+             * filled independently (e.g. one per band of an image) in band order gives exactly the store that
+             * inserting all of their scanlines into one store in that order would have.
+             */
+            void append(const SegmentStore& other) {
+
+                if(other.buckets().empty()) {
+                    return;
+                }
+
+                if(!arena) {
+                    arena = std::make_shared<Arena>();
+                }
+
+                if(arena->buckets.size() < other.buckets().size()) {
+                    arena->buckets.resize(other.buckets().size());
+                }
+
+                // Where each of the other store's classes starts in ours, taken before anything is copied
+                std::vector<Handle> offsets(other.buckets().size());
+                for(size_t c = 0; c < offsets.size(); ++c) {
+                    offsets[c] = Handle(arena->buckets[c].size());
+                }
+
+                auto rebase = [&offsets] (const Handle& handle) {
+                    return handle == NONE ? NONE : Handle(handle + offsets[handle >> INDEX_BITS]);
+                };
+
+                for(size_t c = 0; c < offsets.size(); ++c) {
+                    const Bucket& from = other.buckets()[c];
+                    Bucket& to = arena->buckets[c];
+
+                    to.length.insert(to.length.end(), from.length.begin(), from.length.end());
+                    to.subsample.insert(to.subsample.end(), from.subsample.begin(), from.subsample.end());
+                    to.start.insert(to.start.end(), from.start.begin(), from.start.end());
+                    to.end.insert(to.end.end(), from.end.begin(), from.end.end());
+
+                    to.previous.reserve(to.previous.size() + from.size());
+                    to.next.reserve(to.next.size() + from.size());
+                    for(size_t i = 0; i < from.size(); ++i) {
+                        to.previous.push_back(rebase(from.previous[i]));
+                        to.next.push_back(rebase(from.next[i]));
+                    }
+                }
+            }
+
+            /**
+             * Makes room for n segments of each class up to and including maxClass
+             */
+            void reserve(const TClass& maxClass, const size_t& n) {
+                if(!arena) {
+                    arena = std::make_shared<Arena>();
+                }
+
+                if(arena->buckets.size() <= size_t(maxClass)) {
+                    arena->buckets.resize(size_t(maxClass) + 1);
+                }
+
+                for(auto& bucket : arena->buckets) {
+                    bucket.reserve(n);
+                }
+            }
+
+            void clear() {
+                if(arena) {
+                    arena->clear();
+                }
+            }
+
+            std::pair<const_iterator, const_iterator> equal_range(const TClass& colour) const {
+                size_t c = size_t(colour);
+                return std::make_pair(const_iterator(&buckets(), c, 0), const_iterator(&buckets(), c + 1, 0));
+            }
+
+            size_t count(const TClass& colour) const {
+                size_t c = size_t(colour);
+                return c < buckets().size() ? buckets()[c].size() : 0;
+            }
+
+            size_t size() const {
+                size_t total = 0;
+                for(auto& bucket : buckets()) {
+                    total += bucket.size();
+                }
+                return total;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            const_iterator begin() const {
+                return const_iterator(&buckets(), 0, 0);
+            }
+
+            const_iterator end() const {
+                return const_iterator(&buckets(), buckets().size(), 0);
+            }
+
+            /**
+             * Direct access to the arrays of one class for loops that want to avoid building References
+             */
+            const Bucket& bucket(const TClass& colour) const {
+                static const Bucket none;
+                size_t c = size_t(colour);
+                return c < buckets().size() ? buckets()[c] : none;
+            }
+
+        private:
+            const std::vector<Bucket>& buckets() const {
+                static const std::vector<Bucket> none;
+                return arena ? arena->buckets : none;
+            }
+
+            std::shared_ptr<Arena> arena;
+        };
+
+    }  // vision
+}  // messages
+
+#endif  // MESSAGES_VISION_SEGMENTSTORE_H
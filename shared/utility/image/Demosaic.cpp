@@ -0,0 +1,335 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "Demosaic.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "utility/parallel/WorkerPool.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace utility {
+namespace image {
+
+    namespace {
+
+        // Bands shorter than this aren't worth handing to another thread
+        constexpr uint MINIMUM_BAND_ROWS = 64;
+
+        // The three rows of the source that surround the row being demosaiced
+        struct Rows {
+            const uint8_t* up;
+            const uint8_t* mid;
+            const uint8_t* down;
+        };
+
+        /*
+         * Interpolates a single pixel exactly as Image::operator() does, using the passed column
+         * indices for the left and right neighbours so the border can be mirrored.
+         */
+        inline void demosaicPixel(const Rows& r, uint l, uint x, uint rt, bool oY, uint8_t* out[3]) {
+
+            uint a  = r.mid[l] + r.mid[rt];
+            uint v  = r.up[x] + r.down[x];
+            uint d4 = r.up[l] + r.up[rt] + r.down[l] + r.down[rt];
+            uint c  = r.mid[x];
+
+            bool oX = x % 2;
+
+            if(oX == oY) {
+                out[!oY * 2][x] = uint8_t(a / 2);        // Left right
+                out[1][x]       = uint8_t((c + d4) / 5); // Diag + mid
+                out[ oY * 2][x] = uint8_t(v / 2);        // Top base
+            }
+            else {
+                out[!oY * 2][x] = uint8_t(c);            // Centre
+                out[1][x]       = uint8_t((a + v) / 4);  // Top/Bottom/Left/Right
+                out[ oY * 2][x] = uint8_t(d4 / 4);       // Diags
+            }
+        }
+
+#if defined(__AVX2__)
+
+        constexpr uint VECTOR_WIDTH = 16;
+
+        /*
+         * Interpolates 16 pixels starting at an odd column x, reading x - 1 to x + 16 of each row.
+         * Works in 16 bit lanes and selects the result for each lane from its column parity.
+         */
+        inline void demosaicBlock(const Rows& r, uint x, const __m256i& eqMask, uint8_t* a, uint8_t* g, uint8_t* b) {
+
+            auto load = [] (const uint8_t* p) {
+                return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            };
+
+            __m256i ul = load(r.up   + x - 1), u = load(r.up   + x), ur = load(r.up   + x + 1);
+            __m256i l  = load(r.mid  + x - 1), c = load(r.mid  + x), rt = load(r.mid  + x + 1);
+            __m256i dl = load(r.down + x - 1), d = load(r.down + x), dr = load(r.down + x + 1);
+
+            __m256i h  = _mm256_add_epi16(l, rt);
+            __m256i v  = _mm256_add_epi16(u, d);
+            __m256i d4 = _mm256_add_epi16(_mm256_add_epi16(ul, ur), _mm256_add_epi16(dl, dr));
+
+            // Same colour as the diagonals (x / 5 == (x * 0xCCCD) >> 18 for all 16 bit x)
+            __m256i eqA = _mm256_srli_epi16(h, 1);
+            __m256i eqG = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_add_epi16(c, d4), _mm256_set1_epi16(short(0xCCCD))), 2);
+            __m256i eqB = _mm256_srli_epi16(v, 1);
+
+            // Opposite colour to the diagonals
+            __m256i neA = c;
+            __m256i neG = _mm256_srli_epi16(_mm256_add_epi16(h, v), 2);
+            __m256i neB = _mm256_srli_epi16(d4, 2);
+
+            auto store = [&eqMask] (uint8_t* out, const __m256i& eq, const __m256i& ne) {
+                __m256i v = _mm256_blendv_epi8(ne, eq, eqMask);
+                v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(v));
+            };
+
+            store(a + x, eqA, neA);
+            store(g + x, eqG, neG);
+            store(b + x, eqB, neB);
+        }
+
+        inline __m256i parityMask(bool evenLanes) {
+            return evenLanes ? _mm256_set1_epi32(0x0000FFFF) : _mm256_set1_epi32(int(0xFFFF0000));
+        }
+
+#elif defined(__SSE2__)
+
+        constexpr uint VECTOR_WIDTH = 16;
+
+        /*
+         * Interpolates 16 pixels starting at an odd column x, reading x - 1 to x + 16 of each row.
+         * Works on two halves of 8 16 bit lanes and selects the result for each lane from its column parity.
+         */
+        inline void demosaicBlock(const Rows& r, uint x, const __m128i& eqMask, uint8_t* a, uint8_t* g, uint8_t* b) {
+
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i five = _mm_set1_epi16(short(0xCCCD));
+
+            __m128i ul = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.up   + x - 1));
+            __m128i u  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.up   + x));
+            __m128i ur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.up   + x + 1));
+            __m128i l  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.mid  + x - 1));
+            __m128i c  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.mid  + x));
+            __m128i rt = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.mid  + x + 1));
+            __m128i dl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.down + x - 1));
+            __m128i d  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.down + x));
+            __m128i dr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r.down + x + 1));
+
+            __m128i outA[2];
+            __m128i outG[2];
+            __m128i outB[2];
+
+            for(int half = 0; half < 2; ++half) {
+
+                auto widen = [&zero, half] (const __m128i& p) {
+                    return half ? _mm_unpackhi_epi8(p, zero) : _mm_unpacklo_epi8(p, zero);
+                };
+
+                __m128i h  = _mm_add_epi16(widen(l), widen(rt));
+                __m128i v  = _mm_add_epi16(widen(u), widen(d));
+                __m128i d4 = _mm_add_epi16(_mm_add_epi16(widen(ul), widen(ur)), _mm_add_epi16(widen(dl), widen(dr)));
+                __m128i cc = widen(c);
+
+                // Same colour as the diagonals (x / 5 == (x * 0xCCCD) >> 18 for all 16 bit x)
+                __m128i eqA = _mm_srli_epi16(h, 1);
+                __m128i eqG = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(cc, d4), five), 2);
+                __m128i eqB = _mm_srli_epi16(v, 1);
+
+                // Opposite colour to the diagonals
+                __m128i neA = cc;
+                __m128i neG = _mm_srli_epi16(_mm_add_epi16(h, v), 2);
+                __m128i neB = _mm_srli_epi16(d4, 2);
+
+                outA[half] = _mm_or_si128(_mm_and_si128(eqMask, eqA), _mm_andnot_si128(eqMask, neA));
+                outG[half] = _mm_or_si128(_mm_and_si128(eqMask, eqG), _mm_andnot_si128(eqMask, neG));
+                outB[half] = _mm_or_si128(_mm_and_si128(eqMask, eqB), _mm_andnot_si128(eqMask, neB));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a + x), _mm_packus_epi16(outA[0], outA[1]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(g + x), _mm_packus_epi16(outG[0], outG[1]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(b + x), _mm_packus_epi16(outB[0], outB[1]));
+        }
+
+        inline __m128i parityMask(bool evenLanes) {
+            return evenLanes ? _mm_set1_epi32(0x0000FFFF) : _mm_set1_epi32(int(0xFFFF0000));
+        }
+
+#endif
+
+        /*
+         * Demosaics one row into three planar channel buffers
+         */
+        void demosaicRow(const Rows& r, uint width, bool oY, uint8_t* out[3]) {
+
+            // The left border mirrors column 1 into column -1
+            demosaicPixel(r, 1, 0, 1, oY, out);
+
+            uint x = 1;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+            // The block writes its a channel to out[!oY * 2] and its b channel to out[oY * 2].
+            // Blocks start on odd columns, so lane 0 has the same parity as the diagonals when the row is odd
+            auto eqMask = parityMask(oY);
+
+            // Each block reads one column past its last pixel, which must still be inside the row
+            for(; x + VECTOR_WIDTH < width; x += VECTOR_WIDTH) {
+                demosaicBlock(r, x, eqMask, out[!oY * 2], out[1], out[oY * 2]);
+            }
+#endif
+
+            for(; x < width - 1; ++x) {
+                demosaicPixel(r, x - 1, x, x + 1, oY, out);
+            }
+
+            // The right border mirrors column width - 2 into column width
+            demosaicPixel(r, width - 2, width - 1, width - 2, oY, out);
+        }
+
+        /*
+         * Converts a row of RGB channels to YCbCr in place using 16 bit fixed point versions of the toYCbCr
+         * coefficients. The result is within one of toYCbCr.
+         */
+        void convertRow(uint8_t* c0, uint8_t* c1, uint8_t* c2, uint width) {
+
+            auto clamp = [] (int v) {
+                return uint8_t(std::min(255, std::max(0, v)));
+            };
+
+            for(uint x = 0; x < width; ++x) {
+                int r = c0[x];
+                int g = c1[x];
+                int b = c2[x];
+
+                c0[x] = clamp(( 19595 * r + 38470 * g +  7471 * b) >> 16);
+                c1[x] = clamp((-11076 * r - 21758 * g + 32768 * b + (128 << 16)) >> 16);
+                c2[x] = clamp(( 32768 * r - 27460 * g -  5329 * b + (128 << 16)) >> 16);
+            }
+        }
+
+        void pack444(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, uint width, uint8_t* out) {
+            for(uint x = 0; x < width; ++x) {
+                out[x * 3 + 0] = c0[x];
+                out[x * 3 + 1] = c1[x];
+                out[x * 3 + 2] = c2[x];
+            }
+        }
+
+        void pack422(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, uint width, uint8_t* out) {
+            uint x = 0;
+            for(; x + 1 < width; x += 2) {
+                out[x * 2 + 0] = c0[x];
+                out[x * 2 + 1] = uint8_t((c1[x] + c1[x + 1]) / 2);
+                out[x * 2 + 2] = c0[x + 1];
+                out[x * 2 + 3] = uint8_t((c2[x] + c2[x + 1]) / 2);
+            }
+
+            // An odd width pairs the last pixel with itself
+            if(x < width) {
+                out[x * 2 + 0] = c0[x];
+                out[x * 2 + 1] = c1[x];
+                out[x * 2 + 2] = c0[x];
+                out[x * 2 + 3] = c2[x];
+            }
+        }
+    }
+
+    void demosaic(const uint8_t* bayer, uint width, uint height, PlaneFormat format, Conversion conversion, std::vector<uint8_t>& output, uint threads) {
+
+        size_t stride = format == PlaneFormat::YCbCr444 ? width * 3 : ((width + 1) / 2) * 4;
+        output.resize(stride * height);
+
+        auto demosaicRows = [&] (uint first, uint last) {
+
+            // Planar scratch for a single row, small enough to stay in cache
+            std::vector<uint8_t> scratch(width * 3);
+            uint8_t* channels[3] = { scratch.data(), scratch.data() + width, scratch.data() + width * 2 };
+
+            for(uint y = first; y < last; ++y) {
+
+                // Mirror the rows above and below at the top and bottom of the frame
+                Rows r;
+                r.up   = bayer + (y == 0          ? 1          : y - 1) * width;
+                r.mid  = bayer + y * width;
+                r.down = bayer + (y == height - 1 ? height - 2 : y + 1) * width;
+
+                demosaicRow(r, width, y % 2, channels);
+
+                if(conversion == Conversion::YCBCR) {
+                    convertRow(channels[0], channels[1], channels[2], width);
+                }
+
+                if(format == PlaneFormat::YCbCr444) {
+                    pack444(channels[0], channels[1], channels[2], width, output.data() + y * stride);
+                }
+                else {
+                    pack422(channels[0], channels[1], channels[2], width, output.data() + y * stride);
+                }
+            }
+        };
+
+        // Every row only reads the source, so bands of rows can be done on separate threads
+        auto& workers = utility::parallel::WorkerPool::instance();
+        uint bands = std::min(threads == 0 ? workers.size() : threads, height / MINIMUM_BAND_ROWS);
+
+        if(bands <= 1) {
+            demosaicRows(0, height);
+            return;
+        }
+
+        std::atomic<uint> next(0);
+        workers.run(bands, [&] (uint) {
+            for(uint band = next++; band < bands; band = next++) {
+                demosaicRows(height * band / bands, height * (band + 1) / bands);
+            }
+        });
+    }
+
+    DemosaicedPlane demosaic(const uint8_t* bayer, uint width, uint height, PlaneFormat format, Conversion conversion) {
+
+        DemosaicedPlane plane;
+        plane.format = format;
+        plane.width = width;
+        plane.height = height;
+
+        demosaic(bayer, width, height, format, conversion, plane.data);
+
+        return plane;
+    }
+
+    const char* demosaicInstructionSet() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE2__)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+}
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_IMAGE_DEMOSAIC_H
+#define UTILITY_IMAGE_DEMOSAIC_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace utility {
+namespace image {
+
+    /**
+     * The memory layout of a demosaiced plane
+     */
+    enum class PlaneFormat {
+        YCbCr444, // Three bytes per pixel
+        YCbCr422  // Four bytes per pair of pixels (Y0 Cb Y1 Cr)
+    };
+
+    /**
+     * What is done to the interpolated Bayer channels before they are packed
+     */
+    enum class Conversion {
+        NONE,  // Keep the channels exactly as Image::operator() returns them (what the LUT is built against)
+        YCBCR  // Treat the channels as RGB and convert them using the same coefficients as toYCbCr
+    };
+
+    /**
+     * A whole demosaiced frame stored as a single packed plane
+     */
+    struct DemosaicedPlane {
+        PlaneFormat format = PlaneFormat::YCbCr444;
+        uint width = 0;
+        uint height = 0;
+        std::vector<uint8_t> data;
+
+        inline size_t stride() const {
+            return format == PlaneFormat::YCbCr444 ? width * 3 : ((width + 1) / 2) * 4;
+        }
+
+        /**
+         * Gets a pointer to the three channels of a pixel, only valid for YCbCr444 planes
+         */
+        inline const uint8_t* operator()(const uint& x, const uint& y) const {
+            return &data[y * stride() + x * 3];
+        }
+    };
+
+    /**
+     * Demosaics a full Bayer frame in a single pass.
+     *
+     * Interior pixels are identical to Image::operator(). On the one pixel border, where operator() reads outside
+     * of the row or the buffer, the missing neighbours are mirrored (which keeps the Bayer phase).
+     * Uses AVX2 or SSE2 for the interpolation when the compiler targets them and a scalar loop otherwise.
+     *
+     * @param bayer      the raw frame, one byte per pixel
+     * @param width      the width of the frame in pixels (at least 2)
+     * @param height     the height of the frame in pixels (at least 2)
+     * @param format     the packing to use for the output
+     * @param conversion the colour conversion to apply before packing
+     * @param output     resized to hold the plane and filled
+     * @param threads    the most threads from the worker pool to split the rows between, 0 for all of them
+     */
+    void demosaic(const uint8_t* bayer, uint width, uint height, PlaneFormat format, Conversion conversion, std::vector<uint8_t>& output, uint threads = 1);
+
+    DemosaicedPlane demosaic(const uint8_t* bayer, uint width, uint height, PlaneFormat format = PlaneFormat::YCbCr444, Conversion conversion = Conversion::NONE);
+
+    /**
+     * The name of the instruction set demosaic was built with (for benchmarks and logging)
+     */
+    const char* demosaicInstructionSet();
+
+    /**
+     * A lazily populated YCbCr444 plane that is attached to an image.
+     *
+     * The first caller of get demosaics the frame (on as many threads as it asks for), every later caller (from any
+     * thread) shares the result.
+     * Copying or assigning an image does not copy its cache, as the source the copy describes can be changed.
+     */
+    class DemosaicCache {
+    public:
+        DemosaicCache() : ready(false), mutex(), plane() {}
+        DemosaicCache(const DemosaicCache&) : ready(false), mutex(), plane() {}
+
+        DemosaicCache& operator=(const DemosaicCache&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = false;
+            plane = DemosaicedPlane();
+            return *this;
+        }
+
+        const DemosaicedPlane& get(const uint8_t* bayer, uint width, uint height, uint threads = 1) const {
+
+            if(!ready.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if(!ready.load(std::memory_order_relaxed)) {
+                    plane.format = PlaneFormat::YCbCr444;
+                    plane.width = width;
+                    plane.height = height;
+                    demosaic(bayer, width, height, PlaneFormat::YCbCr444, Conversion::NONE, plane.data, threads);
+                    ready.store(true, std::memory_order_release);
+                }
+            }
+
+            return plane;
+        }
+
+        bool populated() const {
+            return ready.load(std::memory_order_acquire);
+        }
+
+    private:
+        mutable std::atomic<bool> ready;
+        mutable std::mutex mutex;
+        mutable DemosaicedPlane plane;
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "utility/image/FramePool.h"
+
+namespace utility {
+namespace image {
+
+    FramePool::FramePool(size_t capacity) : state(std::make_shared<State>()) {
+        state->capacity = capacity;
+        state->free.reserve(capacity);
+    }
+
+    std::vector<uint8_t> FramePool::acquire(size_t size, bool& reused) {
+
+        std::vector<uint8_t> buffer;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(!state->free.empty()) {
+                buffer = std::move(state->free.back());
+                state->free.pop_back();
+            }
+        }
+
+        // A buffer from an earlier frame of the same size can be resized without allocating
+        reused = buffer.capacity() >= size;
+        buffer.resize(size);
+
+        return buffer;
+    }
+
+    std::function<void (std::vector<uint8_t>&&)> FramePool::recycler() const {
+
+        std::weak_ptr<State> weak = state;
+
+        return [weak] (std::vector<uint8_t>&& buffer) {
+            auto s = weak.lock();
+            if(s) {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if(s->free.size() < s->capacity) {
+                    s->free.push_back(std::move(buffer));
+                }
+            }
+        };
+    }
+
+    size_t FramePool::available() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->free.size();
+    }
+
+}
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_IMAGE_FRAMEPOOL_H
+#define UTILITY_IMAGE_FRAMEPOOL_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utility {
+namespace image {
+
+    /**
+     * @brief Keeps the pixel buffers of images we have emitted so they can be reused once nobody needs them.
+     *
+     * @details
+     *  An image built from an acquired buffer should have its recycle function set to recycler(). When the last
+     *  reference to the image goes away its buffer comes back here instead of being freed, so in the steady state
+     *  capturing a frame does not allocate. The pool keeps at most capacity buffers, any more are freed.
+     */
+    class FramePool {
+    public:
+        explicit FramePool(size_t capacity);
+
+        /**
+         * @brief Gets a buffer of size bytes, reusing a free one if there is one
+         *
+         * @param size how many bytes the buffer needs
+         * @param reused set to whether the buffer came from the pool
+         */
+        std::vector<uint8_t> acquire(size_t size, bool& reused);
+
+        /**
+         * @brief A function that puts a buffer back into this pool, which is safe to call after the pool is gone
+         */
+        std::function<void (std::vector<uint8_t>&&)> recycler() const;
+
+        /// @brief How many buffers are waiting to be reused
+        size_t available() const;
+
+    private:
+        struct State {
+            std::mutex mutex;
+            std::vector<std::vector<uint8_t>> free;
+            size_t capacity;
+        };
+
+        std::shared_ptr<State> state;
+    };
+
+}
+}
+
+#endif
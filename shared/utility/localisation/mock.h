@@ -0,0 +1,105 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_LOCALISATION_MOCK_H
+#define UTILITY_LOCALISATION_MOCK_H
+
+#include <cmath>
+#include <memory>
+#include <armadillo>
+#include "utility/localisation/transform.h"
+#include "utility/motion/ForwardKinematics.h"
+#include "messages/input/Sensors.h"
+#include "messages/input/ServoID.h"
+#include "messages/vision/VisionObjects.h"
+
+namespace utility {
+namespace localisation {
+namespace mock {
+
+    inline double triangleWave(double t, double period) {
+        auto k = t / period;
+        return 2.0 * std::abs(2.0 * (k - std::floor(k + 0.5))) - 1.0;
+    }
+
+    /// The position at time t (in seconds) on the loop MockRobot walks around the field
+    inline arma::vec2 robotPath(double t, double period) {
+        double x_amp = 3;
+        double y_amp = 2;
+
+        auto wave1 = triangleWave(t, period);
+        auto wave2 = triangleWave(t + (period / 4.0), period);
+
+        return arma::vec2({ wave1 * x_amp, wave2 * y_amp });
+    }
+
+    /// The sensors of a robot facing robot_heading whose imu is pointing along world_imu_direction
+    inline std::shared_ptr<messages::input::Sensors> robotSensors(
+            double robot_heading,
+            const arma::vec2& world_imu_direction,
+            const arma::vec2& odometry) {
+
+        auto sensors = std::make_shared<messages::input::Sensors>();
+
+        // orientation
+        arma::vec2 robot_imu_dir = transform::WorldToRobotTransform(arma::vec2({0, 0}), robot_heading, world_imu_direction);
+        arma::mat orientation = arma::eye(3, 3);
+        orientation.submat(0, 0, 1, 0) = robot_imu_dir;
+        orientation.submat(0, 1, 1, 1) = arma::vec2({ -robot_imu_dir(1), robot_imu_dir(0) });
+
+        sensors->orientation = orientation;
+        sensors->robotToIMU = utility::motion::kinematics::calculateRobotToIMU(sensors->orientation);
+
+        sensors->orientationCamToGround = arma::eye(4, 4);
+        sensors->forwardKinematics[messages::input::ServoID::HEAD_PITCH] = arma::eye(4, 4);
+
+        sensors->odometry = odometry;
+        sensors->odometryCovariance = arma::eye(2, 2) * 0.05;
+
+        return sensors;
+    }
+
+    /// A perfect observation of the goal post at goal_position made from the given robot pose
+    inline messages::vision::Goal goalObservation(
+            const arma::vec2& robot_position,
+            double robot_heading,
+            const arma::vec2& goal_position,
+            messages::vision::Goal::Side side,
+            const std::shared_ptr<const messages::input::Sensors>& sensors) {
+
+        arma::vec3 goal_pos = {0, 0, 0};
+        goal_pos.rows(0, 1) = goal_position;
+
+        messages::vision::Goal goal;
+        messages::vision::VisionObject::Measurement measurement;
+        measurement.position = transform::SphericalRobotObservation(robot_position, robot_heading, goal_pos);
+        measurement.error = arma::eye(3, 3) * 0.1;
+        goal.measurements.push_back(measurement);
+        goal.measurements.push_back(measurement);
+        goal.side = side;
+        goal.sensors = sensors;
+
+        return goal;
+    }
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,437 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_MATH_KALMAN_FIXEDUKF_H
+#define UTILITY_MATH_KALMAN_FIXEDUKF_H
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <armadillo>
+
+namespace utility {
+    namespace math {
+        namespace kalman {
+
+            namespace cholesky {
+
+                /**
+                 * Factors a into lower triangular l where l * l.t() == a
+                 *
+                 * @return false if a is not positive definite
+                 */
+                template <arma::uword n>
+                bool factor(const arma::mat::fixed<n, n>& a, arma::mat::fixed<n, n>& l) {
+
+                    l.zeros();
+
+                    for(arma::uword j = 0; j < n; ++j) {
+
+                        double diagonal = a.at(j, j);
+                        for(arma::uword k = 0; k < j; ++k) {
+                            diagonal -= l.at(j, k) * l.at(j, k);
+                        }
+
+                        if(!(diagonal > 0)) {
+                            return false;
+                        }
+
+                        l.at(j, j) = std::sqrt(diagonal);
+
+                        for(arma::uword i = j + 1; i < n; ++i) {
+                            double value = a.at(i, j);
+                            for(arma::uword k = 0; k < j; ++k) {
+                                value -= l.at(i, k) * l.at(j, k);
+                            }
+                            l.at(i, j) = value / l.at(j, j);
+                        }
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Replaces each column of b with the solution x of l * l.t() * x = b
+                 */
+                template <arma::uword n, arma::uword m>
+                void solve(const arma::mat::fixed<n, n>& l, arma::mat::fixed<n, m>& b) {
+
+                    for(arma::uword c = 0; c < m; ++c) {
+
+                        // Forward substitution with l
+                        for(arma::uword i = 0; i < n; ++i) {
+                            double value = b.at(i, c);
+                            for(arma::uword k = 0; k < i; ++k) {
+                                value -= l.at(i, k) * b.at(k, c);
+                            }
+                            b.at(i, c) = value / l.at(i, i);
+                        }
+
+                        // Back substitution with l.t()
+                        for(arma::uword i = n; i-- > 0;) {
+                            double value = b.at(i, c);
+                            for(arma::uword k = i + 1; k < n; ++k) {
+                                value -= l.at(k, i) * b.at(k, c);
+                            }
+                            b.at(i, c) = value / l.at(i, i);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief An unscented Kalman filter where every dimension is known at compile time.
+             *
+             * @details
+             *  This is the same filter as UKF (and a drop in replacement for it) but the sigma points and all of the
+             *  working matrices are fixed size members, the measurement update is sized by the measurement, and the
+             *  inverses are replaced with Cholesky solves. Once constructed it does not allocate (as long as the model's
+             *  own vectors are small enough for armadillo to keep on the stack).
+             */
+            template <typename Model>
+            class FixedUKF {
+            public:
+                // The model
+                Model model;
+
+            private:
+                // The number of sigma points
+                static constexpr uint NUM_SIGMA_POINTS = (Model::size * 2) + 1;
+
+                // Dimension types for vectors and square matricies
+                using StateVec = arma::vec::fixed<Model::size>;
+                using StateMat = arma::mat::fixed<Model::size, Model::size>;
+
+                using SigmaVec = arma::vec::fixed<NUM_SIGMA_POINTS>;
+                using SigmaMat = arma::mat::fixed<Model::size, NUM_SIGMA_POINTS>;
+                using SigmaSquareMat = arma::mat::fixed<NUM_SIGMA_POINTS, NUM_SIGMA_POINTS>;
+
+                // Our estimate and covariance
+                StateVec mean;
+                StateMat covariance;
+
+                // Our sigma points for UKF, kept as separate vectors so they can be handed straight to the model
+                StateVec sigmaMean;
+                std::array<StateVec, NUM_SIGMA_POINTS> sigmaPoints;
+
+                SigmaMat centredSigmaPoints; // X in Steves kalman theory
+                SigmaVec d;
+                SigmaSquareMat covarianceUpdate; // C in Steves kalman theory
+
+                SigmaSquareMat defaultCovarianceUpdate;
+
+                // The mean and covariance weights
+                SigmaVec meanWeights;
+                SigmaVec covarianceWeights;
+
+                // UKF variables
+                double covarianceSigmaWeights;
+
+                // Working space
+                StateMat scaledCovariance;
+                StateMat factor;
+                SigmaMat centredUpdate;
+
+                void generateSigmaPoints() {
+
+                    // Our first point is always the mean
+                    sigmaPoints[0] = mean;
+
+                    scaledCovariance = covariance * covarianceSigmaWeights;
+                    if(!cholesky::factor(scaledCovariance, factor)) {
+                        throw std::runtime_error("covarianceSigmaWeights * covariance was NOT positive-definite and the cholesky decomposition failed");
+                    }
+
+                    // The rows of our lower factor are the columns of the upper one UKF uses, so the points match
+                    for(uint i = 0; i < Model::size; ++i) {
+                        for(uint j = 0; j < Model::size; ++j) {
+                            sigmaPoints[i + 1].at(j)               = mean.at(j) + factor.at(i, j);
+                            sigmaPoints[i + 1 + Model::size].at(j) = mean.at(j) - factor.at(i, j);
+                        }
+                    }
+                }
+
+                void resetMeasurementState() {
+
+                    // Calculate our sigma points
+                    sigmaMean = mean;
+                    generateSigmaPoints();
+
+                    // Reset our state for more measurements
+                    covarianceUpdate = defaultCovarianceUpdate;
+                    d.zeros();
+
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        for(uint j = 0; j < Model::size; ++j) {
+                            centredSigmaPoints.at(j, i) = sigmaPoints[i].at(j) - sigmaMean.at(j);
+                        }
+                    }
+                }
+
+            public:
+                FixedUKF(StateVec initialMean = arma::zeros(Model::size),
+                         StateMat initialCovariance = arma::eye(Model::size, Model::size) * 0.1,
+                         double alpha = 1e-1,
+                         double kappa = 0.f,
+                         double beta = 2.f) {
+
+                    reset(initialMean, initialCovariance, alpha, kappa, beta);
+                }
+
+                void reset(StateVec initialMean, StateMat initialCovariance,
+                           double alpha, double kappa, double beta) {
+                    double lambda = pow(alpha, 2) * (Model::size + kappa) - Model::size;
+
+                    covarianceSigmaWeights = Model::size + lambda;
+
+                    meanWeights.fill(1.0 / (2.0 * (Model::size + lambda)));
+                    meanWeights[0] = lambda / (Model::size + lambda);
+
+                    covarianceWeights.fill(1.0 / (2.0 * (Model::size + lambda)));
+                    covarianceWeights[0] = lambda / (Model::size + lambda) + (1.0 - pow(alpha,2) + beta);
+
+                    defaultCovarianceUpdate.zeros();
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        defaultCovarianceUpdate.at(i, i) = covarianceWeights.at(i);
+                    }
+
+                    setState(initialMean, initialCovariance);
+                }
+
+                void setState(StateVec initialMean, StateMat initialCovariance) {
+                    mean = initialMean;
+                    covariance = initialCovariance;
+
+                    resetMeasurementState();
+                }
+
+                template <typename... TAdditionalParameters>
+                void timeUpdate(double deltaT, const TAdditionalParameters&... additionalParameters) {
+                    // Generate our sigma points
+                    generateSigmaPoints();
+
+                    // Write the propagated version of the sigma point
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        sigmaPoints[i] = model.timeUpdate(sigmaPoints[i], deltaT, additionalParameters...);
+                    }
+
+                    // Calculate the new mean and covariance values.
+                    mean.zeros();
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        for(uint j = 0; j < Model::size; ++j) {
+                            mean.at(j) += sigmaPoints[i].at(j) * meanWeights.at(i);
+                        }
+                    }
+                    mean = model.limitState(mean);
+
+                    covariance = model.processNoise();
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        for(uint a = 0; a < Model::size; ++a) {
+                            double weighted = covarianceWeights.at(i) * (sigmaPoints[i].at(a) - mean.at(a));
+                            for(uint b = 0; b < Model::size; ++b) {
+                                covariance.at(a, b) += weighted * (sigmaPoints[i].at(b) - mean.at(b));
+                            }
+                        }
+                    }
+
+                    // Re calculate our sigma points and reset our state for more measurements
+                    resetMeasurementState();
+                }
+
+                template <arma::uword M, typename TVariance, typename... TMeasurementType>
+                double measurementUpdate(const arma::vec::fixed<M>& measurement,
+                                         const TVariance& measurement_variance,
+                                         const TMeasurementType&... measurementArgs) {
+
+                    using MeasurementVec = arma::vec::fixed<M>;
+                    using MeasurementMat = arma::mat::fixed<M, M>;
+                    using ObservationMat = arma::mat::fixed<M, NUM_SIGMA_POINTS>;
+
+                    const MeasurementMat variance = measurement_variance;
+
+                    // First step is to calculate the expected measurement for each sigma point.
+                    ObservationMat predictedObservations;
+                    MeasurementVec predictedMean;
+                    predictedMean.zeros();
+
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        const MeasurementVec observation = model.predictedObservation(sigmaPoints[i], measurementArgs...);
+                        for(uint r = 0; r < M; ++r) {
+                            predictedObservations.at(r, i) = observation.at(r);
+                            predictedMean.at(r) += observation.at(r) * meanWeights.at(i);
+                        }
+                    }
+
+                    // Centre the predictions on their mean and find their covariance
+                    MeasurementMat predictedCovariance;
+                    predictedCovariance.zeros();
+
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        for(uint a = 0; a < M; ++a) {
+                            predictedObservations.at(a, i) -= predictedMean.at(a);
+                        }
+                        for(uint a = 0; a < M; ++a) {
+                            double weighted = covarianceWeights.at(i) * predictedObservations.at(a, i);
+                            for(uint b = 0; b < M; ++b) {
+                                predictedCovariance.at(a, b) += weighted * predictedObservations.at(b, i);
+                            }
+                        }
+                    }
+
+                    const MeasurementVec innovation = model.observationDifference(measurement, predictedMean);
+
+                    // gain = Y * C
+                    ObservationMat gain;
+                    for(uint j = 0; j < NUM_SIGMA_POINTS; ++j) {
+                        for(uint r = 0; r < M; ++r) {
+                            double value = 0;
+                            for(uint k = 0; k < NUM_SIGMA_POINTS; ++k) {
+                                value += predictedObservations.at(r, k) * covarianceUpdate.at(k, j);
+                            }
+                            gain.at(r, j) = value;
+                        }
+                    }
+
+                    // system = R + Y * C * Y.t()
+                    MeasurementMat system = variance;
+                    for(uint a = 0; a < M; ++a) {
+                        for(uint b = 0; b < M; ++b) {
+                            for(uint k = 0; k < NUM_SIGMA_POINTS; ++k) {
+                                system.at(a, b) += gain.at(a, k) * predictedObservations.at(b, k);
+                            }
+                        }
+                    }
+
+                    // Update our state: C -= (Y * C).t() * system.i() * (Y * C)
+                    MeasurementMat l;
+                    if(!cholesky::factor(system, l)) {
+                        throw std::runtime_error("The innovation of a measurement update was not positive-definite");
+                    }
+                    ObservationMat solved = gain;
+                    cholesky::solve(l, solved);
+
+                    for(uint j = 0; j < NUM_SIGMA_POINTS; ++j) {
+                        for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                            double value = 0;
+                            for(uint a = 0; a < M; ++a) {
+                                value += gain.at(a, i) * solved.at(a, j);
+                            }
+                            covarianceUpdate.at(i, j) -= value;
+                        }
+                    }
+
+                    // d += Y.t() * R.i() * innovation
+                    if(!cholesky::factor(variance, l)) {
+                        throw std::runtime_error("The measurement variance was not positive-definite");
+                    }
+                    arma::mat::fixed<M, 1> scaledInnovation = innovation;
+                    cholesky::solve(l, scaledInnovation);
+
+                    for(uint i = 0; i < NUM_SIGMA_POINTS; ++i) {
+                        for(uint a = 0; a < M; ++a) {
+                            d.at(i) += predictedObservations.at(a, i) * scaledInnovation.at(a);
+                        }
+                    }
+
+                    // Update our mean and covariance: X * C * d and X * C * X.t()
+                    for(uint j = 0; j < NUM_SIGMA_POINTS; ++j) {
+                        for(uint n = 0; n < Model::size; ++n) {
+                            double value = 0;
+                            for(uint k = 0; k < NUM_SIGMA_POINTS; ++k) {
+                                value += centredSigmaPoints.at(n, k) * covarianceUpdate.at(k, j);
+                            }
+                            centredUpdate.at(n, j) = value;
+                        }
+                    }
+
+                    for(uint n = 0; n < Model::size; ++n) {
+                        double value = sigmaMean.at(n);
+                        for(uint k = 0; k < NUM_SIGMA_POINTS; ++k) {
+                            value += centredUpdate.at(n, k) * d.at(k);
+                        }
+                        mean.at(n) = value;
+                    }
+                    mean = model.limitState(mean);
+
+                    for(uint a = 0; a < Model::size; ++a) {
+                        for(uint b = 0; b < Model::size; ++b) {
+                            double value = 0;
+                            for(uint k = 0; k < NUM_SIGMA_POINTS; ++k) {
+                                value += centredUpdate.at(a, k) * centredSigmaPoints.at(b, k);
+                            }
+                            covariance.at(a, b) = value;
+                        }
+                    }
+
+                    // Magical quality calculation
+                    MeasurementMat innovationVariance = predictedCovariance + variance;
+                    if(!cholesky::factor(innovationVariance, l)) {
+                        throw std::runtime_error("The innovation variance of a measurement update was not positive-definite");
+                    }
+                    arma::mat::fixed<M, 1> solvedInnovation = innovation;
+                    cholesky::solve(l, solvedInnovation);
+
+                    double mahalanobis = 0;
+                    double determinant = 1;
+                    for(uint a = 0; a < M; ++a) {
+                        mahalanobis += innovation.at(a) * solvedInnovation.at(a);
+                        determinant *= l.at(a, a) * l.at(a, a);
+                    }
+
+                    double expTerm = -0.5 * mahalanobis;
+                    double fract = 1 / sqrt(pow(2 * M_PI, M) * determinant);
+                    const float outlierProbability = 0.05;
+
+                    return (1.0 - outlierProbability) * fract * exp(expTerm) + outlierProbability;
+                }
+
+                /**
+                 * Takes measurements whose size is only known at runtime (as UKF does) and passes them on to the fixed
+                 * size update
+                 */
+                template <typename... TMeasurementType>
+                double measurementUpdate(const arma::vec& measurement,
+                                         const arma::mat& measurement_variance,
+                                         const TMeasurementType&... measurementArgs) {
+
+                    switch(measurement.n_elem) {
+                        case 1: return measurementUpdate(arma::vec::fixed<1>(measurement), measurement_variance, measurementArgs...);
+                        case 2: return measurementUpdate(arma::vec::fixed<2>(measurement), measurement_variance, measurementArgs...);
+                        case 3: return measurementUpdate(arma::vec::fixed<3>(measurement), measurement_variance, measurementArgs...);
+                        case 4: return measurementUpdate(arma::vec::fixed<4>(measurement), measurement_variance, measurementArgs...);
+                        case 5: return measurementUpdate(arma::vec::fixed<5>(measurement), measurement_variance, measurementArgs...);
+                        case 6: return measurementUpdate(arma::vec::fixed<6>(measurement), measurement_variance, measurementArgs...);
+                        default: throw std::invalid_argument("FixedUKF only takes measurements with up to 6 dimensions");
+                    }
+                }
+
+                StateVec get() const {
+                    return mean;
+                }
+
+                StateMat getCovariance() const {
+                    return covariance;
+                }
+            };
+        }
+    }
+}
+
+
+#endif
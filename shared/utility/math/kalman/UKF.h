@@ -200,11 +200,11 @@ namespace utility {
 
                     // Now calculate the mean of these measurement sigmas.
                     arma::vec predictedMean = meanFromSigmas(predictedObservations);
-                    predictedObservations.each_col() -= predictedMean;
-
-
                     arma::mat predictedCovariance = covarianceFromSigmas(predictedObservations, predictedMean);
 
+                    // The rest of the update works with the centred predictions
+                    predictedObservations.each_col() -= predictedMean;
+
                     const arma::mat innovation = model.observationDifference(measurement, predictedMean);
 
                     // Update our state
@@ -21,13 +21,56 @@
 #define UTILITY_MATH_RANSAC_RANSAC_H
 
 #include <nuclear>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <utility>
 #include <vector>
 
+#include "utility/parallel/WorkerPool.h"
+
 namespace utility {
 namespace math {
 namespace ransac {
 
+    /**
+     * The settings for one run of ransac
+     */
+    struct RansacParameters {
+
+        RansacParameters(uint minimumPointsForConsensus
+                       , uint maximumIterationsPerFitting
+                       , uint maximumFittedModels
+                       , double consensusErrorThreshold
+                       , double confidence = 1.0
+                       , uint threads = 1
+                       , uint preemptiveBlockSize = 0)
+        : minimumPointsForConsensus(minimumPointsForConsensus)
+        , maximumIterationsPerFitting(maximumIterationsPerFitting)
+        , maximumFittedModels(maximumFittedModels)
+        , consensusErrorThreshold(consensusErrorThreshold)
+        , confidence(confidence)
+        , threads(threads)
+        , preemptiveBlockSize(preemptiveBlockSize) {}
+
+        uint minimumPointsForConsensus;
+        uint maximumIterationsPerFitting;
+        uint maximumFittedModels;
+        double consensusErrorThreshold;
+
+        // Stop once we are this sure no better model exists (e.g. 0.99), the default of 1 always runs every iteration
+        double confidence;
+
+        // How many threads to score hypotheses on (0 uses every thread in the worker pool)
+        uint threads;
+
+        // When non zero every hypothesis is made up front and after each block of this many points the worse half is dropped
+        uint preemptiveBlockSize;
+    };
+
     template <typename Model>
     struct Ransac {
 
@@ -41,6 +84,9 @@ namespace ransac {
 
         using DataPoint = typename Model::DataPoint;
 
+        // How many times we try to draw a sample that makes a valid model before giving up on that hypothesis
+        static constexpr uint MAXIMUM_REGENERATION_ATTEMPTS = 100;
+
         static uint64_t xorShift() {
             static thread_local uint64_t s[2] = { uint64_t(rand()), uint64_t(rand()) };
 
@@ -51,29 +97,256 @@ namespace ransac {
             return (s[1] = (s1 ^ s0 ^ (s1 >> 17) ^ (s0 >> 26))) + s0;
         }
 
+        /**
+         * Draws REQUIRED_POINTS distinct indices below range
+         */
+        static void sampleIndices(uint64_t (&indices)[Model::REQUIRED_POINTS], const uint64_t range) {
+            for(size_t i = 0; i < Model::REQUIRED_POINTS; ++i) {
+                bool unique;
+                do {
+                    indices[i] = xorShift() % range;
+                    unique = std::find(indices, indices + i, indices[i]) == indices + i;
+                }
+                while(!unique);
+            }
+        }
+
         template <typename Iterator>
-        static void regenerateRandomModel(Model& model, const Iterator first, const Iterator last) {
+        static void samplePoints(std::vector<DataPoint>& points, const Iterator first, const Iterator last, std::random_access_iterator_tag) {
+
+            uint64_t indices[Model::REQUIRED_POINTS];
+            sampleIndices(indices, std::distance(first, last));
+
+            for(auto& i : indices) {
+                points.push_back(first[i]);
+            }
+        }
+
+        template <typename Iterator>
+        static void samplePoints(std::vector<DataPoint>& points, const Iterator first, const Iterator last, std::forward_iterator_tag) {
+
+            uint64_t indices[Model::REQUIRED_POINTS];
+            sampleIndices(indices, std::distance(first, last));
+            std::sort(std::begin(indices), std::end(indices));
+
+            // Walk the data once, stopping at each index in order
+            Iterator it = first;
+            uint64_t position = 0;
+            for(auto& i : indices) {
+                std::advance(it, i - position);
+                position = i;
+                points.push_back(*it);
+            }
+        }
 
-            // Get random points between first and last
-            uint range = std::distance(first, last);
-            std::vector<DataPoint> points;
-            do {
+        /**
+         * Makes the model from a random sample of the points between first and last
+         *
+         * @return false if no valid model could be made from the samples we tried
+         */
+        template <typename Iterator>
+        static bool regenerateRandomModel(Model& model, const Iterator first, const Iterator last) {
+
+            // Reused between calls so sampling does not allocate
+            static thread_local std::vector<DataPoint> points;
+
+            for(uint attempt = 0; attempt < MAXIMUM_REGENERATION_ATTEMPTS; ++attempt) {
                 points.clear();
-                std::set<uint64_t> indices;
+                samplePoints(points, first, last, typename std::iterator_traits<Iterator>::iterator_category());
+
+                // If this returns false then it was an invalid model
+                if(model.regenerate(points)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * The number of iterations needed to have drawn an all inlier sample with the given confidence
+         */
+        static uint requiredIterations(const uint consensus, const uint points, const double confidence, const uint maximum) {
+
+            if(confidence >= 1.0 || consensus == 0) {
+                return maximum;
+            }
 
-                while(indices.size() < Model::REQUIRED_POINTS) {
-                    indices.insert(xorShift() % range);
+            double allInliers = std::pow(double(consensus) / double(points), double(Model::REQUIRED_POINTS));
 
+            if(allInliers >= 1.0) {
+                return 1;
+            }
+            else if(allInliers <= std::numeric_limits<double>::epsilon()) {
+                return maximum;
+            }
+
+            double iterations = std::ceil(std::log(1.0 - confidence) / std::log(1.0 - allInliers));
+            return iterations < double(maximum) ? std::max(1u, uint(iterations)) : maximum;
+        }
+
+        /**
+         * Counts the points within the threshold of the model, giving up once it can no longer reach target
+         */
+        template <typename Iterator>
+        static uint score(const Model& model, const Iterator first, const Iterator last, const uint points, const uint target, const double threshold, double& error) {
+
+            uint consensus = 0;
+            uint remaining = points;
+            error = 0.0;
+
+            for(auto it = first; it != last && consensus + remaining >= target; ++it, --remaining) {
+                double e = model.calculateError(*it);
+                if(e < threshold) {
+                    ++consensus;
+                    error += e;
                 }
+            }
+
+            return consensus;
+        }
+
+        /**
+         * The best hypothesis found so far by one thread
+         */
+        struct Candidate {
+            Candidate() : consensus(0), error(std::numeric_limits<double>::max()), model() {}
+
+            bool betterThan(const uint otherConsensus, const double otherError) const {
+                return consensus > otherConsensus || (consensus == otherConsensus && error < otherError);
+            }
 
-                for(auto& i : indices) {
-                    points.push_back(*std::next(first, i));
+            uint consensus;
+            double error;
+            Model model;
+        };
+
+        /**
+         * Scores random hypotheses until we run out of iterations or are confident there is nothing better to find.
+         * The iterations are shared between the threads so stopping early on one stops them all.
+         */
+        template <typename Iterator>
+        static Candidate searchAdaptive(const Iterator first, const Iterator last, const RansacParameters& parameters) {
+
+            const uint points = std::distance(first, last);
+
+            std::atomic<uint> next(0);
+            std::atomic<uint> limit(parameters.maximumIterationsPerFitting);
+            std::atomic<uint> largestConsensus(0);
+
+            std::mutex mutex;
+            Candidate best;
+
+            std::function<void (uint)> job = [&] (uint) {
+
+                Candidate local;
+                Model model;
+
+                while(next++ < limit) {
+
+                    if(!regenerateRandomModel(model, first, last)) {
+                        continue;
+                    }
+
+                    double error;
+                    uint consensus = score(model, first, last, points, largestConsensus, parameters.consensusErrorThreshold, error);
+
+                    if(local.betterThan(consensus, error)) {
+                        continue;
+                    }
 
+                    local.consensus = consensus;
+                    local.error = error;
+                    local.model = model;
+
+                    // Share how good our best is so the other threads can stop scoring hopeless hypotheses sooner
+                    uint shared = largestConsensus;
+                    while(consensus > shared && !largestConsensus.compare_exchange_weak(shared, consensus));
+
+                    uint required = requiredIterations(consensus, points, parameters.confidence, parameters.maximumIterationsPerFitting);
+                    uint current = limit;
+                    while(required < current && !limit.compare_exchange_weak(current, required));
                 }
 
-                // If this returns false then it was an invalid model
+                std::lock_guard<std::mutex> lock(mutex);
+                if(local.betterThan(best.consensus, best.error)) {
+                    best = std::move(local);
+                }
+            };
+
+            uint threads = parameters.threads == 0 ? utility::parallel::WorkerPool::instance().size() : parameters.threads;
+            utility::parallel::WorkerPool::instance().run(threads, job);
+
+            return best;
+        }
+
+        /**
+         * Preemptive ransac: makes every hypothesis up front then scores them all a block of points at a time,
+         * dropping the worse half after each block until one is left.
+         * The points are visited in a scattered order so each block is a fair sample of the data.
+         */
+        template <typename Iterator>
+        static Candidate searchPreemptive(const Iterator first, const Iterator last, const RansacParameters& parameters) {
+
+            const uint points = std::distance(first, last);
+
+            static thread_local std::vector<Model> models;
+            static thread_local std::vector<std::pair<uint, uint>> scores;
+            models.clear();
+            scores.clear();
+
+            Model model;
+            for(uint i = 0; i < parameters.maximumIterationsPerFitting; ++i) {
+                if(regenerateRandomModel(model, first, last)) {
+                    scores.push_back(std::make_pair(0u, uint(models.size())));
+                    models.push_back(model);
+                }
+            }
+
+            if(models.empty()) {
+                return Candidate();
             }
-            while(!model.regenerate(points));
+
+            // Step through the points with a stride that shares no factors with their count so we visit each once
+            uint stride = uint(xorShift() % points) | 1;
+            while(points > 1 && gcd(stride, points) != 1) {
+                stride += 2;
+            }
+            uint offset = xorShift() % points;
+
+            const uint block = parameters.preemptiveBlockSize;
+            uint visited = 0;
+            size_t alive = scores.size();
+
+            while(alive > 1 && visited < points) {
+
+                uint blockEnd = std::min(points, visited + block);
+                for(; visited < blockEnd; ++visited) {
+                    auto it = std::next(first, (offset + uint64_t(visited) * stride) % points);
+
+                    for(size_t h = 0; h < alive; ++h) {
+                        if(models[scores[h].second].calculateError(*it) < parameters.consensusErrorThreshold) {
+                            ++scores[h].first;
+                        }
+                    }
+                }
+
+                // Keep the best half
+                size_t keep = (alive + 1) / 2;
+                std::nth_element(scores.begin(), scores.begin() + keep - 1, scores.begin() + alive, [] (const std::pair<uint, uint>& a, const std::pair<uint, uint>& b) {
+                    return a.first > b.first;
+                });
+                alive = keep;
+            }
+
+            // Pick the survivor with the most support then score it over everything
+            auto survivor = std::max_element(scores.begin(), scores.begin() + alive);
+
+            Candidate best;
+            best.model = models[survivor->second];
+            best.consensus = score(best.model, first, last, points, 0, parameters.consensusErrorThreshold, best.error);
+
+            return best;
         }
 
         /**
@@ -84,48 +357,26 @@ namespace ransac {
         template <typename Iterator>
         static std::pair<Iterator, RansacResult<Iterator>> findModel(Iterator first
                                                                    , Iterator last
-                                                                   , uint minimumPointsForConsensus
-                                                                   , uint maximumIterationsPerFitting
-                                                                   , double consensusErrorThreshold) {
+                                                                   , const RansacParameters& parameters) {
 
             // Check we have enough points
-            if(std::distance(first, last) < int(minimumPointsForConsensus)) {
+            if(std::distance(first, last) < int(std::max(size_t(parameters.minimumPointsForConsensus), size_t(Model::REQUIRED_POINTS)))) {
                 return std::make_pair(last, RansacResult<Iterator>{ false, Model(), Iterator(), Iterator() });
             }
 
-            uint largestConsensus = 0;
-            double bestError = std::numeric_limits<double>::max();
-            Model bestModel;
-            Model model;
+            Candidate best = parameters.preemptiveBlockSize > 0
+                ? searchPreemptive(first, last, parameters)
+                : searchAdaptive(first, last, parameters);
 
-            for(uint i = 0; i < maximumIterationsPerFitting; ++i) {
+            if(best.consensus > 0 && best.consensus >= parameters.minimumPointsForConsensus) {
 
-                uint consensusSize = 0;
-                double error = 0.0;
+                Model& bestModel = best.model;
+                const double threshold = parameters.consensusErrorThreshold;
 
-                regenerateRandomModel(model, first, last);
-                for(auto it = first; it != last; ++it) {
-                    if(model.calculateError(*it) < consensusErrorThreshold) {
-                        ++consensusSize;
-                        error += consensusErrorThreshold;
-                    }
-                }
+                bestModel.refineModel(first, last, threshold);
 
-                // If largest consensus
-                if(consensusSize > largestConsensus or
-                   (consensusSize == largestConsensus and error < bestError)) {
-                    largestConsensus = consensusSize;
-                    bestError = error;
-                    bestModel = std::move(model);
-                }
-            }
-
-            if(largestConsensus >= minimumPointsForConsensus) {
-
-                model.refineModel(first,last,consensusErrorThreshold);
-
-                auto newFirst = std::partition(first, last, [consensusErrorThreshold, bestModel] (const DataPoint& point) {
-                    return consensusErrorThreshold > bestModel.calculateError(std::forward<const DataPoint&>(point));
+                auto newFirst = std::partition(first, last, [threshold, &bestModel] (const DataPoint& point) {
+                    return threshold > bestModel.calculateError(std::forward<const DataPoint&>(point));
                 });
 
                 return std::make_pair(newFirst, RansacResult<Iterator>{ true, bestModel, first, newFirst });
@@ -135,20 +386,27 @@ namespace ransac {
             }
         }
 
+        template <typename Iterator>
+        static std::pair<Iterator, RansacResult<Iterator>> findModel(Iterator first
+                                                                   , Iterator last
+                                                                   , uint minimumPointsForConsensus
+                                                                   , uint maximumIterationsPerFitting
+                                                                   , double consensusErrorThreshold) {
+
+            return findModel(first, last, RansacParameters(minimumPointsForConsensus, maximumIterationsPerFitting, 1, consensusErrorThreshold));
+        }
+
         template <typename Iterator>
         static std::vector<RansacResult<Iterator>> fitModels(Iterator first
                                                            , Iterator last
-                                                           , uint minimumPointsForConsensus
-                                                           , uint maximumIterationsPerFitting
-                                                           , uint maximumFittedModels
-                                                           , double consensusErrorThreshold) {
+                                                           , const RansacParameters& parameters) {
 
             std::vector<RansacResult<Iterator>> results;
-            results.reserve(maximumFittedModels);
+            results.reserve(parameters.maximumFittedModels);
 
-            while(results.size() < maximumFittedModels) {
+            while(results.size() < parameters.maximumFittedModels) {
                 RansacResult<Iterator> result;
-                std::tie(first, result) = findModel(first, last, minimumPointsForConsensus, maximumIterationsPerFitting, consensusErrorThreshold);
+                std::tie(first, result) = findModel(first, last, parameters);
 
                 // If we have more datapoints left then add this one and continue
                 if(result.valid) {
@@ -161,6 +419,30 @@ namespace ransac {
 
             return results;
         }
+
+        template <typename Iterator>
+        static std::vector<RansacResult<Iterator>> fitModels(Iterator first
+                                                           , Iterator last
+                                                           , uint minimumPointsForConsensus
+                                                           , uint maximumIterationsPerFitting
+                                                           , uint maximumFittedModels
+                                                           , double consensusErrorThreshold) {
+
+            return fitModels(first, last, RansacParameters(minimumPointsForConsensus
+                                                         , maximumIterationsPerFitting
+                                                         , maximumFittedModels
+                                                         , consensusErrorThreshold));
+        }
+
+    private:
+        static uint gcd(uint a, uint b) {
+            while(b != 0) {
+                uint t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
     };
 
 }
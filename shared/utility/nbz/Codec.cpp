@@ -0,0 +1,338 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "Codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef USE_LZ4
+    #include <lz4.h>
+#endif
+
+namespace utility {
+namespace nbz {
+
+    namespace {
+
+        // The LZ4 block format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_FIND_LIMIT = 12;
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr int HASH_BITS = 14;
+
+        inline uint32_t read32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint32_t hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        inline uint8_t* writeLength(uint8_t* op, size_t length) {
+            while(length >= 255) {
+                *op++ = 255;
+                length -= 255;
+            }
+            *op++ = uint8_t(length);
+            return op;
+        }
+
+        inline uint64_t rotl(uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+#ifndef USE_LZ4
+        size_t compressLZ4(const uint8_t* input, size_t size, uint8_t* output) {
+
+            // Positions are stored plus one so zero means empty
+            static thread_local uint32_t table[1 << HASH_BITS];
+            std::memset(table, 0, sizeof(table));
+
+            const uint8_t* ip = input;
+            const uint8_t* anchor = input;
+            const uint8_t* const end = input + size;
+            uint8_t* op = output;
+
+            if(size > MATCH_FIND_LIMIT) {
+                const uint8_t* const matchLimit = end - LAST_LITERALS;
+                const uint8_t* const findLimit = end - MATCH_FIND_LIMIT;
+
+                while(ip < findLimit) {
+
+                    uint32_t sequence = read32(ip);
+                    uint32_t& slot = table[hash(sequence)];
+                    const uint8_t* ref = input + slot - 1;
+                    bool found = slot != 0 && size_t(ip - ref) <= MAX_OFFSET && read32(ref) == sequence;
+                    slot = uint32_t(ip - input) + 1;
+
+                    if(!found) {
+                        // Step further the longer we go without a match so incompressible data is skipped quickly
+                        ip += 1 + ((ip - anchor) >> 6);
+                        continue;
+                    }
+
+                    // See how far the match goes, 8 bytes at a time until they differ
+                    const uint8_t* matchEnd = ip + MIN_MATCH;
+                    const uint8_t* refEnd = ref + MIN_MATCH;
+                    while(matchEnd + 8 <= matchLimit) {
+                        uint64_t a;
+                        uint64_t b;
+                        std::memcpy(&a, matchEnd, sizeof(a));
+                        std::memcpy(&b, refEnd, sizeof(b));
+                        if(a != b) {
+                            // The lowest set bit is the first byte that differs (we are little endian)
+                            matchEnd += __builtin_ctzll(a ^ b) / 8;
+                            break;
+                        }
+                        matchEnd += 8;
+                        refEnd += 8;
+                    }
+                    if(matchEnd + 8 > matchLimit) {
+                        refEnd = ref + (matchEnd - ip);
+                        while(matchEnd < matchLimit && *matchEnd == *refEnd) {
+                            ++matchEnd;
+                            ++refEnd;
+                        }
+                    }
+
+                    size_t literals = ip - anchor;
+                    size_t matchLength = matchEnd - ip - MIN_MATCH;
+                    size_t offset = ip - ref;
+
+                    uint8_t* token = op++;
+                    *token = uint8_t(((literals < 15 ? literals : 15) << 4) | (matchLength < 15 ? matchLength : 15));
+
+                    if(literals >= 15) {
+                        op = writeLength(op, literals - 15);
+                    }
+                    std::memcpy(op, anchor, literals);
+                    op += literals;
+
+                    *op++ = uint8_t(offset);
+                    *op++ = uint8_t(offset >> 8);
+
+                    if(matchLength >= 15) {
+                        op = writeLength(op, matchLength - 15);
+                    }
+
+                    ip = matchEnd;
+                    anchor = ip;
+                }
+            }
+
+            // Everything left over is literals
+            size_t literals = end - anchor;
+            *op++ = uint8_t((literals < 15 ? literals : 15) << 4);
+            if(literals >= 15) {
+                op = writeLength(op, literals - 15);
+            }
+            if(literals > 0) {
+                std::memcpy(op, anchor, literals);
+                op += literals;
+            }
+
+            return op - output;
+        }
+#endif
+
+        size_t decompressLZ4(const uint8_t* input, size_t size, uint8_t* output, size_t outputSize, bool partial) {
+
+            const uint8_t* ip = input;
+            const uint8_t* const end = input + size;
+            uint8_t* op = output;
+            uint8_t* const outputEnd = output + outputSize;
+
+            // When the input runs out part way through a partial block we keep what we have, otherwise it is corrupt
+            const size_t failed = 0;
+
+            while(ip < end) {
+
+                uint8_t token = *ip++;
+
+                size_t literals = token >> 4;
+                if(literals == 15) {
+                    uint8_t b;
+                    do {
+                        if(ip >= end) {
+                            return partial ? op - output : failed;
+                        }
+                        b = *ip++;
+                        literals += b;
+                    } while(b == 255);
+                }
+
+                if(literals > size_t(end - ip)) {
+                    if(!partial) {
+                        return failed;
+                    }
+                    literals = std::min(size_t(end - ip), size_t(outputEnd - op));
+                    std::memcpy(op, ip, literals);
+                    return (op + literals) - output;
+                }
+                if(literals > size_t(outputEnd - op)) {
+                    return failed;
+                }
+
+                if(literals > 0) {
+                    std::memcpy(op, ip, literals);
+                    ip += literals;
+                    op += literals;
+                }
+
+                // The last sequence is only literals
+                if(ip == end) {
+                    break;
+                }
+
+                if(end - ip < 2) {
+                    return partial ? op - output : failed;
+                }
+
+                size_t offset = ip[0] | (ip[1] << 8);
+                ip += 2;
+
+                if(offset == 0 || offset > size_t(op - output)) {
+                    return failed;
+                }
+
+                size_t matchLength = token & 15;
+                if(matchLength == 15) {
+                    uint8_t b;
+                    do {
+                        if(ip >= end) {
+                            return partial ? op - output : failed;
+                        }
+                        b = *ip++;
+                        matchLength += b;
+                    } while(b == 255);
+                }
+                matchLength += MIN_MATCH;
+
+                if(matchLength > size_t(outputEnd - op)) {
+                    return failed;
+                }
+
+                const uint8_t* match = op - offset;
+
+                if(offset >= 8) {
+                    // Copying forward 8 bytes at a time never reads bytes this copy has not written yet
+                    uint8_t* copyEnd = op + matchLength;
+                    while(size_t(copyEnd - op) >= 8) {
+                        std::memcpy(op, match, 8);
+                        op += 8;
+                        match += 8;
+                    }
+                    while(op < copyEnd) {
+                        *op++ = *match++;
+                    }
+                }
+                else {
+                    // Short offsets repeat a pattern so must be copied a byte at a time
+                    for(size_t i = 0; i < matchLength; ++i) {
+                        *op++ = *match++;
+                    }
+                }
+            }
+
+            return op - output;
+        }
+    }
+
+    size_t compressBound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    size_t compress(Codec codec, const uint8_t* input, size_t size, uint8_t* output) {
+
+        switch(codec) {
+            case Codec::LZ4:
+#ifdef USE_LZ4
+                return LZ4_compress_default(reinterpret_cast<const char*>(input), reinterpret_cast<char*>(output), int(size), int(compressBound(size)));
+#else
+                return compressLZ4(input, size, output);
+#endif
+            case Codec::STORED:
+            default:
+                if(size > 0) {
+                    std::memcpy(output, input, size);
+                }
+                return size;
+        }
+    }
+
+    size_t decompress(Codec codec, const uint8_t* input, size_t size, uint8_t* output, size_t outputSize, bool partial) {
+
+        switch(codec) {
+            case Codec::LZ4:
+#ifdef USE_LZ4
+                if(!partial) {
+                    int decoded = LZ4_decompress_safe(reinterpret_cast<const char*>(input), reinterpret_cast<char*>(output), int(size), int(outputSize));
+                    return decoded < 0 ? 0 : size_t(decoded);
+                }
+#endif
+                return decompressLZ4(input, size, output, outputSize, partial);
+
+            case Codec::STORED:
+                if(size > outputSize || (size < outputSize && !partial)) {
+                    return 0;
+                }
+                std::memcpy(output, input, size);
+                return size;
+
+            default:
+                return 0;
+        }
+    }
+
+    uint32_t checksum(const uint8_t* data, size_t size) {
+
+        uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+        size_t i = 0;
+
+        for(; i + 8 <= size; i += 8) {
+            uint64_t k;
+            std::memcpy(&k, data + i, sizeof(k));
+            k *= 0x87C37B91114253D5ull;
+            k = rotl(k, 31);
+            k *= 0x4CF5AD432745937Full;
+            h ^= k;
+            h = rotl(h, 27) * 5 + 0x52DCE729;
+        }
+
+        for(; i < size; ++i) {
+            h ^= data[i] * 0x9E3779B97F4A7C15ull;
+            h = rotl(h, 11) * 0x87C37B91114253D5ull;
+        }
+
+        // Mix the bits so every input bit affects the 32 we keep
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+
+        return uint32_t(h ^ (h >> 32));
+    }
+
+}
+}
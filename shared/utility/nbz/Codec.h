@@ -0,0 +1,69 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_NBZ_CODEC_H
+#define UTILITY_NBZ_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utility {
+namespace nbz {
+
+    /**
+     * How the records in a block are compressed
+     */
+    enum class Codec : uint8_t {
+        // The records as they are
+        STORED = 0,
+        // The LZ4 block format, using liblz4 when we are built with it and our own implementation when we are not
+        LZ4 = 1
+    };
+
+    /**
+     * The largest output compressing size bytes could produce
+     */
+    size_t compressBound(size_t size);
+
+    /**
+     * Compresses size bytes from input into output, which must have room for compressBound(size) bytes
+     *
+     * @return the compressed size
+     */
+    size_t compress(Codec codec, const uint8_t* input, size_t size, uint8_t* output);
+
+    /**
+     * Decompresses a block into output.
+     *
+     * When partial is set the input may be cut short (e.g. a block that was being written when we crashed),
+     * in which case everything that could be decoded before the input ran out is kept.
+     *
+     * @return the number of bytes written to output, or 0 if the input was corrupt
+     */
+    size_t decompress(Codec codec, const uint8_t* input, size_t size, uint8_t* output, size_t outputSize, bool partial = false);
+
+    /**
+     * A fast 32 bit checksum for catching torn or corrupt writes
+     */
+    uint32_t checksum(const uint8_t* data, size_t size);
+
+}
+}
+
+#endif
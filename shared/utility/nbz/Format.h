@@ -0,0 +1,137 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_NBZ_FORMAT_H
+#define UTILITY_NBZ_FORMAT_H
+
+#include <cstdint>
+#include <string>
+
+#include "Codec.h"
+
+namespace utility {
+namespace nbz {
+
+    /**
+     * @brief The layout of an NBZ (version 2) log file.
+     *
+     * @details
+     *  FileHeader
+     *  Block (BlockHeader then the compressed records) ...
+     *  Index (IndexHeader then an IndexEntry for every block)
+     *  Trailer
+     *
+     *  Inside a block each record is a RecordHeader followed by its data. Blocks are written whole so a crash only
+     *  loses the block being written, and a file with no index (the writer never closed it) can be recovered by
+     *  walking the block headers. All values are little endian. The structures below are copied to and from the file
+     *  as they are laid out in memory, so NBZ can only be built for little endian machines (checked below).
+     */
+
+    constexpr uint32_t FILE_MAGIC    = 0x325A424E; // "NBZ2"
+    constexpr uint32_t BLOCK_MAGIC   = 0x425A424E; // "NBZB"
+    constexpr uint32_t INDEX_MAGIC   = 0x495A424E; // "NBZI"
+    constexpr uint32_t TRAILER_MAGIC = 0x455A424E; // "NBZE"
+    constexpr uint16_t VERSION = 2;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t flags;
+        uint32_t blockSize;
+        uint32_t reserved;
+    };
+
+    struct BlockHeader {
+        uint32_t magic;
+        Codec codec;
+        uint8_t reserved[3];
+        uint32_t compressedSize;
+        uint32_t uncompressedSize;
+        uint32_t records;
+        // Checksum of the compressed payload
+        uint32_t payloadChecksum;
+        // Checksum of this header with this field set to 0
+        uint32_t headerChecksum;
+        uint32_t reserved2;
+        int64_t firstTimestamp;
+        int64_t lastTimestamp;
+        // Bit (type % 64) is set when the block holds a record of that type
+        uint64_t typeMask;
+    };
+
+    struct RecordHeader {
+        int64_t timestamp;
+        uint32_t type;
+        uint32_t length;
+    };
+
+    struct IndexHeader {
+        uint32_t magic;
+        uint32_t entries;
+        uint32_t checksum;
+        uint32_t reserved;
+    };
+
+    struct IndexEntry {
+        uint64_t offset;
+        int64_t firstTimestamp;
+        int64_t lastTimestamp;
+        uint32_t records;
+        uint32_t reserved;
+        uint64_t typeMask;
+    };
+
+    struct Trailer {
+        uint64_t indexOffset;
+        uint32_t magic;
+        uint32_t reserved;
+    };
+
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "NBZ structures are written in host byte order, which must be little endian");
+    static_assert(sizeof(FileHeader) == 16, "NBZ file header must be 16 bytes");
+    static_assert(sizeof(BlockHeader) == 56, "NBZ block header must be 56 bytes");
+    static_assert(sizeof(RecordHeader) == 16, "NBZ record header must be 16 bytes");
+    static_assert(sizeof(IndexHeader) == 16, "NBZ index header must be 16 bytes");
+    static_assert(sizeof(IndexEntry) == 40, "NBZ index entry must be 40 bytes");
+    static_assert(sizeof(Trailer) == 16, "NBZ trailer must be 16 bytes");
+
+    /**
+     * Hashes the name of a record's type (FNV-1a) so readers can pick out the records they want without parsing them
+     */
+    inline uint32_t typeHash(const std::string& name) {
+        uint32_t hash = 2166136261u;
+        for(auto& c : name) {
+            hash = (hash ^ uint8_t(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    inline uint64_t typeBit(const uint32_t& type) {
+        return uint64_t(1) << (type % 64);
+    }
+
+    inline uint32_t headerChecksum(BlockHeader header) {
+        header.headerChecksum = 0;
+        return checksum(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    }
+
+}
+}
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "NBZReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utility {
+namespace nbz {
+
+    NBZReader::NBZReader(const std::string& path)
+        : fd(-1)
+        , fileSize(0)
+        , wasRecovered(false)
+        , index()
+        , types()
+        , typeMask(std::numeric_limits<uint64_t>::max())
+        , from(std::numeric_limits<int64_t>::min())
+        , skip(0)
+        , nextBlock(0)
+        , compressed()
+        , records()
+        , position(0)
+        , recordsEnd(0) {
+
+        fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open " + path);
+        }
+
+        struct stat info;
+        if(::fstat(fd, &info) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "Failed to stat " + path);
+        }
+        fileSize = info.st_size;
+
+        FileHeader header;
+        if(fileSize < sizeof(header)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not an NBZ log");
+        }
+
+        readAll(&header, sizeof(header), 0);
+        if(header.magic != FILE_MAGIC || header.version != VERSION) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not an NBZ version 2 log");
+        }
+
+        if(!readIndex()) {
+            rebuildIndex();
+        }
+    }
+
+    NBZReader::~NBZReader() {
+        if(fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool NBZReader::next(Record& record) {
+
+        while(true) {
+
+            // Pull records out of the current block
+            while(position + sizeof(RecordHeader) <= recordsEnd) {
+
+                RecordHeader header;
+                std::memcpy(&header, records.data() + position, sizeof(header));
+
+                // A record cut off by the end of a recovered block
+                if(header.length > recordsEnd - position - sizeof(header)) {
+                    position = recordsEnd;
+                    break;
+                }
+
+                record.timestamp = header.timestamp;
+                record.type = header.type;
+                record.data = records.data() + position + sizeof(header);
+                record.length = header.length;
+
+                position += sizeof(header) + header.length;
+
+                if(skip > 0) {
+                    --skip;
+                    continue;
+                }
+
+                if(header.timestamp < from) {
+                    continue;
+                }
+                from = std::numeric_limits<int64_t>::min();
+
+                if(types.empty() || std::find(types.begin(), types.end(), header.type) != types.end()) {
+                    return true;
+                }
+            }
+
+            // Move on to the next block that could have something for us
+            while(nextBlock < index.size() && !(index[nextBlock].typeMask & typeMask)) {
+                ++nextBlock;
+                skip = 0;
+            }
+
+            if(nextBlock >= index.size()) {
+                return false;
+            }
+
+            // A skip only applies to the block it was for
+            if(!load(nextBlock++)) {
+                skip = 0;
+            }
+        }
+    }
+
+    void NBZReader::seek(int64_t timestamp) {
+
+        // The first block that ends at or after the time we want
+        auto block = std::lower_bound(index.begin(), index.end(), timestamp, [] (const IndexEntry& entry, const int64_t& t) {
+            return entry.lastTimestamp < t;
+        });
+
+        nextBlock = block - index.begin();
+        position = 0;
+        recordsEnd = 0;
+        from = timestamp;
+        skip = 0;
+    }
+
+    void NBZReader::seekRecord(uint64_t record) {
+
+        // Find the block the record is in using the record counts of the blocks before it
+        uint64_t first = 0;
+        size_t block = 0;
+        while(block < index.size() && first + index[block].records <= record) {
+            first += index[block].records;
+            ++block;
+        }
+
+        nextBlock = block;
+        position = 0;
+        recordsEnd = 0;
+        from = std::numeric_limits<int64_t>::min();
+        skip = record - first;
+    }
+
+    void NBZReader::rewind() {
+        nextBlock = 0;
+        position = 0;
+        recordsEnd = 0;
+        from = std::numeric_limits<int64_t>::min();
+        skip = 0;
+    }
+
+    void NBZReader::filter(const std::vector<uint32_t>& types) {
+
+        this->types = types;
+
+        if(types.empty()) {
+            typeMask = std::numeric_limits<uint64_t>::max();
+        }
+        else {
+            typeMask = 0;
+            for(auto& type : types) {
+                typeMask |= typeBit(type);
+            }
+        }
+    }
+
+    int64_t NBZReader::firstTimestamp() const {
+        return index.empty() ? 0 : index.front().firstTimestamp;
+    }
+
+    int64_t NBZReader::lastTimestamp() const {
+        return index.empty() ? 0 : index.back().lastTimestamp;
+    }
+
+    uint64_t NBZReader::size() const {
+        uint64_t records = 0;
+        for(auto& entry : index) {
+            records += entry.records;
+        }
+        return records;
+    }
+
+    bool NBZReader::readIndex() {
+
+        if(fileSize < sizeof(FileHeader) + sizeof(IndexHeader) + sizeof(Trailer)) {
+            return false;
+        }
+
+        Trailer trailer;
+        readAll(&trailer, sizeof(trailer), fileSize - sizeof(trailer));
+
+        if(trailer.magic != TRAILER_MAGIC || trailer.indexOffset < sizeof(FileHeader)
+        || trailer.indexOffset + sizeof(IndexHeader) + sizeof(Trailer) > fileSize) {
+            return false;
+        }
+
+        IndexHeader header;
+        readAll(&header, sizeof(header), trailer.indexOffset);
+
+        if(header.magic != INDEX_MAGIC
+        || trailer.indexOffset + sizeof(IndexHeader) + uint64_t(header.entries) * sizeof(IndexEntry) + sizeof(Trailer) != fileSize) {
+            return false;
+        }
+
+        index.resize(header.entries);
+        readAll(index.data(), index.size() * sizeof(IndexEntry), trailer.indexOffset + sizeof(IndexHeader));
+
+        if(checksum(reinterpret_cast<const uint8_t*>(index.data()), index.size() * sizeof(IndexEntry)) != header.checksum) {
+            index.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    void NBZReader::rebuildIndex() {
+
+        wasRecovered = true;
+        index.clear();
+
+        // Walk the block headers until we run out of file or find something that is not a block
+        uint64_t offset = sizeof(FileHeader);
+        while(offset + sizeof(BlockHeader) <= fileSize) {
+
+            BlockHeader header;
+            readAll(&header, sizeof(header), offset);
+
+            if(header.magic != BLOCK_MAGIC || header.headerChecksum != headerChecksum(header)) {
+                break;
+            }
+
+            index.push_back(IndexEntry { offset, header.firstTimestamp, header.lastTimestamp, header.records, 0, header.typeMask });
+
+            // A block cut off part way through is the last one
+            offset += sizeof(BlockHeader) + header.compressedSize;
+        }
+    }
+
+    bool NBZReader::load(size_t block) {
+
+        position = 0;
+        recordsEnd = 0;
+
+        uint64_t offset = index[block].offset;
+        if(offset + sizeof(BlockHeader) > fileSize) {
+            return false;
+        }
+
+        BlockHeader header;
+        readAll(&header, sizeof(header), offset);
+
+        if(header.magic != BLOCK_MAGIC || header.headerChecksum != headerChecksum(header)) {
+            return false;
+        }
+
+        // Read as much of the payload as there is
+        uint64_t available = std::min(uint64_t(header.compressedSize), fileSize - offset - sizeof(BlockHeader));
+        compressed.resize(available);
+        readAll(compressed.data(), available, offset + sizeof(BlockHeader));
+
+        records.resize(header.uncompressedSize);
+
+        if(available == header.compressedSize && checksum(compressed.data(), available) == header.payloadChecksum) {
+            recordsEnd = decompress(header.codec, compressed.data(), available, records.data(), records.size());
+        }
+        // A torn block from a crash, keep the records that made it
+        else if(available < header.compressedSize) {
+            recordsEnd = decompress(header.codec, compressed.data(), available, records.data(), records.size(), true);
+        }
+        // Otherwise the block is corrupt and we skip it
+
+        return recordsEnd > 0;
+    }
+
+    void NBZReader::readAll(void* data, size_t length, uint64_t offset) {
+
+        uint8_t* p = static_cast<uint8_t*>(data);
+
+        while(length > 0) {
+            ssize_t got = ::pread(fd, p, length, offset);
+
+            if(got < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(), "Failed to read NBZ log");
+            }
+            if(got == 0) {
+                throw std::runtime_error("Unexpected end of NBZ log");
+            }
+
+            p += got;
+            length -= got;
+            offset += got;
+        }
+    }
+
+}
+}
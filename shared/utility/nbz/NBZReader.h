@@ -0,0 +1,137 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_NBZ_NBZREADER_H
+#define UTILITY_NBZ_NBZREADER_H
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Format.h"
+
+namespace utility {
+namespace nbz {
+
+    /**
+     * @brief Reads records back out of an NBZ log.
+     *
+     * @details
+     *  The block index at the end of the file lets the reader seek to a timestamp and skip blocks with no records of
+     *  the types it is filtering for. If the log was never closed (there is no index) the index is rebuilt by walking
+     *  the block headers, and the complete records of a block that was cut off part way through are kept.
+     */
+    class NBZReader {
+    public:
+        /**
+         * A record in the log. The data points into the reader's block buffer so is only valid until the next call
+         */
+        struct Record {
+            int64_t timestamp;
+            uint32_t type;
+            const uint8_t* data;
+            uint32_t length;
+        };
+
+        explicit NBZReader(const std::string& path);
+        ~NBZReader();
+
+        NBZReader(const NBZReader&) = delete;
+        NBZReader& operator=(const NBZReader&) = delete;
+
+        /**
+         * Reads the next record that passes the filter
+         *
+         * @return false when there are no more records
+         */
+        bool next(Record& record);
+
+        /**
+         * Moves so the next record read is the first one at or after timestamp
+         */
+        void seek(int64_t timestamp);
+
+        /**
+         * Moves so the next record read is the given record of the log (counting every record, not just filtered ones)
+         */
+        void seekRecord(uint64_t record);
+
+        /**
+         * Moves back to the start of the log
+         */
+        void rewind();
+
+        /**
+         * Only read records of these types (typeHash values), an empty list reads everything
+         */
+        void filter(const std::vector<uint32_t>& types);
+
+        /**
+         * The index of blocks in the file
+         */
+        const std::vector<IndexEntry>& blocks() const {
+            return index;
+        }
+
+        /**
+         * True if the log had no index (the writer did not close it) and it was rebuilt from the blocks
+         */
+        bool recovered() const {
+            return wasRecovered;
+        }
+
+        int64_t firstTimestamp() const;
+        int64_t lastTimestamp() const;
+
+        /**
+         * The number of records in the log
+         */
+        uint64_t size() const;
+
+    private:
+        bool readIndex();
+        void rebuildIndex();
+        bool load(size_t block);
+        void readAll(void* data, size_t length, uint64_t offset);
+
+        int fd;
+        uint64_t fileSize;
+        bool wasRecovered;
+
+        std::vector<IndexEntry> index;
+
+        std::vector<uint32_t> types;
+        uint64_t typeMask;
+
+        // Records before this time are skipped (set by seek), as are the first skip records of the next block
+        int64_t from;
+        uint64_t skip;
+
+        // The next block to load and the records of the current one
+        size_t nextBlock;
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> records;
+        size_t position;
+        size_t recordsEnd;
+    };
+
+}
+}
+
+#endif
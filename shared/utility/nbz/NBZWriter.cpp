@@ -0,0 +1,185 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "NBZWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace utility {
+namespace nbz {
+
+    NBZWriter::NBZWriter(const std::string& path, Codec codec, uint32_t blockSize, std::chrono::milliseconds maxBlockAge)
+        : fd(-1)
+        , codec(codec)
+        , blockSize(blockSize)
+        , maxBlockAge(maxBlockAge)
+        , offset(0)
+        , index()
+        , block()
+        , compressed()
+        , header()
+        , blockStarted() {
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open " + path + " for writing");
+        }
+
+        block.reserve(blockSize + sizeof(RecordHeader));
+        compressed.reserve(sizeof(BlockHeader) + compressBound(blockSize));
+
+        FileHeader file;
+        std::memset(&file, 0, sizeof(file));
+        file.magic = FILE_MAGIC;
+        file.version = VERSION;
+        file.blockSize = blockSize;
+        writeAll(&file, sizeof(file));
+    }
+
+    NBZWriter::~NBZWriter() {
+        try {
+            close();
+        }
+        catch(...) {
+            // There is nobody to tell, the log will be recovered from its blocks when it is read
+        }
+    }
+
+    void NBZWriter::write(int64_t timestamp, uint32_t type, const void* data, uint32_t length) {
+
+        if(!isOpen()) {
+            throw std::runtime_error("Attempted to write to a closed NBZ log");
+        }
+
+        if(block.empty()) {
+            std::memset(&header, 0, sizeof(header));
+            header.firstTimestamp = timestamp;
+            blockStarted = std::chrono::steady_clock::now();
+        }
+
+        RecordHeader record { timestamp, type, length };
+        size_t start = block.size();
+        block.resize(start + sizeof(record) + length);
+        std::memcpy(block.data() + start, &record, sizeof(record));
+        std::memcpy(block.data() + start + sizeof(record), data, length);
+
+        header.lastTimestamp = timestamp;
+        header.typeMask |= typeBit(type);
+        ++header.records;
+
+        if(block.size() >= blockSize) {
+            flush();
+        }
+        else {
+            flushAged();
+        }
+    }
+
+    void NBZWriter::flushAged() {
+        if(!block.empty() && std::chrono::steady_clock::now() - blockStarted >= maxBlockAge) {
+            flush();
+        }
+    }
+
+    void NBZWriter::flush() {
+
+        if(!isOpen() || block.empty()) {
+            return;
+        }
+
+        // The header and payload go out in one write so a block is either there or torn at the end of the file
+        compressed.resize(sizeof(BlockHeader) + compressBound(block.size()));
+        uint8_t* payload = compressed.data() + sizeof(BlockHeader);
+        size_t size = compress(codec, block.data(), block.size(), payload);
+
+        header.magic = BLOCK_MAGIC;
+        header.codec = codec;
+
+        // Keep the records as they are if compressing did not help
+        if(size >= block.size()) {
+            header.codec = Codec::STORED;
+            size = compress(Codec::STORED, block.data(), block.size(), payload);
+        }
+
+        header.compressedSize = uint32_t(size);
+        header.uncompressedSize = uint32_t(block.size());
+        header.payloadChecksum = checksum(payload, size);
+        header.headerChecksum = headerChecksum(header);
+        std::memcpy(compressed.data(), &header, sizeof(header));
+
+        index.push_back(IndexEntry { offset, header.firstTimestamp, header.lastTimestamp, header.records, 0, header.typeMask });
+
+        writeAll(compressed.data(), sizeof(BlockHeader) + size);
+        block.clear();
+    }
+
+    void NBZWriter::close() {
+
+        if(!isOpen()) {
+            return;
+        }
+
+        flush();
+
+        IndexHeader indexHeader;
+        std::memset(&indexHeader, 0, sizeof(indexHeader));
+        indexHeader.magic = INDEX_MAGIC;
+        indexHeader.entries = uint32_t(index.size());
+        indexHeader.checksum = checksum(reinterpret_cast<const uint8_t*>(index.data()), index.size() * sizeof(IndexEntry));
+
+        Trailer trailer;
+        std::memset(&trailer, 0, sizeof(trailer));
+        trailer.indexOffset = offset;
+        trailer.magic = TRAILER_MAGIC;
+
+        writeAll(&indexHeader, sizeof(indexHeader));
+        writeAll(index.data(), index.size() * sizeof(IndexEntry));
+        writeAll(&trailer, sizeof(trailer));
+
+        ::close(fd);
+        fd = -1;
+    }
+
+    void NBZWriter::writeAll(const void* data, size_t length) {
+
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+
+        while(length > 0) {
+            ssize_t written = ::write(fd, p, length);
+
+            if(written < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(), "Failed to write to NBZ log");
+            }
+
+            p += written;
+            length -= written;
+            offset += written;
+        }
+    }
+
+}
+}
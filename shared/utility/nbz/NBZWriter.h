@@ -0,0 +1,111 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_NBZ_NBZWRITER_H
+#define UTILITY_NBZ_NBZWRITER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Format.h"
+
+namespace utility {
+namespace nbz {
+
+    /**
+     * @brief Writes records to an NBZ log.
+     *
+     * @details
+     *  Records are collected into a block which is compressed and written with a single write once it reaches
+     *  blockSize bytes or its first record is older than maxBlockAge, so a crash loses at most that much. The age is
+     *  checked on each write and by flushAged, which a quiet log needs called periodically. The index of blocks is
+     *  written when the log is closed (or destroyed). Writing is not thread safe, callers lock around it.
+     */
+    class NBZWriter {
+    public:
+        NBZWriter(const std::string& path
+                , Codec codec = Codec::LZ4
+                , uint32_t blockSize = 1 << 20
+                , std::chrono::milliseconds maxBlockAge = std::chrono::milliseconds(1000));
+        ~NBZWriter();
+
+        NBZWriter(const NBZWriter&) = delete;
+        NBZWriter& operator=(const NBZWriter&) = delete;
+
+        /**
+         * Adds a record to the log
+         *
+         * @param timestamp when the record happened (milliseconds)
+         * @param type      the typeHash of the record's type
+         */
+        void write(int64_t timestamp, uint32_t type, const void* data, uint32_t length);
+
+        void write(int64_t timestamp, uint32_t type, const std::string& data) {
+            write(timestamp, type, data.data(), uint32_t(data.size()));
+        }
+
+        /**
+         * Writes out the block in progress
+         */
+        void flush();
+
+        /**
+         * Writes out the block in progress if its first record is older than maxBlockAge
+         */
+        void flushAged();
+
+        /**
+         * Writes out the block in progress and the index and closes the file
+         */
+        void close();
+
+        bool isOpen() const {
+            return fd >= 0;
+        }
+
+        /**
+         * The number of bytes written to the file so far
+         */
+        uint64_t size() const {
+            return offset;
+        }
+
+    private:
+        void writeAll(const void* data, size_t length);
+
+        int fd;
+        Codec codec;
+        uint32_t blockSize;
+        std::chrono::milliseconds maxBlockAge;
+
+        uint64_t offset;
+        std::vector<IndexEntry> index;
+
+        // The block in progress, both buffers are kept between blocks
+        std::vector<uint8_t> block;
+        std::vector<uint8_t> compressed;
+        BlockHeader header;
+        std::chrono::steady_clock::time_point blockStarted;
+    };
+
+}
+}
+
+#endif
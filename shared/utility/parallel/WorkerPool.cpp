@@ -0,0 +1,150 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace utility {
+namespace parallel {
+
+    namespace {
+        // Set while this thread is running part of a job, so a nested run doesn't wait on the pool it is holding
+        thread_local bool insideJob = false;
+    }
+
+    WorkerPool& WorkerPool::instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    WorkerPool::WorkerPool()
+    : threads()
+    , busy()
+    , mutex()
+    , wake()
+    , done()
+    , job(nullptr)
+    , requested(0)
+    , remaining(0)
+    , generation(0)
+    , stopping(false) {
+
+        // The caller always takes part so we only need one less thread than we have cores
+        uint extra = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+        for(uint i = 0; i < extra; ++i) {
+            threads.emplace_back(&WorkerPool::work, this, i + 1);
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    uint WorkerPool::size() const {
+        return threads.size() + 1;
+    }
+
+    uint WorkerPool::run(uint workers, const std::function<void (uint)>& f) {
+
+        workers = std::min(workers, size());
+
+        // We are already part of a job (so we may hold the pool), or we were only asked for one worker
+        if(insideJob || workers <= 1) {
+            f(0);
+            return 1;
+        }
+
+        // Wait for any other caller's job to finish
+        std::lock_guard<std::mutex> running(busy);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &f;
+            requested = workers;
+            remaining = workers - 1;
+            ++generation;
+        }
+        wake.notify_all();
+
+        // The other workers still use the job if ours throws, so wait for them before passing it on
+        std::exception_ptr error;
+        insideJob = true;
+        try {
+            f(0);
+        }
+        catch(...) {
+            error = std::current_exception();
+        }
+        insideJob = false;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return remaining == 0; });
+        job = nullptr;
+
+        if(error) {
+            std::rethrow_exception(error);
+        }
+
+        return workers;
+    }
+
+    void WorkerPool::work(uint worker) {
+
+        uint64_t seen = 0;
+
+        // This thread only ever runs jobs
+        insideJob = true;
+
+        while(true) {
+            const std::function<void (uint)>* f;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || (generation != seen && worker < requested); });
+
+                if(stopping) {
+                    return;
+                }
+
+                seen = generation;
+                f = job;
+            }
+
+            (*f)(worker);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --remaining;
+            }
+            done.notify_one();
+        }
+    }
+
+}
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_PARALLEL_WORKERPOOL_H
+#define UTILITY_PARALLEL_WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utility {
+namespace parallel {
+
+    /**
+     * A fixed set of threads that share out a job, used by ransac and localisation to spread their work over the cores.
+     *
+     * The threads are started the first time the pool is used and sleep between jobs. Only one job runs at a time,
+     * a second caller waits until the pool is free. A job that calls run again (from any of its workers) runs the
+     * inner job on its own thread alone rather than waiting on itself.
+     */
+    class WorkerPool {
+    public:
+        static WorkerPool& instance();
+
+        ~WorkerPool();
+
+        /**
+         * Runs job(worker) for worker in [0, workers) and returns once they have all finished.
+         * The calling thread is worker 0, workers beyond the size of the pool are not started.
+         * Blocks while another thread's job is running, and runs job(0) alone when called from inside a job.
+         *
+         * @return the number of workers that ran the job
+         */
+        uint run(uint workers, const std::function<void (uint)>& job);
+
+        // The number of threads that can run a job including the caller
+        uint size() const;
+
+    private:
+        WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        void work(uint worker);
+
+        std::vector<std::thread> threads;
+
+        std::mutex busy;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        const std::function<void (uint)>* job;
+        uint requested;
+        uint remaining;
+        uint64_t generation;
+        bool stopping;
+    };
+
+}
+}
+
+#endif
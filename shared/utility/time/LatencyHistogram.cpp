@@ -0,0 +1,92 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "LatencyHistogram.h"
+
+#include <cmath>
+
+namespace utility {
+namespace time {
+
+    constexpr uint LatencyHistogram::SUB_BUCKET_BITS;
+    constexpr uint LatencyHistogram::SUB_BUCKETS;
+    constexpr uint LatencyHistogram::BUCKETS;
+
+    uint LatencyHistogram::bucket(uint64_t micros) {
+
+        // Values past the top bucket go into it
+        micros = std::min<uint64_t>(micros, 0xFFFFFFFF);
+
+        if(micros < SUB_BUCKETS) {
+            return micros;
+        }
+
+        uint magnitude = 63 - __builtin_clzll(micros);
+        uint group = magnitude - SUB_BUCKET_BITS + 1;
+        uint sub = (micros >> (magnitude - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+
+        return group * SUB_BUCKETS + sub;
+    }
+
+    uint64_t LatencyHistogram::lowest(uint bucket) {
+        uint group = bucket / SUB_BUCKETS;
+        uint sub = bucket % SUB_BUCKETS;
+
+        return group == 0 ? sub : uint64_t(SUB_BUCKETS + sub) << (group - 1);
+    }
+
+    uint64_t LatencyHistogram::width(uint bucket) {
+        uint group = bucket / SUB_BUCKETS;
+
+        return group == 0 ? 1 : uint64_t(1) << (group - 1);
+    }
+
+    void LatencyHistogram::record(uint64_t micros) {
+        ++counts[bucket(micros)];
+        ++total;
+        largest = std::max(largest, micros);
+    }
+
+    void LatencyHistogram::clear() {
+        counts.fill(0);
+        total = 0;
+        largest = 0;
+    }
+
+    uint64_t LatencyHistogram::percentile(double fraction) const {
+
+        if(total == 0) {
+            return 0;
+        }
+
+        uint64_t target = std::max<uint64_t>(1, uint64_t(std::ceil(fraction * total)));
+        uint64_t seen = 0;
+
+        for(uint i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if(seen >= target) {
+                return std::min(largest, lowest(i) + width(i) / 2);
+            }
+        }
+
+        return largest;
+    }
+
+}
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_TIME_LATENCYHISTOGRAM_H
+#define UTILITY_TIME_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace utility {
+namespace time {
+
+    /**
+     * A histogram of microsecond times with buckets that grow with the value (in the style of HdrHistogram).
+     *
+     * Every power of two is split into 16 buckets so any value is recorded to within 1/16th of itself, from a
+     * microsecond up to about an hour, in a fixed 2KB of counts.
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr uint SUB_BUCKET_BITS = 4;
+        static constexpr uint SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr uint BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        void record(uint64_t micros);
+
+        /// Records a duration in microseconds, negative durations count as 0
+        template <typename Rep, typename Period>
+        void record(const std::chrono::duration<Rep, Period>& duration) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+            record(uint64_t(std::max<std::chrono::microseconds::rep>(micros, 0)));
+        }
+
+        void clear();
+
+        uint64_t count() const { return total; }
+        uint64_t max() const { return largest; }
+
+        /// The value that fraction of the recorded values are at or below (the middle of its bucket), 0 if empty
+        uint64_t percentile(double fraction) const;
+
+        static uint bucket(uint64_t micros);
+        static uint64_t lowest(uint bucket);
+        static uint64_t width(uint bucket);
+
+    private:
+        std::array<uint32_t, BUCKETS> counts {};
+        uint64_t total = 0;
+        uint64_t largest = 0;
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "LookUpTableFile.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/nbz/Codec.h"
+
+namespace utility {
+namespace vision {
+
+    using messages::vision::Colour;
+    using messages::vision::LookUpTable;
+
+    namespace {
+        // Where ConfigSystem keeps the config files
+        constexpr const char* CONFIG_DIRECTORY = "config/";
+
+        uint32_t headerChecksum(LookUpTableFileHeader header) {
+            header.headerChecksum = 0;
+            return nbz::checksum(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+        }
+
+        std::vector<uint8_t> encodeRunLength(const Colour* table, size_t size) {
+
+            std::vector<uint8_t> output;
+
+            for(size_t i = 0; i < size;) {
+                size_t run = 1;
+                while(i + run < size && table[i + run] == table[i]) {
+                    ++run;
+                }
+
+                // Write the length as a varint (7 bits at a time) then the colour
+                for(size_t length = run; ; length >>= 7) {
+                    if(length < 0x80) {
+                        output.push_back(uint8_t(length));
+                        break;
+                    }
+                    output.push_back(uint8_t(length & 0x7F) | 0x80);
+                }
+                output.push_back(uint8_t(table[i]));
+
+                i += run;
+            }
+
+            return output;
+        }
+
+        std::vector<Colour> decodeRunLength(const uint8_t* input, size_t size, size_t entries) {
+
+            std::vector<Colour> output;
+            output.reserve(entries);
+
+            for(size_t i = 0; i < size;) {
+                size_t run = 0;
+                for(int shift = 0; ; shift += 7) {
+                    if(i >= size || shift > 56) {
+                        throw std::runtime_error("Corrupt run length in LUT file");
+                    }
+                    uint8_t b = input[i++];
+                    run |= size_t(b & 0x7F) << shift;
+                    if(!(b & 0x80)) {
+                        break;
+                    }
+                }
+
+                if(i >= size || run > entries - output.size()) {
+                    throw std::runtime_error("Corrupt run length in LUT file");
+                }
+
+                output.insert(output.end(), run, Colour(input[i++]));
+            }
+
+            if(output.size() != entries) {
+                throw std::runtime_error("LUT file holds " + std::to_string(output.size()) + " colours, expected " + std::to_string(entries));
+            }
+
+            return output;
+        }
+    }
+
+    void saveLookUpTable(const std::string& path, const LookUpTable& lut, LookUpTableEncoding encoding) {
+
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(lut.getRawData());
+        size_t payloadSize = lut.LUT_SIZE;
+
+        std::vector<uint8_t> encoded;
+        if(encoding == LookUpTableEncoding::RUN_LENGTH) {
+            encoded = encodeRunLength(lut.getRawData(), lut.LUT_SIZE);
+            payload = encoded.data();
+            payloadSize = encoded.size();
+        }
+
+        LookUpTableFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = LUT_FILE_MAGIC;
+        header.version = LUT_FILE_VERSION;
+        header.encoding = encoding;
+        header.bits[0] = lut.BITS_C1;
+        header.bits[1] = lut.BITS_C2;
+        header.bits[2] = lut.BITS_C3;
+        header.entries = lut.LUT_SIZE;
+        header.payloadSize = payloadSize;
+        header.payloadChecksum = nbz::checksum(payload, payloadSize);
+        header.headerChecksum = headerChecksum(header);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(payload), payloadSize);
+
+            if(!file) {
+                throw std::runtime_error("Failed to write " + tempPath);
+            }
+        }
+
+        if(std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to move " + tempPath + " to " + path);
+        }
+    }
+
+    LookUpTable loadLookUpTable(const std::string& path, bool verify) {
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open " + path);
+        }
+
+        struct stat info;
+        if(::fstat(fd, &info) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "Failed to stat " + path);
+        }
+
+        size_t fileSize = info.st_size;
+        if(fileSize < sizeof(LookUpTableFileHeader)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a LUT file");
+        }
+
+        // The mapping holds its own reference to the file so we are done with the descriptor
+        void* mapped = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        int error = errno;
+        ::close(fd);
+        if(mapped == MAP_FAILED) {
+            throw std::system_error(error, std::system_category(), "Failed to map " + path);
+        }
+
+        std::shared_ptr<const uint8_t> file(static_cast<const uint8_t*>(mapped), [fileSize] (const uint8_t* p) {
+            ::munmap(const_cast<uint8_t*>(p), fileSize);
+        });
+
+        LookUpTableFileHeader header;
+        std::memcpy(&header, file.get(), sizeof(header));
+
+        if(header.magic != LUT_FILE_MAGIC) {
+            throw std::runtime_error(path + " is not a LUT file");
+        }
+        if(header.version != LUT_FILE_VERSION) {
+            throw std::runtime_error(path + " is LUT file version " + std::to_string(header.version) + ", expected " + std::to_string(LUT_FILE_VERSION));
+        }
+        if(header.headerChecksum != headerChecksum(header)) {
+            throw std::runtime_error(path + " has a corrupt header");
+        }
+        if(header.bits[0] + header.bits[1] + header.bits[2] > 24 || header.entries != (uint64_t(1) << (header.bits[0] + header.bits[1] + header.bits[2]))) {
+            throw std::runtime_error(path + " has a table size that does not match its bit depths");
+        }
+        if(header.payloadSize != fileSize - sizeof(header)) {
+            throw std::runtime_error(path + " is " + std::to_string(fileSize) + " bytes, expected " + std::to_string(sizeof(header) + header.payloadSize));
+        }
+
+        const uint8_t* payload = file.get() + sizeof(header);
+
+        if(verify && nbz::checksum(payload, header.payloadSize) != header.payloadChecksum) {
+            throw std::runtime_error(path + " has a corrupt table");
+        }
+
+        switch(header.encoding) {
+            case LookUpTableEncoding::RAW: {
+                if(header.payloadSize != header.entries) {
+                    throw std::runtime_error(path + " has a raw table of the wrong size");
+                }
+
+                // Point the table into the mapping, which stays mapped for as long as a copy of the table is around
+                std::shared_ptr<const Colour> table(file, reinterpret_cast<const Colour*>(payload));
+                return LookUpTable(header.bits[0], header.bits[1], header.bits[2], std::move(table));
+            }
+            case LookUpTableEncoding::RUN_LENGTH: {
+                return LookUpTable(header.bits[0], header.bits[1], header.bits[2], decodeRunLength(payload, header.payloadSize, header.entries));
+            }
+            default:
+                throw std::runtime_error(path + " has an unknown encoding " + std::to_string(int(header.encoding)));
+        }
+    }
+
+    LookUpTable loadLookUpTable(const YAML::Node& config) {
+
+        if(config["file"]) {
+            return loadLookUpTable(CONFIG_DIRECTORY + config["file"].as<std::string>());
+        }
+        else {
+            return config.as<LookUpTable>();
+        }
+    }
+
+    YAML::Node saveLookUpTableConfig(const std::string& file, const LookUpTable& lut, LookUpTableEncoding encoding) {
+
+        saveLookUpTable(CONFIG_DIRECTORY + file, lut, encoding);
+
+        YAML::Node node;
+        node["bits"][0] = uint(lut.BITS_C1);
+        node["bits"][1] = uint(lut.BITS_C2);
+        node["bits"][2] = uint(lut.BITS_C3);
+        node["file"] = file;
+
+        return node;
+    }
+
+}
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_VISION_LOOKUPTABLEFILE_H
+#define UTILITY_VISION_LOOKUPTABLEFILE_H
+
+#include <cstdint>
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+#include "messages/vision/LookUpTable.h"
+
+namespace utility {
+namespace vision {
+
+    /**
+     * @brief The layout of a binary LUT file.
+     *
+     * @details
+     *  LookUpTableFileHeader then the encoded colours. The header is padded to a cache line so a raw table is used
+     *  straight out of the mapped file without being copied or parsed. Files are always replaced by renaming a new
+     *  one over the old, so a table that is still mapped keeps the contents it was loaded with.
+     */
+
+    constexpr uint32_t LUT_FILE_MAGIC = 0x54554C4E; // "NLUT"
+    constexpr uint16_t LUT_FILE_VERSION = 1;
+
+    enum class LookUpTableEncoding : uint8_t {
+        // One colour per byte, in getLUTIndex order
+        RAW = 0,
+        // (varint length, colour) pairs, the table must be decoded into memory
+        RUN_LENGTH = 1
+    };
+
+    struct LookUpTableFileHeader {
+        uint32_t magic;
+        uint16_t version;
+        LookUpTableEncoding encoding;
+        uint8_t reserved;
+        uint8_t bits[3];
+        uint8_t reserved2;
+        uint32_t reserved3;
+        // Number of colours in the table (LUT_SIZE)
+        uint64_t entries;
+        // Size of the encoded colours following the header
+        uint64_t payloadSize;
+        uint32_t payloadChecksum;
+        // Checksum of this header with this field set to 0
+        uint32_t headerChecksum;
+        uint8_t padding[24];
+    };
+
+    static_assert(sizeof(LookUpTableFileHeader) == 64, "LUT file header must be 64 bytes");
+
+    /**
+     * Writes a LUT to a binary file. It is written beside the path and renamed into place so nobody reads it half done.
+     */
+    void saveLookUpTable(const std::string& path, const messages::vision::LookUpTable& lut, LookUpTableEncoding encoding = LookUpTableEncoding::RAW);
+
+    /**
+     * Loads a binary LUT file. A raw table is mapped rather than read, so loading costs little more than checking it.
+     *
+     * @throws std::system_error if the file can't be opened or mapped
+     * @throws std::runtime_error if the file is not a valid LUT file
+     */
+    messages::vision::LookUpTable loadLookUpTable(const std::string& path, bool verify = true);
+
+    /**
+     * Loads the LUT a LookUpTable.yaml config describes. Either it has the table inline (lut) as it always did, or it
+     * names a binary LUT file relative to the config directory (file).
+     */
+    messages::vision::LookUpTable loadLookUpTable(const YAML::Node& config);
+
+    /**
+     * Saves a LUT as the binary file named by file (relative to the config directory) and builds the config that
+     * points to it. Saving the config afterwards then reloads the new table in one step.
+     */
+    YAML::Node saveLookUpTableConfig(const std::string& file, const messages::vision::LookUpTable& lut, LookUpTableEncoding encoding = LookUpTableEncoding::RAW);
+
+}
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_VISION_SYNTHETICFRAMES_H
+#define UTILITY_VISION_SYNTHETICFRAMES_H
+
+#include <vector>
+#include <armadillo>
+
+#include "messages/input/Image.h"
+#include "messages/vision/LookUpTable.h"
+
+namespace utility {
+namespace vision {
+namespace synthetic {
+
+    /*
+     * Builds a 6/6/6 LUT that splits the (R, G, B) triple from Image::operator() into field, line, ball, goal and unknown
+     */
+    inline messages::vision::LookUpTable makeLUT() {
+
+        std::vector<messages::vision::Colour> data(1 << 18);
+
+        for(uint i = 0; i < data.size(); ++i) {
+            int r = ((i >> 12) & 0x3F) << 2;
+            int g = ((i >> 6) & 0x3F) << 2;
+            int b = (i & 0x3F) << 2;
+
+            data[i] = r > 180 && g > 180 && b > 180       ? messages::vision::Colour::WHITE
+                    : g > r + 20 && g > b + 20            ? messages::vision::Colour::GREEN
+                    : r > 180 && g > 60 && g < 160 && b < 80 ? messages::vision::Colour::ORANGE
+                    : r > 180 && g > 180 && b < 80         ? messages::vision::Colour::YELLOW
+                    : messages::vision::Colour::UNCLASSIFIED;
+        }
+
+        return messages::vision::LookUpTable(6, 6, 6, std::move(data));
+    }
+
+    /*
+     * Mosaics a scene with sky above a field that has lines across it, a goal post standing on it and a ball on it.
+     * The ball moves with the frame number so consecutive frames differ.
+     */
+    inline messages::input::Image<0> makeScene(uint width, uint height, uint frame) {
+
+        messages::input::Image<0> image;
+        image.format = messages::input::Image<0>::SourceFormat::BGGR;
+        image.dimensions = { width, height };
+        image.source.resize(width * height);
+
+        int ballX = int((200 + frame * 37) % (width - 200)) + 100;
+        int ballY = int(height * 3 / 4);
+        int ballR = 40;
+
+        int postX = int(width / 5);
+        int postWidth = 30;
+
+        for(uint y = 0; y < height; ++y) {
+            for(uint x = 0; x < width; ++x) {
+
+                int dx = int(x) - ballX;
+                int dy = int(y) - ballY;
+
+                uint8_t rgb[3] = { 90, 120, 200 };                                      // Sky
+                if(y > height / 3)                           { rgb[0] = 40;  rgb[1] = 160; rgb[2] = 50; }  // Field
+                if(y > height / 3 && (y / 8) % 20 == 0)      { rgb[0] = 230; rgb[1] = 230; rgb[2] = 230; } // Lines
+                if(y > height / 6 && y < height * 2 / 3
+                    && int(x) >= postX && int(x) < postX + postWidth) { rgb[0] = 220; rgb[1] = 210; rgb[2] = 40; }  // Goal
+                if(dx * dx + dy * dy < ballR * ballR)        { rgb[0] = 240; rgb[1] = 110; rgb[2] = 30; }  // Ball
+
+                // Green where the column and row parity match, otherwise blue on even rows and red on odd rows
+                bool oX = x % 2;
+                bool oY = y % 2;
+                image.source[y * width + x] = oX == oY ? rgb[1] : oY ? rgb[0] : rgb[2];
+            }
+        }
+
+        return image;
+    }
+
+    /*
+     * A scan pattern shaped like the one LUTClassifier uses: sparse vertical visual horizon lines,
+     * dense horizontal ball finder lines below the horizon and a full resolution crosshatch over the ball
+     */
+    template <typename Classify>
+    inline size_t scanFrame(uint width, uint height, Classify&& classify) {
+
+        size_t segments = 0;
+
+        for(int x = 1; x < int(width) - 1; x += 20) {
+            segments += classify(arma::ivec2({ x, int(height / 4) }), arma::ivec2({ x, int(height) - 2 }), 4).size();
+        }
+
+        for(int y = int(height / 3); y < int(height) - 1; y += 3) {
+            segments += classify(arma::ivec2({ 1, y }), arma::ivec2({ int(width) - 2, y }), 3).size();
+        }
+
+        for(int i = 0; i < 40; ++i) {
+            int x = int(width / 2) - 100 + i * 5;
+            int y = int(height * 3 / 4) - 100 + i * 5;
+            segments += classify(arma::ivec2({ x, int(height * 3 / 4) - 100 }), arma::ivec2({ x, int(height * 3 / 4) + 100 }), 1).size();
+            segments += classify(arma::ivec2({ int(width / 2) - 100, y }), arma::ivec2({ int(width / 2) + 100, y }), 1).size();
+        }
+
+        return segments;
+    }
+
+}  // synthetic
+}  // vision
+}  // utility
+
+#endif  // UTILITY_VISION_SYNTHETICFRAMES_H
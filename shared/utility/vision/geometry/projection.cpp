@@ -0,0 +1,520 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "projection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace utility {
+namespace vision {
+namespace geometry {
+
+    namespace {
+
+        // Table entries per radian (for angles) or per unit (for atan), linear interpolation keeps both within 1e-7
+        constexpr double RESOLUTION = 1024;
+
+        // Radial lenses are only tabulated out to pi radians from their centre
+        constexpr double MAX_ANGLE = M_PI * RESOLUTION;
+
+        // Stops divisions by zero at the centre of radial lenses
+        constexpr double TINY = 1e-300;
+
+        struct Tables {
+            // Indexed by angle * RESOLUTION
+            std::vector<double> sinc;
+            std::vector<double> cosine;
+
+            // Indexed by value * RESOLUTION over [0, 1]
+            std::vector<double> arctan;
+
+            Tables() {
+                // One past the last index so interpolation can always read the next entry
+                const size_t angles = size_t(MAX_ANGLE) + 2;
+                sinc.resize(angles);
+                cosine.resize(angles);
+                for (size_t i = 0; i < angles; ++i) {
+                    double angle = i / RESOLUTION;
+                    sinc[i] = i == 0 ? 1.0 : std::sin(angle) / angle;
+                    cosine[i] = std::cos(angle);
+                }
+
+                arctan.resize(size_t(RESOLUTION) + 2);
+                for (size_t i = 0; i < arctan.size(); ++i) {
+                    arctan[i] = std::atan(i / RESOLUTION);
+                }
+            }
+        };
+
+        // Every lens shares the same tables (they only depend on the angle) so they are built on first use
+        const Tables& tables() {
+            static const Tables instance;
+            return instance;
+        }
+
+        /*
+         * One double at a time, with the same operations as the SIMD lanes so the kernels below can be written once
+         * and finish off whatever is left over after the last full set of lanes.
+         */
+        struct Scalar {
+            static constexpr size_t size = 1;
+            typedef int Index;
+
+            double v;
+
+            Scalar(double v) : v(v) {}
+
+            static Scalar load(const double* data) { return *data; }
+        };
+
+        inline Scalar operator+(Scalar a, Scalar b) { return a.v + b.v; }
+        inline Scalar operator-(Scalar a, Scalar b) { return a.v - b.v; }
+        inline Scalar operator*(Scalar a, Scalar b) { return a.v * b.v; }
+        inline Scalar operator/(Scalar a, Scalar b) { return a.v / b.v; }
+        inline bool operator<(Scalar a, Scalar b) { return a.v < b.v; }
+        inline bool operator>(Scalar a, Scalar b) { return a.v > b.v; }
+        inline Scalar sqrt(Scalar a) { return std::sqrt(a.v); }
+        // Like minpd and maxpd these return b when either is NaN
+        inline Scalar min(Scalar a, Scalar b) { return a.v < b.v ? a.v : b.v; }
+        inline Scalar max(Scalar a, Scalar b) { return a.v > b.v ? a.v : b.v; }
+        inline Scalar abs(Scalar a) { return std::fabs(a.v); }
+        inline Scalar select(bool mask, Scalar a, Scalar b) { return mask ? a : b; }
+        inline int truncate(Scalar a) { return int(a.v); }
+        inline int round(Scalar a) { return int(std::round(a.v)); }
+        inline Scalar toLanes(int i) { return double(i); }
+        inline Scalar gather(const double* table, int i) { return table[i]; }
+        inline void store(double* data, Scalar a) { *data = a.v; }
+
+        inline void loadPixels(const int* pixels, Scalar& x, Scalar& y) {
+            x = pixels[0];
+            y = pixels[1];
+        }
+
+        inline void storePixels(int* pixels, int x, int y) {
+            pixels[0] = x;
+            pixels[1] = y;
+        }
+
+#if defined(__AVX2__)
+
+        struct Simd {
+            static constexpr size_t size = 4;
+            typedef __m128i Index;
+
+            __m256d v;
+
+            Simd(__m256d v) : v(v) {}
+            Simd(double v) : v(_mm256_set1_pd(v)) {}
+
+            static Simd load(const double* data) { return _mm256_loadu_pd(data); }
+        };
+
+        inline Simd operator+(Simd a, Simd b) { return _mm256_add_pd(a.v, b.v); }
+        inline Simd operator-(Simd a, Simd b) { return _mm256_sub_pd(a.v, b.v); }
+        inline Simd operator*(Simd a, Simd b) { return _mm256_mul_pd(a.v, b.v); }
+        inline Simd operator/(Simd a, Simd b) { return _mm256_div_pd(a.v, b.v); }
+        inline Simd operator<(Simd a, Simd b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+        inline Simd operator>(Simd a, Simd b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+        inline Simd sqrt(Simd a) { return _mm256_sqrt_pd(a.v); }
+        inline Simd min(Simd a, Simd b) { return _mm256_min_pd(a.v, b.v); }
+        inline Simd max(Simd a, Simd b) { return _mm256_max_pd(a.v, b.v); }
+        inline Simd abs(Simd a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+        inline Simd select(Simd mask, Simd a, Simd b) { return _mm256_blendv_pd(b.v, a.v, mask.v); }
+        inline __m128i truncate(Simd a) { return _mm256_cvttpd_epi32(a.v); }
+        inline Simd toLanes(__m128i i) { return _mm256_cvtepi32_pd(i); }
+        inline Simd gather(const double* table, __m128i i) { return _mm256_i32gather_pd(table, i, 8); }
+        inline void store(double* data, Simd a) { _mm256_storeu_pd(data, a.v); }
+
+        // Rounds half away from zero like std::round (the largest double below a half so x.49999... stays put)
+        inline __m128i round(Simd a) {
+            __m256d half = _mm256_or_pd(_mm256_and_pd(_mm256_set1_pd(-0.0), a.v), _mm256_set1_pd(0.49999999999999994));
+            return _mm256_cvttpd_epi32(_mm256_add_pd(a.v, half));
+        }
+
+        inline void loadPixels(const int* pixels, Simd& x, Simd& y) {
+            // Gather the xs into the low half and the ys into the high half
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+            v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+            x = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+            y = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        }
+
+        inline void storePixels(int* pixels, __m128i x, __m128i y) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), _mm_unpacklo_epi32(x, y));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 4), _mm_unpackhi_epi32(x, y));
+        }
+
+#elif defined(__SSE2__)
+
+        struct Simd {
+            static constexpr size_t size = 2;
+            // Only the low two ints are used
+            typedef __m128i Index;
+
+            __m128d v;
+
+            Simd(__m128d v) : v(v) {}
+            Simd(double v) : v(_mm_set1_pd(v)) {}
+
+            static Simd load(const double* data) { return _mm_loadu_pd(data); }
+        };
+
+        inline Simd operator+(Simd a, Simd b) { return _mm_add_pd(a.v, b.v); }
+        inline Simd operator-(Simd a, Simd b) { return _mm_sub_pd(a.v, b.v); }
+        inline Simd operator*(Simd a, Simd b) { return _mm_mul_pd(a.v, b.v); }
+        inline Simd operator/(Simd a, Simd b) { return _mm_div_pd(a.v, b.v); }
+        inline Simd operator<(Simd a, Simd b) { return _mm_cmplt_pd(a.v, b.v); }
+        inline Simd operator>(Simd a, Simd b) { return _mm_cmpgt_pd(a.v, b.v); }
+        inline Simd sqrt(Simd a) { return _mm_sqrt_pd(a.v); }
+        inline Simd min(Simd a, Simd b) { return _mm_min_pd(a.v, b.v); }
+        inline Simd max(Simd a, Simd b) { return _mm_max_pd(a.v, b.v); }
+        inline Simd abs(Simd a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+        inline Simd select(Simd mask, Simd a, Simd b) { return _mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v)); }
+        inline __m128i truncate(Simd a) { return _mm_cvttpd_epi32(a.v); }
+        inline Simd toLanes(__m128i i) { return _mm_cvtepi32_pd(i); }
+        inline void store(double* data, Simd a) { _mm_storeu_pd(data, a.v); }
+
+        // SSE2 has no gather so load the two entries separately
+        inline Simd gather(const double* table, __m128i i) {
+            return _mm_set_pd(table[_mm_cvtsi128_si32(_mm_srli_si128(i, 4))], table[_mm_cvtsi128_si32(i)]);
+        }
+
+        // Rounds half away from zero like std::round (the largest double below a half so x.49999... stays put)
+        inline __m128i round(Simd a) {
+            __m128d half = _mm_or_pd(_mm_and_pd(_mm_set1_pd(-0.0), a.v), _mm_set1_pd(0.49999999999999994));
+            return _mm_cvttpd_epi32(_mm_add_pd(a.v, half));
+        }
+
+        inline void loadPixels(const int* pixels, Simd& x, Simd& y) {
+            // x0 y0 x1 y1 -> x0 x1 y0 y1
+            __m128i v = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)), _MM_SHUFFLE(3, 1, 2, 0));
+            x = _mm_cvtepi32_pd(v);
+            y = _mm_cvtepi32_pd(_mm_srli_si128(v, 8));
+        }
+
+        inline void storePixels(int* pixels, __m128i x, __m128i y) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), _mm_unpacklo_epi32(x, y));
+        }
+
+#else
+
+        typedef Scalar Simd;
+
+#endif
+
+        // Rays are interleaved so go through the stack to split them into lanes
+        template <typename Lanes>
+        inline void loadRays(const double* rays, Lanes& x, Lanes& y, Lanes& z) {
+            double lanes[3][Lanes::size];
+            for (size_t l = 0; l < Lanes::size; ++l) {
+                lanes[0][l] = rays[l * 3 + 0];
+                lanes[1][l] = rays[l * 3 + 1];
+                lanes[2][l] = rays[l * 3 + 2];
+            }
+            x = Lanes::load(lanes[0]);
+            y = Lanes::load(lanes[1]);
+            z = Lanes::load(lanes[2]);
+        }
+
+        template <typename Lanes>
+        inline void storeRays(double* rays, Lanes x, Lanes y, Lanes z) {
+            double lanes[3][Lanes::size];
+            store(lanes[0], x);
+            store(lanes[1], y);
+            store(lanes[2], z);
+            for (size_t l = 0; l < Lanes::size; ++l) {
+                rays[l * 3 + 0] = lanes[0][l];
+                rays[l * 3 + 1] = lanes[1][l];
+                rays[l * 3 + 2] = lanes[2][l];
+            }
+        }
+
+        template <typename Lanes, typename Index>
+        inline Lanes interpolate(const double* table, Index index, Lanes fraction) {
+            Lanes a = gather(table, index);
+            Lanes b = gather(table + 1, index);
+            return a + (b - a) * fraction;
+        }
+
+        /*
+         * Projects pixels from i onwards, a whole set of lanes at a time, and returns the first pixel it didn't do.
+         *
+         * The angle from the centre is pitch * |p - c| and the ray is (cos(angle), sin(angle) * (p - c) / |p - c|)
+         * with y flipped, which is (cos(angle), pitch * sinc(angle) * (p - c)) without the division.
+         */
+        template <typename Lanes>
+        size_t radialPixelsToRays(const double centre[2], double pitch, const int* pixels, size_t i, size_t count, double* rays) {
+
+            const Tables& t = tables();
+            const Lanes cx(centre[0]), cy(centre[1]), scale(pitch * RESOLUTION), limit(MAX_ANGLE);
+            const Lanes positive(pitch), negative(-pitch);
+
+            for (; i + Lanes::size <= count; i += Lanes::size) {
+                Lanes x(0.0), y(0.0);
+                loadPixels(pixels + i * 2, x, y);
+
+                Lanes dx = x - cx;
+                Lanes dy = y - cy;
+
+                Lanes f = min(sqrt(dx * dx + dy * dy) * scale, limit);
+                auto index = truncate(f);
+                Lanes fraction = f - toLanes(index);
+
+                Lanes sinc = interpolate(t.sinc.data(), index, fraction);
+                Lanes cosine = interpolate(t.cosine.data(), index, fraction);
+
+                storeRays(rays + i * 3, cosine, dx * sinc * positive, dy * sinc * negative);
+            }
+
+            return i;
+        }
+
+        /*
+         * Projects rays from i onwards, a whole set of lanes at a time, and returns the first ray it didn't do.
+         *
+         * The pixel is angle / pitch from the centre in the direction of (y, -z), where angle is acos(x) worked out
+         * as atan2(sqrt(1 - x^2), x) so it can come from the [0, 1] atan table.
+         */
+        template <typename Lanes>
+        size_t radialRaysToPixels(const double centre[2], double pitch, const double* rays, size_t i, size_t count, int* pixels) {
+
+            const Tables& t = tables();
+            const Lanes cx(centre[0]), cy(centre[1]), p(pitch), resolution(RESOLUTION);
+            const Lanes zero(0.0), one(1.0), tiny(TINY), halfPi(M_PI_2), pi(M_PI);
+
+            for (; i + Lanes::size <= count; i += Lanes::size) {
+                Lanes x(0.0), y(0.0), z(0.0);
+                loadRays(rays + i * 3, x, y, z);
+
+                Lanes ax = abs(x);
+                Lanes s = sqrt(max(one - x * x, zero));
+
+                // atan of the smaller over the larger, then fold it back out to the right octant
+                Lanes f = min(min(ax, s) / max(max(ax, s), tiny) * resolution, resolution);
+                auto index = truncate(f);
+                Lanes angle = interpolate(t.arctan.data(), index, f - toLanes(index));
+                angle = select(s > ax, halfPi - angle, angle);
+                angle = select(x < zero, pi - angle, angle);
+
+                // y and z are both 0 at the centre so k being huge there doesn't matter
+                Lanes k = angle / max(sqrt(y * y + z * z) * p, tiny);
+
+                storePixels(pixels + i * 2, round(cx + y * k), round(cy - z * k));
+            }
+
+            return i;
+        }
+    }
+
+    void LensProjection::setRadial(Type type, double fov, double pitch, double centreX, double centreY, uint width, uint height) {
+        this->type = type;
+        this->width = width;
+        this->height = height;
+        this->fov[0] = fov;
+        this->fov[1] = 0;
+        this->pitch = pitch;
+        this->centre[0] = centreX;
+        this->centre[1] = centreY;
+        this->focalLength = 0;
+
+        fovLimit[0] = std::cos(fov / 2.0);
+        fovLimit[1] = 0;
+
+        // Build the tables now rather than on the first projection
+        tables();
+    }
+
+    void LensProjection::setEquirectangular(double fovX, double fovY, double focalLength, uint width, uint height) {
+        this->type = Type::EQUIRECTANGULAR;
+        this->width = width;
+        this->height = height;
+        this->fov[0] = fovX;
+        this->fov[1] = fovY;
+        this->pitch = 0;
+        this->centre[0] = width / 2.0;
+        this->centre[1] = height / 2.0;
+        this->focalLength = focalLength;
+
+        fovLimit[0] = std::cos(fovX / 2.0);
+        fovLimit[1] = std::cos(fovY / 2.0);
+    }
+
+    bool LensProjection::operator==(const LensProjection& other) const {
+        return type == other.type
+            && width == other.width
+            && height == other.height
+            && fov[0] == other.fov[0]
+            && fov[1] == other.fov[1]
+            && pitch == other.pitch
+            && centre[0] == other.centre[0]
+            && centre[1] == other.centre[1]
+            && focalLength == other.focalLength;
+    }
+
+    void LensProjection::pixelsToRays(const int* pixels, size_t count, double* rays) const {
+
+        if (type == Type::EQUIRECTANGULAR) {
+            for (size_t i = 0; i < count; ++i) {
+                double x = pixels[i * 2 + 0] - centre[0];
+                double y = pixels[i * 2 + 1] - centre[1];
+                double norm = std::sqrt(x * x + y * y + focalLength * focalLength);
+
+                rays[i * 3 + 0] = x / norm;
+                rays[i * 3 + 1] = y / norm;
+                rays[i * 3 + 2] = focalLength / norm;
+            }
+        }
+        else {
+            size_t i = radialPixelsToRays<Simd>(centre, pitch, pixels, 0, count, rays);
+            radialPixelsToRays<Scalar>(centre, pitch, pixels, i, count, rays);
+        }
+    }
+
+    void LensProjection::raysToPixels(const double* rays, size_t count, int* pixels) const {
+
+        if (type == Type::EQUIRECTANGULAR) {
+            for (size_t i = 0; i < count; ++i) {
+                double scale = focalLength / rays[i * 3 + 2];
+
+                pixels[i * 2 + 0] = int(std::round(rays[i * 3 + 0] * scale + centre[0]));
+                pixels[i * 2 + 1] = int(std::round(rays[i * 3 + 1] * scale + centre[1]));
+            }
+        }
+        else {
+            size_t i = radialRaysToPixels<Simd>(centre, pitch, rays, 0, count, pixels);
+            radialRaysToPixels<Scalar>(centre, pitch, rays, i, count, pixels);
+        }
+    }
+
+    size_t LensProjection::trimToFOV(const double* rays, size_t count, double* output) const {
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const double* ray = rays + i * 3;
+
+            bool inside = type == Type::EQUIRECTANGULAR
+                ? ray[0] < fovLimit[0] && ray[1] < fovLimit[1]
+                : ray[0] > fovLimit[0];
+
+            if (inside) {
+                // Moving backwards over the same buffer is fine as kept <= i
+                std::copy(ray, ray + 3, output + kept * 3);
+                ++kept;
+            }
+        }
+
+        return kept;
+    }
+
+    size_t LensProjection::trimToImage(const int* pixels, size_t count, int* output) const {
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            int x = pixels[i * 2 + 0];
+            int y = pixels[i * 2 + 1];
+
+            if (x >= 0 && x < int(width) && y >= 0 && y < int(height)) {
+                output[kept * 2 + 0] = x;
+                output[kept * 2 + 1] = y;
+                ++kept;
+            }
+        }
+
+        return kept;
+    }
+
+    void LensProjection::snapToScreen(const double* positions, size_t count, const double direction[2], double* ends) const {
+
+        const double dx = direction[0];
+        const double dy = direction[1];
+
+        // These are the edges snapToScreen has always used
+        const double edgeX = width / 2;
+        const double edgeY = height;
+
+        // The radius of the lens's circle in pixels and the constant part of the quadratic for where we cross it
+        const double radius = fov[0] / 2.0 / pitch;
+        const double a = dx * dx + dy * dy;
+
+        for (size_t i = 0; i < count; ++i) {
+            const double x = positions[i * 2 + 0];
+            const double y = positions[i * 2 + 1];
+
+            double scale = std::numeric_limits<double>::max();
+
+            if (type != Type::EQUIRECTANGULAR) {
+                const double cx = x - centre[0];
+                const double cy = y - centre[1];
+                const double b = 2.0 * (cx * dx + cy * dy);
+                const double c = cx * cx + cy * cy - radius * radius;
+
+                scale = (-b + std::sqrt(b * b - 4.0 * a * c)) / (2.0 * a);
+            }
+
+            if (dx > 0) {
+                scale = std::min((edgeX - x) / dx, scale);
+            }
+            else if (dx < 0) {
+                scale = std::min((x - edgeX) / dx, scale);
+            }
+
+            if (dx == 0) {
+                if (dy > 0) {
+                    scale = (edgeY - y) / dy;
+                }
+                else if (dy < 0) {
+                    scale = (y - edgeY) / dy;
+                }
+            }
+            else {
+                if (dy > 0) {
+                    scale = std::min((edgeY - y) / dy, scale);
+                }
+                else if (dy < 0) {
+                    scale = std::min((y - edgeY) / dy, scale);
+                }
+            }
+
+            ends[i * 2 + 0] = std::round(dx * scale + x);
+            ends[i * 2 + 1] = std::round(dy * scale + y);
+        }
+    }
+
+    const char* projectionInstructionSet() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE2__)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+}
+}
+}
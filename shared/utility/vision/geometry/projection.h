@@ -0,0 +1,161 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_VISION_GEOMETRY_PROJECTION_H
+#define UTILITY_VISION_GEOMETRY_PROJECTION_H
+
+#include <cstddef>
+
+#include "messages/input/Image.h"
+
+namespace utility {
+namespace vision {
+namespace geometry {
+
+    /**
+     * Projects between pixels and camera rays for one lens, in batches over contiguous buffers and without allocating.
+     *
+     * Pixels are interleaved (x, y) ints and rays are interleaved (x, y, z) doubles in the same camera space as
+     * screen.h, where radial lenses look down x and equirectangular lenses down z. Everything the projections need is
+     * worked out once when the lens is set, and radial (and barrel, which has the same parameters) lenses replace sin,
+     * cos and acos with interpolated tables that are shared by every lens. The radial loops use AVX2 or SSE2 when the
+     * compiler targets them and a scalar loop otherwise.
+     *
+     * The results match bulkPixel2Ray, bulkRay2Pixel, trimToFOV, trimToImage and snapToScreen to within 1e-6 (a
+     * projected pixel can round the other way when it is that close to half way), except where they are undefined:
+     * the centre pixel of a radial lens is the forward ray rather than NaN, pixels more than pi radians from the centre
+     * of a radial lens are treated as pi radians away, and equirectangular lenses are centred on (width / 2, height / 2).
+     */
+    class LensProjection {
+    public:
+        enum class Type {
+            EQUIRECTANGULAR,
+            RADIAL,
+            BARREL
+        };
+
+        LensProjection() = default;
+
+        template <int camID>
+        explicit LensProjection(const messages::input::Image<camID>& image) {
+            set(image);
+        }
+
+        /**
+         * Sets up a radial (or barrel) lens where the angle from the centre is pitch radians per pixel
+         */
+        void setRadial(Type type, double fov, double pitch, double centreX, double centreY, uint width, uint height);
+
+        void setEquirectangular(double fovX, double fovY, double focalLength, uint width, uint height);
+
+        template <int camID>
+        void set(const messages::input::Image<camID>& image) {
+            using LensType = typename messages::input::Image<camID>::Lens::Type;
+            const auto& lens = image.lens;
+
+            if (lens.type == LensType::EQUIRECTANGULAR) {
+                setEquirectangular(lens.parameters.equirectangular.fov[0]
+                    , lens.parameters.equirectangular.fov[1]
+                    , lens.parameters.equirectangular.focalLength
+                    , image.width()
+                    , image.height());
+            }
+            else {
+                setRadial(lens.type == LensType::BARREL ? Type::BARREL : Type::RADIAL
+                    , lens.parameters.radial.fov
+                    , lens.parameters.radial.pitch
+                    , lens.parameters.radial.centre[0]
+                    , lens.parameters.radial.centre[1]
+                    , image.width()
+                    , image.height());
+            }
+        }
+
+        /**
+         * Whether this was set up from a lens and image size like image's, so callers can keep one between frames
+         */
+        template <int camID>
+        bool describes(const messages::input::Image<camID>& image) const {
+            using LensType = typename messages::input::Image<camID>::Lens::Type;
+            const auto& lens = image.lens;
+
+            if (width != image.width() || height != image.height()) {
+                return false;
+            }
+            if (lens.type == LensType::EQUIRECTANGULAR) {
+                return type == Type::EQUIRECTANGULAR
+                    && fov[0] == lens.parameters.equirectangular.fov[0]
+                    && fov[1] == lens.parameters.equirectangular.fov[1]
+                    && focalLength == lens.parameters.equirectangular.focalLength;
+            }
+            return type == (lens.type == LensType::BARREL ? Type::BARREL : Type::RADIAL)
+                && fov[0] == lens.parameters.radial.fov
+                && pitch == lens.parameters.radial.pitch
+                && centre[0] == lens.parameters.radial.centre[0]
+                && centre[1] == lens.parameters.radial.centre[1];
+        }
+
+        /// Whether both project the same way (same lens and image size)
+        bool operator==(const LensProjection& other) const;
+
+        /// Projects count pixels to unit rays (bulkPixel2Ray)
+        void pixelsToRays(const int* pixels, size_t count, double* rays) const;
+
+        /// Projects count rays to the nearest pixels (bulkRay2Pixel)
+        void raysToPixels(const double* rays, size_t count, int* pixels) const;
+
+        /// Keeps the rays inside the lens's field of view in order, returns how many (trimToFOV, output may be rays)
+        size_t trimToFOV(const double* rays, size_t count, double* output) const;
+
+        /// Keeps the pixels inside the image in order, returns how many (trimToImage, output may be pixels)
+        size_t trimToImage(const int* pixels, size_t count, int* output) const;
+
+        /**
+         * Extends count (x, y) positions along direction to the edge of the image (snapToScreen)
+         *
+         * @param positions the start of each line, interleaved (x, y)
+         * @param direction the (x, y) direction every line goes in
+         * @param ends      where each line leaves the image, interleaved (x, y) and rounded
+         */
+        void snapToScreen(const double* positions, size_t count, const double direction[2], double* ends) const;
+
+    private:
+        Type type = Type::RADIAL;
+        uint width = 0;
+        uint height = 0;
+
+        double fov[2] = { 0, 0 };
+        double pitch = 0;
+        double centre[2] = { 0, 0 };
+        double focalLength = 0;
+
+        // Rays inside the field of view have an x (radial) or both x and y (equirectangular) above these
+        double fovLimit[2] = { 0, 0 };
+    };
+
+    /**
+     * The name of the instruction set LensProjection was built with (for benchmarks and logging)
+     */
+    const char* projectionInstructionSet();
+
+}
+}
+}
+
+#endif
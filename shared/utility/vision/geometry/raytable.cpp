@@ -0,0 +1,176 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#include "raytable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace utility {
+namespace vision {
+namespace geometry {
+
+    namespace {
+
+        // The current table for each camera and spacing
+        std::mutex cacheMutex;
+        std::map<std::pair<int, uint>, std::shared_ptr<const RayTable>> cache;
+    }
+
+    RayTable::RayTable(const LensProjection& projection, uint width, uint height, uint spacing)
+        : projection(projection)
+        , width(std::max(width, 1u))
+        , height(std::max(height, 1u))
+        , gridShift(0)
+        , grid() {
+
+        // Power of two spacings let lookups find their cell with shifts
+        while ((1u << gridShift) < spacing) {
+            ++gridShift;
+        }
+        gridSpacing = 1u << gridShift;
+
+        // One extra grid point past the last pixel so every pixel has a cell to interpolate in
+        columns = (this->width - 1) / gridSpacing + 2;
+        rows = (this->height - 1) / gridSpacing + 2;
+        grid.resize(size_t(rows) * columns * 3);
+
+        std::vector<int> pixels(columns * 2);
+        std::vector<double> rays(columns * 3);
+
+        for (uint r = 0; r < rows; ++r) {
+            for (uint c = 0; c < columns; ++c) {
+                pixels[c * 2 + 0] = int(c * gridSpacing);
+                pixels[c * 2 + 1] = int(r * gridSpacing);
+            }
+
+            projection.pixelsToRays(pixels.data(), columns, rays.data());
+            std::copy(rays.begin(), rays.end(), grid.begin() + size_t(r) * columns * 3);
+        }
+    }
+
+    std::shared_ptr<const RayTable> RayTable::find(int camera, uint spacing) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        auto it = cache.find(std::make_pair(camera, spacing));
+        return it == cache.end() ? nullptr : it->second;
+    }
+
+    std::shared_ptr<const RayTable> RayTable::update(int camera, const LensProjection& projection, uint width, uint height, uint spacing) {
+
+        const auto key = std::make_pair(camera, spacing);
+
+        // Finds a table already built for this lens, must be called with cacheMutex held
+        auto existing = [&] () -> std::shared_ptr<const RayTable> {
+
+            // Another reaction may have built it while we waited
+            auto it = cache.find(key);
+            if (it != cache.end() && it->second && it->second->projection == projection) {
+                return it->second;
+            }
+
+            // Cameras with the same lens can share a table
+            for (auto& other : cache) {
+                if (other.first.second == spacing && other.second && other.second->projection == projection) {
+                    cache[key] = other.second;
+                    return other.second;
+                }
+            }
+
+            return nullptr;
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (auto table = existing()) {
+                return table;
+            }
+        }
+
+        // Build it without the lock so other cameras can still get their tables (two reactions may both build one,
+        // the first to finish is kept)
+        auto table = std::make_shared<const RayTable>(projection, width, height, spacing);
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (auto built = existing()) {
+            return built;
+        }
+
+        // Anyone still using the old table keeps it until they let go
+        cache[key] = table;
+        return table;
+    }
+
+    void RayTable::pixelsToRays(const int* pixels, size_t count, double* rays) const {
+
+        const int lastX = int(width) - 1;
+        const int lastY = int(height) - 1;
+        const int shift = int(gridShift);
+        const int mask = int(gridSpacing) - 1;
+        const size_t stride = size_t(columns) * 3;
+
+        // Every pixel is a grid point so there is nothing to interpolate
+        if (shift == 0) {
+            for (size_t i = 0; i < count; ++i) {
+                int x = std::min(std::max(pixels[i * 2 + 0], 0), lastX);
+                int y = std::min(std::max(pixels[i * 2 + 1], 0), lastY);
+
+                const float* ray = grid.data() + y * stride + x * 3;
+                rays[i * 3 + 0] = ray[0];
+                rays[i * 3 + 1] = ray[1];
+                rays[i * 3 + 2] = ray[2];
+            }
+            return;
+        }
+
+        const double scale = 1.0 / gridSpacing;
+
+        for (size_t i = 0; i < count; ++i) {
+
+            // Find the cell and how far across it we are (pixels off the image get the nearest edge's ray)
+            int x = std::min(std::max(pixels[i * 2 + 0], 0), lastX);
+            int y = std::min(std::max(pixels[i * 2 + 1], 0), lastY);
+            int cx = x >> shift;
+            int cy = y >> shift;
+            double fx = (x & mask) * scale;
+            double fy = (y & mask) * scale;
+
+            const float* topLeft = grid.data() + cy * stride + cx * 3;
+            const float* bottomLeft = topLeft + stride;
+
+            double ray[3];
+            for (int d = 0; d < 3; ++d) {
+                double top = topLeft[d] + (topLeft[d + 3] - topLeft[d]) * fx;
+                double bottom = bottomLeft[d] + (bottomLeft[d + 3] - bottomLeft[d]) * fx;
+                ray[d] = top + (bottom - top) * fy;
+            }
+
+            double norm = 1.0 / std::sqrt(ray[0] * ray[0] + ray[1] * ray[1] + ray[2] * ray[2]);
+            rays[i * 3 + 0] = ray[0] * norm;
+            rays[i * 3 + 1] = ray[1] * norm;
+            rays[i * 3 + 2] = ray[2] * norm;
+        }
+    }
+
+}
+}
+}
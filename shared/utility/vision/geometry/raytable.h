@@ -0,0 +1,96 @@
+/*
+ * This file is part of the NUbots Codebase.
+ *
+ * The NUbots Codebase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The NUbots Codebase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the NUbots Codebase.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2013 NUBots <nubots@nubots.net>
+ */
+
+#ifndef UTILITY_VISION_GEOMETRY_RAYTABLE_H
+#define UTILITY_VISION_GEOMETRY_RAYTABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "messages/input/Image.h"
+#include "utility/vision/geometry/projection.h"
+
+namespace utility {
+namespace vision {
+namespace geometry {
+
+    /**
+     * The unit ray for every spacing'th pixel of a camera, worked out once and then interpolated from. The spacing is
+     * rounded up to a power of two.
+     *
+     * A spacing of 1 stores every pixel (about 15MB for 1280x960) and looks up rays as accurately as LensProjection,
+     * bigger spacings are smaller and interpolate bilinearly between the four grid points around each pixel, which
+     * on a radial lens is out by roughly (spacing * pitch)^2 / 8 radians.
+     *
+     * Tables are shared: get hands every reaction the same read only table for a camera and spacing, and only builds
+     * a new one when the camera's lens or image size changes (or reuses another camera's if it has the same lens).
+     */
+    class RayTable {
+    public:
+        RayTable(const LensProjection& projection, uint width, uint height, uint spacing);
+
+        /**
+         * Gets the shared table for this image's camera and lens, building it if the lens has changed
+         */
+        template <int camID>
+        static std::shared_ptr<const RayTable> get(const messages::input::Image<camID>& image, uint spacing) {
+
+            auto table = find(camID, spacing);
+
+            if (!table || !table->projection.describes(image)) {
+                table = update(camID, LensProjection(image), image.width(), image.height(), spacing);
+            }
+
+            return table;
+        }
+
+        /// Looks up unit rays for count interleaved (x, y) pixels into interleaved (x, y, z) rays, clamping them to the image
+        void pixelsToRays(const int* pixels, size_t count, double* rays) const;
+
+        inline uint spacing() const {
+            return gridSpacing;
+        }
+
+        /// How much memory the table takes up
+        inline size_t bytes() const {
+            return grid.size() * sizeof(float);
+        }
+
+    private:
+        static std::shared_ptr<const RayTable> find(int camera, uint spacing);
+        static std::shared_ptr<const RayTable> update(int camera, const LensProjection& projection, uint width, uint height, uint spacing);
+
+        LensProjection projection;
+        uint width;
+        uint height;
+        uint gridShift;
+        uint gridSpacing;
+        uint columns;
+        uint rows;
+
+        // rows * columns interleaved (x, y, z) rays, floats so a whole pixel table stays a reasonable size
+        std::vector<float> grid;
+    };
+
+}
+}
+}
+
+#endif